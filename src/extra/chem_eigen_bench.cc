@@ -0,0 +1,330 @@
+/*
+        Chemical Kinetics and Dynamics Library
+        Copyright (C) 2008-2013, Yuri Georgievski <ygeorgi@anl.gov>
+
+        This library is free software; you can redistribute it and/or
+        modify it under the terms of the GNU Library General Public
+        License as published by the Free Software Foundation; either
+        version 2 of the License, or (at your option) any later version.
+
+        This library is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+        Library General Public License for more details.
+*/
+
+// Chemical subspace eigensolvers benchmark: the double precision, the refined double precision,
+// and, if built WITH_MPACK, the double-double diagonalization, applied to the random symmetric
+// matrices with the eigenvalues spread over many orders of magnitude, as the low eigenvalue
+// method kinetic matrices are. The accuracy is measured against the cyclic Jacobi diagonalization
+// of the same matrix in the quadruple precision (long double, if __float128 is not supported)
+//
+// usage: chem_eigen_bench [size [smallest eigenvalue order [repetitions]]]
+
+#include "lapack.hh"
+#include "linpack.hh"
+
+#ifdef WITH_MPACK
+
+#include "mpack.hh"
+
+#endif
+
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <sys/time.h>
+
+#ifdef __SIZEOF_FLOAT128__
+
+typedef __float128  quad_float;
+
+#else
+
+typedef long double quad_float;
+
+#endif
+
+quad_float quad_abs (quad_float x) { return x < 0 ? -x : x; }
+
+// Newton iterations from the double precision root
+//
+quad_float quad_sqrt (quad_float x)
+{
+  if(x <= 0)
+    //
+    return 0;
+
+  quad_float res = std::sqrt((double)x);
+
+  for(int i = 0; i < 3; ++i)
+    //
+    res = (res + x / res) / 2;
+
+  return res;
+}
+
+// reference eigenvalues in the ascending order: the cyclic Jacobi method; the rotation is skipped
+// if the off-diagonal element is small relative to the diagonal ones, which keeps the relative
+// accuracy of the small eigenvalues
+//
+Lapack::Vector jacobi_eigenvalues (const Lapack::SymmetricMatrix& m)
+{
+  const char funame [] = "jacobi_eigenvalues: ";
+
+  static const int sweep_max = 100;
+
+  static const quad_float tol = 1.e-32;
+
+  const int n = m.size();
+
+  std::vector<quad_float> a(n * n);
+
+  for(int i = 0; i < n; ++i)
+    //
+    for(int j = 0; j < n; ++j)
+      //
+      a[i + j * n] = m(i, j);
+
+  int sweep = 0;
+
+  for(; sweep < sweep_max; ++sweep) {
+    //
+    bool is_rotated = false;
+
+    for(int p = 0; p < n; ++p)
+      //
+      for(int q = p + 1; q < n; ++q) {
+	//
+	const quad_float apq = a[p + q * n];
+
+	if(quad_abs(apq) <= tol * quad_sqrt(quad_abs(a[p + p * n] * a[q + q * n])))
+	  //
+	  continue;
+
+	is_rotated = true;
+
+	const quad_float theta = (a[q + q * n] - a[p + p * n]) / (2 * apq);
+
+	quad_float t = 1 / (quad_abs(theta) + quad_sqrt(theta * theta + 1));
+
+	if(theta < 0)
+	  //
+	  t = -t;
+
+	const quad_float c   = 1 / quad_sqrt(t * t + 1);
+	const quad_float s   = t * c;
+	const quad_float tau = s / (1 + c);
+
+	a[p + p * n] -= t * apq;
+	a[q + q * n] += t * apq;
+
+	a[p + q * n] = a[q + p * n] = 0;
+
+	for(int r = 0; r < n; ++r) {
+	  //
+	  if(r == p || r == q)
+	    //
+	    continue;
+
+	  const quad_float g = a[r + p * n];
+	  const quad_float h = a[r + q * n];
+
+	  a[r + p * n] = a[p + r * n] = g - s * (h + g * tau);
+	  a[r + q * n] = a[q + r * n] = h + s * (g - h * tau);
+	}
+      }
+
+    if(!is_rotated)
+      //
+      break;
+  }
+
+  if(sweep == sweep_max)
+    //
+    std::cerr << funame << "WARNING: not converged in " << sweep_max << " sweeps\n";
+
+  std::vector<quad_float> eval(n);
+
+  for(int i = 0; i < n; ++i)
+    //
+    eval[i] = a[i + i * n];
+
+  std::sort(eval.begin(), eval.end());
+
+  Lapack::Vector res(n);
+
+  for(int i = 0; i < n; ++i)
+    //
+    res[i] = (double)eval[i];
+
+  return res;
+}
+
+double wall_time ()
+{
+  timeval tv;
+
+  gettimeofday(&tv, 0);
+
+  return (double)tv.tv_sec + 1.e-6 * (double)tv.tv_usec;
+}
+
+// maximal relative deviation of the eigenvalues
+//
+double max_deviation (const Lapack::Vector& eval, const Lapack::Vector& ref)
+{
+  double res = 0.;
+
+  for(int i = 0; i < ref.size(); ++i) {
+    //
+    const double dtemp = std::fabs(eval[i] - ref[i]) / std::fabs(ref[i]);
+
+    if(dtemp > res)
+      //
+      res = dtemp;
+  }
+
+  return res;
+}
+
+int main (int argc, char* argv [])
+{
+  int n = 20;
+
+  double order = 20.;
+
+  int rep = 100;
+
+  if(argc > 1)
+    //
+    n = std::atoi(argv[1]);
+
+  if(argc > 2)
+    //
+    order = std::atof(argv[2]);
+
+  if(argc > 3)
+    //
+    rep = std::atoi(argv[3]);
+
+  if(n < 2 || rep < 1) {
+    //
+    std::cerr << "usage: " << argv[0] << " [size [smallest eigenvalue order [repetitions]]]\n";
+
+    return 1;
+  }
+
+  srand48(1);
+
+  // eigenvalues from 10^-order to 1
+  //
+  Lapack::Vector lambda(n);
+
+  for(int i = 0; i < n; ++i)
+    //
+    lambda[i] = std::pow(10., order * ((double)i / (double)(n - 1) - 1.)) * (1. + drand48());
+
+  // random orthogonal transformation
+  //
+  Lapack::Matrix v(n);
+
+  for(int j = 0; j < n; ++j) {
+    //
+    for(int i = 0; i < n; ++i)
+      //
+      v(i, j) = drand48() - 0.5;
+
+    for(int k = 0; k < j; ++k)
+      //
+      orthogonalize(&v(0, j), &v(0, k), n);
+
+    normalize(&v(0, j), n);
+  }
+
+  Lapack::SymmetricMatrix m(n);
+
+  for(int i = 0; i < n; ++i)
+    //
+    for(int j = i; j < n; ++j) {
+      //
+      double dtemp = 0.;
+
+      for(int k = 0; k < n; ++k)
+	//
+	dtemp += v(i, k) * v(j, k) * lambda[k];
+
+      m(i, j) = dtemp;
+    }
+
+  Lapack::Matrix evec;
+
+  Lapack::Vector eval [3];
+
+  const char* name [3] = {"double", "refined", "mpack dd"};
+
+  double timing [3] = {-1., -1., -1.};
+
+  double start = wall_time();
+
+  for(int r = 0; r < rep; ++r)
+    //
+    eval[0] = m.eigenvalues(&evec);
+
+  timing[0] = (wall_time() - start) / (double)rep;
+
+  start = wall_time();
+
+  for(int r = 0; r < rep; ++r)
+    //
+    eval[1] = m.refined_eigenvalues(&evec);
+
+  timing[1] = (wall_time() - start) / (double)rep;
+
+#ifdef WITH_MPACK
+
+  start = wall_time();
+
+  for(int r = 0; r < rep; ++r) {
+    //
+    evec.resize(n);
+
+    eval[2] = Mpack::dd_eigenvalues(m, &evec);
+  }
+
+  timing[2] = (wall_time() - start) / (double)rep;
+
+#endif
+
+  const Lapack::Vector ref = jacobi_eigenvalues(m);
+
+  std::cout << "matrix size = " << n << ", eigenvalues from 1.e-" << order << " to 1, repetitions = " << rep << "\n"
+	    << "reference: "
+#ifdef __SIZEOF_FLOAT128__
+	    << "__float128"
+#else
+	    << "long double"
+#endif
+	    << " Jacobi\n\n"
+	    << std::setw(10) << "solver"
+	    << std::setw(15) << "time, msec"
+	    << std::setw(20) << "max rel deviation"
+	    << "\n";
+
+  for(int s = 0; s < 3; ++s) {
+    //
+    if(timing[s] < 0.)
+      //
+      continue;
+
+    std::cout << std::setw(10) << name[s]
+	      << std::setw(15) << timing[s] * 1.e3
+	      << std::setw(20) << max_deviation(eval[s], ref)
+	      << "\n";
+  }
+
+  return 0;
+}
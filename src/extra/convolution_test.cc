@@ -0,0 +1,236 @@
+/*
+        Chemical Kinetics and Dynamics Library
+        Copyright (C) 2008-2013, Yuri Georgievski <ygeorgi@anl.gov>
+
+        This library is free software; you can redistribute it and/or
+        modify it under the terms of the GNU Library General Public
+        License as published by the Free Software Foundation; either
+        version 2 of the License, or (at your option) any later version.
+
+        This library is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+        Library General Public License for more details.
+*/
+
+// convolution engine benchmark: speed and accuracy of the direct, FFT, and automatically
+// chosen convolutions against the reference loops used for the density of states previously
+//
+// usage: convolution_test [grid_size] [kernel_size] [level_number]
+
+#include "convolution.hh"
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <cmath>
+#include <ctime>
+#include <map>
+
+#include <omp.h>
+
+// reference dense convolution loop (former Model::Tunnel::convolute)
+//
+void reference_dense (Array<double>& stat, const Array<double>& td)
+{
+  double dtemp;
+
+  Array<double> new_stat(stat.size());
+
+#pragma omp parallel for default(shared) private(dtemp) schedule(dynamic, 1)
+
+  for(int j = 0; j < stat.size(); ++j) {
+    dtemp = 0.;
+    for(int i = 0; i < td.size(); ++i) {
+      if(i > j)
+	break;
+      dtemp += stat[j - i] * td[i];
+    }
+    new_stat[j] = dtemp;
+  }
+
+  stat = new_stat;
+}
+
+// reference sparse convolution loop (former Model::Rotor::convolute)
+//
+void reference_sparse (Array<double>& stat_grid, const std::map<int, int>& shift)
+{
+  Array<double> new_stat_grid = stat_grid;
+
+#pragma omp parallel for default(shared) schedule(static, 10)
+
+  for(int i = 0; i < stat_grid.size(); ++i)
+    //
+    for(std::map<int, int>::const_iterator it = shift.begin(); it != shift.end(); ++it)
+      //
+      if(i >= it->first)
+	//
+	new_stat_grid[i] += (double)it->second * stat_grid[i - it->first];
+
+  stat_grid = new_stat_grid;
+}
+
+double max_relative_error (const Array<double>& a, const Array<double>& b)
+{
+  double res = 0.;
+
+  for(int i = 0; i < a.size(); ++i) {
+    //
+    const double norm = std::fabs(b[i]) > 0. ? std::fabs(b[i]) : 1.;
+
+    const double dtemp = std::fabs(a[i] - b[i]) / norm;
+
+    if(dtemp > res)
+      //
+      res = dtemp;
+  }
+
+  return res;
+}
+
+void report (const char* name, double time, double ref_time, double error)
+{
+  std::cout << std::setw(20) << name
+	    << std::setw(15) << time
+	    << std::setw(15) << ref_time / time
+	    << std::setw(15) << error
+	    << "\n";
+}
+
+int main (int argc, char* argv [])
+{
+  int grid_size   = 100000;
+  int kernel_size = 20000;
+  int level_size  = 2000;
+
+  if(argc > 1)
+    grid_size   = std::atoi(argv[1]);
+
+  if(argc > 2)
+    kernel_size = std::atoi(argv[2]);
+
+  if(argc > 3)
+    level_size  = std::atoi(argv[3]);
+
+  std::cout << "grid size = "    << grid_size
+	    << "   kernel size = " << kernel_size
+	    << "   rotor levels = " << level_size
+	    << "\n\n";
+
+  // number of states of 30 harmonic oscillators (Beyer-Swinehart)
+  //
+  Array<double> stat(grid_size, 0.);
+
+  stat[0] = 1.;
+
+  srand48(1);
+
+  for(int f = 0; f < 30; ++f)
+    //
+    Convolution::harmonic(stat, 50 + (int)(drand48() * 2000.));
+
+  // tunneling-like kernel
+  //
+  Array<double> td(kernel_size);
+
+  double fac = 0.;
+
+  for(int i = 0; i < td.size(); ++i) {
+    //
+    const double x = 10. * (double(i) / double(kernel_size) - 0.5);
+
+    td[i] = 1. / (1. + std::exp(-x)) / (1. + std::exp(x));
+
+    fac += td[i];
+  }
+
+  td /= fac;
+
+  // rotor-like levels
+  //
+  std::map<int, int>    rotor_shift;
+  std::map<int, double> conv_shift;
+
+  conv_shift[0] = 1.;
+
+  for(int n = 1; n < level_size; ++n) {
+    //
+    const int itemp = n * n / 4;
+
+    if(itemp < grid_size) {
+      //
+      rotor_shift[itemp]++;
+
+      conv_shift[itemp] += 1.;
+    }
+  }
+
+  double start, ref_time;
+
+  std::cout << std::setw(20) << "method"
+	    << std::setw(15) << "time, sec"
+	    << std::setw(15) << "speedup"
+	    << std::setw(15) << "max rel error"
+	    << "\n";
+
+  /********************************** DENSE KERNEL *************************************/
+
+  std::cout << "dense kernel:\n";
+
+  Array<double> ref = stat;
+
+  start = omp_get_wtime();
+
+  reference_dense(ref, td);
+
+  ref_time = omp_get_wtime() - start;
+
+  report("reference", ref_time, ref_time, 0.);
+
+  const int methods [] = {Convolution::DIRECT, Convolution::FFT, Convolution::AUTO};
+
+  const char* method_name [] = {"direct", "fft", "auto"};
+
+  for(int m = 0; m < 3; ++m) {
+    //
+    Convolution::method = methods[m];
+
+    Array<double> res = stat;
+
+    start = omp_get_wtime();
+
+    Convolution::dense(res, td);
+
+    report(method_name[m], omp_get_wtime() - start, ref_time, max_relative_error(res, ref));
+  }
+
+  /********************************** SPARSE KERNEL *************************************/
+
+  std::cout << "sparse kernel:\n";
+
+  ref = stat;
+
+  start = omp_get_wtime();
+
+  reference_sparse(ref, rotor_shift);
+
+  ref_time = omp_get_wtime() - start;
+
+  report("reference", ref_time, ref_time, 0.);
+
+  for(int m = 0; m < 3; ++m) {
+    //
+    Convolution::method = methods[m];
+
+    Array<double> res = stat;
+
+    start = omp_get_wtime();
+
+    Convolution::sparse(res, conv_shift);
+
+    report(method_name[m], omp_get_wtime() - start, ref_time, max_relative_error(res, ref));
+  }
+
+  return 0;
+}
@@ -17,7 +17,7 @@
 
 #include "lr.hh"
 #include "read.hh"
-#include "slatec.hh"
+#include "spline.hh"
 #include "slatec.h"
 
 #include <cmath>
@@ -52,13 +52,13 @@ ShortDoubleOut& ShortDoubleOut::operator<< (double d)
 
 class FreeEnergy: public Math::GradientSearch { // S - E/T, E = exp(x)
 
-  const Slatec::Spline& _entropy;
+  const Math::Spline& _entropy;
 public:
   double beta;  // T^-1
 
   double operator() (double, int) const ;
 
-  FreeEnergy (const Slatec::Spline& e, double temperature, double tol) 
+  FreeEnergy (const Math::Spline& e, double temperature, double tol) 
     : Math::GradientSearch(tol), _entropy(e), beta(1./temperature) {}
 };
 
@@ -181,7 +181,7 @@ int main (int argc, char* argv [])
   double ener, ener_step;
 
   Array<double> x_data, y_data;
-  Slatec::Spline corr;
+  Math::Spline corr;
 
   // coarse grid calculation of the optimization correction factor
 
@@ -434,7 +434,7 @@ int main (int argc, char* argv [])
   }
   std::cout << std::endl;
 
-  Slatec::Spline ne_log(x_data, y_data, medium_ener_size);
+  Math::Spline ne_log(x_data, y_data, medium_ener_size);
 
 
   /******************************* rate calculation *********************************/
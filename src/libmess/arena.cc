@@ -0,0 +1,192 @@
+/*
+        Chemical Kinetics and Dynamics Library
+        Copyright (C) 2008-2013, Yuri Georgievski <ygeorgi@anl.gov>
+
+        This library is free software; you can redistribute it and/or
+        modify it under the terms of the GNU Library General Public
+        License as published by the Free Software Foundation; either
+        version 2 of the License, or (at your option) any later version.
+
+        This library is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+        Library General Public License for more details.
+*/
+
+#include "arena.hh"
+
+#include <limits>
+
+namespace Arena {
+  //
+  long min_size    = 1 << 13;
+
+  long cache_limit = -1;
+
+  thread_local Pool  _thread_pool;
+
+  thread_local Pool* _current = 0;
+
+  Pool& thread_pool () { return _thread_pool; }
+
+  Pool* current () { return _current; }
+}
+
+Arena::Pool::~Pool ()
+{
+  clear();
+
+  if(_current == this)
+    //
+    _current = 0;
+}
+
+double* Arena::Pool::allocate (long n, long& capacity)
+{
+  ++_count;
+
+  // the best fitting released buffer, if it is not too large
+  //
+  std::multimap<long, double*>::iterator it = _free.lower_bound(n);
+
+  double* res;
+
+  if(it != _free.end() && it->first <= 2 * n && it->first <= std::numeric_limits<int>::max()) {
+    //
+    capacity = it->first;
+
+    res = it->second;
+
+    _free.erase(it);
+
+    _cached -= capacity * sizeof(double);
+
+    _reused += capacity * sizeof(double);
+  }
+  else {
+    //
+    capacity = n;
+
+    res = new double[n];
+
+    _fresh += capacity * sizeof(double);
+  }
+
+  _in_use += capacity * sizeof(double);
+
+  if(_in_use > _in_use_max)
+    //
+    _in_use_max = _in_use;
+
+  // by default the pool does not take more memory than the largest working set, the largest
+  // released buffers, which are the least likely to fit, are deleted first
+  //
+  while(cache_limit < 0 && _free.size() && _in_use + _cached > _in_use_max) {
+    //
+    std::multimap<long, double*>::iterator last = --_free.end();
+
+    _cached -= last->first * sizeof(double);
+
+    delete[] last->second;
+
+    _free.erase(last);
+  }
+
+  if(_in_use + _cached > _peak)
+    //
+    _peak = _in_use + _cached;
+
+  return res;
+}
+
+void Arena::Pool::release (double* p, long capacity)
+{
+  const long bytes = capacity * sizeof(double);
+
+  // the buffer may have been allocated before the pool was bound
+  //
+  _in_use = _in_use > bytes ? _in_use - bytes : 0;
+
+  const long limit = cache_limit >= 0 ? cache_limit : _in_use_max - _in_use;
+
+  if(_cached + bytes > limit) {
+    //
+    delete[] p;
+
+    return;
+  }
+
+  _free.insert(std::make_pair(capacity, p));
+
+  _cached += bytes;
+
+  if(_in_use + _cached > _peak)
+    //
+    _peak = _in_use + _cached;
+}
+
+void Arena::Pool::clear ()
+{
+  for(std::multimap<long, double*>::iterator it = _free.begin(); it != _free.end(); ++it)
+    //
+    delete[] it->second;
+
+  _free.clear();
+
+  _cached = 0;
+}
+
+void Arena::Pool::reset_stat ()
+{
+  _peak   = _in_use + _cached;
+  _fresh  = 0;
+  _reused = 0;
+  _count  = 0;
+}
+
+void Arena::Pool::report (std::ostream& to) const
+{
+  const double mb = 1024. * 1024.;
+
+  to << "scratch pool: requests = " << _count
+     << ", allocated = " << (double)_fresh / mb << " MB"
+     << ", reused = "    << (double)_reused / mb << " MB"
+     << ", peak = "      << (double)_peak / mb << " MB"
+     << ", cached = "    << (double)_cached / mb << " MB";
+}
+
+Arena::Bind::Bind (Pool& p) : _save(_current)
+{
+  if(cache_limit)
+    //
+    _current = &p;
+}
+
+Arena::Bind::~Bind ()
+{
+  _current = _save;
+}
+
+double* Arena::allocate (long n, long& capacity)
+{
+  if(!_current || n < min_size) {
+    //
+    capacity = n;
+
+    return new double[n];
+  }
+
+  return _current->allocate(n, capacity);
+}
+
+void Arena::release (double* p, long capacity)
+{
+  if(!_current || capacity < min_size) {
+    //
+    delete[] p;
+
+    return;
+  }
+
+  _current->release(p, capacity);
+}
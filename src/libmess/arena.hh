@@ -0,0 +1,118 @@
+/*
+        Chemical Kinetics and Dynamics Library
+        Copyright (C) 2008-2013, Yuri Georgievski <ygeorgi@anl.gov>
+
+        This library is free software; you can redistribute it and/or
+        modify it under the terms of the GNU Library General Public
+        License as published by the Free Software Foundation; either
+        version 2 of the License, or (at your option) any later version.
+
+        This library is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+        Library General Public License for more details.
+*/
+
+#ifndef ARENA_HH
+#define ARENA_HH
+
+#include <iostream>
+#include <map>
+
+/********************************************************************************************
+ * Pool of large double buffers: while the pool is bound to the calling thread, the storage of
+ * Array<double> (and so of Lapack::Vector, Matrix, and SymmetricMatrix) is taken from and
+ * returned to the pool, so that the scratch matrices of one master equation solve are reused
+ * by the next one instead of being page-faulted in anew; the cached buffers are released in
+ * bulk by clear() or by the pool destructor
+ ********************************************************************************************/
+
+namespace Arena {
+
+  class Pool {
+    //
+    // released buffers by capacity
+    //
+    std::multimap<long, double*> _free;
+
+    long _cached;    // bytes in the released buffers
+    long _in_use;    // bytes taken from the pool and not yet returned
+    long _in_use_max; // maximal in use bytes
+    long _peak;      // maximal in use plus cached bytes
+    long _fresh;     // bytes allocated anew
+    long _reused;    // bytes served from the released buffers
+    long _count;     // number of requests
+
+    Pool            (const Pool&);
+    Pool& operator= (const Pool&);
+
+  public:
+    //
+    Pool () : _cached(0), _in_use(0), _in_use_max(0), _peak(0), _fresh(0), _reused(0), _count(0) {}
+
+    ~Pool ();
+
+    // buffer of at least n doubles; the actual capacity is returned
+    //
+    double* allocate (long n, long& capacity);
+
+    void    release  (double*, long capacity);
+
+    // delete the released buffers
+    //
+    void clear ();
+
+    // reset the statistics, except the in use bytes
+    //
+    void reset_stat ();
+
+    long  cached_bytes () const { return _cached; }
+    long  in_use_bytes () const { return _in_use; }
+    long    peak_bytes () const { return _peak;   }
+    long   fresh_bytes () const { return _fresh;  }
+    long  reused_bytes () const { return _reused; }
+
+    void report (std::ostream&) const;
+  };
+
+  // pool of the calling thread
+  //
+  Pool& thread_pool ();
+
+  // the pool the Array<double> storage goes through on the calling thread, if any
+  //
+  Pool* current ();
+
+  // binds the pool to the calling thread while in scope
+  //
+  class Bind {
+    //
+    Pool* _save;
+
+    Bind            (const Bind&);
+    Bind& operator= (const Bind&);
+
+  public:
+    //
+    explicit Bind (Pool&);
+
+    ~Bind ();
+  };
+
+  // smallest buffer size, in doubles, served by the pool; smaller ones go to the heap directly
+  //
+  extern long min_size;
+
+  // maximal cached bytes per pool; zero disables the pools; negative, the default, limits the
+  // cached plus in use bytes by the maximal in use bytes, i. e., by the memory used without the pool
+  //
+  extern long cache_limit;
+
+  // Array<double> storage
+  //
+  double* allocate (long n, long& capacity);
+
+  void    release  (double*, long capacity);
+}
+
+#endif
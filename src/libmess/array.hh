@@ -20,8 +20,11 @@
 #include <iomanip>
 #include <cstdlib>
 #include <vector>
+#include <atomic>
+#include <utility>
 
 #include "error.hh"
+#include "arena.hh"
 
 /**************************************************************************
  *********************** ARRAY WITH DEFAULT VALUE *************************
@@ -492,6 +495,11 @@ class Array
   T*  _end;
 
   int _compare (const Array&) const;
+
+  // storage allocation: the double arrays go through the scratch pool bound to the thread, if any
+  //
+  static T*   _allocate (int n, int& capacity) { capacity = n; return new T[n]; }
+  static void _release  (T* p, int)            { delete[] p; }
   
 public:
   typedef       T*       iterator;
@@ -502,13 +510,21 @@ public:
   Array (const Array&);
   Array& operator= (const Array&);
 
+  // the storage is taken over from the temporary
+  //
+  Array (Array&& v) : _capacity(v._capacity), _size(v._size), _begin(v._begin), _end(v._end)
+  { v._capacity = v._size = 0; v._begin = v._end = 0; }
+
+  Array& operator= (Array&& v)
+  { std::swap(_capacity, v._capacity); std::swap(_size, v._size); std::swap(_begin, v._begin); std::swap(_end, v._end); return *this; }
+
   explicit Array (int)  ;
   Array (int, const T&) ;
 
   template <typename V>
   explicit Array (const V&);
 
-  ~Array () { if(_begin) delete[] _begin; }
+  ~Array () { if(_begin) _release(_begin, _capacity); }
 
   T*       begin ()       { return _begin; }
   T*       end   ()       { return _end; }
@@ -567,6 +583,21 @@ public:
 
 };// class Array
 
+template <>
+inline double* Array<double>::_allocate (int n, int& capacity)
+{
+  long itemp;
+
+  double* res = Arena::allocate(n, itemp);
+
+  capacity = itemp;
+
+  return res;
+}
+
+template <>
+inline void Array<double>::_release (double* p, int capacity) { Arena::release(p, capacity); }
+
 template <typename T>
 int Array<T>::_compare (const Array& v) const
 {
@@ -594,7 +625,7 @@ Array<T>::Array (const Array& v)
     return;
   }
   
-  _begin = new T[_size];
+  _begin = _allocate(_size, _capacity);
   _end = _begin + _size;
 
   const_iterator vit = v.begin();
@@ -616,10 +647,9 @@ Array<T>& Array<T>::operator= (const Array& v)
 
 
   if(v.size() > _capacity) {
-    _capacity = v.size();
     if(_begin)
-      delete[] _begin;
-    _begin = new T[_size];
+      _release(_begin, _capacity);
+    _begin = _allocate(_size, _capacity);
   }
 
   _end  = _begin + _size;
@@ -647,7 +677,7 @@ Array<T>::Array (int s)
     return;
   }
 
-  _begin = new T[_size];
+  _begin = _allocate(_size, _capacity);
   _end = _begin + _size;
 }
 
@@ -667,7 +697,7 @@ Array<T>::Array (int s, const T& t)
     return;
   }
 
-  _begin = new T[_size];
+  _begin = _allocate(_size, _capacity);
   _end = _begin + _size;
 
   for(T* it = begin(); it != end(); ++it)
@@ -684,7 +714,7 @@ Array<T>::Array (const V& v)
     return;
   }
   
-  _begin = new T[_size];
+  _begin = _allocate(_size, _capacity);
   _end = _begin + _size;
 
   typename V::const_iterator vit = v.begin();
@@ -699,7 +729,7 @@ void Array<T>::compact ()
 	return;
 
     if(!_size) {
-	delete[] _begin;
+	_release(_begin, _capacity);
 	_end = _begin = 0;
 	_capacity = 0;
 	return;
@@ -707,15 +737,16 @@ void Array<T>::compact ()
 
     T* old_begin = _begin;
 
-    _begin = new T[_size];
+    const int old_capacity = _capacity;
+
+    _begin = _allocate(_size, _capacity);
     _end = _begin + _size;
-    _capacity = _size;
 
     const T* vit = old_begin;
     for(T* it = begin(); it != end(); ++it, ++vit)
 	*it = *vit;
 
-    delete[] old_begin;
+    _release(old_begin, old_capacity);
 }
 
 template <typename T>
@@ -734,16 +765,19 @@ void Array<T>::resize (int s)
     return;
   }
 
-  T* new_begin = new T[s];
+  int new_capacity;
+
+  T* new_begin = _allocate(s, new_capacity);
 
   if(_begin) {
     T* vit = new_begin;
     for(const T* it = begin(); it != end(); ++it, ++vit)
       *vit = *it;
-    delete[] _begin;
+    _release(_begin, _capacity);
   }
 
-  _capacity = _size = s;
+  _capacity = new_capacity;
+  _size = s;
   _begin = new_begin;
   _end = _begin + _size;
 }
@@ -756,17 +790,18 @@ void Array<T>::reserve (int s)
   if(s <= _capacity)
       return;
 
-  _capacity  = s;
-
   T* old_begin = _begin;
-  _begin = new T[s];
+
+  const int old_capacity = _capacity;
+
+  _begin = _allocate(s, _capacity);
   _end = _begin + _size;
 
   if(old_begin) {
     const T* vit = old_begin;
     for(T* it = begin(); it != end(); ++it, ++vit)
       *it = *vit;
-    delete[] old_begin;
+    _release(old_begin, old_capacity);
   }
 }
 
@@ -1672,7 +1707,10 @@ template <typename T>
 class RefArr {
 
   Array<T>* _data;
-  int*      _count;  // number of references
+
+  // number of references; atomic, so that the handles can be copied and destroyed concurrently
+  //
+  std::atomic<int>* _count;
 
   void delete_ref ();
   void create_ref (const RefArr&);
@@ -1682,13 +1720,20 @@ public:
   bool isinit () const { return _data; }
 
   RefArr ()                      : _data(0), _count(0) {}
-  explicit RefArr (int s)        : _data(new Array<T>(s)),    _count(new int(1)) {}
-  RefArr (int s, const T& t)     : _data(new Array<T>(s, t)), _count(new int(1)) {}
+  explicit RefArr (int s)        : _data(new Array<T>(s)),    _count(new std::atomic<int>(1)) {}
+  RefArr (int s, const T& t)     : _data(new Array<T>(s, t)), _count(new std::atomic<int>(1)) {}
  
   RefArr (const RefArr& a) { create_ref(a); }
   ~RefArr () { delete_ref(); }
 
   RefArr& operator= (const RefArr& a) { if(_data != a._data) { delete_ref(); create_ref(a); } return *this; }
+
+  // the reference is taken over from the temporary without touching the counter
+  //
+  RefArr (RefArr&& a) : _data(a._data), _count(a._count) { a._data = 0; a._count = 0; }
+
+  RefArr& operator= (RefArr&& a)
+  { if(this != &a) { delete_ref(); _data = a._data; _count = a._count; a._data = 0; a._count = 0; } return *this; }
   RefArr copy() const;// make a new copy
     
   void resize  (int s);
@@ -1725,15 +1770,15 @@ public:
   RefArr operator+ (const RefArr&) const ;
   RefArr operator- (const RefArr&) const ;
 
-  RefArr operator+= (const RefArr& a) ;
-  RefArr operator-= (const RefArr& a) ;
+  RefArr& operator+= (const RefArr& a) ;
+  RefArr& operator-= (const RefArr& a) ;
 
-  RefArr operator= (const T*);
+  RefArr& operator= (const T*);
 
-  RefArr operator-  ()           ;
-  RefArr operator=  (const T& t) ;
-  RefArr operator*= (const T& t) ;
-  RefArr operator/= (const T& t) ;
+  RefArr& operator-  ()           ;
+  RefArr& operator=  (const T& t) ;
+  RefArr& operator*= (const T& t) ;
+  RefArr& operator/= (const T& t) ;
 
 };// class RefArr
 
@@ -1752,9 +1797,7 @@ inline void RefArr<T>::delete_ref ()
   if(!_count)
     return;
 
-  if(*_count > 1)
-      --(*_count);
-  else {
+  if(!--(*_count)) {
       delete _data;
       delete _count;
   }
@@ -1793,7 +1836,7 @@ inline void RefArr<T>::resize  (int s)
 { 
   if(!_data) {
     _data = new Array<T>(s);
-    _count= new int(1);
+    _count= new std::atomic<int>(1);
   }
   else
     _data->resize(s);  
@@ -1804,7 +1847,7 @@ inline void RefArr<T>::reserve (int s)
 { 
   if(!_data) {
     _data = new Array<T>(0);
-    _count= new int(1);
+    _count= new std::atomic<int>(1);
   }
   _data->reserve(s); 
 }
@@ -1984,7 +2027,7 @@ T& RefArr<T>::operator[] (int i)
 }
 
 template <typename T>
-RefArr<T>  RefArr<T>::operator+= (const RefArr& a) 
+RefArr<T>& RefArr<T>::operator+= (const RefArr& a) 
 {
   const char funame [] = "RefArr<T>::operator+=: ";
 
@@ -1998,7 +2041,7 @@ RefArr<T>  RefArr<T>::operator+= (const RefArr& a)
 }
 
 template <typename T>
-RefArr<T>  RefArr<T>::operator-= (const RefArr& a) 
+RefArr<T>& RefArr<T>::operator-= (const RefArr& a) 
 {
   const char funame [] = "RefArr<T>::operator-=: ";
 
@@ -2012,7 +2055,7 @@ RefArr<T>  RefArr<T>::operator-= (const RefArr& a)
 }
 
 template <typename T>
-inline RefArr<T>  RefArr<T>::operator- () 
+inline RefArr<T>& RefArr<T>::operator- () 
 {
   const char funame [] = "RefArr<T>::operator-: ";
 
@@ -2026,7 +2069,7 @@ inline RefArr<T>  RefArr<T>::operator- ()
 }
 
 template <typename T>
-inline RefArr<T>  RefArr<T>::operator=  (const T& t)  
+inline RefArr<T>& RefArr<T>::operator=  (const T& t)  
 {
   const char funame [] = "RefArr<T>::operator=: ";
 
@@ -2040,7 +2083,7 @@ inline RefArr<T>  RefArr<T>::operator=  (const T& t)
 }
 
 template <typename T>
-inline RefArr<T>  RefArr<T>::operator=  (const T* t)  
+inline RefArr<T>& RefArr<T>::operator=  (const T* t)  
 {
   const char funame [] = "RefArr<T>::operator=: ";
 
@@ -2054,7 +2097,7 @@ inline RefArr<T>  RefArr<T>::operator=  (const T* t)
 }
 
 template <typename T>
-inline RefArr<T>  RefArr<T>::operator*= (const T& t)  
+inline RefArr<T>& RefArr<T>::operator*= (const T& t)  
 {
   const char funame [] = "RefArr<T>::operator*=: ";
 
@@ -2068,7 +2111,7 @@ inline RefArr<T>  RefArr<T>::operator*= (const T& t)
 }
 
 template <typename T>
-inline RefArr<T>  RefArr<T>::operator/= (const T& t) 
+inline RefArr<T>& RefArr<T>::operator/= (const T& t) 
 { 
   const char funame [] = "RefArr<T>::operator/=: ";
 
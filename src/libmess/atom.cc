@@ -20,6 +20,8 @@
 #include <sstream>
 #include <cstdlib>
 #include <vector>
+#include <algorithm>
+#include <cmath>
 
 /************************** Atom description ****************************/
 
@@ -392,61 +394,491 @@ Permutation is_symmetric (const std::vector<Atom>& mol, const Symmetry::SpaceEle
   return Permutation(perm);
 }
 
-std::set<Permutation> identical_atoms_permutation_symmetry_group (const Lapack::SymmetricMatrix& dist, double tol) 
-{
-  const char funame [] = "identical_atoms_permutation_symmetry_group: ";
+namespace {
+  //
+  // atoms which can be images of the given atom: the same class and, within the tolerance,
+  // the same sorted distances to the atoms of each class
+  //
+  std::vector<std::vector<int> > _image_candidates (const Lapack::SymmetricMatrix& dist, const std::vector<int>& type, double tol)
+  {
+    const int size = dist.size();
+
+    int type_num = 0;
+    for(int i = 0; i < size; ++i)
+      if(type[i] >= type_num)
+	type_num = type[i] + 1;
+
+    std::vector<std::vector<double> > profile(size);
+    for(int i = 0; i < size; ++i) {
+      //
+      for(int t = 0; t < type_num; ++t) {
+	//
+	const int start = profile[i].size();
+
+	for(int j = 0; j < size; ++j)
+	  if(j != i && type[j] == t)
+	    profile[i].push_back(dist(i, j));
+
+	std::sort(profile[i].begin() + start, profile[i].end());
+      }
+    }
 
-  bool btemp;
+    std::vector<std::vector<int> > res(size);
+    for(int i = 0; i < size; ++i)
+      for(int j = 0; j < size; ++j) {
+	//
+	if(type[j] != type[i])
+	  continue;
 
-  std::set<Permutation> res;
-  if(!dist.size())
-    return res;
+	bool match = true;
+	for(int k = 0; k < profile[i].size(); ++k)
+	  if(!are_equal(profile[i][k], profile[j][k], tol)) {
+	    match = false;
+	    break;
+	  }
+
+	if(match)
+	  res[i].push_back(j);
+      }
 
-  if(dist.size() == 1) {
-    res.insert(Permutation(1));
     return res;
   }
 
-  std::vector<std::vector<int> > perm(1);
+  bool _is_distance_preserving (const Lapack::SymmetricMatrix& dist, const std::vector<int>& perm, double tol)
+  {
+    for(int i = 0; i < perm.size(); ++i)
+      for(int j = 0; j < i; ++j)
+	if(!are_equal(dist(i, j), dist(perm[i], perm[j]), tol))
+	  return false;
+
+    return true;
+  }
+
+  // the permutations should form a group: the group generated by the permutations is built
+  // from a small generating set, each permutation not yet generated becoming a new generator,
+  // so that the cost is proportional to the group order times the number of generators
+  //
+  void _check_group (const std::set<Permutation>& perm, int size, const char* funame)
+  {
+    std::vector<Permutation> gen;
+
+    std::set<Permutation> group;
+
+    group.insert(Permutation(size));
+
+    for(std::set<Permutation>::const_iterator p = perm.begin(); p != perm.end(); ++p) {
+      //
+      if(group.find(*p) != group.end())
+	continue;
+
+      gen.push_back(*p);
+
+      std::vector<Permutation> queue(group.begin(), group.end());
+
+      for(int q = 0; q < queue.size(); ++q)
+	for(int g = 0; g < gen.size(); ++g) {
+	  //
+	  Permutation x = queue[q] * gen[g];
+
+	  if(!group.insert(x).second)
+	    continue;
+
+	  if(perm.find(x) == perm.end()) {
+	    std::cerr << funame << "not a group\n";
+	    throw Error::Logic();
+	  }
+
+	  queue.push_back(x);
+	}
+    }
+
+    if(group.size() != perm.size()) {
+      std::cerr << funame << "not a group\n";
+      throw Error::Logic();
+    }
+  }
+
+  // depth-first search of the distance preserving permutations of identical atoms, or of the
+  // atoms of the same class, if the classes are given
+  //
+  class _IdenticalAtomsSearch {
+    //
+    const Lapack::SymmetricMatrix&  _dist;
+    const double                    _tol;
+    std::vector<std::vector<int> >  _cand;
+    std::vector<int>                _perm;
+    std::vector<bool>               _used;
+
+  public:
+    //
+    std::set<Permutation> res;
+
+    _IdenticalAtomsSearch (const Lapack::SymmetricMatrix& dist, double tol)
+      : _dist(dist), _tol(tol), _cand(_image_candidates(dist, std::vector<int>(dist.size()), tol)),
+	_perm(dist.size()), _used(dist.size(), false) {}
+
+    _IdenticalAtomsSearch (const Lapack::SymmetricMatrix& dist, const std::vector<int>& type, double tol)
+      : _dist(dist), _tol(tol), _cand(_image_candidates(dist, type, tol)),
+	_perm(dist.size()), _used(dist.size(), false) {}
+
+    void assign (int n)
+    {
+      if(n == _perm.size()) {
+	//
+	res.insert(Permutation(_perm, Permutation::NOCHECK));
+
+	return;
+      }
 
-  for(int n = 0; n < dist.size(); ++n) {
-    std::vector<std::vector<int> > new_perm;
-    for(int p = 0; p < perm.size(); ++p) {
-      std::set<int> used;
-      for(int i = 0; i < n; ++i)
-	used.insert(perm[p][i]);
+      for(int c = 0; c < _cand[n].size(); ++c) {
+	//
+	const int ii = _cand[n][c];
 
-      for(int ii = 0; ii < dist.size(); ++ii) {
-	if(used.find(ii) != used.end())
+	if(_used[ii])
 	  continue;
 
-	btemp = false;
+	bool match = true;
 	for(int i = 0; i < n; ++i)
-	  if(!are_equal(dist(i, n), dist(perm[p][i], ii), tol)) {
-	    btemp = true;
+	  if(!are_equal(_dist(i, n), _dist(_perm[i], ii), _tol)) {
+	    match = false;
 	    break;
 	  }
-	if(btemp)
+
+	if(!match)
 	  continue;
 
-	new_perm.push_back(perm[p]);
-	new_perm.back().push_back(ii);
+	_perm[n]  = ii;
+	_used[ii] = true;
+
+	assign(n + 1);
+
+	_used[ii] = false;
       }
     }
-    perm = new_perm;
+  };
+
+  // distance preserving permutations of the atoms of the molecule: up to three frame atoms,
+  // spanning the molecule, are mapped onto the atoms with the same distance invariants, and
+  // the images of the other atoms are predicted by the orthogonal transformation fixed by the
+  // frame and looked up in the spatial hash of the atoms; all the atoms near the predicted
+  // position are tried, the nearest first. The distances within the tolerance do not fix the
+  // orthogonal map, if the frame image is degenerate or the matching image is far from the
+  // predicted position, and then the exhaustive search is needed
+  //
+  class _PermutationSearch {
+    //
+    const Lapack::SymmetricMatrix&  _dist;
+    const std::vector<int>&         _type;
+    const double                    _tol;
+
+    std::vector<std::vector<int> >  _cand;
+
+    // atom positions relative to the geometric center
+    //
+    std::vector<D3::Vector>         _pos;
+
+    // frame atoms and the orthonormal frame they define
+    //
+    std::vector<int>                _frame;
+    std::vector<D3::Vector>         _axis;
+
+    // the other atoms
+    //
+    std::vector<int>                _rest;
+
+    // the atom coordinates in the frame
+    //
+    std::vector<D3::Vector>         _coor;
+
+    // spatial hash: atoms by cell
+    //
+    double                          _radius;
+    int                             _cell_max;
+    std::map<long, std::vector<int> > _cell;
+
+    long _cell_index (int ix, int iy, int iz) const
+    {
+      const long m = 2 * _cell_max + 3;
+
+      return ((long)(ix + _cell_max + 1) * m + (long)(iy + _cell_max + 1)) * m + (long)(iz + _cell_max + 1);
+    }
+
+    int _cell_coor (double x) const { return (int)std::floor(x / _radius); }
+
+    std::vector<int>                _perm;
+    std::vector<bool>               _used;
+    std::vector<D3::Vector>         _image_axis;
+
+    bool                            _is_degenerate;
+
+    void _assign_frame (int k);
+
+    void _complete (int k);
+
+  public:
+    //
+    std::set<Permutation> res;
+
+    _PermutationSearch (const std::vector<Atom>&, const Lapack::SymmetricMatrix&, const std::vector<int>&, double);
+
+    void run () { _assign_frame(0); }
+
+    bool is_degenerate () const { return _is_degenerate; }
+  };
+
+  _PermutationSearch::_PermutationSearch (const std::vector<Atom>& molecule, const Lapack::SymmetricMatrix& dist,
+					  const std::vector<int>& type, double tol)
+    : _dist(dist), _type(type), _tol(tol), _cand(_image_candidates(dist, type, tol)),
+      _pos(molecule.size()), _coor(molecule.size()), _perm(molecule.size()), _used(molecule.size(), false),
+      _is_degenerate(false)
+  {
+    const int size = molecule.size();
+
+    D3::Vector center(0.);
+    for(int i = 0; i < size; ++i)
+      center += molecule[i];
+    center /= (double)size;
+
+    double rmax = 0.;
+    for(int i = 0; i < size; ++i) {
+      //
+      _pos[i] = molecule[i] - center;
+
+      if(_pos[i].vlength() > rmax)
+	rmax = _pos[i].vlength();
+    }
+
+    // frame atoms: the farthest from the center, then from the line, then from the plane,
+    // if they are farther than the tolerance
+    //
+    double hmin = 0.;
+
+    for(int k = 0; k < 3; ++k) {
+      //
+      int    imax = -1;
+      double hmax = 0.;
+      D3::Vector vmax;
+
+      for(int i = 0; i < size; ++i) {
+	//
+	D3::Vector v = _pos[i];
+	for(int l = 0; l < _axis.size(); ++l)
+	  v -= _axis[l] * vdot(v, _axis[l]);
+
+	const double h = v.vlength();
+
+	if(h > hmax) {
+	  imax = i;
+	  hmax = h;
+	  vmax = v;
+	}
+      }
+
+      if(imax < 0 || (k && hmax < tol))
+	break;
+
+      vmax /= hmax;
+
+      _frame.push_back(imax);
+      _axis.push_back(vmax);
+
+      hmin = hmax;
+    }
+
+    for(int i = 0; i < size; ++i)
+      for(int l = 0; l < 3; ++l)
+	_coor[i][l] = l < _axis.size() ? vdot(_pos[i], _axis[l]) : 0.;
+
+    for(int i = 0; i < size; ++i)
+      if(std::find(_frame.begin(), _frame.end(), i) == _frame.end())
+	_rest.push_back(i);
+
+    // the position of the image predicted from the frame atom images is off by about
+    // the tolerance magnified by the ratio of the molecule size to the frame height
+    //
+    _radius = 2. * tol * (1. + 2. * rmax / std::max(hmin, tol));
+
+    _cell_max = _cell_coor(rmax) + 1;
+
+    for(int i = 0; i < size; ++i)
+      _cell[_cell_index(_cell_coor(_pos[i][0]), _cell_coor(_pos[i][1]), _cell_coor(_pos[i][2]))].push_back(i);
+
+    _image_axis.resize(_axis.size());
   }
 
-  for(int i = 0; i < perm.size(); ++i)
-    res.insert(Permutation(perm[i], Permutation::NOCHECK));
+  void _PermutationSearch::_assign_frame (int k)
+  {
+    if(k == _frame.size()) {
+      //
+      _complete(0);
 
-  // check that the result is the group
-  for(std::set<Permutation>::const_iterator i = res.begin(); i != res.end(); ++i)
-    for(std::set<Permutation>::const_iterator j = res.begin(); j != res.end(); ++j)
-      if(res.find(*i * *j) == res.end()) {
-	std::cerr << funame << "not a group\n";
-	throw Error::Logic();
+      return;
+    }
+
+    const int f = _frame[k];
+
+    for(int c = 0; c < _cand[f].size(); ++c) {
+      //
+      const int ii = _cand[f][c];
+
+      if(_used[ii])
+	continue;
+
+      bool match = true;
+      for(int l = 0; l < k; ++l)
+	if(!are_equal(_dist(_frame[l], f), _dist(_perm[_frame[l]], ii), _tol)) {
+	  match = false;
+	  break;
+	}
+
+      if(!match)
+	continue;
+
+      // image frame axis
+      //
+      D3::Vector v = _pos[ii];
+      for(int l = 0; l < k; ++l)
+	v -= _image_axis[l] * vdot(v, _image_axis[l]);
+
+      if(v.vlength() < _tol) {
+	_is_degenerate = true;
+	continue;
       }
 
+      v /= v.vlength();
+
+      _image_axis[k] = v;
+
+      _perm[f]  = ii;
+      _used[ii] = true;
+
+      _assign_frame(k + 1);
+
+      _used[ii] = false;
+    }
+  }
+
+  void _PermutationSearch::_complete (int k)
+  {
+    if(k == _rest.size()) {
+      //
+      if(_is_distance_preserving(_dist, _perm, _tol))
+	//
+	res.insert(Permutation(_perm, Permutation::NOCHECK));
+
+      return;
+    }
+
+    const int i = _rest[k];
+
+    // predicted image position
+    //
+    D3::Vector p(0.);
+    for(int l = 0; l < _image_axis.size(); ++l)
+      p += _image_axis[l] * _coor[i][l];
+
+    const int cx = _cell_coor(p[0]);
+    const int cy = _cell_coor(p[1]);
+    const int cz = _cell_coor(p[2]);
+
+    // unused atoms of the same class in the neighboring cells, which keep the distances
+    // to the atoms assigned so far, ordered by the distance to the predicted position
+    //
+    std::multimap<double, int> image;
+
+    for(int ix = cx - 1; ix <= cx + 1; ++ix)
+      for(int iy = cy - 1; iy <= cy + 1; ++iy)
+	for(int iz = cz - 1; iz <= cz + 1; ++iz) {
+	  //
+	  std::map<long, std::vector<int> >::const_iterator cit = _cell.find(_cell_index(ix, iy, iz));
+
+	  if(cit == _cell.end())
+	    continue;
+
+	  for(int a = 0; a < cit->second.size(); ++a) {
+	    //
+	    const int ii = cit->second[a];
+
+	    if(_used[ii] || _type[ii] != _type[i])
+	      continue;
+
+	    const double d = vdistance(p, _pos[ii]);
+
+	    if(d > _radius)
+	      continue;
+
+	    bool match = true;
+	    for(int l = 0; l < _frame.size() && match; ++l)
+	      if(!are_equal(_dist(_frame[l], i), _dist(_perm[_frame[l]], ii), _tol))
+		match = false;
+
+	    for(int l = 0; l < k && match; ++l)
+	      if(!are_equal(_dist(_rest[l], i), _dist(_perm[_rest[l]], ii), _tol))
+		match = false;
+
+	    if(match)
+	      image.insert(std::make_pair(d, ii));
+	  }
+	}
+
+    // the atom keeping the distances away from the predicted position
+    //
+    if(image.empty())
+      for(int c = 0; c < _cand[i].size() && !_is_degenerate; ++c) {
+	//
+	const int ii = _cand[i][c];
+
+	if(_used[ii])
+	  continue;
+
+	bool match = true;
+	for(int l = 0; l < _frame.size() && match; ++l)
+	  if(!are_equal(_dist(_frame[l], i), _dist(_perm[_frame[l]], ii), _tol))
+	    match = false;
+
+	for(int l = 0; l < k && match; ++l)
+	  if(!are_equal(_dist(_rest[l], i), _dist(_perm[_rest[l]], ii), _tol))
+	    match = false;
+
+	if(match)
+	  _is_degenerate = true;
+      }
+
+    for(std::multimap<double, int>::const_iterator it = image.begin(); it != image.end(); ++it) {
+      //
+      const int ii = it->second;
+
+      _perm[i]  = ii;
+      _used[ii] = true;
+
+      _complete(k + 1);
+
+      _used[ii] = false;
+    }
+  }
+}
+
+std::set<Permutation> identical_atoms_permutation_symmetry_group (const Lapack::SymmetricMatrix& dist, double tol) 
+{
+  const char funame [] = "identical_atoms_permutation_symmetry_group: ";
+
+  std::set<Permutation> res;
+  if(!dist.size())
+    return res;
+
+  if(dist.size() == 1) {
+    res.insert(Permutation(1));
+    return res;
+  }
+
+  _IdenticalAtomsSearch search(dist, tol);
+
+  search.assign(0);
+
+  res = search.res;
+
+  _check_group(res, dist.size(), funame);
+
   return res;
 }
 
@@ -454,10 +886,6 @@ std::set<Permutation> permutation_symmetry_group (const std::vector<Atom>& molec
 {
   const char funame [] = "permutation_symmetry_group: ";
   
-  int    itemp;
-  double dtemp;
-  bool   btemp;
-
   if(tolerance <= 0. || tolerance >= 1.) {
     std::cerr << funame << "tolerance out of range\n";
     throw Error::Range();
@@ -482,75 +910,51 @@ std::set<Permutation> permutation_symmetry_group (const std::vector<Atom>& molec
     for(int j = 0; j < i; ++j)
       dist(i, j) = vdistance(molecule[i], molecule[j]);
 
-  // identical atoms groups
-  std::vector<std::vector<int> > atom_group;
+  // identical atoms classes
+  std::vector<int> type(molecule.size());
   if(flags & IGNORE_ISOTOPE) {
-    std::map<int, std::vector<int> > ag;
-    for(int i = 0; i < molecule.size(); ++i)
-      ag[molecule[i].number()].push_back(i);
-
-    for(std::map<int, std::vector<int> >::const_iterator it = ag.begin(); it != ag.end(); ++it)
-      atom_group.push_back(it->second);
+    std::map<int, int> ag;
+    for(int i = 0; i < molecule.size(); ++i) {
+      std::map<int, int>::const_iterator it = ag.find(molecule[i].number());
+      if(it == ag.end()) {
+	type[i] = ag.size();
+	ag[molecule[i].number()] = type[i];
+      }
+      else
+	type[i] = it->second;
+    }
   }
   else {
-    std::map<AtomBase, std::vector<int> > ag;
-    for(int i = 0; i < molecule.size(); ++i)
-      ag[molecule[i]].push_back(i);
-    
-    for(std::map<AtomBase, std::vector<int> >::const_iterator it = ag.begin(); it != ag.end(); ++it)
-      atom_group.push_back(it->second);
+    std::map<AtomBase, int> ag;
+    for(int i = 0; i < molecule.size(); ++i) {
+      std::map<AtomBase, int>::const_iterator it = ag.find(molecule[i]);
+      if(it == ag.end()) {
+	type[i] = ag.size();
+	ag[molecule[i]] = type[i];
+      }
+      else
+	type[i] = it->second;
+    }
   }
 
-  // identical atoms permutation symmetry groups
-  std::vector<std::set<Permutation> > atom_group_perm(atom_group.size());
-  for(int g = 0; g < atom_group.size(); ++g) {
-    Lapack::SymmetricMatrix group_dist(atom_group[g].size());
-    for(int i = 0; i < atom_group[g].size(); ++i)
-      for(int j = 0; j < i; ++j)
-	group_dist(i, j) = dist(atom_group[g][i], atom_group[g][j]);
-    
-    atom_group_perm[g] = identical_atoms_permutation_symmetry_group(group_dist, tolerance);
-  }
+  _PermutationSearch search(molecule, dist, type, tolerance);
 
-  // all atoms permutation symmetry group
-  std::vector<std::vector<Permutation> > perm(1);
-  for(int g = 0; g < atom_group.size(); ++g) {
-    std::vector<std::vector<Permutation> > new_perm;
-    for(int p = 0; p < perm.size(); ++p)
-      for(std::set<Permutation>::const_iterator q = atom_group_perm[g].begin(); q != atom_group_perm[g].end(); ++q) {
-	btemp = false;
-	for(int i = 0; i < atom_group[g].size(); ++i)
-	  for(int f = 0; f < g; ++f)
-	    for(int j = 0; j < atom_group[f].size(); ++j)
-	      if(!are_equal(dist(atom_group[f][j], atom_group[g][i]), dist(atom_group[f][perm[p][f][j]],atom_group[g][(*q)[i]]), tolerance)) {
-		btemp = true;
-		break;
-	      }
-	if(btemp)
-	  continue;
-	new_perm.push_back(perm[p]);
-	new_perm.back().push_back(*q);
-      }
-    perm = new_perm;
-  }
+  search.run();
 
-  std::set<Permutation> res;
-  for(int p = 0; p < perm.size(); ++p) {
-    std::vector<int> gp(dist.size());
-    for(int g = 0; g < atom_group.size(); ++g)
-      for(int a = 0; a < atom_group[g].size(); ++a)
-	gp[atom_group[g][a]] = atom_group[g][perm[p][g][a]];
-    
-    res.insert(Permutation(gp, Permutation::NOCHECK));
+  std::set<Permutation> res = search.res;
+
+  if(search.is_degenerate()) {
+    //
+    IO::log << IO::log_offset << funame << "WARNING: the distances do not fix the atoms images within the tolerance, exhaustive search\n";
+
+    _IdenticalAtomsSearch exhaustive(dist, type, tolerance);
+
+    exhaustive.assign(0);
+
+    res = exhaustive.res;
   }
 
-  // check that the result is the group
-  for(std::set<Permutation>::const_iterator i = res.begin(); i != res.end(); ++i)
-    for(std::set<Permutation>::const_iterator j = res.begin(); j != res.end(); ++j)
-      if(res.find(*i * *j) == res.end()) {
-	std::cerr << funame << "not a group\n";
-	throw Error::Logic();
-      }
+  _check_group(res, molecule.size(), funame);
 
   return res;
 }
@@ -592,38 +996,100 @@ std::pair<int, int> symmetry_number (const std::vector<Atom>& molecule, double t
       }
   
   bool is_plane = false;
-  int max_volume_set[3];
+  int max_volume_set[3] = {-1, -1, -1};
   double max_volume = 0.;
 
   if(molecule.size() < 4)
     is_plane = true;
   else {
-    for(int i = 1; i < molecule.size(); ++i)
-      for(int j = 1; j < i; ++j)
-	for(int k = 1; k < j; ++k) { 
-	  dtemp = D3::volume(molecule[i] - molecule[0], molecule[j] - molecule[0], molecule[k] - molecule[0])
-	    / (molecule[i] - molecule[0]).vlength() 
-	    / (molecule[j] - molecule[0]).vlength() 
-	    / (molecule[k] - molecule[0]).vlength();
+    // greedy frame: the farthest atom, the one with the largest angle to it, and the one
+    // with the largest volume; the exhaustive search only if the molecule looks planar
+    //
+    max_volume_set[0] = 1;
+    for(int i = 2; i < molecule.size(); ++i)
+      if((molecule[i] - molecule[0]).vlength() > (molecule[max_volume_set[0]] - molecule[0]).vlength())
+	max_volume_set[0] = i;
+
+    const D3::Vector r0 = molecule[max_volume_set[0]] - molecule[0];
+
+    dtemp = -1.;
+    for(int j = 1; j < molecule.size(); ++j) {
+      if(j == max_volume_set[0])
+	continue;
+
+      const D3::Vector r1 = molecule[j] - molecule[0];
+
+      const double s = D3::vprod(r0, r1).vlength() / r0.vlength() / r1.vlength();
+      if(s > dtemp) {
+	max_volume_set[1] = j;
+	dtemp = s;
+      }
+    }
 
-	  if(dtemp > max_volume) {
-	    max_volume_set[0] = i;
-	    max_volume_set[1] = j;
-	    max_volume_set[2] = k;
-	    max_volume = dtemp;
-	  }
-	  else if(dtemp < -max_volume) {
-	    max_volume_set[0] = j;
-	    max_volume_set[1] = i;
-	    max_volume_set[2] = k;
-	    max_volume = -dtemp;
+    if(max_volume_set[1] < 0) {
+      std::cerr << funame << "second frame atom not found\n";
+      throw Error::Logic();
+    }
+
+    const D3::Vector r1 = molecule[max_volume_set[1]] - molecule[0];
+
+    for(int k = 1; k < molecule.size(); ++k) {
+      if(k == max_volume_set[0] || k == max_volume_set[1])
+	continue;
+
+      const D3::Vector r2 = molecule[k] - molecule[0];
+
+      dtemp = D3::volume(r0, r1, r2) / r0.vlength() / r1.vlength() / r2.vlength();
+
+      if(dtemp > max_volume) {
+	max_volume_set[2] = k;
+	max_volume = dtemp;
+      }
+      else if(dtemp < -max_volume) {
+	max_volume_set[2] = k;
+	max_volume = -dtemp;
+      }
+    }
+
+    // orientation
+    //
+    if(max_volume > 0. && D3::volume(r0, r1, molecule[max_volume_set[2]] - molecule[0]) < 0.)
+      std::swap(max_volume_set[0], max_volume_set[1]);
+
+    if(max_volume < tolerance)
+      for(int i = 1; i < molecule.size(); ++i)
+	for(int j = 1; j < i; ++j)
+	  for(int k = 1; k < j; ++k) { 
+	    dtemp = D3::volume(molecule[i] - molecule[0], molecule[j] - molecule[0], molecule[k] - molecule[0])
+	      / (molecule[i] - molecule[0]).vlength() 
+	      / (molecule[j] - molecule[0]).vlength() 
+	      / (molecule[k] - molecule[0]).vlength();
+
+	    if(dtemp > max_volume) {
+	      max_volume_set[0] = i;
+	      max_volume_set[1] = j;
+	      max_volume_set[2] = k;
+	      max_volume = dtemp;
+	    }
+	    else if(dtemp < -max_volume) {
+	      max_volume_set[0] = j;
+	      max_volume_set[1] = i;
+	      max_volume_set[2] = k;
+	      max_volume = -dtemp;
+	    }
 	  }
-	}
 
     if(max_volume < tolerance)
       is_plane = true;
   }
 
+  if(!is_plane)
+    for(int i = 0; i < 3; ++i)
+      if(max_volume_set[i] < 0) {
+	std::cerr << funame << "frame atoms not found\n";
+	throw Error::Logic();
+      }
+
   std::set<Permutation> symm_group = permutation_symmetry_group(molecule, tolerance, flags);
 
   if(is_plane)
@@ -0,0 +1,397 @@
+/*
+        Chemical Kinetics and Dynamics Library
+        Copyright (C) 2008-2013, Yuri Georgievski <ygeorgi@anl.gov>
+
+        This library is free software; you can redistribute it and/or
+        modify it under the terms of the GNU Library General Public
+        License as published by the Free Software Foundation; either
+        version 2 of the License, or (at your option) any later version.
+
+        This library is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+        Library General Public License for more details.
+*/
+
+#include "convolution.hh"
+
+#include <cmath>
+#include <complex>
+#include <vector>
+#include <iostream>
+
+namespace Convolution {
+  //
+  int    method        = AUTO;
+
+  double fft_work_min  = 1.e7;
+
+  double fft_precision = 1.e-6;
+
+  // in-place radix-2 complex fourier transform, the size should be a power of two;
+  // sign = -1 - forward transform, sign = 1 - backward transform without normalization
+  //
+  void _fft (std::vector<std::complex<double> >& a, int sign);
+
+  // FFT work estimate
+  //
+  double _fft_work (int size);
+
+  // FFT size
+  //
+  int _fft_size (int size);
+}
+
+int Convolution::_fft_size (int size)
+{
+  int res = 1;
+
+  while(res < size)
+    //
+    res <<= 1;
+
+  return res;
+}
+
+double Convolution::_fft_work (int size)
+{
+  const int n = _fft_size(size);
+
+  return 50. * (double)n * std::log((double)n) / std::log(2.);
+}
+
+void Convolution::_fft (std::vector<std::complex<double> >& a, int sign)
+{
+  const int n = a.size();
+
+  // bit-reversal permutation
+  //
+  for(int i = 1, j = 0; i < n; ++i) {
+    //
+    int bit = n >> 1;
+
+    for(; j & bit; bit >>= 1)
+      //
+      j ^= bit;
+
+    j ^= bit;
+
+    if(i < j)
+      //
+      std::swap(a[i], a[j]);
+  }
+
+  // twiddle factors are evaluated directly: the recursive evaluation accumulates the error
+  //
+  std::vector<std::complex<double> > w(n / 2);
+
+  for(int j = 0; j < n / 2; ++j) {
+    //
+    const double ang = (double)sign * 2. * M_PI * (double)j / (double)n;
+
+    w[j] = std::complex<double>(std::cos(ang), std::sin(ang));
+  }
+
+  // butterflies
+  //
+  for(int len = 2; len <= n; len <<= 1) {
+    //
+    const int step = n / len;
+
+    for(int i = 0; i < n; i += len) {
+      //
+      for(int j = 0; j < len / 2; ++j) {
+	//
+	const std::complex<double> u = a[i + j];
+	const std::complex<double> v = a[i + j + len / 2] * w[j * step];
+
+	a[i + j]           = u + v;
+	a[i + j + len / 2] = u - v;
+      }
+    }
+  }
+}
+
+void Convolution::direct (Array<double>& res, const Array<double>& stat, const Array<double>& kernel)
+{
+  const int size = stat.size();
+
+  const int kmax = kernel.size() < size ? kernel.size() : size;
+
+  res.resize(size);
+
+  const double* sp = stat;
+  const double* kp = kernel;
+  double*       rp = res;
+
+#pragma omp parallel for default(shared) schedule(dynamic, 16)
+
+  for(int i = 0; i < size; ++i) {
+    //
+    const int kend = i < kmax ? i + 1 : kmax;
+
+    double dtemp = 0.;
+
+    for(int k = 0; k < kend; ++k)
+      //
+      dtemp += kp[k] * sp[i - k];
+
+    rp[i] = dtemp;
+  }
+}
+
+void Convolution::fft (Array<double>& res, const Array<double>& stat, const Array<double>& kernel)
+{
+  const int size = stat.size();
+
+  const int kmax = kernel.size() < size ? kernel.size() : size;
+
+  res.resize(size);
+
+  if(!size)
+    //
+    return;
+
+  const double* sp = stat;
+  const double* kp = kernel;
+  double*       rp = res;
+
+  // exponential tilt making the number of states growing with energy flat
+  //
+  int start = 0;
+  while(start < size && sp[start] == 0.)
+    //
+    ++start;
+
+  double alpha = 0.;
+
+  if(start < size - 1 && sp[size - 1] != 0.) {
+    //
+    alpha = std::log(std::fabs(sp[size - 1] / sp[start])) / double(size - 1 - start);
+
+    if(alpha < 0.)
+      //
+      alpha = 0.;
+  }
+
+  // both real sequences are transformed at once; the kernel is scaled to the magnitude
+  // of the states, otherwise the smaller one is lost in the packed transform
+  //
+  const int n = _fft_size(size + kmax - 1);
+
+  std::vector<std::complex<double> > z(n);
+
+  double smax = 0., kmag = 0.;
+
+  for(int i = 0; i < size; ++i) {
+    //
+    z[i].real(sp[i] * std::exp(-alpha * double(i)));
+
+    if(std::fabs(z[i].real()) > smax)
+      //
+      smax = std::fabs(z[i].real());
+  }
+
+  for(int k = 0; k < kmax; ++k) {
+    //
+    z[k].imag(kp[k] * std::exp(-alpha * double(k)));
+
+    if(std::fabs(z[k].imag()) > kmag)
+      //
+      kmag = std::fabs(z[k].imag());
+  }
+
+  const double kscale = kmag > 0. && smax > 0. ? smax / kmag : 1.;
+
+  for(int k = 0; k < kmax; ++k)
+    //
+    z[k].imag(z[k].imag() * kscale);
+
+  _fft(z, -1);
+
+  std::vector<std::complex<double> > p(n);
+
+  for(int k = 0; k < n; ++k) {
+    //
+    const std::complex<double> zc = std::conj(z[(n - k) % n]);
+
+    p[k] = (z[k] + zc) * (z[k] - zc) * std::complex<double>(0., -0.25);
+  }
+
+  _fft(p, 1);
+
+  double rmax = 0.;
+
+  for(int i = 0; i < size; ++i) {
+    //
+    const double dtemp = p[i].real() / double(n) / kscale;
+
+    if(std::fabs(dtemp) > rmax)
+      //
+      rmax = std::fabs(dtemp);
+
+    rp[i] = dtemp;
+  }
+
+  // small values are recalculated directly
+  //
+#pragma omp parallel for default(shared) schedule(dynamic, 16)
+
+  for(int i = 0; i < size; ++i) {
+    //
+    if(std::fabs(rp[i]) >= fft_precision * rmax) {
+      //
+      rp[i] *= std::exp(alpha * double(i));
+
+      continue;
+    }
+
+    const int kend = i < kmax ? i + 1 : kmax;
+
+    double dtemp = 0.;
+
+    for(int k = 0; k < kend; ++k)
+      //
+      dtemp += kp[k] * sp[i - k];
+
+    rp[i] = dtemp;
+  }
+}
+
+void Convolution::dense (Array<double>& stat, const Array<double>& kernel)
+{
+  const char funame [] = "Convolution::dense: ";
+
+  const int size = stat.size();
+
+  const int kmax = kernel.size() < size ? kernel.size() : size;
+
+  const double work = (double)size * (double)kmax;
+
+  Array<double> res;
+
+  switch(method) {
+  case AUTO:
+    //
+    if(work > fft_work_min && work > _fft_work(size + kmax - 1)) {
+      //
+      fft(res, stat, kernel);
+    }
+    else
+      //
+      direct(res, stat, kernel);
+
+    break;
+  case DIRECT:
+    //
+    direct(res, stat, kernel);
+
+    break;
+  case FFT:
+    //
+    fft(res, stat, kernel);
+
+    break;
+  default:
+    //
+    std::cerr << funame << "unknown method: " << method << "\n";
+
+    throw Error::Logic();
+  }
+
+  stat = res;
+}
+
+void Convolution::sparse (Array<double>& stat, const std::map<int, double>& kernel)
+{
+  const char funame [] = "Convolution::sparse: ";
+
+  const int size = stat.size();
+
+  std::vector<std::pair<int, double> > shift;
+
+  for(std::map<int, double>::const_iterator it = kernel.begin(); it != kernel.end(); ++it) {
+    //
+    if(it->first < 0) {
+      //
+      std::cerr << funame << "negative shift: " << it->first << "\n";
+
+      throw Error::Range();
+    }
+
+    if(it->first < size)
+      //
+      shift.push_back(*it);
+  }
+
+  if(!shift.size()) {
+    //
+    stat = 0.;
+
+    return;
+  }
+
+  const int kmax = shift.back().first + 1;
+
+  const double work = (double)size * (double)shift.size();
+
+  if(method == FFT || (method == AUTO && work > fft_work_min && work > _fft_work(size + kmax - 1))) {
+    //
+    Array<double> dense_kernel(kmax, 0.);
+
+    for(int s = 0; s < shift.size(); ++s)
+      //
+      dense_kernel[shift[s].first] = shift[s].second;
+
+    Array<double> res;
+
+    fft(res, stat, dense_kernel);
+
+    stat = res;
+
+    return;
+  }
+
+  Array<double> res(size);
+
+  const double* sp = stat;
+  double*       rp = res;
+
+#pragma omp parallel for default(shared) schedule(static)
+
+  for(int i = 0; i < size; ++i) {
+    //
+    double dtemp = 0.;
+
+    for(int s = 0; s < shift.size(); ++s) {
+      //
+      if(shift[s].first > i)
+	//
+	break;
+
+      dtemp += shift[s].second * sp[i - shift[s].first];
+    }
+
+    rp[i] = dtemp;
+  }
+
+  stat = res;
+}
+
+void Convolution::harmonic (Array<double>& stat, int quantum)
+{
+  const char funame [] = "Convolution::harmonic: ";
+
+  if(quantum < 0) {
+    //
+    std::cerr << funame << "negative quantum: " << quantum << "\n";
+
+    throw Error::Range();
+  }
+
+  double* sp = stat;
+
+  for(int i = quantum; i < stat.size(); ++i)
+    //
+    sp[i] += sp[i - quantum];
+}
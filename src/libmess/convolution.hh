@@ -0,0 +1,71 @@
+/*
+        Chemical Kinetics and Dynamics Library
+        Copyright (C) 2008-2013, Yuri Georgievski <ygeorgi@anl.gov>
+
+        This library is free software; you can redistribute it and/or
+        modify it under the terms of the GNU Library General Public
+        License as published by the Free Software Foundation; either
+        version 2 of the License, or (at your option) any later version.
+
+        This library is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+        Library General Public License for more details.
+*/
+
+#ifndef CONVOLUTION_HH
+#define CONVOLUTION_HH
+
+#include <map>
+
+#include "error.hh"
+#include "array.hh"
+
+/********************************************************************************************
+ * Convolution of the density/number of states on the uniform energy grid with the kernel
+ * given on the same grid:
+ *
+ *                    stat[i] <- sum_{k <= i} kernel[k] * stat[i - k],
+ *
+ * the result is truncated to the original grid size.
+ ********************************************************************************************/
+
+namespace Convolution {
+
+  // convolution algorithm
+  //
+  enum {AUTO, DIRECT, FFT};
+
+  extern int method;
+
+  // in the automatic mode the FFT is used if the direct convolution work, the grid size times
+  // the kernel size, exceeds the threshold and the FFT work estimate
+  //
+  extern double fft_work_min;
+
+  // relative magnitude below which the FFT result is recalculated directly; the FFT error is
+  // relative to the maximal (exponentially tilted) result and not to the result itself
+  //
+  extern double fft_precision;
+
+  // dense kernel
+  //
+  void dense  (Array<double>& stat, const Array<double>& kernel) ;
+
+  // sparse kernel: grid shift to weight map
+  //
+  void sparse (Array<double>& stat, const std::map<int, double>& kernel) ;
+
+  // Beyer-Swinehart algorithm: convolution with the harmonic oscillator states,
+  // kernel[k] = 1 for k = n * quantum, n = 0, 1, ...
+  //
+  void harmonic (Array<double>& stat, int quantum) ;
+
+  // implementations
+  //
+  void direct (Array<double>& res, const Array<double>& stat, const Array<double>& kernel);
+
+  void fft    (Array<double>& res, const Array<double>& stat, const Array<double>& kernel);
+}
+
+#endif
@@ -22,6 +22,7 @@
 #include <iomanip>
 #include <cmath>
 #include <set>
+#include <exception>
 
 namespace CrossRate {
 
@@ -47,6 +48,9 @@ namespace CrossRate {
   int    MultiArray::min_pot_size;
   // maximum number of facet samplings
   int    MultiArray::max_pot_size;
+  // maximum number of surface samplings run in parallel
+  int    MultiArray::smp_batch_size;
+  int    MultiArray::traj_batch_size;
 
   // tolerances
   double MultiArray::face_rel_tol;  // facet   statistical flux relative tolerance
@@ -117,7 +121,7 @@ void CrossRate::init (std::istream& from)
     std::map<std::string, Read>::iterator idit;
 
     double trt;
-    std::string calc_mode, job_type;
+    std::string calc_mode, job_type, traj_method;
     input ["JobType"                    ] = Read(job_type, "dynamical");
     input ["CalculationMode"            ] = Read(calc_mode, "canonical");
     input ["Reactant"                   ] = Read(_reactant, -1);
@@ -129,12 +133,15 @@ void CrossRate::init (std::istream& from)
     input ["MaxImportanceSamplingNumber"] = Read(MultiArray::max_imp_size, 10000);
     input ["MinPotentialSamplingNumber" ] = Read(MultiArray::min_pot_size, 100);
     input ["MaxPotentialSamplingNumber" ] = Read(MultiArray::max_pot_size, 1000000);
+    input ["SamplingBatchSize"          ] = Read(MultiArray::smp_batch_size, 256);
     input ["FacetStatisticalTolerance"  ] = Read(MultiArray::face_rel_tol, 0.1);
     input ["SpeciesStatisticalTolerance"] = Read(MultiArray::spec_rel_tol, 0.1);
     input ["SpeciesReactiveTolerance"   ] = Read(MultiArray::reac_rel_tol, 0.1);
     input ["ReactiveTransitionTolerance"] = Read(MultiArray::tran_rel_tol, 0.1);
     input ["ReactiveTransition"         ] = Read(MultiArray::reactive_transition, std::vector<int>());
     input ["TrajectRelativeTolerance"   ] = Read(trt, 1.e-5);
+    input ["TrajectIntegrator"          ] = Read(traj_method, "runge-kutta");
+    input ["TrajectBatchSize"           ] = Read(MultiArray::traj_batch_size, 64);
     input ["RandomPotentialErrorFlag"   ] = Read(rand_pot_err_flag, 0);
     input ["RadialEnergyFlag"           ] = Read(raden_flag, 0);
     input ["RadialEnergyFile"           ] = Read(raden_file, "raden.out");
@@ -191,6 +198,21 @@ void CrossRate::init (std::istream& from)
       throw Error::Init();
     }
     
+    if(traj_method == "runge-kutta")
+      Trajectory::Propagator::method = Ode::RUNGE_KUTTA;
+    else if(traj_method == "adams")
+      Trajectory::Propagator::method = Ode::ADAMS;
+    else {
+      std::cerr << funame << "unknown trajectory integrator: " << traj_method
+		<< "; possible integrators: runge-kutta and adams\n";
+      throw Error::Init();
+    }
+
+    if(MultiArray::traj_batch_size <= 0) {
+      std::cerr << funame << "trajectory batch size should be positive\n";
+      throw Error::Init();
+    }
+
     if(calc_mode == "canonical")
       _mode = T_MODE;
     else if(calc_mode == "microcanonical")
@@ -287,7 +309,7 @@ void CrossRate::init (std::istream& from)
 
 
 CrossRate::DynSmp::DynSmp (Potential::Wrap pot, const DivSur::MultiSur& surface, int prim, const Dynamic::Coordinates& dc)
-  : Dynamic::Vars(dc)
+  : Dynamic::Vars(dc), _leg(0), _leg_res(0), _leg_spec(-1)
 {
   const char funame [] = "CrossRate::DynSmp::DynSmp: ";
   
@@ -338,211 +360,176 @@ CrossRate::DynSmp::DynSmp (Potential::Wrap pot, const DivSur::MultiSur& surface,
 // propagate trajectory both forward and backward
 void CrossRate::DynSmp::run_traj (const DivSur::MultiSur& ms, const DivSur::face_t& face, Dynamic::CCP stop)
 {
-  const char funame [] = "CrossRate::DynSmp::run_traj: ";
+  Dynamic::CCP leg_stop;
 
-  if(!isinit()) {
-    std::cerr << funame << "crossrate environment has not yet been initialized\n";
-    throw Error::Init();
-  }
+  while(DynRes* leg = next_leg(ms, face, stop, leg_stop))
+    leg_done(leg->run(leg_stop, ms));
+}
 
-  if(is_run()) {
-    std::cerr << funame << "trajectory has been run already\n";
-    throw Error::Init();
-  }
+CrossRate::DynRes* CrossRate::DynSmp::next_leg (const DivSur::MultiSur& ms, const DivSur::face_t& face, 
+						Dynamic::CCP stop, Dynamic::CCP& leg_stop)
+{
+  const char funame [] = "CrossRate::DynSmp::next_leg: ";
 
-  if(reactant() >= 0 && face.first != reactant() && face.second != reactant())
-    return;
+  if(_leg < 0)
+    return 0;
 
   int    itemp;
   double dtemp;
 
-  back->rel_tol = traj_rel_tol;
-  back->abs_tol = traj_abs_tol;
-  forw->rel_tol = traj_rel_tol;
-  forw->abs_tol = traj_abs_tol;
-  if(temperature() < 0.) {
-    dtemp = std::sqrt(energy_value() - potential_energy());
-    for(int i = 0; i < 3; ++i) {
-      itemp = Structure::pos_size() + Structure::orb_vel() + i;
-      back->abs_tol[itemp] *= dtemp / Structure::mass_sqrt();
-      forw->abs_tol[itemp] *= dtemp / Structure::mass_sqrt();
+  if(!_leg) {
+    if(!isinit()) {
+      std::cerr << funame << "crossrate environment has not yet been initialized\n";
+      throw Error::Init();
     }
-  
-    for(int frag = 0; frag < 2; ++frag)
-      for(int i = 0; i < Structure::fragment(frag).vel_size(); ++i) {
-	itemp = Structure::pos_size() + Structure::ang_vel(frag) + i;
-	back->abs_tol[itemp] *= dtemp / Structure::fragment(frag).imom_sqrt(i);
-	forw->abs_tol[itemp] *= dtemp / Structure::fragment(frag).imom_sqrt(i);
-      }
-  }
 
-  if(reactant() >= 0) {
-    if(reactant() == face.first){
-      try {
-	back->run(stop | Dynamic::negate(Dynamic::CCP(new SpecCondition(ms, face.first))), ms);
+    if(is_run()) {
+      std::cerr << funame << "trajectory has been run already\n";
+      throw Error::Init();
+    }
 
-	if(back->species() == face.first)
-	  back->stat = DynRes::DIRECT;
-	else {
-	  back->stat = DynRes::RECROSS;
-	  return;
-	}
-      }
-      catch(Trajectory::PotentialFailure) {
-	back->stat =  DynRes::POT_FAIL;
-	return;
-      }
-      catch(Trajectory::RunFailure) {
-	back->stat =  DynRes::RUN_FAIL;
-	return;
-      }
-      catch(Trajectory::ExcludeRegionHit) {
-	back->stat =  DynRes::EXCLUDE;
-	return;
-      }
+    if(reactant() >= 0 && face.first != reactant() && face.second != reactant()) {
+      _leg = -1;
+      return 0;
+    }
 
-      try {
-	forw->run(stop, ms);
-	forw->stat = DynRes::PASS;
-      }
-      catch(Trajectory::PotentialFailure) {
-	forw->stat =  DynRes::POT_FAIL;
-	return;
-      }
-      catch(Trajectory::RunFailure) {
-	forw->stat =  DynRes::RUN_FAIL;
-	return;
-      }
-      catch(Trajectory::ExcludeRegionHit) {
-	forw->stat =  DynRes::EXCLUDE;
-	return;
+    back->rel_tol = traj_rel_tol;
+    back->abs_tol = traj_abs_tol;
+    forw->rel_tol = traj_rel_tol;
+    forw->abs_tol = traj_abs_tol;
+    if(temperature() < 0.) {
+      dtemp = std::sqrt(energy_value() - potential_energy());
+      for(int i = 0; i < 3; ++i) {
+	itemp = Structure::pos_size() + Structure::orb_vel() + i;
+	back->abs_tol[itemp] *= dtemp / Structure::mass_sqrt();
+	forw->abs_tol[itemp] *= dtemp / Structure::mass_sqrt();
       }
+  
+      for(int frag = 0; frag < 2; ++frag)
+	for(int i = 0; i < Structure::fragment(frag).vel_size(); ++i) {
+	  itemp = Structure::pos_size() + Structure::ang_vel(frag) + i;
+	  back->abs_tol[itemp] *= dtemp / Structure::fragment(frag).imom_sqrt(i);
+	  forw->abs_tol[itemp] *= dtemp / Structure::fragment(frag).imom_sqrt(i);
+	}
     }
-    else if(reactant() == face.second){
-      try {
-	forw->run(stop | Dynamic::negate(Dynamic::CCP(new SpecCondition(ms, face.second))), ms);
+  }
 
-	if(forw->species() == face.second)
-	  forw->stat = DynRes::DIRECT;
-	else {
-	  forw->stat = DynRes::RECROSS;
-	  return;
-	}
-      }
-      catch(Trajectory::PotentialFailure) {
-	forw->stat =  DynRes::POT_FAIL;
-	return;
-      }
-      catch(Trajectory::RunFailure) {
-	forw->stat =  DynRes::RUN_FAIL;
-	return;
-      }
-      catch(Trajectory::ExcludeRegionHit) {
-	forw->stat =  DynRes::EXCLUDE;
-	return;
-      }
+  _leg_res  = 0;
+  _leg_spec = -1;
 
-      try {
-	back->run(stop, ms);
-	back->stat = DynRes::PASS;
-      }
-      catch(Trajectory::PotentialFailure) {
-	back->stat =  DynRes::POT_FAIL;
-	return;
-      }
-      catch(Trajectory::RunFailure) {
-	back->stat =  DynRes::RUN_FAIL;
-	return;
-      }
-      catch(Trajectory::ExcludeRegionHit) {
-	back->stat =  DynRes::EXCLUDE;
-	return;
-      }
+  if(reactant() >= 0) {
+    // the reactant side first, until the trajectory leaves the reactant, then the other side to the end
+    const bool back_first = reactant() == face.first;
+
+    switch(_leg) {
+    case 0:
+      _leg_res  = back_first ? &*back : &*forw;
+      _leg_spec = reactant();
+      break;
+    case 1:
+      _leg_res  = back_first ? &*forw : &*back;
+      break;
     }
-    return;
-  }// reactant
+  }
+  else
+    switch(_leg) {
+    case 0:
+      _leg_res  = &*back;
+      _leg_spec = face.first;
+      break;
+    case 1:
+      _leg_res  = &*forw;
+      _leg_spec = face.second;
+      break;
+    case 2:
+      // either forward and backward trajectories both recrossed or both finished
+      if(forw->stat == back->stat)
+	break;
 
-  try {
-    back->run(stop | Dynamic::negate(Dynamic::CCP(new SpecCondition(ms, face.first))), ms);
+      // run the recrossed one to the end
+      _leg_res = back->stat == DynRes::RECROSS ? &*back : &*forw;
+      break;
+    }
 
-    if(back->species() == face.first)
-      back->stat = DynRes::DIRECT;
-    else
-      back->stat = DynRes::RECROSS;
-  }
-  catch(Trajectory::PotentialFailure) {
-    back->stat =  DynRes::POT_FAIL;
-    return;
-  }
-  catch(Trajectory::RunFailure) {
-    back->stat =  DynRes::RUN_FAIL;
-    return;
-  }
-  catch(Trajectory::ExcludeRegionHit) {
-    back->stat =  DynRes::EXCLUDE;
-    return;
+  if(!_leg_res) {
+    _leg = -1;
+    return 0;
   }
 
-  try {
-    forw->run(stop | Dynamic::negate(Dynamic::CCP(new SpecCondition(ms, face.second))), ms);
+  if(_leg_spec >= 0)
+    leg_stop = stop | Dynamic::negate(Dynamic::CCP(new SpecCondition(ms, _leg_spec)));
+  else
+    leg_stop = stop;
 
-    if(forw->species() == face.second)
-      forw->stat = DynRes::DIRECT;
-    else
-      forw->stat = DynRes::RECROSS;
-  }
-  catch(Trajectory::PotentialFailure) {
-    forw->stat =  DynRes::POT_FAIL;
+  return _leg_res;
+}
+
+void CrossRate::DynSmp::leg_done (Trajectory::status_t stat)
+{
+  ++_leg;
+
+  switch(stat) {
+  case Trajectory::POTENTIAL_FAILURE:
+    _leg_res->stat = DynRes::POT_FAIL;
+    _leg = -1;
     return;
-  }
-  catch(Trajectory::RunFailure) {
-    forw->stat =  DynRes::RUN_FAIL;
+  case Trajectory::RUN_FAILURE:
+    _leg_res->stat = DynRes::RUN_FAIL;
+    _leg = -1;
     return;
-  }
-  catch(Trajectory::ExcludeRegionHit) {
-    forw->stat =  DynRes::EXCLUDE;
+  case Trajectory::EXCLUDE_REGION_HIT:
+    _leg_res->stat = DynRes::EXCLUDE;
+    _leg = -1;
     return;
+  default:
+    break;
   }
 
-  // either forward and backward trajectories both recrossed or both finished
-  if(forw->stat == back->stat)
-    return;
+  if(_leg_spec >= 0) {
+    if(_leg_res->species() == _leg_spec)
+      _leg_res->stat = DynRes::DIRECT;
+    else {
+      _leg_res->stat = DynRes::RECROSS;
 
-  // run backward to the end
-  if(back->stat == DynRes::RECROSS)
-    try {
-      back->run(stop, ms);
-    }
-    catch(Trajectory::PotentialFailure) {
-      back->stat =  DynRes::POT_FAIL;
-      return;
-    }
-    catch(Trajectory::RunFailure) {
-      back->stat =  DynRes::RUN_FAIL;
-      return;
-    }
-    catch(Trajectory::ExcludeRegionHit) {
-      back->stat =  DynRes::EXCLUDE;
-      return;
+      // the trajectory did not come from the reactant
+      if(reactant() >= 0)
+	_leg = -1;
     }
+  }
+  else if(reactant() >= 0)
+    _leg_res->stat = DynRes::PASS;
+}
 
-  // run forward to the end
-  if(forw->stat == DynRes::RECROSS)
-    try {
-      forw->run(stop, ms);
-    }
-    catch(Trajectory::PotentialFailure) {
-      forw->stat =  DynRes::POT_FAIL;
-      return;
-    }
-    catch(Trajectory::RunFailure) {
-      forw->stat =  DynRes::RUN_FAIL;
-      return;
+void CrossRate::run_traj (const DivSur::MultiSur& ms, DynSmp* const* smp, const DivSur::face_t* const* face, int size,
+			  Dynamic::CCP stop)
+{
+  std::vector<Trajectory::Propagator*> leg;
+  std::vector<Dynamic::CCP>            leg_stop;
+  std::vector<int>                     leg_smp;
+  std::vector<Trajectory::status_t>    leg_stat;
+
+  while(1) {
+    leg.clear();
+    leg_stop.clear();
+    leg_smp.clear();
+
+    for(int s = 0; s < size; ++s) {
+      Dynamic::CCP cond;
+      if(DynRes* res = smp[s]->next_leg(ms, *face[s], stop, cond)) {
+	leg.push_back(res);
+	leg_stop.push_back(cond);
+	leg_smp.push_back(s);
+      }
     }
-    catch(Trajectory::ExcludeRegionHit) {
-      forw->stat =  DynRes::EXCLUDE;
+
+    if(!leg.size())
       return;
-    }
+
+    Trajectory::run(leg, leg_stop, ms, leg_stat);
+
+    for(int l = 0; l < leg.size(); ++l)
+      smp[leg_smp[l]]->leg_done(leg_stat[l]);
+  }
 }
 
 /************************************************************************
@@ -648,91 +635,19 @@ int CrossRate::FacetArray::reac_traj_num (int dir, int spec) const
   return res;
 }
 
-// propagate trajectories for facet samplings
-void CrossRate::FacetArray::run_traj (const DivSur::MultiSur& ms, const DivSur::face_t& face, Dynamic::CCP stop)
+// facet samplings which trajectories have not been run
+void CrossRate::FacetArray::init_traj (std::vector<DynSmp*>& traj)
 {
-  const char funame [] = "CrossRate::FacetArray::run_traj: ";
-  
-  if(reactant() >= 0 && face.first != reactant() && face.second != reactant())
-    return;
-
-  if(!size())
-    return;
-
-  int new_traj_num = init_traj_num();
-  if(!new_traj_num)
-    return;
-
-#ifndef DEBUG
-
-  int new_share, old_share = 0;
-
-#endif
-
-  int count = 0;
-  for(iterator fit = begin(); fit != end(); ++fit) // sampling cycle
-    if(!fit->is_run()) {
-      fit->run_traj(ms, face, stop);
-      ++count;
-
-#ifdef DEBUG
-
-      if(!fit->is_run_fail() &&  !fit->is_pot_fail() &&  !fit->is_exclude()) {
-	IO::log << count << "-th trajectory:\n";
-	IO::log << std::setw(13) << "time/a.u."
-		  << std::setw(13) << "dist/bohr"
-		  << std::setw(13) << "ener/kcal"
-		  << std::setw(13) << "amom/a.u." << "\n";
-
-	IO::log << std::setw(13) << "0"
-		  << std::setw(13) << fit->interfragment_distance()
-		  << std::setw(13) << fit->total_energy() / Phys_const::kcal;
-
-	D3::Vector tam;
-	fit->total_angular_momentum(tam);
-	for(int i = 0; i < 3; ++i)
-	  IO::log << std::setw(13) << tam[i];
-	IO::log << "\n";
-
-	if(fit->forw->stat != DynRes::INIT) {
-	  IO::log << std::setw(13) << fit->forw->time()
-		    << std::setw(13) << fit->forw->interfragment_distance() 
-		    << std::setw(13) << fit->forw->total_energy() / Phys_const::kcal;
-
-	  fit->forw->total_angular_momentum(tam);
-	  for(int i = 0; i < 3; ++i)
-	    IO::log << std::setw(13) << tam[i];
-	  IO::log << "\n";
-	}
-
-	if(fit->back->stat != DynRes::INIT) {
-	  IO::log << std::setw(13) << fit->back->time()
-		    << std::setw(13) << fit->back->interfragment_distance() 
-		    << std::setw(13) << fit->back->total_energy() / Phys_const::kcal;
-
-	  fit->back->total_angular_momentum(tam);
-	  for(int i = 0; i < 3; ++i)
-	    IO::log << std::setw(13) << tam[i];
-	  IO::log << "\n";
-	}
-	IO::log << "\n";
-      }
-      else {
-	IO::log << "   failed\n\n";
-      }
-
-#else
-
-      new_share =(int)((double)count / (double)new_traj_num * 100.);
-      print_progress(old_share, new_share);
-
-#endif
-
-    }// sampling cycle
-
-  //IO::log << "\n";
+  for(iterator fit = begin(); fit != end(); ++fit)
+    if(!fit->is_run())
+      traj.push_back(&*fit);
+}
 
-  // checking
+// check the trajectories results for facet samplings
+void CrossRate::FacetArray::check_traj (const DivSur::face_t& face) const
+{
+  const char funame [] = "CrossRate::FacetArray::check_traj: ";
+  
   for(const_iterator fit = begin(); fit != end(); ++fit) { // sampling cycle
     if(fit->is_run_fail() || fit->is_pot_fail() || fit->is_exclude() || !fit->is_run())
       continue;
@@ -752,57 +667,59 @@ bool CrossRate::FacetArray::add_smp (Potential::Wrap pot, const DivSur::MultiSur
   const char funame [] = "CrossRate::FacetArray::add_smp: ";
 
   try {
-    DynSmp smp(pot, surface, prim, dc);
-
-    // update minimal energy
-    if(!flux_num() || smp.potential_energy() < _min_ener) {
-      _min_ener = smp.potential_energy();
-      _min_geom = dc;
-    }
+    add_smp(DynSmp(pot, surface, prim, dc));
+    return true;
+  }
+  catch(Error::General) {
+    //std::cerr << funame << "potential energy calculation failed\n";
+    ++_fail_num;
+    return false;
+  }
+}
+  
+void CrossRate::FacetArray::add_smp (const DynSmp& smp)
+{
+  // update minimal energy
+  if(!flux_num() || smp.potential_energy() < _min_ener) {
+    _min_ener = smp.potential_energy();
+    _min_geom = smp;
+  }
 
-    ++_flux_num;
+  ++_flux_num;
 
-    // zero weight sampling
-    if(smp.weight() <= 0.)
-      return true;
+  // zero weight sampling
+  if(smp.weight() <= 0.)
+    return;
 
-    // update flux
-    _flux += smp.weight();
-    _fvar += smp.weight() * smp.weight();
+  // update flux
+  _flux += smp.weight();
+  _fvar += smp.weight() * smp.weight();
 
-    // update importance samplings data
-    if(!size()) {
-      _max_weight = smp.weight();
-      push_back(smp);
-      return true;
-    }
+  // update importance samplings data
+  if(!size()) {
+    _max_weight = smp.weight();
+    push_back(smp);
+    return;
+  }
 
-    if(smp.weight() > _max_weight) {
-      // use new sampling weight as a reference weight
-      _max_weight = smp.weight();
+  if(smp.weight() > _max_weight) {
+    // use new sampling weight as a reference weight
+    _max_weight = smp.weight();
 
-      // remove all non-quallifying samplings from the
-      // importance samplings list
-      iterator it = begin();
-      while(it != end())
-	if(it->ranval() * _max_weight >= it->weight())
-	  it = erase(it);
-	else
-	  ++it;
+    // remove all non-quallifying samplings from the
+    // importance samplings list
+    iterator it = begin();
+    while(it != end())
+      if(it->ranval() * _max_weight >= it->weight())
+	it = erase(it);
+      else
+	++it;
     
-      // add sampling to the importance samplings list
-      push_back(smp);
-    }
-    else if(smp.weight() > smp.ranval() * _max_weight)
-      push_back(smp);
-
-    return true;
-  }
-  catch(Error::General) {
-    //std::cerr << funame << "potential energy calculation failed\n";
-    ++_fail_num;
-    return false;
+    // add sampling to the importance samplings list
+    push_back(smp);
   }
+  else if(smp.weight() > smp.ranval() * _max_weight)
+    push_back(smp);
 }
   
 inline int CrossRate::FacetArray::samp_num () const 
@@ -895,6 +812,8 @@ namespace IO {
 
 void CrossRate::MultiArray::run_traj (Dynamic::CCP stop) 
 {
+  const char funame [] = "CrossRate::MultiArray::run_traj: ";
+
   // check that minimal potential enery is bigger than reactive energy
   for(const_iterator mit = begin(); mit != end(); ++mit)
     for(SurArray::const_iterator sit = mit->begin(); sit != mit->end(); ++sit)
@@ -906,86 +825,275 @@ void CrossRate::MultiArray::run_traj (Dynamic::CCP stop)
 	throw Error::Run();
       }
 
+  // trajectories from all facets are run together, the facets being very different in size
+  std::vector<DynSmp*>               traj;
+  std::vector<const DivSur::face_t*> traj_face;
+
   for(iterator mit = begin(); mit != end(); ++mit) {// primitives cycle
     IO::log << "   " << mit - begin() << "-th surface:\n";
-    for(SurArray::iterator sit = mit->begin(); sit != mit->end(); ++sit)
-      if(sit->second.init_traj_num()) {// facet cycle
-	IO::log <<  "      " << sit->first << " facet:\n";
-	sit->second.run_traj(_ms, sit->first, stop);
-      }// facet cycle
+    for(SurArray::iterator sit = mit->begin(); sit != mit->end(); ++sit) {// facet cycle
+      if(reactant() >= 0 && sit->first.first != reactant() && sit->first.second != reactant())
+	continue;
+
+      if(!sit->second.init_traj_num())
+	continue;
+
+      IO::log <<  "      " << sit->first << " facet: " << sit->second.init_traj_num() << " trajectories\n";
+
+      sit->second.init_traj(traj);
+
+      traj_face.resize(traj.size(), &sit->first);
+    }// facet cycle
   }// primitives cycle
-}
 
+  if(!traj.size())
+    return;
+
+  // the trajectories are independent: each one has its own propagators, and
+  // each thread propagates a batch of them together
+  const int batch_num = (traj.size() + traj_batch_size - 1) / traj_batch_size;
+
+  std::vector<std::exception_ptr> traj_error(batch_num);
+
+  int count = 0;
+
+  int new_share, old_share = 0;
+
+#pragma omp parallel for default(shared) private(new_share) schedule(dynamic, 1)
+
+  for(int b = 0; b < batch_num; ++b) {
+    //
+    const int t = b * traj_batch_size;
+
+    const int size = std::min<int>(traj_batch_size, traj.size() - t);
+
+    try {
+      //
+      CrossRate::run_traj(_ms, &traj[t], &traj_face[t], size, stop);
+    }
+    catch(...) {
+      //
+      traj_error[b] = std::current_exception();
+    }
+
+#pragma omp critical(traj_progress)
+    {
+      count += size;
+
+      new_share = (int)((double)count / (double)traj.size() * 100.);
+
+      print_progress(old_share, new_share);
+    }
+  }
+
+  for(int b = 0; b < batch_num; ++b)
+    //
+    if(traj_error[b])
+      //
+      std::rethrow_exception(traj_error[b]);
+
+#ifdef DEBUG
+
+  for(int t = 0; t < traj.size(); ++t) {
+    DynSmp* fit = traj[t];
+
+    if(!fit->is_run_fail() &&  !fit->is_pot_fail() &&  !fit->is_exclude()) {
+      IO::log << t << "-th trajectory:\n";
+      IO::log << std::setw(13) << "time/a.u."
+	      << std::setw(13) << "dist/bohr"
+	      << std::setw(13) << "ener/kcal"
+	      << std::setw(13) << "amom/a.u." << "\n";
+
+      IO::log << std::setw(13) << "0"
+	      << std::setw(13) << fit->interfragment_distance()
+	      << std::setw(13) << fit->total_energy() / Phys_const::kcal;
+
+      D3::Vector tam;
+      fit->total_angular_momentum(tam);
+      for(int i = 0; i < 3; ++i)
+	IO::log << std::setw(13) << tam[i];
+      IO::log << "\n";
+
+      if(fit->forw->stat != DynRes::INIT) {
+	IO::log << std::setw(13) << fit->forw->time()
+		<< std::setw(13) << fit->forw->interfragment_distance() 
+		<< std::setw(13) << fit->forw->total_energy() / Phys_const::kcal;
+
+	fit->forw->total_angular_momentum(tam);
+	for(int i = 0; i < 3; ++i)
+	  IO::log << std::setw(13) << tam[i];
+	IO::log << "\n";
+      }
+
+      if(fit->back->stat != DynRes::INIT) {
+	IO::log << std::setw(13) << fit->back->time()
+		<< std::setw(13) << fit->back->interfragment_distance() 
+		<< std::setw(13) << fit->back->total_energy() / Phys_const::kcal;
+
+	fit->back->total_angular_momentum(tam);
+	for(int i = 0; i < 3; ++i)
+	  IO::log << std::setw(13) << tam[i];
+	IO::log << "\n";
+      }
+      IO::log << "\n";
+    }
+    else {
+      IO::log << "   failed\n\n";
+    }
+  }
+
+#endif
 
-int CrossRate::MultiArray::_sample (iterator mit, const std::set<DivSur::face_t >& face_work)
+  // checking
+  for(const_iterator mit = begin(); mit != end(); ++mit)
+    for(SurArray::const_iterator sit = mit->begin(); sit != mit->end(); ++sit)
+      sit->second.check_traj(sit->first);
+}
+
+int CrossRate::MultiArray::_sample (iterator mit, const std::set<DivSur::face_t >& face_work, int& size)
 {
   const char funame [] = "CrossRate::MultiArray::_sample: ";
 
   static int  imp_warn = 1;
   static int samp_warn = 1;
 
-  Dynamic::Coordinates new_conf;
+  if(size <= 0) {
+    std::cerr << funame << "wrong batch size: " << size << "\n";
+    throw Error::Logic();
+  }
+
   SurArray::iterator sit;
 
   const int sur = mit - begin();
 
-  _ms.random_orient(sur, new_conf);
-  DivSur::MultiSur::SmpRes smp_res = _ms.facet_test(sur, new_conf);
+  const SurArray& sur_array = *mit;
 
-  switch(smp_res.stat) {
-  case DivSur::MultiSur::SmpRes::CLOSE:
-    mit->add_close();
-    return 0;
-  case DivSur::MultiSur::SmpRes::EXCLUDE:
-    mit->add_excl();
-    return 0;
-  case DivSur::MultiSur::SmpRes::INNER:
-    mit->add_inner();
-    return 0;
-  case DivSur::MultiSur::SmpRes::FAIL:
-    mit->add_fail();
-    return 0;
-  case DivSur::MultiSur::SmpRes::FACET:
-    // skip non-reactant facets
-    if(reactant() >= 0 && smp_res.face.first != reactant() && smp_res.face.second != reactant()) {
-      mit->add_skip();
-      return 0;
-    }
+  std::vector<_SmpTask>           task(size);
+  std::vector<std::exception_ptr> task_error(size);
+
+  const uint64_t task_start = _task_count;
+
+  _task_count += size;
+
+  // surface samplings and potential energy calculations: each task has its own random
+  // numbers stream, so that the samplings do not depend on the number of threads
+#pragma omp parallel for default(shared) schedule(dynamic, 1)
+
+  for(int t = 0; t < size; ++t) {
+    //
+    try {
+      //
+      Random::TaskStream stream(Random::task_base + task_start + t);
+
+      _SmpTask& smp = task[t];
+
+      smp.fail = false;
+
+      _ms.random_orient(sur, smp.conf);
+
+      smp.res = _ms.facet_test(sur, smp.conf);
+
+      if(smp.res.stat != DivSur::MultiSur::SmpRes::FACET)
+	//
+	continue;
+
+      // skip non-reactant facets
+      if(reactant() >= 0 && smp.res.face.first != reactant() && smp.res.face.second != reactant())
+	//
+	continue;
+
+      SurArray::const_iterator cit = sur_array.find(smp.res.face);
 
-    sit = mit->find(smp_res.face);
-    // new facet
-    if(sit == mit->end() || !sit->second.face_num()) {
-      IO::log << "      " << sur << "-th surface: new " << smp_res.face << " facet\n";
-      (*mit)[smp_res.face].add_smp(_pot, _ms, sur, new_conf);
-      return 1;
+      // no potential calculation is needed
+      if(cit != sur_array.end() && cit->second.face_num() && face_work.find(smp.res.face) == face_work.end())
+	//
+	continue;
+
+      try {
+	//
+	smp.smp.init(new DynSmp(_pot, _ms, sur, smp.conf));
+      }
+      catch(Error::General) {
+	//
+	smp.fail = true;
+      }
     }
+    catch(...) {
+      //
+      task_error[t] = std::current_exception();
+    }
+  }
 
-    // maximum facet sampling number warning
-    if(samp_warn && sit->second.samp_num() >= max_pot_size) {
-      std::cerr << funame << sur << "-th surface, " << sit->first << " facet: "
-		<< "WARNING: maximal facet samplings number has been reached\n";
-      samp_warn = 0;
-    } 
-
-    // maximum importance sampling number warning
-    if(imp_warn && sit->second.size() >= max_imp_size) {
-      std::cerr << funame << sur << "-th surface, " << sit->first << " facet: "
-		<< "WARNING: maximal importance samplings number has been reached\n";
-      imp_warn = 0;
-    } 
-
-    // no potential calculation is needed
-    if(face_work.find(smp_res.face) == face_work.end())
-      sit->second.add_fake();
-    // add facet samping
-    else
-      sit->second.add_smp(_pot, _ms, sur, new_conf);
+  // merge the results in the samplings order
+  for(int t = 0; t < size; ++t) {
+    if(task_error[t])
+      std::rethrow_exception(task_error[t]);
 
-    return 0;
-  default:
-    std::cerr << funame << "wrong case\n";
-    throw Error::Logic();
+    const _SmpTask& smp = task[t];
+
+    switch(smp.res.stat) {
+    case DivSur::MultiSur::SmpRes::CLOSE:
+      mit->add_close();
+      continue;
+    case DivSur::MultiSur::SmpRes::EXCLUDE:
+      mit->add_excl();
+      continue;
+    case DivSur::MultiSur::SmpRes::INNER:
+      mit->add_inner();
+      continue;
+    case DivSur::MultiSur::SmpRes::FAIL:
+      mit->add_fail();
+      continue;
+    case DivSur::MultiSur::SmpRes::FACET:
+      // skip non-reactant facets
+      if(reactant() >= 0 && smp.res.face.first != reactant() && smp.res.face.second != reactant()) {
+	mit->add_skip();
+	continue;
+      }
+
+      sit = mit->find(smp.res.face);
+      // new facet
+      if(sit == mit->end() || !sit->second.face_num()) {
+	IO::log << "      " << sur << "-th surface: new " << smp.res.face << " facet\n";
+	if(smp.fail)
+	  (*mit)[smp.res.face].add_fail();
+	else
+	  (*mit)[smp.res.face].add_smp(*smp.smp);
+	size = t + 1;
+	return 1;
+      }
+
+      // maximum facet sampling number warning
+      if(samp_warn && sit->second.samp_num() >= max_pot_size) {
+	std::cerr << funame << sur << "-th surface, " << sit->first << " facet: "
+		  << "WARNING: maximal facet samplings number has been reached\n";
+	samp_warn = 0;
+      } 
+
+      // maximum importance sampling number warning
+      if(imp_warn && sit->second.size() >= max_imp_size) {
+	std::cerr << funame << sur << "-th surface, " << sit->first << " facet: "
+		  << "WARNING: maximal importance samplings number has been reached\n";
+	imp_warn = 0;
+      } 
+
+      // no potential calculation is needed
+      if(!smp.smp && !smp.fail)
+	sit->second.add_fake();
+      // add facet samping
+      else if(smp.fail)
+	sit->second.add_fail();
+      else
+	sit->second.add_smp(*smp.smp);
+
+      continue;
+    default:
+      std::cerr << funame << "wrong case\n";
+      throw Error::Logic();
+    }
   }
+
+  return 0;
 }
 
 void CrossRate::MultiArray::_get_stat_flux(std::vector<double>& flux_mean, 
@@ -1684,7 +1792,8 @@ bool CrossRate::MultiArray::_work (Dynamic::CCP stop)
       if(!face_work.size())
 	break;
 
-      if(_sample(mit, face_work))
+      itemp = count < smp_batch_size ? count : smp_batch_size;
+      if(_sample(mit, face_work, itemp))
 	return false;
     }// sampling loop
   }// surface cycle
@@ -1752,7 +1861,8 @@ bool CrossRate::MultiArray::_work (Dynamic::CCP stop)
       if(!face_work.size())
 	break;
 
-      if(_sample(mit, face_work))
+      itemp = count < smp_batch_size ? count : smp_batch_size;
+      if(_sample(mit, face_work, itemp))
 	return false;
     }// sampling loop
   }// primitive cycle
@@ -1843,7 +1953,8 @@ bool CrossRate::MultiArray::_work (Dynamic::CCP stop)
       if(!face_work.size())
 	break;
 
-      if(_sample(mit, face_work))
+      itemp = count < smp_batch_size ? count : smp_batch_size;
+      if(_sample(mit, face_work, itemp))
 	return false;
     }// sampling loop
   }// surface cycle
@@ -1906,7 +2017,8 @@ bool CrossRate::MultiArray::_work (Dynamic::CCP stop)
 	if(!face_work.size())
 	  break;
 
-	if(_sample(mit, face_work))
+	itemp = count < smp_batch_size ? count : smp_batch_size;
+	if(_sample(mit, face_work, itemp))
 	  return false;
       }// sampling loop
     }// surface cycle
@@ -2025,7 +2137,8 @@ bool CrossRate::MultiArray::_work (Dynamic::CCP stop)
 	if(!face_work.size())
 	  break;
 
-	if(_sample(mit, face_work))
+	itemp = count < smp_batch_size ? count : smp_batch_size;
+	if(_sample(mit, face_work, itemp))
 	  return false;
       }// sampling loop
     }// surface cycle
@@ -2135,7 +2248,8 @@ bool CrossRate::MultiArray::_work (Dynamic::CCP stop)
 	  if(!face_work.size())
 	    break;
 
-	  if(_sample(mit, face_work))
+	  itemp = count < smp_batch_size ? count : smp_batch_size;
+	  if(_sample(mit, face_work, itemp))
 	    return false;
 	}// sampling loop
       }// surface cycle
@@ -2164,12 +2278,14 @@ bool CrossRate::MultiArray::_work (Dynamic::CCP stop)
 } 
 
 CrossRate::MultiArray::MultiArray(const DivSur::MultiSur& ms, Potential::Wrap pot, Dynamic::CCP stop)
-   : std::vector<SurArray>(ms.primitive_size()), _ms(ms), _pot(pot)
+   : std::vector<SurArray>(ms.primitive_size()), _ms(ms), _pot(pot), _task_count(0)
 {
   const char funame [] = "CrossRate::MultiArray::MultiArray: ";
  
   static const int max_fail = 10;
 
+  int itemp;
+
   SurArray::iterator sit;
 
   // initial sampling to check which facets are actually present
@@ -2177,12 +2293,14 @@ CrossRate::MultiArray::MultiArray(const DivSur::MultiSur& ms, Potential::Wrap po
 	  << " samplings per primitive surface ...\n";
   for(iterator mit = begin(); mit != end(); ++mit) {// surface cycle
     IO::log << "   " << mit - begin() << "-th surface:\n";
-    for(int s = 0; s < min_sur_size; ++s) {// sampling loop
+    for(int s = 0; s < min_sur_size; s += itemp) {// sampling loop
 
       std::set<DivSur::face_t > face_work;
       for(sit = mit->begin(); sit != mit->end(); ++sit)
 	face_work.insert(sit->first);
-      _sample(mit, face_work);
+
+      itemp = min_sur_size - s < smp_batch_size ? min_sur_size - s : smp_batch_size;
+      _sample(mit, face_work, itemp);
     }// sampling loop
   }// surface cycle
   IO::log << "done\n\n";
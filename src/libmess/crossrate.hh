@@ -18,6 +18,8 @@
 
 #include <cmath>
 #include <list>
+#include <vector>
+#include <stdint.h>
 #include <map>
 #include <set>
 #include <sstream>
@@ -112,6 +114,11 @@ namespace CrossRate {
     double _weight;    // statitstical weight
     double _energy;    // configuration potential energy
 
+    // trajectory legs, backward or forward propagations, are run in turn
+    int     _leg;      // number of legs run; negative when the trajectory is finished
+    DynRes* _leg_res;  // current leg propagator
+    int     _leg_spec; // the species the current leg stops at leaving; negative if none
+
   public:
     DynSmp (Potential::Wrap, const DivSur::MultiSur&, int, const Dynamic::Coordinates&) ;
 
@@ -127,12 +134,22 @@ namespace CrossRate {
 
     void run_traj (const DivSur::MultiSur&, const DivSur::face_t&, Dynamic::CCP);
 
+    // the next leg propagator and its stop condition; null when the trajectory is finished
+    DynRes* next_leg (const DivSur::MultiSur&, const DivSur::face_t&, Dynamic::CCP, Dynamic::CCP&);
+
+    void    leg_done (Trajectory::status_t);
+
     bool is_run      () const;
     bool is_pot_fail () const;
     bool is_run_fail () const;
     bool is_exclude  () const;
   };
   
+  // runs the trajectories of the samplings together: the current legs of all of them are
+  // propagated as one batch
+  //
+  void run_traj (const DivSur::MultiSur&, DynSmp* const*, const DivSur::face_t* const*, int, Dynamic::CCP);
+
   inline bool DynSmp::is_run () const
   { 
     if(forw->stat == DynRes::INIT && back->stat == DynRes::INIT)
@@ -197,6 +214,8 @@ namespace CrossRate {
     const Dynamic::Coordinates& min_geom () const { return _min_geom; }
 
     void add_fake () { ++_fake_num; }
+    void add_fail () { ++_fail_num; }
+    void add_smp  (const DynSmp&);
     bool add_smp  (Potential::Wrap, const DivSur::MultiSur&, int, const Dynamic::Coordinates&);
 
     // flux value
@@ -221,7 +240,11 @@ namespace CrossRate {
     const_iterator begin () const { return std::list<DynSmp>::begin(); }
     const_iterator end   () const { return std::list<DynSmp>::end(); }
 
-    void run_traj (const DivSur::MultiSur&, const DivSur::face_t&, Dynamic::CCP);
+    // trajectories which have not been run
+    void init_traj (std::vector<DynSmp*>&);
+
+    // check the trajectories results
+    void check_traj (const DivSur::face_t&) const;
 
     int    init_traj_num ()                   const;
     int potfail_traj_num ()                   const;
@@ -346,7 +369,21 @@ namespace CrossRate {
       const DivSur::MultiSur _ms;
       Potential::Wrap _pot;
 
-    int _sample (iterator, const std::set<DivSur::face_t>&);
+    // surface sampling task
+    struct _SmpTask {
+      Dynamic::Coordinates          conf;
+      DivSur::MultiSur::SmpRes      res;
+      SharedPointer<DynSmp>         smp;  // facet sampling, if needed
+      bool                          fail; // potential failure
+    };
+
+    // number of surface samplings tasks dispatched so far: the task random number stream index
+    uint64_t _task_count;
+
+    // sample the surface in parallel in a batch of a given size and merge the results 
+    // in the samplings order; stops at the first new facet; returns the number of merged 
+    // samplings in the size argument and 1 if the new facet has been found
+    int _sample (iterator, const std::set<DivSur::face_t>&, int& size);
 
     bool _work (Dynamic::CCP) ;
 
@@ -372,6 +409,8 @@ namespace CrossRate {
     static int  max_imp_size; // maximum number of importance samplings for the facet; 
     static int  min_pot_size; // minimum number of facet samplings before the accuracy can be estimated
     static int  max_pot_size; // maximum number of facet samplings
+    static int  smp_batch_size; // maximum number of surface samplings run in parallel
+    static int traj_batch_size; // number of trajectories propagated together by one thread
 
     static double face_rel_tol;  // uniform relative tolerance for a facet statistical flux
     static double spec_rel_tol;  // relative tolerance for a species statistical flux
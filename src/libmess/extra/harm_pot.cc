@@ -1,6 +1,6 @@
 #include "harm_pot.hh"
 #include "harmonic.hh"
-#include "slatec.hh"
+#include "spline.hh"
 #include "io.hh"
 #include "structure.hh"
 
@@ -8,7 +8,7 @@
 
 EnergyConverter                       convert_energy;
 ConstSharedPointer<HarmonicExpansion> harmonic_expansion [2];
-std::vector<Slatec::Spline>           expansion_coefficient;
+std::vector<Math::Spline>           expansion_coefficient;
 
 double EnergyConverter::operator() (double ener, int back) const
 {
@@ -2,6 +2,7 @@
 #include "multindex.hh"
 #include "read.hh"
 #include "slatec.hh"
+#include "spline.hh"
 
 #include<map>
 #include<vector>
@@ -57,7 +58,7 @@ namespace LongRange {
 
   // centrifugal barrier stuff
   double _amom_min, _amom_max;
-  Slatec::Spline _barrier_log;
+  Math::Spline _barrier_log;
 
   //barrier tolerances
   double bar_ener_tol;
@@ -8,6 +8,7 @@
 #include <list>
 #include <cmath>
 #include <complex>
+#include <algorithm>
 
 namespace Graph {
 
@@ -786,6 +787,383 @@ std::set<Graph::FreqGraph> Graph::FreqGraph::perm_pool (int* symm, int flag) con
   return res;
 }
 
+/********************************************************************************************
+ * Canonical form: the vertex partition is refined to an equitable one by the neighbor color
+ * and bond frequencies, the non-singleton cells are split by individualizing their vertices
+ * (search tree), and the canonical form is the smallest relabeled graph among the leaves;
+ * the automorphisms found as the leaves equivalent to the first one prune the first path
+ * branches and give the automorphism group size by the orbit-stabilizer theorem
+ ********************************************************************************************/
+
+namespace {
+  //
+  class CanonSearch {
+    //
+    typedef Graph::FreqGraph graph_t;
+
+    const graph_t& _graph;
+
+    // original vertex labels, ordered
+    //
+    std::vector<int> _vertex;
+
+    // bond frequencies index, plus one, for the vertex pairs; zero if not connected
+    //
+    std::vector<std::vector<int> > _bond;
+
+    // first and best leaves
+    //
+    bool             _has_leaf;
+    graph_t          _first_graph;
+    std::vector<int> _first_label;
+    graph_t          _best_graph;
+    std::vector<int> _best_label;
+
+    // orbits of the automorphisms found
+    //
+    std::vector<int> _orbit;
+
+    int _find (int v) { while(_orbit[v] != v) v = _orbit[v] = _orbit[_orbit[v]]; return v; }
+
+    void _refine (std::vector<int>& color) const;
+
+    graph_t _relabel (const std::vector<int>& label) const;
+
+    bool _search (std::vector<int> color, bool is_first);
+
+  public:
+    //
+    double group_size;
+
+    explicit CanonSearch (const graph_t&);
+
+    const graph_t&          canonical_graph () const { return _best_graph; }
+
+    const std::vector<int>& canonical_label () const { return _best_label; }
+
+    const std::vector<int>& vertex          () const { return _vertex; }
+  };
+
+  CanonSearch::CanonSearch (const graph_t& g) : _graph(g), _has_leaf(false), group_size(1.)
+  {
+    std::set<int> vertex_pool;
+
+    std::set<std::multiset<int> > freq_pool;
+
+    for(graph_t::const_iterator git = g.begin(); git != g.end(); ++git) {
+      //
+      for(std::set<int>::const_iterator bit = git->first.begin(); bit != git->first.end(); ++bit)
+	//
+	vertex_pool.insert(*bit);
+
+      freq_pool.insert(git->second);
+    }
+
+    _vertex.assign(vertex_pool.begin(), vertex_pool.end());
+
+    const int vsize = _vertex.size();
+
+    std::map<int, int> vertex_index;
+
+    for(int v = 0; v < vsize; ++v)
+      //
+      vertex_index[_vertex[v]] = v;
+
+    // the bond frequencies are ordered by value, so that their indices do not depend on the labeling
+    //
+    std::map<std::multiset<int>, int> freq_index;
+
+    for(std::set<std::multiset<int> >::const_iterator fit = freq_pool.begin(); fit != freq_pool.end(); ++fit)
+      //
+      freq_index.insert(std::make_pair(*fit, (int)freq_index.size() + 1));
+
+    _bond.assign(vsize, std::vector<int>(vsize, 0));
+
+    for(graph_t::const_iterator git = g.begin(); git != g.end(); ++git) {
+      //
+      const int v1 = vertex_index[*git->first.begin()];
+      const int v2 = vertex_index[*git->first.rbegin()];
+
+      _bond[v1][v2] = _bond[v2][v1] = freq_index[git->second];
+    }
+
+    _orbit.resize(vsize);
+
+    for(int v = 0; v < vsize; ++v)
+      //
+      _orbit[v] = v;
+
+    if(!vsize)
+      //
+      return;
+
+    _search(std::vector<int>(vsize, 0), true);
+  }
+
+  // refine the ordered partition to the equitable one: the vertex new color is the rank of
+  // its old color and the sorted neighbor colors and bond frequencies
+  //
+  void CanonSearch::_refine (std::vector<int>& color) const
+  {
+    const int vsize = color.size();
+
+    int cell_size = -1;
+
+    while(1) {
+      //
+      std::vector<std::pair<std::vector<int>, int> > sig(vsize);
+
+      for(int v = 0; v < vsize; ++v) {
+	//
+	std::vector<std::pair<int, int> > nb;
+
+	for(int u = 0; u < vsize; ++u)
+	  //
+	  if(_bond[v][u])
+	    //
+	    nb.push_back(std::make_pair(color[u], _bond[v][u]));
+
+	std::sort(nb.begin(), nb.end());
+
+	sig[v].first.push_back(color[v]);
+
+	for(int i = 0; i < nb.size(); ++i) {
+	  //
+	  sig[v].first.push_back(nb[i].first);
+	  sig[v].first.push_back(nb[i].second);
+	}
+
+	sig[v].second = v;
+      }
+
+      std::sort(sig.begin(), sig.end());
+
+      int new_size = 0;
+
+      for(int i = 0; i < vsize; ++i) {
+	//
+	if(i && sig[i].first != sig[i - 1].first)
+	  //
+	  ++new_size;
+
+	color[sig[i].second] = new_size;
+      }
+
+      ++new_size;
+
+      if(new_size == cell_size)
+	//
+	return;
+
+      cell_size = new_size;
+    }
+  }
+
+  CanonSearch::graph_t CanonSearch::_relabel (const std::vector<int>& label) const
+  {
+    std::map<int, int> vertex_map;
+
+    for(int v = 0; v < _vertex.size(); ++v)
+      //
+      vertex_map[_vertex[v]] = _vertex[label[v]];
+
+    graph_t res;
+
+    for(graph_t::const_iterator git = _graph.begin(); git != _graph.end(); ++git) {
+      //
+      std::set<int> bond;
+
+      for(std::set<int>::const_iterator bit = git->first.begin(); bit != git->first.end(); ++bit)
+	//
+	bond.insert(vertex_map[*bit]);
+
+      res[bond] = git->second;
+    }
+
+    return res;
+  }
+
+  // returns true if a leaf equivalent to the first leaf has been found off the first path
+  //
+  bool CanonSearch::_search (std::vector<int> color, bool is_first)
+  {
+    const int vsize = color.size();
+
+    _refine(color);
+
+    // cell sizes
+    //
+    std::vector<int> cell(vsize, 0);
+
+    for(int v = 0; v < vsize; ++v)
+      //
+      ++cell[color[v]];
+
+    int target = -1;
+
+    for(int c = 0; c < vsize; ++c)
+      //
+      if(cell[c] > 1) {
+	//
+	target = c;
+
+	break;
+      }
+
+    // leaf: the discrete partition is the labeling
+    //
+    if(target < 0) {
+      //
+      graph_t leaf = _relabel(color);
+
+      if(!_has_leaf) {
+	//
+	_has_leaf = true;
+
+	_first_graph = _best_graph = leaf;
+
+	_first_label = _best_label = color;
+
+	return false;
+      }
+
+      // automorphism: the vertex of the first leaf goes to the vertex with the same label
+      //
+      if(leaf == _first_graph) {
+	//
+	std::vector<int> inverse(vsize);
+
+	for(int v = 0; v < vsize; ++v)
+	  //
+	  inverse[color[v]] = v;
+
+	for(int v = 0; v < vsize; ++v) {
+	  //
+	  const int o1 = _find(v);
+	  const int o2 = _find(inverse[_first_label[v]]);
+
+	  if(o1 != o2)
+	    //
+	    _orbit[o1] = o2;
+	}
+
+	return true;
+      }
+
+      if(leaf < _best_graph) {
+	//
+	_best_graph = leaf;
+
+	_best_label = color;
+      }
+
+      return false;
+    }
+
+    std::vector<int> target_cell;
+
+    for(int v = 0; v < vsize; ++v)
+      //
+      if(color[v] == target)
+	//
+	target_cell.push_back(v);
+
+    // individualized vertex goes first in its cell
+    //
+    for(int v = 0; v < vsize; ++v)
+      //
+      color[v] = 2 * color[v] + 1;
+
+    if(!is_first) {
+      //
+      for(int i = 0; i < target_cell.size(); ++i) {
+	//
+	const int v = target_cell[i];
+
+	--color[v];
+
+	if(_search(color, false))
+	  //
+	  return true;
+
+	++color[v];
+      }
+
+      return false;
+    }
+
+    // first path node: the branches in the orbits of the explored ones are skipped
+    //
+    std::vector<int> explored;
+
+    for(int i = 0; i < target_cell.size(); ++i) {
+      //
+      const int v = target_cell[i];
+
+      bool is_pruned = false;
+
+      for(int j = 0; j < explored.size(); ++j)
+	//
+	if(_find(v) == _find(explored[j])) {
+	  //
+	  is_pruned = true;
+
+	  break;
+	}
+
+      if(is_pruned)
+	//
+	continue;
+
+      --color[v];
+
+      _search(color, !i);
+
+      ++color[v];
+
+      explored.push_back(v);
+    }
+
+    // orbit of the first path vertex under the stabilizer of the node
+    //
+    int orbit_size = 0;
+
+    for(int i = 0; i < target_cell.size(); ++i)
+      //
+      if(_find(target_cell[i]) == _find(target_cell[0]))
+	//
+	++orbit_size;
+
+    group_size *= (double)orbit_size;
+
+    return false;
+  }
+}
+
+Graph::FreqGraph Graph::FreqGraph::canonical_form (int* symm, std::map<int, int>* label) const
+{
+  const char funame [] = "Graph::FreqGraph::canonical_form: ";
+
+  _check_integrity();
+
+  CanonSearch search(*this);
+
+  if(symm)
+    //
+    *symm = size() ? (int)search.group_size : 0;
+
+  if(label) {
+    //
+    label->clear();
+
+    for(int v = 0; v < search.vertex().size(); ++v)
+      //
+      (*label)[search.vertex()[v]] = search.vertex()[search.canonical_label()[v]];
+  }
+
+  return search.canonical_graph();
+}
+
 void Graph::FreqGraph::_check_order () const
 {
   const char funame [] = "Graph::FreqGraph::_check_order: ";
@@ -135,6 +135,11 @@ namespace Graph {
     //
     std::set<FreqGraph> perm_pool   (int* =0, int =0) const;
 
+    // canonical representative of the permutationally equivalent graphs, the automorphism
+    // group size, and the vertex map to the canonical graph, without the pool enumeration
+    //
+    FreqGraph canonical_form (int* symm =0, std::map<int, int>* label =0) const;
+
     // reduce graph with strongly coupled vertices
     //
     FreqGraph reduce (const std::vector<double>& freq,
@@ -4,8 +4,15 @@
 #include "permutation.hh"
 #include "multindex.hh"
 #include "units.hh"
+#include "system.hh"
 
 #include <cmath>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
 
 // different modification flags
 //
@@ -88,6 +95,8 @@ std::map<int, double> Graph::Expansion::correction (double temperature) const
   _gmap_t sum_data;
   _gmap_t zpe_data;
 
+  _load_store(CORRECTION, temperature, zpe_data, int_data, sum_data);
+
   std::map<int, double> corr;
 
 #ifndef INNER_CYCLE_PARALLEL
@@ -231,30 +240,17 @@ std::map<int, double> Graph::Expansion::correction (double temperature) const
 	  //
 	  _Convert::vec_t mod_graph_conv;
 
-	  if(mod_flag & KEEP_PERM) {
-	    //
-	    mod_graph_conv = _convert(mod_graph);
-	  }
-	  else {
-	    //
-	    mod_graph_conv = _convert(*mod_graph.perm_pool().begin());
-	  }
+	  mod_graph_conv = _convert(mod_graph.canonical_form());
 
-#pragma omp critical(zpe_critical)
-	  {
-	    itemp = zpe_data.find(mod_graph_conv) != zpe_data.end();
-	  }
+	  itemp = zpe_data.find(mod_graph_conv, dtemp);
 	
 	  // read graph value from the database
 	  //
 	  if(itemp) {
 	    //
 	    ++zpe_read;
-	  
-#pragma omp critical(zpe_critical)
-	    {
-	      gfactor *= zpe_data[mod_graph_conv];
-	    }
+
+	    gfactor *= dtemp;
 	  }
 	  // zero temperature integral (zpe factor) calculation
 	  //
@@ -268,24 +264,9 @@ std::map<int, double> Graph::Expansion::correction (double temperature) const
 
 	    // save zero temperature integral value in the database
 	    //
-#pragma omp critical(zpe_critical)
-	    {
-	      if(zpe_data.find(mod_graph_conv) != zpe_data.end()) {
-		//
-		++zpe_miss;
-	      }
-	      else if(mod_flag & KEEP_PERM) {
-		//
-		std::set<FreqGraph> pool = mod_graph.perm_pool();
-
-		for(std::set<FreqGraph>::const_iterator pit = pool.begin(); pit != pool.end(); ++pit)
-		  //
-		  zpe_data[_convert(*pit)] = dtemp;
-	      }
-	      else {
-		//
-		zpe_data[mod_graph_conv] = dtemp;
-	      }
+	    if(!zpe_data.insert(mod_graph_conv, dtemp)) {
+	      //
+	      ++zpe_miss;
 	    }
 	    //
 	    //
@@ -310,30 +291,15 @@ std::map<int, double> Graph::Expansion::correction (double temperature) const
 	    //
 	    _Convert::vec_t fac_graph_conv;
 
-	    if(mod_flag & KEEP_PERM) {
-	      //
-	      fac_graph_conv = _convert(fgit->first);
-	    }
-	    else {
-	      //
-	      fac_graph_conv = _convert(*fgit->first.perm_pool().begin());
-	    }
+	    fac_graph_conv = _convert(fgit->first.canonical_form());
 
-#pragma omp critical(int_critical)
-	    {
-	      itemp = int_data.find(fac_graph_conv) != int_data.end();
-	    }
+	    itemp = int_data.find(fac_graph_conv, dtemp);
 
 	    // read whole integral value from the database
 	    //
 	    if(itemp) {
 	      //
 	      ++int_read;
-
-#pragma omp critical(int_critical)
-	      {
-		dtemp = int_data[fac_graph_conv];
-	      }
 	      
 	      for(int i = 0; i < fgit->second; ++i)
 		gfactor *= dtemp;
@@ -360,29 +326,14 @@ std::map<int, double> Graph::Expansion::correction (double temperature) const
 		//
 		_Convert::vec_t zpe_graph_conv;
 	      
-		if(mod_flag & KEEP_PERM) {
-		  //
-		  zpe_graph_conv = _convert(zgit->first);
-		}
-		else {
-		  //
-		  zpe_graph_conv = _convert(*zgit->first.perm_pool().begin());
-		}
+		zpe_graph_conv = _convert(zgit->first.canonical_form());
 		  
-#pragma omp critical(zpe_critical)
-		{
-		  itemp = zpe_data.find(zpe_graph_conv) != zpe_data.end();
-		}
+		itemp = zpe_data.find(zpe_graph_conv, dtemp);
 
 		// read low temperature integral value from the database
 		//
 		if(itemp) {
 		  ++zpe_read;
-		  
-#pragma omp critical(zpe_critical)
-		  {
-		    dtemp = zpe_data[zpe_graph_conv];
-		  }
 		
 		  for(int i = 0; i < zgit->second; ++i)
 		    int_val *= dtemp;
@@ -399,23 +350,9 @@ std::map<int, double> Graph::Expansion::correction (double temperature) const
 
 		  // save low temperature integral value in the database
 		  //
-#pragma omp critical(zpe_critical)
-		  {
-		    if(zpe_data.find(zpe_graph_conv) != zpe_data.end()) {
-		      ++zpe_miss;
-		    }
-		    else if(mod_flag & KEEP_PERM) {
-		      //
-		      // permutationally equivalent configurations
-		      //
-		      std::set<FreqGraph> pool = zgit->first.perm_pool();
-
-		      for(std::set<FreqGraph>::const_iterator pit = pool.begin(); pit != pool.end(); ++pit)
-			zpe_data[_convert(*pit)] = dtemp;
-		    }
-		    else {
-		      zpe_data[zpe_graph_conv] = dtemp;
-		    }
+		  if(!zpe_data.insert(zpe_graph_conv, dtemp)) {
+		    //
+		    ++zpe_miss;
 		  }
 		  //
 		  //
@@ -430,29 +367,16 @@ std::map<int, double> Graph::Expansion::correction (double temperature) const
 		//
 		_Convert::vec_t red_graph_conv;
 
-		if(mod_flag & KEEP_PERM) {
-		  //
-		  red_graph_conv = _convert(red_graph);
-		}
-		else {
-		  //
-		  red_graph_conv = _convert(*red_graph.perm_pool().begin());
-		}
+		red_graph_conv = _convert(red_graph.canonical_form());
 		
-#pragma omp critical(sum_critical)
-		{
-		  itemp = sum_data.find(red_graph_conv) != sum_data.end();
-		}
+		itemp = sum_data.find(red_graph_conv, dtemp);
 
 		// read reduced graph fourier sum value from the database
 		//
 		if(itemp) {
 		  ++sum_read;
-		
-#pragma omp critical(sum_critical)
-		  {
-		    int_val *= sum_data[red_graph_conv];
-		  }
+
+		  int_val *= dtemp;
 		}
 		// reduced graph fourier sum calculation
 		//
@@ -465,20 +389,9 @@ std::map<int, double> Graph::Expansion::correction (double temperature) const
 
 		  // save fourier sum calculation result in the database
 		  //
-#pragma omp critical(sum_critical)
-		  {
-		    if(sum_data.find(red_graph_conv) != sum_data.end()) {
-		      ++sum_miss;
-		    }
-		    else if(mod_flag & KEEP_PERM) {
-		      std::set<FreqGraph> pool = red_graph.perm_pool();
-		  
-		      for(std::set<FreqGraph>::const_iterator pit = pool.begin(); pit != pool.end(); ++pit)
-			sum_data[_convert(*pit)] = dtemp;
-		    }
-		    else {
-		      sum_data[red_graph_conv] = dtemp;
-		    }
+		  if(!sum_data.insert(red_graph_conv, dtemp)) {
+		    //
+		    ++sum_miss;
 		  }
 		  //
 		  //
@@ -496,19 +409,9 @@ std::map<int, double> Graph::Expansion::correction (double temperature) const
 
 	      // save whole integral calculation result in the database
 	      //
-#pragma omp critical(int_critical)
-	      {
-		if(int_data.find(fac_graph_conv) != int_data.end())
-		  ++int_miss;
-		else if(mod_flag & KEEP_PERM) {
-		  std::set<FreqGraph> pool = fgit->first.perm_pool();
-
-		  for(std::set<FreqGraph>::const_iterator pit = pool.begin(); pit != pool.end(); ++pit)
-		    int_data[_convert(*pit)] = int_val;
-		}
-		else {
-		  int_data[fac_graph_conv] = int_val;
-		}
+	      if(!int_data.insert(fac_graph_conv, int_val)) {
+		//
+		++int_miss;
 	      }
 	      //
 	      //
@@ -580,6 +483,8 @@ std::map<int, double> Graph::Expansion::correction (double temperature) const
     //
     //
   } // graph cycle
+
+  _save_store(CORRECTION, temperature, zpe_data, int_data, sum_data);
   
   IO::log << "\n";
 
@@ -802,6 +707,8 @@ std::map<int, double> Graph::Expansion::centroid_correction (double temperature)
   _gmap_t zpe_data;
   _gmap_t int_data;
 
+  _load_store(CENTROID_CORRECTION, temperature, zpe_data, int_data, sum_data);
+
   std::map<int, double> corr;
   std::map<int, std::map<int, double> > zpe;
 
@@ -1023,14 +930,7 @@ std::map<int, double> Graph::Expansion::centroid_correction (double temperature)
 	    //
 	    _Convert::vec_t fac_graph_conv;
 
-	    if(mod_flag & KEEP_PERM) {
-	      //
-	      fac_graph_conv = _convert(fgit->first);
-	    }
-	    else {
-	      //
-	      fac_graph_conv = _convert(*fgit->first.perm_pool().begin());
-	    }
+	    fac_graph_conv = _convert(fgit->first.canonical_form());
 
 	    // zero temperature integral evaluation
 	    //
@@ -1038,21 +938,13 @@ std::map<int, double> Graph::Expansion::centroid_correction (double temperature)
 	      //
 	      t_count -= fgit->second;
 
-#pragma omp critical(zpe_critical)
-	      {
-		itemp = zpe_data.find(fac_graph_conv) != zpe_data.end();
-	      }
+	      itemp = zpe_data.find(fac_graph_conv, dtemp);
 
 	      // read zero temperature integral value from the database
 	      //
 	      if(itemp) {
 		//
 		++zpe_read;
-		  
-#pragma omp critical(zpe_critical)
-		{
-		  dtemp = zpe_data[fac_graph_conv];
-		}
 		
 		for(int i = 0; i < fgit->second; ++i)
 		  //
@@ -1072,25 +964,9 @@ std::map<int, double> Graph::Expansion::centroid_correction (double temperature)
 
 		// save zero temperature integral calculation result in the database
 		//
-#pragma omp critical(zpe_critical)
-		{
-		  if(zpe_data.find(fac_graph_conv) != zpe_data.end()) {
-		    //
-		    ++zpe_miss;
-		  }
-		  else if(mod_flag & KEEP_PERM) {
-		    //
-		    // permutationally equivalent configurations
-		    //
-		    std::set<FreqGraph> pool = fgit->first.perm_pool();
-		    
-		    for(std::set<FreqGraph>::const_iterator pit = pool.begin(); pit != pool.end(); ++pit)
-		      zpe_data[_convert(*pit)] = dtemp;
-		  }
-		  else {
-		    //
-		    zpe_data[fac_graph_conv] = dtemp;
-		  }
+		if(!zpe_data.insert(fac_graph_conv, dtemp)) {
+		  //
+		  ++zpe_miss;
 		}
 		//
 		//
@@ -1104,21 +980,13 @@ std::map<int, double> Graph::Expansion::centroid_correction (double temperature)
 	    //
 	    else {
 	      //
-#pragma omp critical(int_critical)
-	      {
-		itemp = int_data.find(fac_graph_conv) != int_data.end();
-	      }
+	      itemp = int_data.find(fac_graph_conv, dtemp);
 
 	      // read whole integral value from the database
 	      //
 	      if(itemp) {
 		//
 		++int_read;
-
-#pragma omp critical(int_critical)
-		{
-		  dtemp = int_data[fac_graph_conv];
-		}
 	      
 		for(int i = 0; i < fgit->second; ++i)
 		  //
@@ -1147,29 +1015,14 @@ std::map<int, double> Graph::Expansion::centroid_correction (double temperature)
 	      
 		  _Convert::vec_t zpe_graph_conv;
 	      
-		  if(mod_flag & KEEP_PERM) {
-		    //
-		    zpe_graph_conv = _convert(zgit->first);
-		  }
-		  else {
-		    //
-		    zpe_graph_conv = _convert(*zgit->first.perm_pool().begin());
-		  }
+		  zpe_graph_conv = _convert(zgit->first.canonical_form());
 		  
-#pragma omp critical(zpe_critical)
-		  {
-		    itemp = zpe_data.find(zpe_graph_conv) != zpe_data.end();
-		  }
+		  itemp = zpe_data.find(zpe_graph_conv, dtemp);
 
 		  // read low temperature integral value from the database
 		  if(itemp) {
 		    //
 		    ++zpe_read;
-		  
-#pragma omp critical(zpe_critical)
-		    {
-		      dtemp = zpe_data[zpe_graph_conv];
-		    }
 		
 		    for(int i = 0; i < zgit->second; ++i)
 		      //
@@ -1189,24 +1042,9 @@ std::map<int, double> Graph::Expansion::centroid_correction (double temperature)
 
 		    // save calculation result in the database
 		    //
-#pragma omp critical(zpe_critical)
-		    {
-		      if(zpe_data.find(zpe_graph_conv) != zpe_data.end()) {
-			//
-			++zpe_miss;
-		      }
-		      else if(mod_flag & KEEP_PERM) {
-			//
-			std::set<FreqGraph> pool = zgit->first.perm_pool();
-
-			for(std::set<FreqGraph>::const_iterator pit = pool.begin(); pit != pool.end(); ++pit)
-			  //
-			  zpe_data[_convert(*pit)] = dtemp;
-		      }
-		      else {
-			//
-			zpe_data[zpe_graph_conv] = dtemp;
-		      }
+		    if(!zpe_data.insert(zpe_graph_conv, dtemp)) {
+		      //
+		      ++zpe_miss;
 		    }
 		    //
 		    //
@@ -1221,30 +1059,17 @@ std::map<int, double> Graph::Expansion::centroid_correction (double temperature)
 		  //
 		  _Convert::vec_t red_graph_conv;
 
-		  if(mod_flag & KEEP_PERM) {
-		    //
-		    red_graph_conv = _convert(red_graph);
-		  }
-		  else {
-		    //
-		    red_graph_conv = _convert(*red_graph.perm_pool().begin());
-		  }
+		  red_graph_conv = _convert(red_graph.canonical_form());
 
-#pragma omp critical(sum_critical)
-		  {
-		    itemp = sum_data.find(red_graph_conv) != sum_data.end();
-		  }
+		  itemp = sum_data.find(red_graph_conv, dtemp);
 
 		  // read reduced graph fourier sum from the database
 		  //
 		  if(itemp) {
 		    //
 		    ++sum_read;
-		
-#pragma omp critical(sum_critical)
-		    {
-		      int_val *= sum_data[red_graph_conv];
-		    }
+
+		    int_val *= dtemp;
 		  }
 		  // reduced graph fourier sum calculation
 		  //
@@ -1258,24 +1083,9 @@ std::map<int, double> Graph::Expansion::centroid_correction (double temperature)
 
 		    // save calculation result in the database
 		    //
-#pragma omp critical(sum_critical)
-		    {
-		      if(sum_data.find(red_graph_conv) != sum_data.end()) {
-			//
-			++sum_miss;
-		      }
-		      else if(mod_flag & KEEP_PERM) {
-			//
-			std::set<FreqGraph> pool = red_graph.perm_pool();
-
-			for(std::set<FreqGraph>::const_iterator pit = pool.begin(); pit != pool.end(); ++pit)
-			  //
-			  sum_data[_convert(*pit)] = dtemp;
-		      }
-		      else {
-			//
-			sum_data[red_graph_conv] = dtemp;
-		      }
+		    if(!sum_data.insert(red_graph_conv, dtemp)) {
+		      //
+		      ++sum_miss;
 		    }
 		    //
 		    //
@@ -1295,24 +1105,9 @@ std::map<int, double> Graph::Expansion::centroid_correction (double temperature)
 
 		// save whole integral value in the database
 		//
-#pragma omp critical(int_critical)
-		{
-		  if(int_data.find(fac_graph_conv) != int_data.end()) {
-		    //
-		    ++int_miss;
-		  }
-		  else if(mod_flag & KEEP_PERM) {
-		    //
-		    std::set<FreqGraph> pool = fgit->first.perm_pool();
-	      
-		    for(std::set<FreqGraph>::const_iterator pit = pool.begin(); pit != pool.end(); ++pit)
-		      //
-		      int_data[_convert(*pit)] = int_val;
-		  }
-		  else {
-		    //
-		    int_data[fac_graph_conv] = int_val;
-		  }
+		if(!int_data.insert(fac_graph_conv, int_val)) {
+		  //
+		  ++int_miss;
 		}
 		//
 		//
@@ -1396,6 +1191,8 @@ std::map<int, double> Graph::Expansion::centroid_correction (double temperature)
     }
   } // graph cycle
 
+  _save_store(CENTROID_CORRECTION, temperature, zpe_data, int_data, sum_data);
+
   IO::log << "\n";
 
   if(temperature <= 0.) {
@@ -1665,6 +1462,8 @@ std::map<int, double> Graph::Expansion::centroid_correction (const std::map<std:
   _gmap_t zpe_data;
   _gmap_t int_data;
 
+  _load_store(MASS_CENTROID_CORRECTION, temperature, zpe_data, int_data, sum_data);
+
   std::map<int, double> corr;
   //
   std::map<int, std::map<int, double> > zpe;
@@ -1991,14 +1790,7 @@ std::map<int, double> Graph::Expansion::centroid_correction (const std::map<std:
 	    //
 	    _Convert::vec_t fac_graph_conv;
 
-	    if(mod_flag & KEEP_PERM) {
-	      //
-	      fac_graph_conv = _convert(fgit->first);
-	    }
-	    else {
-	      //
-	      fac_graph_conv = _convert(*fgit->first.perm_pool().begin());
-	    }
+	    fac_graph_conv = _convert(fgit->first.canonical_form());
 	    
 	    // zero temperature integral (zpe factor) evaluation
 	    //
@@ -2006,21 +1798,13 @@ std::map<int, double> Graph::Expansion::centroid_correction (const std::map<std:
 	      //
 	      t_count -= fgit->second;
 
-#pragma omp critical(zpe_critical)
-	      {	      
-		itemp = zpe_data.find(fac_graph_conv) != zpe_data.end();
-	      }
+	      itemp = zpe_data.find(fac_graph_conv, dtemp);
 
 	      // read zero temperature integral (zpe factor) value from the database
 	      //
 	      if(itemp) {
 		//
 		++zpe_read;
-		  
-#pragma omp critical(zpe_critical)
-		{
-		  dtemp = zpe_data[fac_graph_conv];
-		}
 		
 		for(int i = 0; i < fgit->second; ++i)
 		  //
@@ -2041,24 +1825,9 @@ std::map<int, double> Graph::Expansion::centroid_correction (const std::map<std:
 
 		// save zero temperature integral (zpe factor) value in the database
 		//
-#pragma omp critical(zpe_critical)
-		{	      
-		  if(zpe_data.find(fac_graph_conv) != zpe_data.end()) {
-		    //
-		    ++zpe_miss;
-		  }
-		  else if(mod_flag & KEEP_PERM) {
-		    //
-		    std::set<FreqGraph> pool = fgit->first.perm_pool();
-		  
-		    for(std::set<FreqGraph>::const_iterator pit = pool.begin(); pit != pool.end(); ++pit)
-		      //
-		      zpe_data[_convert(*pit)] = dtemp;
-		  }
-		  else {
-		    //
-		    zpe_data[fac_graph_conv] = dtemp;
-		  }
+		if(!zpe_data.insert(fac_graph_conv, dtemp)) {
+		  //
+		  ++zpe_miss;
 		}
 		//
 		//
@@ -2071,21 +1840,13 @@ std::map<int, double> Graph::Expansion::centroid_correction (const std::map<std:
 	    //
 	    else {
 	      //
-#pragma omp critical(int_critical)
-	      {	      
-		itemp = int_data.find(fac_graph_conv) != int_data.end();
-	      }
+	      itemp = int_data.find(fac_graph_conv, dtemp);
 
 	      // read whole integral value from the database
 	      //
 	      if(itemp) {
 		//
 		++int_read;
-	      
-#pragma omp critical(int_critical)
-		{	      
-		  dtemp = int_data[fac_graph_conv];
-		}
 
 		for(int i = 0; i < fgit->second; ++i)
 		  //
@@ -2114,30 +1875,15 @@ std::map<int, double> Graph::Expansion::centroid_correction (const std::map<std:
 		  //
 		  _Convert::vec_t zpe_graph_conv;
 
-		  if(mod_flag & KEEP_PERM) {
-		    //
-		    zpe_graph_conv = _convert(zgit->first);
-		  }
-		  else {
-		    //
-		    zpe_graph_conv = _convert(*zgit->first.perm_pool().begin());
-		  }
+		  zpe_graph_conv = _convert(zgit->first.canonical_form());
 	      
-#pragma omp critical(zpe_critical)
-		  {	      
-		    itemp = zpe_data.find(zpe_graph_conv) != zpe_data.end();
-		  }
+		  itemp = zpe_data.find(zpe_graph_conv, dtemp);
 
 		  // read low temperature integral (zpe factor) value from the database
 		  //
 		  if(itemp) {
 		    //
 		    ++zpe_read;
-		  
-#pragma omp critical(zpe_critical)
-		    {	      
-		      dtemp = zpe_data[zpe_graph_conv];
-		    }
 		
 		    for(int i = 0; i < zgit->second; ++i)
 		      //
@@ -2157,24 +1903,9 @@ std::map<int, double> Graph::Expansion::centroid_correction (const std::map<std:
 
 		    // save low temperature integral (zpe factor) value in the database
 		    //
-#pragma omp critical(zpe_critical)
-		    {	      
-		      if(zpe_data.find(zpe_graph_conv) != zpe_data.end()) {
-			//
-			++zpe_miss;
-		      }
-		      else if(mod_flag & KEEP_PERM) {
-			//
-			std::set<FreqGraph> pool = zgit->first.perm_pool();
-	  
-			for(std::set<FreqGraph>::const_iterator pit = pool.begin(); pit != pool.end(); ++pit)
-			  //
-			  zpe_data[_convert(*pit)] = dtemp;
-		      }
-		      else {
-			//
-			zpe_data[zpe_graph_conv] = dtemp;
-		      }
+		    if(!zpe_data.insert(zpe_graph_conv, dtemp)) {
+		      //
+		      ++zpe_miss;
 		    }
 		    //
 		    //
@@ -2189,30 +1920,17 @@ std::map<int, double> Graph::Expansion::centroid_correction (const std::map<std:
 		  //
 		  _Convert::vec_t red_graph_conv;
 
-		  if(mod_flag & KEEP_PERM) {
-		    //
-		    red_graph_conv = _convert(red_graph);
-		  }
-		  else {
-		    //
-		    red_graph_conv = _convert(*red_graph.perm_pool().begin());
-		  }
+		  red_graph_conv = _convert(red_graph.canonical_form());
 
-#pragma omp critical(sum_critical)
-		  {	      
-		    itemp = sum_data.find(red_graph_conv) != sum_data.end();
-		  }
+		  itemp = sum_data.find(red_graph_conv, dtemp);
 
 		  // read reduced graph fourier sum from the database
 		  //
 		  if(itemp) {
 		    //
 		    ++sum_read;
-		
-#pragma omp critical(sum_critical)
-		    {	      
-		      int_val *= sum_data[red_graph_conv];
-		    }
+
+		    int_val *= dtemp;
 		  }
 		  // reduced graph fourier sum calculation
 		  //
@@ -2226,24 +1944,9 @@ std::map<int, double> Graph::Expansion::centroid_correction (const std::map<std:
 
 		    // save reduced graph fourier sum in the database
 		    //
-#pragma omp critical(sum_critical)
-		    {	      
-		      if(sum_data.find(red_graph_conv) != sum_data.end()) {
-			//
-			++sum_miss;
-		      }
-		      else if(mod_flag & KEEP_PERM) {
-			//
-			std::set<FreqGraph> pool = red_graph.perm_pool();
-		
-			for(std::set<FreqGraph>::const_iterator pit = pool.begin(); pit != pool.end(); ++pit)
-			  //
-			  sum_data[_convert(*pit)] = dtemp;
-		      }
-		      else {
-			//
-			sum_data[red_graph_conv] = dtemp;
-		      }
+		    if(!sum_data.insert(red_graph_conv, dtemp)) {
+		      //
+		      ++sum_miss;
 		    }
 		    //
 		    //
@@ -2263,24 +1966,9 @@ std::map<int, double> Graph::Expansion::centroid_correction (const std::map<std:
 
 		// save whole integral value in the database
 		//
-#pragma omp critical(int_critical)
-		{	      
-		  if(int_data.find(fac_graph_conv) != int_data.end()) {
-		    //
-		    ++int_miss;
-		  }
-		  else if(mod_flag & KEEP_PERM) {
-		    //
-		    std::set<FreqGraph> pool = fgit->first.perm_pool();
-
-		    for(std::set<FreqGraph>::const_iterator pit = pool.begin(); pit != pool.end(); ++pit)
-		      //
-		      int_data[_convert(*pit)] = int_val;
-		  }
-		  else {
-		    //
-		    int_data[fac_graph_conv] = int_val;
-		  }
+		if(!int_data.insert(fac_graph_conv, int_val)) {
+		  //
+		  ++int_miss;
 		}
 		//
 		//
@@ -2371,6 +2059,8 @@ std::map<int, double> Graph::Expansion::centroid_correction (const std::map<std:
     //
   } // graph cycle
 
+  _save_store(MASS_CENTROID_CORRECTION, temperature, zpe_data, int_data, sum_data);
+
   IO::log << "\n";
 
   if(temperature <= 0) {
@@ -2765,16 +2455,438 @@ Graph::Expansion::_Convert::vec_t Graph::Expansion::_Convert::operator() (const
   return res;  
 }
 
+/********************************************************************************************
+ ********************************** PERSISTENT VALUE STORE **********************************
+ ********************************************************************************************/
+
+// graph value store file
+//
+std::string Graph::Expansion::store_file;
+
+// the store file starts with the header; each record then consists of the method and the
+// database indices (unsigned char), the bonds number (unsigned short), the temperature (double),
+// the value (double), and, for each bond, the vertex pair index (unsigned short) and the
+// bond frequency (double); the frequency values instead of the molecule specific frequency
+// indices make the graph values reusable across molecules
+//
+namespace {
+  //
+  const char   store_magic [] = "MESSGDB1";
+
+  const size_t record_head_size = 2 * sizeof(unsigned char) + sizeof(unsigned short) + 2 * sizeof(double);
+
+  const size_t record_bond_size = sizeof(unsigned short) + sizeof(double);
+
+  template <typename T>
+  //
+  void store_put (std::string& to, const T& t) { to.append((const char*)&t, sizeof(T)); }
+
+  template <typename T>
+  //
+  T store_get (const char*& from) { T res; std::memcpy(&res, from, sizeof(T)); from += sizeof(T); return res; }
+
+  // the new store is written under a temporary name and then linked to the store name, so
+  // that it appears complete, the header included; the link fails if another process has
+  // created the store meanwhile: returns 0 on success, 1 if the store exists, and -1 on error
+  //
+  int store_create (const std::string& file, const std::string& data)
+  {
+    std::ostringstream tmp;
+
+    tmp << file << "." << getpid() << ".tmp";
+
+    std::remove(tmp.str().c_str());
+
+    if(System::file_append(tmp.str().c_str(), data.data(), data.size())) {
+      //
+      std::remove(tmp.str().c_str());
+
+      return -1;
+    }
+
+    int res = 0;
+
+    if(link(tmp.str().c_str(), file.c_str()))
+      //
+      res = errno == EEXIST ? 1 : -1;
+
+    std::remove(tmp.str().c_str());
+
+    return res;
+  }
+}
+
+// header: the settings which the graph values depend on
+//
+std::string Graph::Expansion::_store_header () const
+{
+  std::string res(store_magic, sizeof(store_magic) - 1);
+
+  store_put(res, FreqGraph::red_thresh);
+
+  store_put(res, FreqGraph::four_par);
+
+  store_put(res, (int)FreqGraph::four_cut);
+
+  return res;
+}
+
+void Graph::Expansion::_load_store (int method, double temperature, _gmap_t& zpe_data, _gmap_t& int_data, _gmap_t& sum_data) const
+{
+  if(!store_file.size())
+    //
+    return;
+
+  zpe_data.set_journal(true);
+  int_data.set_journal(true);
+  sum_data.set_journal(true);
+
+  std::ifstream exist(store_file.c_str());
+
+  if(!exist)
+    //
+    return;
+
+  exist.close();
+
+  System::MappedFile store(store_file);
+
+  const std::string header = _store_header();
+
+  const char* const begin = (const char*)store.data();
+
+  const char* const end   = begin + store.size();
+
+  if(store.size() < header.size() || header.compare(0, header.size(), begin, header.size())) {
+    //
+    IO::log << IO::log_offset << "WARNING: " << store_file
+	    << ": graph value store header does not match the current graph settings, the store is not used\n";
+
+    return;
+  }
+
+  if(temperature <= 0.)
+    //
+    temperature = -1.;
+
+  // frequency value to reduced frequency index map
+  //
+  std::map<double, int> freq_index;
+
+  for(int f = 0; f < _red_freq.size(); ++f)
+    //
+    freq_index[_red_freq[f]] = f;
+
+  const int pair_size = _convert.vertex_size_max() * (_convert.vertex_size_max() - 1) / 2;
+
+  _gmap_t* data [] = {&zpe_data, &int_data, &sum_data};
+
+  int load_count = 0;
+
+  int skip_count = 0;
+
+  const char* p = begin + header.size();
+
+  while(p + record_head_size <= end) {
+    //
+    const int    record_method = store_get<unsigned char>(p);
+    const int    record_data   = store_get<unsigned char>(p);
+    const int    bond_size     = store_get<unsigned short>(p);
+    const double record_temp   = store_get<double>(p);
+    const double value         = store_get<double>(p);
+
+    // incomplete record: the store is being appended by another process
+    //
+    if(p + bond_size * record_bond_size > end)
+      //
+      break;
+
+    if(record_data > SUM_DATA) {
+      //
+      IO::log << IO::log_offset << "WARNING: " << store_file << ": corrupted graph value store, the rest is ignored\n";
+
+      break;
+    }
+    
+    if(record_method != method || record_temp != temperature) {
+      //
+      p += bond_size * record_bond_size;
+
+      continue;
+    }
+    
+    _Convert::vec_t gconv(bond_size);
+
+    bool is_found = true;
+
+    for(int b = 0; b < bond_size; ++b) {
+      //
+      const int    pair = store_get<unsigned short>(p);
+      const double freq = store_get<double>(p);
+
+      int fi = -1;
+
+      if(freq != 0.) {
+	//
+	std::map<double, int>::const_iterator fit = freq_index.find(freq);
+
+	if(fit == freq_index.end()) {
+	  //
+	  is_found = false;
+
+	  continue;
+	}
+
+	fi = fit->second;
+      }
+
+      if(pair >= pair_size) {
+	//
+	is_found = false;
+
+	continue;
+      }
+
+      gconv[b] = pair * _convert.freq_size() + fi + 1;
+    }
+
+    if(!is_found) {
+      //
+      ++skip_count;
+
+      continue;
+    }
+
+    // canonical form for the current frequency indices
+    //
+    data[record_data]->load(_convert(_convert(gconv).canonical_form()), value);
+
+    ++load_count;
+  }
+
+  IO::log << IO::log_offset << store_file << ": " << load_count << " graph values loaded, "
+	  << skip_count << " graph values for other frequencies skipped\n";
+}
+
+void Graph::Expansion::_save_store (int method, double temperature, const _gmap_t& zpe_data, const _gmap_t& int_data, const _gmap_t& sum_data) const
+{
+  const char funame [] = "Graph::Expansion::_save_store: ";
+
+  if(!store_file.size())
+    //
+    return;
+
+  if(temperature <= 0.)
+    //
+    temperature = -1.;
+
+  const std::string header = _store_header();
+
+  std::string buffer;
+
+  const _gmap_t* data [] = {&zpe_data, &int_data, &sum_data};
+
+  int save_count = 0;
+  
+  std::vector<std::pair<_Convert::vec_t, double> > journal;
+
+  for(int d = 0; d < 3; ++d) {
+    //
+    data[d]->journal(journal);
+
+    for(int j = 0; j < journal.size(); ++j) {
+      //
+      const _Convert::vec_t& gconv = journal[j].first;
+
+      store_put(buffer, (unsigned char)method);
+      store_put(buffer, (unsigned char)d);
+      store_put(buffer, (unsigned short)gconv.size());
+      store_put(buffer, temperature);
+      store_put(buffer, journal[j].second);
+
+      for(int b = 0; b < gconv.size(); ++b) {
+	//
+	const int fi = gconv[b] % _convert.freq_size() - 1;
+
+	store_put(buffer, (unsigned short)(gconv[b] / _convert.freq_size()));
+
+	store_put(buffer, fi < 0 ? 0. : _red_freq[fi]);
+      }
+
+      ++save_count;
+    }
+  }
+
+  if(!save_count)
+    //
+    return;
+
+  // new store
+  //
+  std::ifstream exist(store_file.c_str());
+
+  if(!exist) {
+    //
+    const int res = store_create(store_file, header + buffer);
+
+    if(!res) {
+      //
+      IO::log << IO::log_offset << store_file << ": " << save_count << " graph values saved\n";
+
+      return;
+    }
+
+    if(res < 0) {
+      //
+      std::cerr << funame << "cannot create the graph value store " << store_file << "\n";
+
+      return;
+    }
+
+    // the store has been created by another process
+    //
+    exist.clear();
+
+    exist.open(store_file.c_str());
+  }
+
+  std::string stemp(header.size(), 0);
+
+  if(!exist.read(&stemp[0], header.size()) || stemp != header)
+    //
+    return;
+
+  exist.close();
+
+  if(System::file_append(store_file.c_str(), buffer.data(), buffer.size())) {
+    //
+    std::cerr << funame << "cannot append to the graph value store " << store_file << "\n";
+
+    return;
+  }
+
+  IO::log << IO::log_offset << store_file << ": " << save_count << " graph values appended\n";
+}
+
+/********************************************************************************************
+ ************************************ CONCURRENT DATABASE ***********************************
+ ********************************************************************************************/
+
+int Graph::Expansion::_gmap_t::shard_size = 64;
+
+size_t Graph::Expansion::_gmap_t::_Hash::operator() (const _Convert::vec_t& v) const
+{
+  // FNV-1a
+  //
+  size_t res = 14695981039346656037ULL;
+
+  for(const _Convert::int_t* it = v.begin(); it != v.end(); ++it) {
+    //
+    res ^= (unsigned char)*it;
+
+    res *= 1099511628211ULL;
+  }
+
+  return res;
+}
+
+Graph::Expansion::_gmap_t::_gmap_t () : _shard_size(shard_size > 0 ? shard_size : 1), _journal(false)
+{
+  _shard = new _Shard[_shard_size];
+}
+
+Graph::Expansion::_gmap_t::_Shard& Graph::Expansion::_gmap_t::_get (const _Convert::vec_t& v) const
+{
+  // high bits select the shard, low bits the bucket inside the shard
+  //
+  return _shard[(_Hash()(v) >> 32) % _shard_size];
+}
+
+bool Graph::Expansion::_gmap_t::find (const _Convert::vec_t& v, double& val) const
+{
+  _Shard& shard = _get(v);
+
+  std::lock_guard<std::mutex> guard(shard.lock);
+
+  _map_t::const_iterator it = shard.data.find(v);
+
+  if(it == shard.data.end())
+    //
+    return false;
+
+  val = it->second;
+
+  return true;
+}
+
+bool Graph::Expansion::_gmap_t::insert (const _Convert::vec_t& v, double val)
+{
+  _Shard& shard = _get(v);
+
+  std::lock_guard<std::mutex> guard(shard.lock);
+
+  if(!shard.data.insert(std::make_pair(v, val)).second)
+    //
+    return false;
+
+  if(_journal)
+    //
+    shard.journal.push_back(v);
+
+  return true;
+}
+
+void Graph::Expansion::_gmap_t::load (const _Convert::vec_t& v, double val)
+{
+  _Shard& shard = _get(v);
+
+  std::lock_guard<std::mutex> guard(shard.lock);
+
+  shard.data.insert(std::make_pair(v, val));
+}
+
+void Graph::Expansion::_gmap_t::journal (std::vector<std::pair<_Convert::vec_t, double> >& res) const
+{
+  res.clear();
+
+  for(int s = 0; s < _shard_size; ++s) {
+    //
+    std::lock_guard<std::mutex> guard(_shard[s].lock);
+
+    for(int j = 0; j < _shard[s].journal.size(); ++j)
+      //
+      res.push_back(std::make_pair(_shard[s].journal[j], _shard[s].data.find(_shard[s].journal[j])->second));
+  }
+}
+
+long Graph::Expansion::_gmap_t::size () const
+{
+  long res = 0;
+
+  for(int s = 0; s < _shard_size; ++s) {
+    //
+    std::lock_guard<std::mutex> guard(_shard[s].lock);
+
+    res += _shard[s].data.size();
+  }
+
+  return res;
+}
+
 long Graph::Expansion::_gmap_t::mem_size () const
 {
   long res = 0;
   //
-  for(const_iterator dit = begin(); dit != end(); ++dit)
+  for(int s = 0; s < _shard_size; ++s) {
     //
-    res += (long)_Convert::mem_size(dit->first);
+    std::lock_guard<std::mutex> guard(_shard[s].lock);
+
+    for(_map_t::const_iterator dit = _shard[s].data.begin(); dit != _shard[s].data.end(); ++dit)
+      //
+      res += (long)_Convert::mem_size(dit->first);
 
-  res += (long)size() * long(sizeof(_Convert::vec_t) + 32); // 32 stands for three pointers and the double
+    res += (long)_shard[s].data.size() * long(sizeof(_Convert::vec_t) + 32); // 32 stands for the node pointer, the hash, and the double
+  }
   
   return res;
 }
-
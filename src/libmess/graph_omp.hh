@@ -19,6 +19,10 @@
 #include "graph_common.hh"
 #include "array.hh"
 
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
   /******************************************************************************************
    ********************** PARTITION FUNCTION GRAPH PERTURBATION THEORY **********************
    ******************************************************************************************/
@@ -54,15 +58,85 @@ namespace Graph {
       vec_t operator() (const FreqGraph&) const;
 
       FreqGraph operator() (const vec_t&) const;
+
+      int freq_size () const { return _freq_size; }
+      
+      int vertex_size_max () const { return _vertex_size_max; }
     };
       
     _Convert _convert;
     
-    // database format
+    // concurrent database with read-mostly lookups and insert-once values: the graphs
+    // are distributed over the shards by their hash, each shard having its own lock
     //
-    struct _gmap_t : public std::map<_Convert::vec_t, double> {
+    class _gmap_t {
+      //
+      struct _Hash {
+	//
+	size_t operator() (const _Convert::vec_t&) const;
+      };
+
+      typedef std::unordered_map<_Convert::vec_t, double, _Hash> _map_t;
+
+      struct _Shard {
+	//
+	std::mutex lock;
+
+	_map_t     data;
+
+	// inserted graphs
+	//
+	std::vector<_Convert::vec_t> journal;
+
+	// to keep the locks in different cache lines
+	//
+	char       pad [64];
+      };
+
+      _Shard* _shard;
+
+      int     _shard_size;
+
+      // keep track of the inserted graphs
+      //
+      bool    _journal;
+
+      _Shard& _get (const _Convert::vec_t&) const;
+      
+      _gmap_t            (const _gmap_t&);
+      _gmap_t& operator= (const _gmap_t&);
+
+    public:
+      //
+      _gmap_t ();
+
+      ~_gmap_t () { delete[] _shard; }
+
+      // returns false if the graph is not in the database
       //
-      long mem_size() const;
+      bool find   (const _Convert::vec_t&, double&) const;
+
+      // returns false if the graph is already in the database; the value is not changed then
+      //
+      bool insert (const _Convert::vec_t&, double);
+
+      // inserts the graph without recording it in the journal
+      //
+      void load   (const _Convert::vec_t&, double);
+
+      void set_journal (bool j) { _journal = j; }
+
+      // graphs inserted since the journal was set
+      //
+      void journal (std::vector<std::pair<_Convert::vec_t, double> >&) const;
+
+      long size     () const;
+
+      long mem_size () const;
+
+      // number of shards
+      //
+      static int shard_size;
     };
 
     // potential expansion
@@ -82,10 +156,26 @@ namespace Graph {
     std::vector<int> _red_freq_index;
   
     void _set_frequencies (std::vector<double> freq);
+
+    // persistent graph value store: the databases are warm-started from the store
+    // and the newly calculated values are appended to it
+    //
+    enum {ZPE_DATA, INT_DATA, SUM_DATA};
+
+    enum {CORRECTION, CENTROID_CORRECTION, MASS_CENTROID_CORRECTION};
+
+    void _load_store (int method, double temperature, _gmap_t& zpe_data, _gmap_t& int_data, _gmap_t& sum_data) const;
+
+    void _save_store (int method, double temperature, const _gmap_t& zpe_data, const _gmap_t& int_data, const _gmap_t& sum_data) const;
+
+    std::string _store_header () const;
   
     std::set<int> _low_freq_set (double temperature, std::vector<double>& tanh_factor) const;
 
   public:
+    //
+    // the databases are keyed on the graph canonical form, so that the permutationally
+    // equivalent graphs are not stored; the flag is kept for the input compatibility
     //
     enum { KEEP_PERM = 1};
 
@@ -112,6 +202,10 @@ namespace Graph {
     // low frequency threshold
     //
     static double low_freq_thresh;
+
+    // persistent graph value store file, if any
+    //
+    static std::string store_file;
   };
 }
 
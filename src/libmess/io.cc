@@ -33,7 +33,11 @@ namespace IO {
   LogOut log;
   LogOut out;
 
-  Offset log_offset(3);
+  thread_local Offset log_offset(3);
+
+  // output capture of the current thread
+  //
+  thread_local Capture* _active_capture = 0;
 
   log_t _loglevel = NOTICE;
   //
@@ -216,6 +220,105 @@ void IO::LineInput::read_line(std::istream& from)
   std::istringstream::str(line);
 }
 
+/************************************************************************************
+ *********************************** OUTPUT CAPTURE *********************************
+ ************************************************************************************/
+
+std::ostream& IO::LogOut::target ()
+{
+  if(_active_capture)
+    //
+    return _active_capture->buffer(*this);
+
+  if(is_open())
+    //
+    return *this;
+
+  return std::cout;
+}
+
+IO::Capture* IO::Capture::active ()
+{
+  return _active_capture;
+}
+
+void IO::Capture::start ()
+{
+  const char funame [] = "IO::Capture::start: ";
+
+  for(const Capture* c = _active_capture; c; c = c->_outer)
+    //
+    if(c == this) {
+      //
+      std::cerr << funame << "output has been already captured\n";
+
+      throw Error::Init();
+    }
+
+  _outer = _active_capture;
+
+  _active_capture = this;
+}
+
+void IO::Capture::stop ()
+{
+  if(_active_capture == this) {
+    //
+    _active_capture = _outer;
+
+    _outer = 0;
+  }
+}
+
+IO::Capture::~Capture ()
+{
+  stop();
+}
+
+std::ostream& IO::Capture::buffer (LogOut& to)
+{
+  for(int i = 0; i < _stream.size(); ++i)
+    //
+    if(_stream[i] == &to)
+      //
+      return *_buffer[i];
+
+  // the buffer inherits the stream formatting
+  //
+  _stream.push_back(&to);
+
+  _buffer.push_back(SharedPointer<std::ostringstream>(new std::ostringstream));
+
+  _buffer.back()->copyfmt(to);
+
+  return *_buffer.back();
+}
+
+void IO::Capture::release ()
+{
+  const char funame [] = "IO::Capture::release: ";
+
+  if(_active_capture == this) {
+    //
+    std::cerr << funame << "capture is still active\n";
+
+    throw Error::Logic();
+  }
+
+  for(int i = 0; i < _stream.size(); ++i) {
+    //
+    std::ostream& to = _stream[i]->target();
+
+    to << _buffer[i]->str();
+
+    to.copyfmt(*_buffer[i]);
+  }
+  
+  _stream.clear();
+
+  _buffer.clear();
+}
+
 /************************************************************************************
  ************************************ INPUT MARKER **********************************
  ************************************************************************************/
@@ -231,10 +334,8 @@ IO::Marker::Marker(const char* h, int f, std::ostream* out)
 
   if(out)
     _to = out;
-  else if(log.is_open())
-    _to = &log;
   else
-    _to = &std::cout;
+    _to = &log.target();
 
   *_to << log_offset << _header;
 
@@ -26,6 +26,7 @@
 #include <ctime>
 
 #include "error.hh"
+#include "shared.hh"
 
 namespace IO {
   //
@@ -57,7 +58,15 @@ namespace IO {
    ****************************** OUTPUT **********************************
    ************************************************************************/
 
-  class LogOut : public std::ofstream {};
+  class LogOut : public std::ofstream {
+    //
+  public:
+    //
+    // the stream the output actually goes to: the capture buffer, if the
+    // current thread output is captured, the file, if opened, or the standard output
+    //
+    std::ostream& target ();
+  };
 
   template <typename T>
   //
@@ -69,13 +78,20 @@ namespace IO {
       //
       return to;
 
-    if(to.is_open()) {
-      //
-      (std::ostream&)to << t;
-    }
-    else
+    to.target() << t;
+
+    return to;
+  }
+
+  // manipulators (std::endl, std::flush, etc.)
+  //
+  inline LogOut& operator<< (LogOut& to, std::ostream& (*manip)(std::ostream&))
+  {
+    if(mpi_rank)
       //
-      std::cout << t;
+      return to;
+
+    manip(to.target());
 
     return to;
   }
@@ -84,6 +100,57 @@ namespace IO {
   
   extern LogOut out;
 
+  /************************************************************************
+   *************************** OUTPUT CAPTURE *****************************
+   ************************************************************************/
+
+  // Buffers everything written to the LogOut streams from the thread it is
+  // started on, so that independent calculations may run concurrently
+  // and still produce their output in the serial order. The captures nest:
+  // the capture started while another one is active in the same thread
+  // releases its output into the outer one
+  //
+  class Capture {
+    //
+    std::vector<LogOut*>                              _stream;
+    
+    std::vector<SharedPointer<std::ostringstream> >   _buffer;
+
+    // capture active when this one has been started
+    //
+    Capture*                                          _outer;
+
+    Capture            (const Capture&);
+    
+    Capture& operator= (const Capture&);
+
+  public:
+    //
+    Capture () : _outer(0) {}
+    
+    ~Capture ();
+
+    // start/stop capturing the current thread output; the nested captures
+    // are stopped in the reverse order
+    //
+    void start ();
+    
+    void stop  ();
+
+    // capture buffer for the stream
+    //
+    std::ostream& buffer (LogOut&);
+
+    // write captured output to the streams, or to the capture active in the
+    // current thread, and clear the buffers
+    //
+    void release ();
+
+    // capture active in the current thread, if any
+    //
+    static Capture* active ();
+  };
+
   /***********************************************************************************
    ****************************** LINE INPUT STREAM **********************************
    ***********************************************************************************/
@@ -154,7 +221,9 @@ namespace IO {
     return to << std::setw(off) << "";
   }
 
-  extern Offset log_offset;
+  // each thread has its own offset
+  //
+  extern thread_local Offset log_offset;
 
   /***********************************************************************************
    ****************************** KEY BUFFER STREAM **********************************
@@ -166,12 +235,18 @@ namespace IO {
     //
     std::vector<std::string> _buffer;
 
+    // the text to read from instead of the file
+    //
+    std::stringbuf           _text;
+
   public:
     //
     KeyBufferStream (const char* f) : std::ifstream(f) {}
     
     KeyBufferStream () {}
 
+    explicit KeyBufferStream (const std::string& t) : _text(t, std::ios_base::in) { std::ios::rdbuf(&_text); }
+
     void put_back (const std::string&) ;
 
     template <typename T>
@@ -18,7 +18,7 @@
 #include <stack>
 #include <iomanip>
 
-std::vector<std::vector<Key::_Val> > Key::_stack;
+thread_local std::vector<std::vector<Key::_Val> > Key::_stack;
 
 void Key::_check_stack ()
 {
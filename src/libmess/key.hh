@@ -32,7 +32,8 @@ class Key {
     _Val (const std::string& s) : std::string(s), _init(false) {}
   };
 
-  static std::vector<std::vector<_Val> > _stack;
+  // each thread has its own stack, so that the input may be read concurrently
+  static thread_local std::vector<std::vector<_Val> > _stack;
 
   static void _check_stack ();
 
@@ -21,6 +21,10 @@
 #include "linpack.hh"
 
 #include <iostream>
+#include <vector>
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
 
 /****************************************************************
  ************************** Vector ******************************
@@ -617,6 +621,503 @@ Lapack::Vector Lapack::BandMatrix::eigenvalues (Matrix* evec)
   }
 }
 
+Lapack::Vector Lapack::BandMatrix::eigenvalues (int_t ilo, int_t ihi, Matrix* evec)
+  const 
+{
+  const char funame [] = "Lapack::BandMatrix::eigenvalues: ";
+
+  if(!isinit()) {
+    std::cerr << funame << "not initialized\n";
+    throw Error::Init();
+  }
+
+  if(ilo < 0 || ihi > size() || ilo >= ihi) {
+    std::cerr << funame << "wrong eigenvalue index range: [" << ilo << ", " << ihi << ")\n";
+    throw Error::Range();
+  }
+
+  const int_t esize = ihi - ilo;
+
+  char job;
+  double* z;
+  Matrix q;
+  if(!evec) {
+    job = 'N';
+    z = 0;
+  }
+  else {
+    job = 'V';
+    q.resize(size());
+    evec->resize(size(), esize);
+    z = *evec;
+  }
+
+  Vector       work(7 * size());
+  Array<int_t> iwork(5 * size());
+  Array<int_t> ifail(size());
+
+  BandMatrix cp = copy();
+  Vector res(size());
+  int_t  info = 0;
+  int_t  m;
+  dsbevx_(job, 'I', 'U', size(), band_size() - 1, cp, band_size(), job == 'V' ? (double*)q : 0, size(),
+	  0., 0., ilo + 1, ihi, 0., m, res, z, size(), work, iwork, ifail, info);
+ 
+  if(info < 0) {
+    std::cerr << funame << "dsbevx: " << -info 
+	      << "-th argument has an illegal value\n";
+    throw Error::Range();
+  }
+  else if(info > 0) {
+    std::cerr << funame << "dsbevx: " << info 
+	      << " eigenvectors failed to converge\n";
+    throw Error::Math();
+  }
+
+  if(m != esize) {
+    std::cerr << funame << "dsbevx: number of eigenvalues found, " << m << ", differs from requested, " << esize << "\n";
+    throw Error::Math();
+  }
+
+  Vector eval(esize);
+  for(int_t i = 0; i < esize; ++i)
+    eval[i] = res[i];
+
+  return eval;
+}
+
+void Lapack::BandMatrix::multiply (const double* x, double* y) const
+{
+  const int_t n = size();
+  const int_t b = band_size();
+
+  for(int_t i = 0; i < n; ++i)
+    //
+    y[i] = 0.;
+
+  for(int_t j = 0; j < n; ++j) {
+    //
+    const double* col = &Matrix::operator()(b - 1, j);
+
+    y[j] += col[0] * x[j];
+
+    for(int_t i = j < b ? 0 : j - b + 1; i < j; ++i) {
+      //
+      const double a = col[i - j];
+
+      y[i] += a * x[j];
+      y[j] += a * x[i];
+    }
+  }
+}
+
+Lapack::Vector Lapack::BandMatrix::lanczos_eigenvalues (int_t esize, double shift, Matrix* evec, const Matrix* guess)
+  const 
+{
+  const char funame [] = "Lapack::BandMatrix::lanczos_eigenvalues: ";
+
+  // relative residual of the converged Ritz pairs of the inverted operator
+  //
+  static const double tol = 1.e-12;
+
+  static const int restart_max = 1000;
+
+  // number of Lanczos steps between the convergence checks
+  //
+  static const int check_step = 5;
+
+  if(!isinit()) {
+    std::cerr << funame << "not initialized\n";
+    throw Error::Init();
+  }
+
+  const int_t n = size();
+
+  if(esize <= 0 || esize > n) {
+    std::cerr << funame << "number of eigenvalues out of range: " << esize << "\n";
+    throw Error::Range();
+  }
+
+  // Krylov subspace dimension
+  //
+  const int_t m = 2 * esize + 20;
+
+  // small matrix
+  //
+  if(m >= n)
+    //
+    return eigenvalues(0, esize, evec);
+
+  BandCholesky factor(*this, shift);
+
+  // Krylov basis and the residual vector as the last column
+  //
+  Matrix v(n, m + 1);
+
+  double* const vp = v;
+
+  // projection of the inverted operator on the Krylov subspace
+  //
+  Matrix t(m);
+
+  // Ritz values and vectors in the Krylov basis
+  //
+  Vector theta;
+  Matrix s;
+
+  double beta;
+
+  // deterministic starting vector, with the guessed eigenvectors added, if any
+  //
+  for(int_t i = 0; i < n; ++i)
+    //
+    vp[i] = 1. + 0.5 * std::sin(double(i + 1));
+
+  if(guess && guess->isinit() && guess->size1() == n) {
+    //
+    normalize(vp, n);
+
+    for(int_t i = 0; i < n; ++i)
+      //
+      vp[i] *= 1.e-3;
+
+    for(int_t k = 0; k < guess->size2() && k < esize; ++k)
+      //
+      for(int_t i = 0; i < n; ++i)
+	//
+	vp[i] += (*guess)(i, k);
+  }
+
+  normalize(vp, n);
+
+  int_t kept = 0;
+
+  // current basis size
+  //
+  int_t dim = 0;
+
+  bool is_conv = false;
+
+  for(int restart = 0; ; ++restart) {
+    //
+    if(restart == restart_max) {
+      //
+      std::cerr << funame << "not converged after " << restart_max << " restarts\n";
+
+      throw Error::Math();
+    }
+
+    for(int_t j = kept; j < m; ++j) {
+      //
+      Vector w(n);
+
+      for(int_t i = 0; i < n; ++i)
+	//
+	w[i] = vp[i + j * n];
+
+      w = factor.invert(w);
+
+      // full reorthogonalization, applied twice
+      //
+      for(int_t i = 0; i <= j; ++i)
+	//
+	t(i, j) = 0.;
+
+      for(int pass = 0; pass < 2; ++pass)
+	//
+	for(int_t i = 0; i <= j; ++i) {
+	  //
+	  const double proj = vdot(&v(0, i), w, n);
+
+	  for(int_t l = 0; l < n; ++l)
+	    //
+	    w[l] -= proj * vp[l + i * n];
+
+	  t(i, j) += proj;
+	}
+
+      for(int_t i = 0; i < j; ++i)
+	//
+	t(j, i) = t(i, j);
+
+      beta = normalize(w, n);
+
+      // invariant subspace: the next vector is an arbitrary one orthogonal to the basis
+      //
+      const bool is_invariant = beta <= tol * std::fabs(t(j, j));
+
+      for(int attempt = 1; beta <= tol * std::fabs(t(j, j)); ++attempt) {
+	//
+	if(attempt > 10) {
+	  //
+	  std::cerr << funame << "cannot extend the Krylov basis\n";
+
+	  throw Error::Math();
+	}
+
+	for(int_t l = 0; l < n; ++l)
+	  //
+	  w[l] = std::sin(double((l + 1) * (j + attempt + 1)));
+
+	normalize(w, n);
+
+	for(int pass = 0; pass < 2; ++pass)
+	  //
+	  for(int_t i = 0; i <= j; ++i) {
+	    //
+	    const double proj = vdot(&v(0, i), w, n);
+
+	    for(int_t l = 0; l < n; ++l)
+	      //
+	      w[l] -= proj * vp[l + i * n];
+	  }
+
+	// the new vector is not in the span of the basis
+	//
+	if(normalize(w, n) > 1.e-3) {
+	  //
+	  beta = 0.;
+
+	  break;
+	}
+      }
+
+      for(int_t l = 0; l < n; ++l)
+	//
+	vp[l + (j + 1) * n] = w[l];
+
+      // Ritz pairs, the wanted ones are the largest; the convergence is checked periodically,
+      // so that a good starting vector saves the solves; the Ritz pairs of an invariant
+      // subspace are exact, but the lower eigenvalues, e. g., the degenerate ones, may be
+      // not in it yet
+      //
+      dim = j + 1;
+
+      if(dim < m && (is_invariant || dim < esize || (dim - kept) % check_step))
+	//
+	continue;
+
+      SymmetricMatrix tm(dim);
+
+      for(int_t jj = 0; jj < dim; ++jj)
+	//
+	for(int_t i = 0; i <= jj; ++i)
+	  //
+	  tm(i, jj) = t(i, jj);
+
+      theta = tm.eigenvalues(&s);
+
+      is_conv = !is_invariant;
+
+      for(int_t i = dim - esize; i < dim; ++i)
+	//
+	if(std::fabs(beta * s(dim - 1, i)) > tol * std::fabs(theta[i])) {
+	  //
+	  is_conv = false;
+
+	  break;
+	}
+
+      if(is_conv)
+	//
+	break;
+    }
+
+    if(is_conv)
+      //
+      break;
+
+    // thick restart: the largest Ritz vectors and the residual vector are kept
+    //
+    kept = esize + (m - esize) / 2;
+
+    Matrix y(n, kept);
+
+    y = 0.;
+
+    double* const yp = y;
+
+    for(int_t k = 0; k < kept; ++k)
+      //
+      for(int_t j = 0; j < m; ++j) {
+	//
+	const double sjk = s(j, m - kept + k);
+
+	for(int_t l = 0; l < n; ++l)
+	  //
+	  yp[l + k * n] += vp[l + j * n] * sjk;
+      }
+
+    for(int_t k = 0; k < kept; ++k)
+      //
+      for(int_t l = 0; l < n; ++l)
+	//
+	vp[l + k * n] = yp[l + k * n];
+
+    for(int_t l = 0; l < n; ++l)
+      //
+      vp[l + kept * n] = vp[l + m * n];
+
+    t = 0.;
+
+    for(int_t k = 0; k < kept; ++k) {
+      //
+      t(k, k) = theta[m - kept + k];
+
+      t(k, kept) = t(kept, k) = beta * s(m - 1, m - kept + k);
+    }
+  }
+
+  // Ritz vectors
+  //
+  Matrix x(n, esize);
+
+  x = 0.;
+
+  double* const xp = x;
+
+  for(int_t k = 0; k < esize; ++k)
+    //
+    for(int_t j = 0; j < dim; ++j) {
+      //
+      const double sjk = s(j, dim - 1 - k);
+
+      for(int_t l = 0; l < n; ++l)
+	//
+	xp[l + k * n] += vp[l + j * n] * sjk;
+    }
+
+  // final Rayleigh-Ritz projection of the matrix itself
+  //
+  Vector res = _rayleigh_ritz(x);
+
+  if(evec)
+    //
+    *evec = x;
+
+  return res;
+}
+
+Lapack::Vector Lapack::BandMatrix::_rayleigh_ritz (Matrix& x) const
+{
+  const int_t n = size();
+  const int_t p = x.size2();
+
+  Matrix ax(n, p);
+
+  for(int_t k = 0; k < p; ++k)
+    //
+    multiply(&x(0, k), &ax(0, k));
+
+  SymmetricMatrix h(p);
+
+  for(int_t j = 0; j < p; ++j)
+    //
+    for(int_t i = 0; i <= j; ++i)
+      //
+      h(i, j) = vdot(&x(0, i), &ax(0, j), n);
+
+  Matrix q;
+
+  Vector res = h.eigenvalues(&q);
+
+  x = x * q;
+
+  return res;
+}
+
+/****************************************************************
+ ************** Band Matrix Cholesky Factorization **************
+ ****************************************************************/
+
+Lapack::BandCholesky::BandCholesky (const BandMatrix& m, double shift) 
+{
+  const char funame [] = "Lapack::BandCholesky::BandCholesky: ";
+
+  if(!m.isinit()) {
+    std::cerr << funame << "not initialized\n";
+    throw Error::Init();
+  }
+
+  const int_t n = m.size();
+  const int_t b = m.band_size();
+
+  _factor.resize(b, n);
+
+  for(int_t j = 0; j < n; ++j)
+    //
+    for(int_t i = j < b ? 0 : j - b + 1; i <= j; ++i)
+      //
+      _factor(b - 1 + i - j, j) = m(i, j);
+
+  for(int_t j = 0; j < n; ++j)
+    //
+    _factor(b - 1, j) -= shift;
+
+  int_t info = 0;
+  dpbtrf_('U', n, b - 1, _factor, b, info);
+
+  if(!info)
+    return;
+
+  if(info < 0) {
+    std::cerr << funame << "dpbtrf: " << -info 
+	      << "-th argument has an illegal value\n";
+    throw Error::Range();
+  }
+  else {
+    std::cerr << funame << "dpbtrf: the leading minor of order " << info 
+	      << " is not positive definite\n";
+    throw Error::Math();
+  }
+}
+
+Lapack::Vector Lapack::BandCholesky::invert (const Vector& v) const 
+{
+  const char funame [] = "Lapack::BandCholesky::invert: ";
+
+  if(v.size() != size()) {
+    std::cerr << funame << "dimensions mismatch\n";
+    throw Error::Range();
+  }
+
+  Vector res = v.copy();
+
+  int_t info = 0;
+  dpbtrs_('U', size(), band_size() - 1, 1, _factor, band_size(), res, size(), info);
+
+  if(info < 0) {
+    std::cerr << funame << "dpbtrs: " << -info 
+	      << "-th argument has an illegal value\n";
+    throw Error::Range();
+  }
+
+  return res;
+}
+
+Lapack::Matrix Lapack::BandCholesky::invert (const Matrix& m) const 
+{
+  const char funame [] = "Lapack::BandCholesky::invert: ";
+
+  if(m.size1() != size()) {
+    std::cerr << funame << "dimensions mismatch\n";
+    throw Error::Range();
+  }
+
+  Matrix res = m.copy();
+
+  int_t info = 0;
+  dpbtrs_('U', size(), band_size() - 1, res.size2(), _factor, band_size(), res, size(), info);
+
+  if(info < 0) {
+    std::cerr << funame << "dpbtrs: " << -info 
+	      << "-th argument has an illegal value\n";
+    throw Error::Range();
+  }
+
+  return res;
+}
+
 /****************************************************************
  ********************* Symmetric Matrix *************************
  ****************************************************************/
@@ -824,6 +1325,389 @@ Lapack::Vector Lapack::SymmetricMatrix::eigenvalues (Matrix* evec)
   }
 }
 
+Lapack::Vector Lapack::SymmetricMatrix::dc_eigenvalues (Matrix* evec)
+  const 
+{
+  const char funame [] = "Lapack::SymmetricMatrix::dc_eigenvalues: ";
+
+  if(!isinit()) {
+    std::cerr << funame << "not initialized\n";
+    throw Error::Init();
+  }
+
+  // full storage: upper triangle
+  //
+  Matrix a(size());
+  const double* dp = *this;
+  for(int_t j = 0; j < size(); ++j)
+    for(int_t i = 0; i <= j; ++i, ++dp)
+      a(i, j) = *dp;
+
+  const char job = evec ? 'V' : 'N';
+
+  // workspace size
+  //
+  double dtemp;
+  int_t  itemp;
+  int_t  info = 0;
+  Vector res(size());
+  dsyevd_(job, 'U', size(), a, size(), res, &dtemp, -1, &itemp, -1, info);
+
+  if(info) {
+    std::cerr << funame << "dsyevd: workspace query failed: info = " << info << "\n";
+    throw Error::Logic();
+  }
+
+  const int_t lwork  = (int_t)dtemp;
+  const int_t liwork = itemp;
+  
+  Vector       work(lwork);
+  Array<int_t> iwork(liwork);
+
+  dsyevd_(job, 'U', size(), a, size(), res, work, lwork, iwork, liwork, info);
+
+  if(info < 0) {
+    std::cerr << funame << "dsyevd: " << -info 
+	      << "-th argument has an illegal value\n";
+    throw Error::Range();
+  }
+  else if(info > 0) {
+    std::cerr << funame << "dsyevd: the algorithm failed to converge: info = " << info << "\n";
+    throw Error::Math();
+  }
+
+  if(evec)
+    *evec = a;
+
+  return res;
+}
+
+Lapack::Vector Lapack::SymmetricMatrix::eigenvalues (int_t ilo, int_t ihi, Matrix* evec)
+  const 
+{
+  const char funame [] = "Lapack::SymmetricMatrix::eigenvalues: ";
+
+  if(!isinit()) {
+    std::cerr << funame << "not initialized\n";
+    throw Error::Init();
+  }
+
+  if(ilo < 0 || ihi > size() || ilo >= ihi) {
+    std::cerr << funame << "wrong eigenvalue index range: [" << ilo << ", " << ihi << ")\n";
+    throw Error::Range();
+  }
+
+  const int_t esize = ihi - ilo;
+
+  // full storage: upper triangle
+  //
+  Matrix a(size());
+  const double* dp = *this;
+  for(int_t j = 0; j < size(); ++j)
+    for(int_t i = 0; i <= j; ++i, ++dp)
+      a(i, j) = *dp;
+
+  const char job = evec ? 'V' : 'N';
+
+  double* z = 0;
+  if(evec) {
+    evec->resize(size(), esize);
+    z = *evec;
+  }
+
+  Vector       res(size());
+  Array<int_t> isuppz(2 * esize);
+
+  // workspace size
+  //
+  double dtemp;
+  int_t  itemp;
+  int_t  info = 0;
+  int_t  m;
+  dsyevr_(job, 'I', 'U', size(), a, size(), 0., 0., ilo + 1, ihi, 0., m, res, z, size(), 
+	  isuppz, &dtemp, -1, &itemp, -1, info);
+
+  if(info) {
+    std::cerr << funame << "dsyevr: workspace query failed: info = " << info << "\n";
+    throw Error::Logic();
+  }
+
+  const int_t lwork  = (int_t)dtemp;
+  const int_t liwork = itemp;
+  
+  Vector       work(lwork);
+  Array<int_t> iwork(liwork);
+
+  dsyevr_(job, 'I', 'U', size(), a, size(), 0., 0., ilo + 1, ihi, 0., m, res, z, size(), 
+	  isuppz, work, lwork, iwork, liwork, info);
+
+  if(info < 0) {
+    std::cerr << funame << "dsyevr: " << -info 
+	      << "-th argument has an illegal value\n";
+    throw Error::Range();
+  }
+  else if(info > 0) {
+    std::cerr << funame << "dsyevr: internal error: info = " << info << "\n";
+    throw Error::Math();
+  }
+
+  if(m != esize) {
+    std::cerr << funame << "dsyevr: number of eigenvalues found, " << m << ", differs from requested, " << esize << "\n";
+    throw Error::Math();
+  }
+
+  Vector eval(esize);
+  for(int_t i = 0; i < esize; ++i)
+    eval[i] = res[i];
+
+  return eval;
+}
+
+Lapack::Vector Lapack::SymmetricMatrix::refined_eigenvalues (Matrix* evec)
+  const 
+{
+  const char funame [] = "Lapack::SymmetricMatrix::refined_eigenvalues: ";
+
+  // relative change of the eigenvalues at convergence
+  //
+  static const double tol = 1.e-12;
+
+  static const int iter_max = 20;
+
+  if(!isinit()) {
+    std::cerr << funame << "not initialized\n";
+    throw Error::Init();
+  }
+
+  const int_t n = size();
+
+  // double precision eigenstates
+  //
+  Matrix x;
+
+  Vector eval = eigenvalues(&x);
+
+  // full storage
+  //
+  Matrix a(n);
+
+  double* const ap = a;
+
+  const double* dp = *this;
+
+  for(int_t j = 0; j < n; ++j)
+    for(int_t i = 0; i <= j; ++i, ++dp)
+      ap[i + j * n] = ap[j + i * n] = *dp;
+
+  const double anorm = vlength(ap, n * n);
+
+  // rounding level of the refined eigenvalues
+  //
+  const double eval_floor = 10. * (double)n * DBL_EPSILON * DBL_EPSILON * anorm;
+
+  // A * X in the doubled precision, S = X^T * A * X, R = I - X^T * X, and the corrections,
+  // X -> X * (I + E)
+  //
+  Matrix yhi(n), ylo(n), s(n), r(n), e(n), xe(n);
+
+  double* const xp   = x;
+  double* const yhip = yhi;
+  double* const ylop = ylo;
+  double* const sp   = s;
+  double* const rp   = r;
+  double* const ep   = e;
+  double* const xep  = xe;
+
+  Vector eval_old(n);
+
+  std::vector<int_t> cluster(n);
+
+  double dtemp, hi, lo;
+
+  bool is_conv = false;
+
+  for(int iter = 0; iter <= iter_max; ++iter) {
+    //
+    for(int_t j = 0; j < n; ++j)
+      //
+      for(int_t k = 0; k < n; ++k)
+	//
+	dd_vdot(ap + k * n, xp + j * n, n, yhip[k + j * n], ylop[k + j * n]);
+
+    for(int_t j = 0; j < n; ++j)
+      //
+      for(int_t i = 0; i <= j; ++i) {
+	//
+	dd_vdot(xp + i * n, yhip + j * n, n, hi, lo);
+
+	sp[i + j * n] = sp[j + i * n] = hi + (lo + vdot(xp + i * n, ylop + j * n, n));
+
+	dd_vdot(xp + i * n, xp + j * n, n, hi, lo);
+
+	rp[i + j * n] = rp[j + i * n] = ((i == j ? 1. : 0.) - hi) - lo;
+      }
+
+    for(int_t i = 0; i < n; ++i)
+      //
+      eval[i] = sp[i + i * n] / (1. - rp[i + i * n]);
+
+    // convergence check
+    //
+    if(iter) {
+      //
+      is_conv = true;
+
+      for(int_t i = 0; i < n; ++i)
+	//
+	if(std::fabs(eval[i] - eval_old[i]) > tol * std::fabs(eval[i]) + eval_floor) {
+	  //
+	  is_conv = false;
+
+	  break;
+	}
+    }
+
+    if(is_conv || iter == iter_max)
+      //
+      break;
+
+    eval_old = eval.copy();
+
+    // the eigenvalues closer than the separation threshold make the clusters
+    //
+    double snorm = 0., rnorm = 0.;
+
+    for(int_t j = 0; j < n; ++j)
+      //
+      for(int_t i = 0; i < n; ++i) {
+	//
+	dtemp = i == j ? sp[i + j * n] - eval[i] : sp[i + j * n];
+
+	snorm += dtemp * dtemp;
+
+	dtemp = rp[i + j * n];
+
+	rnorm += dtemp * dtemp;
+      }
+
+    const double delta = 2. * (std::sqrt(snorm) + anorm * std::sqrt(rnorm));
+
+    cluster[0] = 0;
+
+    for(int_t i = 1; i < n; ++i)
+      //
+      cluster[i] = eval[i] - eval[i - 1] > delta ? i : cluster[i - 1];
+
+    // first order corrections; inside the clusters the eigenvectors are orthonormalized only
+    //
+    for(int_t j = 0; j < n; ++j)
+      //
+      for(int_t i = 0; i < n; ++i)
+	//
+	if(cluster[i] == cluster[j]) {
+	  //
+	  ep[i + j * n] = rp[i + j * n] / 2.;
+	}
+	else
+	  //
+	  ep[i + j * n] = (sp[i + j * n] + eval[j] * rp[i + j * n]) / (eval[j] - eval[i]);
+
+    xe = 0.;
+
+    for(int_t j = 0; j < n; ++j)
+      //
+      for(int_t k = 0; k < n; ++k) {
+	//
+	dtemp = ep[k + j * n];
+
+	for(int_t i = 0; i < n; ++i)
+	  //
+	  xep[i + j * n] += xp[i + k * n] * dtemp;
+      }
+
+    for(int_t i = 0; i < n * n; ++i)
+      //
+      xp[i] += xep[i];
+
+    // the clusters eigenvectors are rotated by the Rayleigh-Ritz procedure with the projection
+    // evaluated in the doubled precision
+    //
+    for(int_t c = 0; c < n;) {
+      //
+      int_t c1 = c + 1;
+
+      while(c1 < n && cluster[c1] == c)
+	//
+	++c1;
+
+      const int_t m = c1 - c;
+
+      if(m > 1) {
+	//
+	dtemp = 0.;
+
+	for(int_t i = c; i < c1; ++i)
+	  //
+	  dtemp += sp[i + i * n];
+
+	dtemp /= (double)m;
+
+	SymmetricMatrix sc(m);
+
+	for(int_t j = 0; j < m; ++j)
+	  //
+	  for(int_t i = 0; i <= j; ++i)
+	    //
+	    sc(i, j) = sp[c + i + (c + j) * n] - (i == j ? dtemp : 0.);
+
+	Matrix q;
+
+	sc.eigenvalues(&q);
+
+	xe = 0.;
+
+	for(int_t l = 0; l < m; ++l)
+	  //
+	  for(int_t k = 0; k < m; ++k) {
+	    //
+	    dtemp = q(k, l);
+
+	    for(int_t i = 0; i < n; ++i)
+	      //
+	      xep[i + l * n] += xp[i + (c + k) * n] * dtemp;
+	  }
+
+	for(int_t i = 0; i < n * m; ++i)
+	  //
+	  xp[i + c * n] = xep[i];
+      }
+
+      c = c1;
+    }
+  }
+
+  if(!is_conv)
+    //
+    IO::log << IO::log_offset << funame << "WARNING: refinement did not converge in " << iter_max << " iterations\n";
+
+  // ascending order, which may change inside the clusters
+  //
+  for(int_t i = 1; i < n; ++i)
+    //
+    for(int_t j = i; j > 0 && eval[j] < eval[j - 1]; --j) {
+      //
+      std::swap(eval[j], eval[j - 1]);
+
+      std::swap_ranges(xp + j * n, xp + (j + 1) * n, xp + (j - 1) * n);
+    }
+
+  if(evec)
+    //
+    *evec = x;
+
+  return eval;
+}
+
 Lapack::SymmetricMatrix Lapack::SymmetricMatrix::invert () const 
 {
   const char funame [] = "Lapack::SymmetricMatrix::invert: ";
@@ -1078,6 +1962,203 @@ Lapack::Vector Lapack::diagonalize (const HermitianMatrix& a0, const HermitianMa
   throw Error::Run();
 }
 
+void Lapack::batch_eigenvalues (int n, int batch, const double* a, double* eval, double* evec) 
+{
+  const char funame [] = "Lapack::batch_eigenvalues: ";
+
+  static const double eps = 1.e-15;
+
+  static const int sweep_max = 50;
+
+  if(n <= 0 || batch <= 0) {
+    //
+    std::cerr << funame << "out of range\n";
+
+    throw Error::Range();
+  }
+
+  // full matrices and eigenvectors, the batch index running fastest
+  //
+  std::vector<double> m(n * n * batch);
+  std::vector<double> v(n * n * batch, 0.);
+
+  for(int j = 0; j < n; ++j)
+    //
+    for(int i = 0; i <= j; ++i) {
+      //
+      const double* src = a + (i + j * (j + 1) / 2) * batch;
+
+      double* mij = &m[(i * n + j) * batch];
+      double* mji = &m[(j * n + i) * batch];
+
+      for(int k = 0; k < batch; ++k)
+	//
+	mij[k] = mji[k] = src[k];
+    }
+
+  for(int i = 0; i < n; ++i)
+    //
+    for(int k = 0; k < batch; ++k)
+      //
+      v[(i * n + i) * batch + k] = 1.;
+
+  std::vector<double> c(batch), s(batch), t(batch);
+
+  int sweep = 0;
+
+  for(; sweep < sweep_max; ++sweep) {// sweep cycle
+    //
+    // convergence: off-diagonal norm relative to the matrix norm, the worst in the batch
+    //
+    double off_max = 0.;
+
+    for(int k = 0; k < batch; ++k) {
+      //
+      double off = 0., norm = 0.;
+
+      for(int i = 0; i < n; ++i)
+	//
+	for(int j = 0; j < n; ++j) {
+	  //
+	  const double dtemp = m[(i * n + j) * batch + k] * m[(i * n + j) * batch + k];
+
+	  norm += dtemp;
+
+	  if(i != j)
+	    //
+	    off += dtemp;
+	}
+
+      if(norm > 0.)
+	//
+	off /= norm;
+
+      off_max = off > off_max ? off : off_max;
+    }
+
+    if(off_max <= eps * eps)
+      //
+      break;
+
+    for(int p = 0; p < n - 1; ++p)
+      //
+      for(int q = p + 1; q < n; ++q) {// rotation cycle
+	//
+	double* mpp = &m[(p * n + p) * batch];
+	double* mqq = &m[(q * n + q) * batch];
+	double* mpq = &m[(p * n + q) * batch];
+	double* mqp = &m[(q * n + p) * batch];
+
+	// rotation angles
+	//
+	for(int k = 0; k < batch; ++k) {
+	  //
+	  double tk = 0.;
+
+	  if(mpq[k] != 0.) {
+	    //
+	    const double theta = (mqq[k] - mpp[k]) / (2. * mpq[k]);
+
+	    tk = 1. / (std::fabs(theta) + std::sqrt(theta * theta + 1.));
+
+	    if(theta < 0.)
+	      //
+	      tk = -tk;
+	  }
+
+	  t[k] = tk;
+
+	  c[k] = 1. / std::sqrt(tk * tk + 1.);
+
+	  s[k] = tk * c[k];
+	}
+
+	for(int k = 0; k < batch; ++k) {
+	  //
+	  mpp[k] -= t[k] * mpq[k];
+	  mqq[k] += t[k] * mpq[k];
+
+	  mpq[k] = mqp[k] = 0.;
+	}
+
+	for(int r = 0; r < n; ++r) {
+	  //
+	  if(r == p || r == q)
+	    //
+	    continue;
+
+	  double* mrp = &m[(r * n + p) * batch];
+	  double* mrq = &m[(r * n + q) * batch];
+	  double* mpr = &m[(p * n + r) * batch];
+	  double* mqr = &m[(q * n + r) * batch];
+
+	  for(int k = 0; k < batch; ++k) {
+	    //
+	    const double xp = mrp[k];
+	    const double xq = mrq[k];
+
+	    mrp[k] = mpr[k] = c[k] * xp - s[k] * xq;
+	    mrq[k] = mqr[k] = s[k] * xp + c[k] * xq;
+	  }
+	}
+
+	if(!evec)
+	  //
+	  continue;
+
+	for(int r = 0; r < n; ++r) {
+	  //
+	  double* vrp = &v[(r * n + p) * batch];
+	  double* vrq = &v[(r * n + q) * batch];
+
+	  for(int k = 0; k < batch; ++k) {
+	    //
+	    const double xp = vrp[k];
+	    const double xq = vrq[k];
+
+	    vrp[k] = c[k] * xp - s[k] * xq;
+	    vrq[k] = s[k] * xp + c[k] * xq;
+	  }
+	}
+      }// rotation cycle
+  }// sweep cycle
+
+  if(sweep == sweep_max) {
+    //
+    std::cerr << funame << "did not converge in " << sweep_max << " sweeps\n";
+
+    throw Error::Math();
+  }
+
+  // ascending order
+  //
+  std::vector<int> order(n);
+
+  for(int k = 0; k < batch; ++k) {
+    //
+    for(int i = 0; i < n; ++i)
+      //
+      order[i] = i;
+
+    for(int i = 1; i < n; ++i)
+      //
+      for(int j = i; j > 0 && m[(order[j] * n + order[j]) * batch + k] < m[(order[j - 1] * n + order[j - 1]) * batch + k]; --j)
+	//
+	std::swap(order[j], order[j - 1]);
+
+    for(int i = 0; i < n; ++i) {
+      //
+      eval[i * batch + k] = m[(order[i] * n + order[i]) * batch + k];
+
+      if(evec)
+	//
+	for(int r = 0; r < n; ++r)
+	  //
+	  evec[(r + i * n) * batch + k] = v[(r * n + order[i]) * batch + k];
+    }
+  }
+}
+
 /****************************************************************
  ********************** LU Factorization ************************
  ****************************************************************/
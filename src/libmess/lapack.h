@@ -64,6 +64,69 @@ extern "C" {
 	      double* work, const Lapack::int_t& lwork, Lapack::int_t* iwork, const Lapack::int_t& liwork,
 	      Lapack::int_t& info);
   
+  int dsbevx_(const char& job, const char& range, const char& uplo, const Lapack::int_t& n, 
+	      const Lapack::int_t& kd, double* ab, const Lapack::int_t& ldab, double* q, 
+	      const Lapack::int_t& ldq, const double& vl, const double& vu, const Lapack::int_t& il, 
+	      const Lapack::int_t& iu, const double& abstol, Lapack::int_t& m, double* w, double* z, 
+	      const Lapack::int_t& ldz, double* work, Lapack::int_t* iwork, Lapack::int_t* ifail, 
+	      Lapack::int_t& info);
+
+  int dpbtrf_(const char& uplo, const Lapack::int_t& n, const Lapack::int_t& kd, double* ab,
+	      const Lapack::int_t& ldab, Lapack::int_t& info);
+
+  int dpbtrs_(const char& uplo, const Lapack::int_t& n, const Lapack::int_t& kd, const Lapack::int_t& nrhs,
+	      const double* ab, const Lapack::int_t& ldab, double* b, const Lapack::int_t& ldb,
+	      Lapack::int_t& info);
+  
+  int dsyevd_(const char& job, const char& uplo, const Lapack::int_t& n, double* a, const Lapack::int_t& lda, 
+	      double* w, double* work, const Lapack::int_t& lwork, Lapack::int_t* iwork, 
+	      const Lapack::int_t& liwork, Lapack::int_t& info);
+
+  // eigenvalues and eigenvectors of the symmetric matrix by the relatively robust representations
+  //
+  int dsyevr_(const char&          job,   // job type: V - eigenvalues and eigenvectors; N - eigenvalues only
+	      //
+	      const char&          range, // A - all eigenvalues; V - in (vl, vu] interval; I - il-th through iu-th
+	      //
+	      const char&          uplo,  // U - upper triangle; L - lower triangle
+	      //
+	      const Lapack::int_t& n,     // matrix order
+	      //
+	      double*              a,     // matrix, destroyed on exit
+	      //
+	      const Lapack::int_t& lda,   // leading dimension of matrix a
+	      //
+	      const double&        vl,    // eigenvalues interval lower bound
+	      //
+	      const double&        vu,    // eigenvalues interval upper bound
+	      //
+	      const Lapack::int_t& il,    // smallest eigenvalue index (starting from one)
+	      //
+	      const Lapack::int_t& iu,    // largest eigenvalue index (starting from one)
+	      //
+	      const double&        abstol,// absolute tolerance
+	      //
+	      Lapack::int_t&       m,     // number of eigenvalues found
+	      //
+	      double*              w,     // eigenvalues
+	      //
+	      double*              z,     // eigenvectors
+	      //
+	      const Lapack::int_t& ldz,   // leading dimension of matrix z
+	      //
+	      Lapack::int_t*       isuppz,// eigenvectors support
+	      //
+	      double*              work,  // real workspace
+	      //
+	      const Lapack::int_t& lwork, // real workspace size
+	      //
+	      Lapack::int_t*       iwork, // integer workspace
+	      //
+	      const Lapack::int_t& liwork,// integer workspace size
+	      //
+	      Lapack::int_t&       info   // exit status
+	      );
+
   int dgesv_(const Lapack::int_t& n, const Lapack::int_t& nrhs, double* a, const Lapack::int_t& lda,
 	     Lapack::int_t* ipiv, double* b, const Lapack::int_t& ldb, Lapack::int_t& info);
 
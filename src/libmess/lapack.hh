@@ -38,6 +38,7 @@ namespace Lapack {
 
   class Vector : private RefArr<double> {
    explicit Vector(const RefArr<double>& a) : RefArr<double>(a) {}
+   explicit Vector(RefArr<double>&& a)      : RefArr<double>(std::move(a)) {}
 
   public:
     typedef       double*       iterator;
@@ -83,8 +84,13 @@ namespace Lapack {
     Vector operator* (const Matrix&) const ;
     Vector operator* (const SymmetricMatrix&) const ;
 
-    Vector operator+ (const Vector&) const ;
-    Vector operator- (const Vector&) const ;
+    Vector operator+ (const Vector&) const & ;
+    Vector operator- (const Vector&) const & ;
+
+    // the storage of the temporary is reused, if it is not shared
+    //
+    Vector operator+ (const Vector&) && ;
+    Vector operator- (const Vector&) && ;
 
     const Vector& operator+= (const Vector&) ;
     const Vector& operator-= (const Vector&) ;
@@ -101,16 +107,34 @@ namespace Lapack {
   
   inline double operator* (ConstSlice<double> p, Vector v) { return v * p; }
   
-  inline Vector Vector::operator+ (const Vector& v) const 
+  inline Vector Vector::operator+ (const Vector& v) const &
   {
     return Vector(RefArr<double>::operator+(v));
   }
 
-  inline Vector Vector::operator- (const Vector& v) const 
+  inline Vector Vector::operator- (const Vector& v) const &
   {
     return Vector(RefArr<double>::operator-(v));
   }
 
+  inline Vector Vector::operator+ (const Vector& v) &&
+  {
+    if(!isinit() || RefArr<double>::ref_count() > 1)
+      return static_cast<const Vector&>(*this) + v;
+
+    *this += v;
+    return std::move(*this);
+  }
+
+  inline Vector Vector::operator- (const Vector& v) &&
+  {
+    if(!isinit() || RefArr<double>::ref_count() > 1)
+      return static_cast<const Vector&>(*this) - v;
+
+    *this -= v;
+    return std::move(*this);
+  }
+
   inline const Vector& Vector::operator+= (const Vector& m) 
   {
     RefArr<double>::operator+=(m);
@@ -199,8 +223,13 @@ namespace Lapack {
     Vector operator* (const Vector&) const ;
     Vector operator* (const double*) const ;
 
-    Matrix operator+ (const Matrix&) const ;
-    Matrix operator- (const Matrix&) const ;
+    Matrix operator+ (const Matrix&) const & ;
+    Matrix operator- (const Matrix&) const & ;
+
+    // the storage of the temporary is reused, if it is not shared
+    //
+    Matrix operator+ (const Matrix&) && ;
+    Matrix operator- (const Matrix&) && ;
 
     Matrix& operator+= (const Matrix&) ;
     Matrix& operator-= (const Matrix&) ;
@@ -351,20 +380,38 @@ namespace Lapack {
     }
   }
 
-  inline Matrix Matrix::operator+ (const Matrix& m) const 
+  inline Matrix Matrix::operator+ (const Matrix& m) const &
   {
     Matrix res(*this, 0);
     res += m;
     return res;
   }
 
-  inline Matrix Matrix::operator- (const Matrix& m) const 
+  inline Matrix Matrix::operator- (const Matrix& m) const &
   {
     Matrix res(*this, 0);
     res -= m;
     return res;
   }
 
+  inline Matrix Matrix::operator+ (const Matrix& m) &&
+  {
+    if(!isinit() || RefArr<double>::ref_count() > 1)
+      return static_cast<const Matrix&>(*this) + m;
+
+    *this += m;
+    return std::move(*this);
+  }
+
+  inline Matrix Matrix::operator- (const Matrix& m) &&
+  {
+    if(!isinit() || RefArr<double>::ref_count() > 1)
+      return static_cast<const Matrix&>(*this) - m;
+
+    *this -= m;
+    return std::move(*this);
+  }
+
   inline Matrix& Matrix::operator+= (const Matrix& m) 
   {
     _check_dim(m);
@@ -486,8 +533,13 @@ namespace Lapack {
     Matrix operator* (const Matrix&)          const ;
     Matrix operator* (const SymmetricMatrix&) const ;
     
-    SymmetricMatrix operator+ (const SymmetricMatrix&) const ;
-    SymmetricMatrix operator- (const SymmetricMatrix&) const ;
+    SymmetricMatrix operator+ (const SymmetricMatrix&) const & ;
+    SymmetricMatrix operator- (const SymmetricMatrix&) const & ;
+
+    // the storage of the temporary is reused, if it is not shared
+    //
+    SymmetricMatrix operator+ (const SymmetricMatrix&) && ;
+    SymmetricMatrix operator- (const SymmetricMatrix&) && ;
 
     SymmetricMatrix operator+= (const SymmetricMatrix&) ;
     SymmetricMatrix operator-= (const SymmetricMatrix&) ;
@@ -501,6 +553,20 @@ namespace Lapack {
 
     Vector    eigenvalues (Matrix* =0) const ;
 
+    // divide-and-conquer algorithm in full storage
+    //
+    Vector dc_eigenvalues (Matrix* =0) const ;
+
+    // eigenvalues with indices in [ilo, ihi) range; eigenvectors are the matrix columns
+    //
+    Vector    eigenvalues (int_t ilo, int_t ihi, Matrix* =0) const ;
+
+    // eigenvalues in double precision, refined by the iterations with the residuals evaluated in the
+    // doubled precision, so that the eigenvalues much smaller than the matrix norm keep their
+    // relative accuracy; eigenvectors are the matrix columns
+    //
+    Vector refined_eigenvalues (Matrix* =0) const ;
+
     SymmetricMatrix invert ()             const ;
     SymmetricMatrix positive_invert ()    const ;
   };
@@ -590,7 +656,7 @@ namespace Lapack {
   }
 
   inline SymmetricMatrix SymmetricMatrix::operator+ (const SymmetricMatrix& m)
-    const 
+    const &
   {
     const char funame [] = "Lapack::SymmetricMatrix::operator+: ";
 
@@ -605,7 +671,7 @@ namespace Lapack {
   }
 
   inline SymmetricMatrix SymmetricMatrix::operator- (const SymmetricMatrix& m)
-    const 
+    const &
   {
     const char funame [] = "Lapack::SymmetricMatrix::operator-: ";
 
@@ -619,6 +685,24 @@ namespace Lapack {
     return res;
   }
 
+  inline SymmetricMatrix SymmetricMatrix::operator+ (const SymmetricMatrix& m) &&
+  {
+    if(!isinit() || RefArr<double>::ref_count() > 1)
+      return static_cast<const SymmetricMatrix&>(*this) + m;
+
+    *this += m;
+    return std::move(*this);
+  }
+
+  inline SymmetricMatrix SymmetricMatrix::operator- (const SymmetricMatrix& m) &&
+  {
+    if(!isinit() || RefArr<double>::ref_count() > 1)
+      return static_cast<const SymmetricMatrix&>(*this) - m;
+
+    *this -= m;
+    return std::move(*this);
+  }
+
   inline SymmetricMatrix SymmetricMatrix::operator+= (const SymmetricMatrix& m) 
   {
     const char funame [] = "Lapack::SymmetricMatrix::operator+=: ";
@@ -743,6 +827,14 @@ namespace Lapack {
   //
   Vector diagonalize(SymmetricMatrix, SymmetricMatrix, Matrix* = 0) ;
 
+  // Eigenvalues and eigenvectors of a batch of small symmetric matrices of the same size
+  // by the cyclic Jacobi method, all the matrices being rotated at once; the element (i, j),
+  // i <= j, of the k-th matrix is a[(i + j * (j + 1) / 2) * batch + k], as in SymmetricMatrix;
+  // the eigenvalues in the ascending order go to eval[i * batch + k] and, if evec is not null,
+  // the eigenvectors to evec[(i + j * n) * batch + k], as in Matrix
+  //
+  void batch_eigenvalues (int n, int batch, const double* a, double* eval, double* evec = 0) ;
+
   /****************************************************************
    ******************* Band Symmetric Matrix **********************
    ****************************************************************/
@@ -750,6 +842,10 @@ namespace Lapack {
   class BandMatrix : private Matrix {
     void _check_size () const ;
 
+    // Rayleigh-Ritz projection on the orthonormal columns, which are replaced by the Ritz vectors
+    //
+    Vector _rayleigh_ritz (Matrix&) const;
+
     BandMatrix (const BandMatrix& m, int_t) : Matrix(m, 0) { } // copy construction by value
 
   public:
@@ -768,8 +864,25 @@ namespace Lapack {
     double& operator() (int_t, int_t) ;
 
     BandMatrix& operator= (double d) { Matrix::operator=(d); return *this; }
+    BandMatrix& operator*= (double d) { Matrix::operator*=(d); return *this; }
+
+    BandMatrix& operator+= (const BandMatrix& m) { Matrix::operator+=(m); return *this; }
 
     Vector eigenvalues (Matrix* =0) const ;
+
+    // eigenvalues with indices in [ilo, ihi) range; eigenvectors are the matrix columns
+    //
+    Vector eigenvalues (int_t ilo, int_t ihi, Matrix* =0) const ;
+
+    // esize lowest eigenvalues by the shift-and-invert Lanczos method with the thick restart;
+    // the shift should be below the spectrum; eigenvectors are the matrix columns; the guessed
+    // eigenvectors, e.g. of the nearby matrix, if given, make the starting vector
+    //
+    Vector lanczos_eigenvalues (int_t esize, double shift, Matrix* evec =0, const Matrix* guess =0) const ;
+
+    // matrix-vector multiplication: y = A * x
+    //
+    void multiply (const double* x, double* y) const;
   };
 
   inline void BandMatrix::_check_size () const 
@@ -783,6 +896,25 @@ namespace Lapack {
     throw Error::Range();
   }
 
+  /****************************************************************
+   ************** Band Matrix Cholesky Factorization **************
+   ****************************************************************/
+
+  // for positively defined matrices; the matrix is shifted by the multiple of the unit matrix
+  //
+  class BandCholesky {
+    Matrix _factor;
+
+  public:
+    explicit BandCholesky (const BandMatrix&, double shift =0.) ;
+
+    int_t size      () const { return _factor.size2(); }
+    int_t band_size () const { return _factor.size1(); }
+
+    Vector invert (const Vector&) const ; // solve linear equations
+    Matrix invert (const Matrix&) const ; // solve linear equations
+  };
+
   /****************************************************************
    ********************** LU Factorization ************************
    ****************************************************************/
@@ -208,6 +208,54 @@ double vdot (const double* v1, const double* v2, int size, int step1, int step2)
   return res;
 }
 
+// error-free transformations: s + e = a + b and p + e = a * b exactly
+//
+static inline void two_sum (double a, double b, double& s, double& e)
+{
+  s = a + b;
+
+  const double z = s - a;
+
+  e = (a - (s - z)) + (b - z);
+}
+
+static inline void two_prod (double a, double b, double& p, double& e)
+{
+  p = a * b;
+
+  e = std::fma(a, b, -p);
+}
+
+void dd_vdot (const double* v1, const double* v2, int size, double& hi, double& lo, int step1, int step2) 
+{
+  const char funame [] = "dd_vdot: ";
+
+  if(step1 <= 0 || step2 <= 0) {
+    std::cerr << funame << "step out of range\n";
+    throw Error::Range();
+  }
+
+  if(size < 0) {
+    std::cerr << funame << "size out of range\n";
+    throw Error::Range();
+  }
+
+  // the running sum and the accumulated rounding errors
+  //
+  double sum = 0., err = 0., p, q, r;
+
+  for (const double* end = v1 + step1 * size; v1 != end; v1 += step1, v2 += step2) {
+    //
+    two_prod(*v1, *v2, p, q);
+
+    two_sum(sum, p, sum, r);
+
+    err += q + r;
+  }
+
+  two_sum(sum, err, hi, lo);
+}
+
 double parallel_vdot (const double* v1, const double* v2, int size, int step1, int step2) 
 {
   const char funame [] = "vdot: ";
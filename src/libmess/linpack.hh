@@ -31,6 +31,11 @@ double vdot      (const double*, const double*, int, int =1, int =1) ;
 double parallel_vdot  (const double*, const double*, int, int =1, int =1) ;
 double vdistance (const double*, const double*, int, int =1, int =1) ;
 
+// dot product as accurate as if computed in the doubled precision (error-free transformations);
+// the result is hi + lo with |lo| not exceeding half the unit in the last place of hi
+//
+void dd_vdot (const double*, const double*, int, double& hi, double& lo, int =1, int =1) ;
+
 void multiply (double*, double, int, int= 1);
 
 template <typename V>
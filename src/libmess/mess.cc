@@ -20,12 +20,21 @@
 #include <list>
 #include <map>
 #include <ctime>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <mutex>
+#include <exception>
+#include <stdint.h>
+#include <unistd.h>
 
 #include "mess.hh"
 #include "units.hh"
 #include "key.hh"
 #include "io.hh"
 #include "shared.hh"
+#include "arena.hh"
 
 #ifdef WITH_MPACK
 
@@ -37,24 +46,16 @@ namespace MasterEquation {
   /*********************************** AUXILIARY OUTPUT *************************************/
 
 
-  std::ofstream eval_out;// eigenvalues output
+  IO::LogOut eval_out;// eigenvalues output
   int  red_out_num = 5; // number of reduction schemes to print 
 
-  std::ofstream evec_out;
+  IO::LogOut evec_out;
   int evec_out_num = 0;
 
-  std::ofstream arr_out; // arrhenius 
+  IO::LogOut arr_out; // arrhenius 
 
   /********************************* USER DEFINED PARAMETERS ********************************/
 
-  // temperature
-  double                                                     _temperature     = -1.;
-  // pressure
-  double                                                     _pressure        = -1.;
-  // energy grid step
-  double                                                     _energy_step     = -1.;
-  // zero energy (also upper limit)
-  double                                                     _energy_reference;
   // well depth cutoff parameter 
   double                                                     well_cutoff       = -1.;
   // highest chemecial eigenvalue
@@ -85,10 +86,19 @@ namespace MasterEquation {
   // well partition threshold
   double                                                     well_projection_threshold = 0.2;
 
-  /********************************* INTERNAL PARAMETERS ************************************/
+  // global relaxation matrix eigensolver
+  int                                                        eigensolver = PACKED_EIGENSOLVER;
+
+  // chemical subspace eigensolver
+  int                                                        chem_eigensolver = REFINED_CHEM_EIGENSOLVER;
+
+  // adaptive energy grid widest node spacing in the units of the energy transfer range; zero disables it
+  double                                                     adaptive_grid_width = 0.;
+
+  // states grid cache directory
+  std::string                                                grid_cache_dir;
 
-  // inner setting check
-  bool  _isset = false;
+  /********************************* INTERNAL PARAMETERS ************************************/
 
   // collisional frequency
   //double _collision_frequency_factor;
@@ -100,77 +110,76 @@ namespace MasterEquation {
 
   /*******************************************************************************************/
 
-  std::vector<double> _thermal_factor;
+  // default context and the context of the current thread
+  //
+  Context _default_context;
+
+  thread_local Context* _current_context = 0;
+
+  Context& context () { if(_current_context) return *_current_context; return _default_context; }
 
-  std::vector<SharedPointer<Well> >  _well;
-  const Well& well (int w) { return *_well[w]; } 
+  void set_context (Context* c) { _current_context = c; }
 
-  std::vector<SharedPointer<Bimolecular> >  _bimolecular;
-  const Bimolecular& bimolecular (int p) { return *_bimolecular[p]; }
+  const Well& well (int w) { return *context().well[w]; } 
 
-  std::vector<SharedPointer<Barrier> > _inner_barrier;
-  const Barrier& inner_barrier (int p) { return *_inner_barrier[p]; }
+  const Bimolecular& bimolecular (int p) { return *context().bimolecular[p]; }
 
-  std::vector<SharedPointer<Barrier> > _outer_barrier;
-  const Barrier& outer_barrier (int p) { return *_outer_barrier[p]; }
+  const Barrier& inner_barrier (int p) { return *context().inner_barrier[p]; }
+
+  const Barrier& outer_barrier (int p) { return *context().outer_barrier[p]; }
   
   // Boltzmann factor: exp(-E/T)
   double        thermal_factor (int); 
   void   resize_thermal_factor (int);
   void    reset_thermal_factor (int = 0);
 
-  bool isset () { return _isset; }
+  bool isset () { return context().isset; }
   
-  double energy_reference () { return _energy_reference; }
+  double energy_reference () { return context().energy_reference; }
 
   double temperature ()
   {
     const char funame [] = "MasterEquation::temperature: ";
     
-    if(_temperature <= 0.) {
+    if(context().temperature <= 0.) {
       std::cerr << funame << "not initialized\n";
       throw Error::Init();
     }
     
-    return _temperature;
+    return context().temperature;
   }
   
   double energy_step ()
   {
     const char funame [] = "MasterEquation::energy_step: ";
     
-    if(_energy_step <= 0.) {
+    if(context().energy_step <= 0.) {
       std::cerr << funame << "not initialized\n";
       throw Error::Init();
     }
     
-    return _energy_step;
+    return context().energy_step;
   }
   
   double pressure                ()
   {
     const char funame [] = "MasterEquation::pressure: ";
     
-    if(_pressure <= 0.) {
+    if(context().pressure <= 0.) {
       std::cerr << funame << "not initialized\n";
       throw Error::Init();
     }
     
-    return _pressure;
+    return context().pressure;
   }
   //double collision_frequency     () { return _collision_frequency;    }
   //double kernel_fraction    (int i) { return _kernel_fraction[i];     }
 
-  // cumulative number of states for each well
-  std::vector<Array<double> >  cum_stat_num;
-
   // capture probabilities
   std::map<std::string, std::vector<double> > hot_energy;
-  std::map<int, std::vector<int> >            hot_index;
-  int hot_energy_size;
 
   // product energy distributions
-  std::ofstream  ped_out;// product energy distribution output stream
+  IO::LogOut  ped_out;// product energy distribution output stream
   std::vector<std::pair<int, int> > ped_pair; // product energy distribution reactants and products indices
 }
 
@@ -178,8 +187,8 @@ void MasterEquation::set_temperature (double t)
 { 
   double dtemp;
 
-  _isset  = false;
-  _temperature = t;
+  context().isset  = false;
+  context().temperature = t;
 
   reset_thermal_factor();
   /*
@@ -200,20 +209,20 @@ void MasterEquation::set_temperature (double t)
 
 void MasterEquation::set_energy_step (double e) 
 { 
-  _isset = false; 
-  _energy_step = e; 
+  context().isset = false; 
+  context().energy_step = e; 
   reset_thermal_factor(); 
 }
 
 void MasterEquation::set_energy_reference (double e) 
 {
-  _isset = false;
-  _energy_reference = e;
+  context().isset = false;
+  context().energy_reference = e;
 }
 
 void MasterEquation::set_pressure (double p) 
 {
-  _pressure = p;
+  context().pressure = p;
   //_collision_frequency = p * _collision_frequency_factor; 
 }
 
@@ -223,33 +232,33 @@ void MasterEquation::set_pressure (double p)
 
 double MasterEquation::thermal_factor(int e)
 {
-  if(e >= _thermal_factor.size())
+  if(e >= context().thermal_factor.size())
     resize_thermal_factor(e + 1);
-    return _thermal_factor[e];
+    return context().thermal_factor[e];
 }
 
 void  MasterEquation::resize_thermal_factor(int s)
 {
-  if(s <= _thermal_factor.size())
+  if(s <= context().thermal_factor.size())
     return;
 
-  int emin = _thermal_factor.size();
-  _thermal_factor.resize(s);
+  int emin = context().thermal_factor.size();
+  context().thermal_factor.resize(s);
 
   double x = energy_step() / temperature();
-  for(int e = emin; e < _thermal_factor.size(); ++e)
-    _thermal_factor[e] = std::exp(double(e) * x);
+  for(int e = emin; e < context().thermal_factor.size(); ++e)
+    context().thermal_factor[e] = std::exp(double(e) * x);
 }
 
 void  MasterEquation::reset_thermal_factor(int s)
 {
-  _thermal_factor.resize(s);
+  context().thermal_factor.resize(s);
   if(!s)
     return;
 
   double x = energy_step() / temperature();
-  for(int e = 0; e < _thermal_factor.size(); ++e)
-    _thermal_factor[e] = std::exp(double(e) * x);
+  for(int e = 0; e < context().thermal_factor.size(); ++e)
+    context().thermal_factor[e] = std::exp(double(e) * x);
 }
 
 /************************************* PRODUCT ENERGY DISTRIBUTION PAIRS ********************************************/
@@ -397,7 +406,14 @@ void MasterEquation::set (std::map<std::pair<int, int>, double>& rate_data, std:
   rate_data.clear();
 
 
-  _isset = true;
+  context().isset = true;
+
+  // the relaxation matrix continuation is valid at given temperature only
+  //
+  context().relax_base      = Lapack::BandMatrix();
+  context().relax_collision = Lapack::BandMatrix();
+  context().relax_pressure  = -1.;
+  context().relax_evec      = Lapack::Matrix();
 
   int    itemp;
   double dtemp;
@@ -410,25 +426,25 @@ void MasterEquation::set (std::map<std::pair<int, int>, double>& rate_data, std:
   {
     IO::Marker set_marker("setting wells, barriers, and bimolecular");
 
-    _well.resize(Model::well_size());
+    context().well.resize(Model::well_size());
     // wells
-    for(int w = 0; w < _well.size(); ++w)
-      _well[w] = SharedPointer<Well>(new Well(Model::well(w)));
+    for(int w = 0; w < context().well.size(); ++w)
+      context().well[w] = SharedPointer<Well>(new Well(Model::well(w)));
 
     // well-to-well barriers
-    _inner_barrier.resize(Model::inner_barrier_size());
-    for(int b = 0; b < _inner_barrier.size(); ++b)
-      _inner_barrier[b] = SharedPointer<Barrier>(new Barrier(Model::inner_barrier(b)));
+    context().inner_barrier.resize(Model::inner_barrier_size());
+    for(int b = 0; b < context().inner_barrier.size(); ++b)
+      context().inner_barrier[b] = SharedPointer<Barrier>(new Barrier(Model::inner_barrier(b)));
 
     // well-to-bimolecular barriers
-    _outer_barrier.resize(Model::outer_barrier_size());
-    for(int b = 0; b < _outer_barrier.size(); ++b)
-      _outer_barrier[b] = SharedPointer<Barrier>(new Barrier(Model::outer_barrier(b)));
+    context().outer_barrier.resize(Model::outer_barrier_size());
+    for(int b = 0; b < context().outer_barrier.size(); ++b)
+      context().outer_barrier[b] = SharedPointer<Barrier>(new Barrier(Model::outer_barrier(b)));
 
     // bimolecular products
-    _bimolecular.resize(Model::bimolecular_size());
-    for(int p = 0; p < _bimolecular.size(); ++p)
-      _bimolecular[p] = SharedPointer<Bimolecular>(new Bimolecular(Model::bimolecular(p)));
+    context().bimolecular.resize(Model::bimolecular_size());
+    for(int p = 0; p < context().bimolecular.size(); ++p)
+      context().bimolecular[p] = SharedPointer<Bimolecular>(new Bimolecular(Model::bimolecular(p)));
 
   }
 
@@ -442,7 +458,7 @@ void MasterEquation::set (std::map<std::pair<int, int>, double>& rate_data, std:
     if(itemp  < inner_barrier(b).size()) {
       IO::log << IO::log_offset << Model::inner_barrier(b).name() 
 	      << " barrier top is lower than the bottom of one of the wells it connects => truncating\n"; 
-      _inner_barrier[b]->truncate(itemp);
+      context().inner_barrier[b]->truncate(itemp);
     }
   }
   
@@ -453,7 +469,7 @@ void MasterEquation::set (std::map<std::pair<int, int>, double>& rate_data, std:
     if(itemp  < outer_barrier(b).size()) {
       IO::log << IO::log_offset << Model::outer_barrier(b).name()
 	      << " barrier top is lower than the bottom of the well it connects => truncating\n"; 
-      _outer_barrier[b]->truncate(itemp);
+      context().outer_barrier[b]->truncate(itemp);
     }
   }
 
@@ -465,13 +481,13 @@ void MasterEquation::set (std::map<std::pair<int, int>, double>& rate_data, std:
     for(int b = 0; b < Model::inner_barrier_size(); ++b) {
       int w1 = Model::inner_connect(b).first;
       int w2 = Model::inner_connect(b).second;
-      for(int i = 0; i < _inner_barrier[b]->size(); ++i) {
+      for(int i = 0; i < context().inner_barrier[b]->size(); ++i) {
 	dtemp = well(w1).state_density(i) < well(w2).state_density(i) ? 
 	  well(w1).state_density(i) : well(w2).state_density(i);
 	dtemp *= rate_max * 2. * M_PI;
 	
-	if(_inner_barrier[b]->state_number(i) > dtemp)
-	  _inner_barrier[b]->state_number(i) = dtemp;
+	if(context().inner_barrier[b]->state_number(i) > dtemp)
+	  context().inner_barrier[b]->state_number(i) = dtemp;
       }
     }
     
@@ -479,17 +495,17 @@ void MasterEquation::set (std::map<std::pair<int, int>, double>& rate_data, std:
     //
     for(int b = 0; b < Model::outer_barrier_size(); ++b) {
       int w = Model::outer_connect(b).first;
-      for(int i = 0; i < _outer_barrier[b]->size(); ++i) {
+      for(int i = 0; i < context().outer_barrier[b]->size(); ++i) {
 	dtemp = rate_max * 2. * M_PI * well(w).state_density(i);
 
-	if(_outer_barrier[b]->state_number(i) > dtemp)
-	  _outer_barrier[b]->state_number(i) = dtemp;
+	if(context().outer_barrier[b]->state_number(i) > dtemp)
+	  context().outer_barrier[b]->state_number(i) = dtemp;
       }
     }
   }
 
   // cumulative number of states for each well
-  cum_stat_num.resize(Model::well_size());
+  context().cum_stat_num.resize(Model::well_size());
   for(int w = 0; w < Model::well_size(); ++w) {// well cycle
     itemp = 0;
     for(int b = 0; b < Model::inner_barrier_size(); ++b)
@@ -499,17 +515,17 @@ void MasterEquation::set (std::map<std::pair<int, int>, double>& rate_data, std:
       if(Model::outer_connect(b).first == w)
 	itemp = outer_barrier(b).size() > itemp ? outer_barrier(b).size() : itemp;
 
-    cum_stat_num[w].resize(itemp);
+    context().cum_stat_num[w].resize(itemp);
     
-    cum_stat_num[w] = 0.;
+    context().cum_stat_num[w] = 0.;
     for(int b = 0; b < Model::inner_barrier_size(); ++b)
       if(Model::inner_connect(b).first == w || Model::inner_connect(b).second == w) 
 	for(int i = 0; i < inner_barrier(b).size(); ++i)
-	  cum_stat_num[w][i] += inner_barrier(b).state_number(i);
+	  context().cum_stat_num[w][i] += inner_barrier(b).state_number(i);
     for(int b = 0; b < Model::outer_barrier_size(); ++b)
       if(Model::outer_connect(b).first == w) 
 	for(int i = 0; i < outer_barrier(b).size(); ++i)
-	  cum_stat_num[w][i] += outer_barrier(b).state_number(i);
+	  context().cum_stat_num[w][i] += outer_barrier(b).state_number(i);
   }// well cycle
 
 
@@ -563,11 +579,11 @@ void MasterEquation::set (std::map<std::pair<int, int>, double>& rate_data, std:
 	      << std::setw(5) << Model::well(w).name();
       dtemp = energy_reference() - double(well(w).size()) * energy_step();
       IO::log << std::setw(7) << (int)std::ceil(dtemp / Phys_const::incm);
-      dtemp = energy_reference() - double(cum_stat_num[w].size()) * energy_step();
+      dtemp = energy_reference() - double(context().cum_stat_num[w].size()) * energy_step();
       IO::log << std::setw(7) << (int)std::ceil(dtemp  / Phys_const::incm);
 
-      if(cum_stat_num[w].size() != well(w).size())
-	itemp = cum_stat_num[w].size();
+      if(context().cum_stat_num[w].size() != well(w).size())
+	itemp = context().cum_stat_num[w].size();
       else
 	itemp = well(w).size() - 1;
 
@@ -745,8 +761,8 @@ void MasterEquation::set (std::map<std::pair<int, int>, double>& rate_data, std:
 
   // hot energies
   if(hot_energy.size()) {
-    hot_index.clear();
-    hot_energy_size = 0;
+    context().hot_index.clear();
+    context().hot_energy_size = 0;
     std::map<std::string, std::vector<double> >::const_iterator hit;
     for(int w = 0; w < Model::well_size(); ++w) {
       hit = hot_energy.find(Model::well(w).name());
@@ -754,8 +770,8 @@ void MasterEquation::set (std::map<std::pair<int, int>, double>& rate_data, std:
 	for(int i = 0; i < hit->second.size(); ++i) {
 	  itemp = int((energy_reference() - hit->second[i]) / energy_step());
 	  if(itemp >= 0 && itemp < well(w).size()) {
-	    hot_index[w].push_back(itemp);
-	    ++hot_energy_size;
+	    context().hot_index[w].push_back(itemp);
+	    ++context().hot_energy_size;
 	  }
 	}
       }
@@ -800,23 +816,15 @@ void  MasterEquation::Well::_set_state_density (const Model::Well& model)
     new_size = itemp < new_size ? itemp : new_size;      
   }
 
-  _state_density.resize(new_size);
   resize_thermal_factor(new_size);
 
   // setting state density
   //
-  double ener = energy_reference();
-  
-  for(int e = 0; e < size(); ++e, ener -= energy_step()) {
-    dtemp = model.states(ener);
-    if(dtemp <= 0.) {
-      IO::log << IO::log_offset << model.name()  << " Well: nonpositive density at " 
-	      << ener / Phys_const::incm << " 1/cm => truncating\n";
-      _state_density.resize(e);      
-      break;    
-    }
-    _state_density[e] = dtemp;
-  }
+  grid_states(*model.species(), new_size, _state_density);
+
+  if(size() < new_size)
+    IO::log << IO::log_offset << model.name()  << " Well: nonpositive density at " 
+	    << (energy_reference() - (double)size() * energy_step()) / Phys_const::incm << " 1/cm => truncating\n";
 }
 
 void MasterEquation::Well::_set_kernel (const Model::Well& model) 
@@ -849,14 +857,37 @@ void MasterEquation::Well::_set_kernel (const Model::Well& model)
 
   double a, c;
 
+  // collisional energy transfer down probability distributions on the grid
+  //
+  std::vector<std::vector<double> > energy_transfer_form(Model::buffer_size());
+
+  for(int b = 0; b < Model::buffer_size(); ++b) {
+    //
+    itemp = (int)std::ceil(model.kernel(b)->cutoff_energy(temperature()) / energy_step());
+      
+    energy_transfer_form[b].resize(itemp);
+      
+    for(int i = 0; i < energy_transfer_form[b].size(); ++i)
+      //
+      energy_transfer_form[b][i] = (*model.kernel(b))((double)i * energy_step(), temperature());
+
+    if(!b || kernel_bandwidth < energy_transfer_form[b].size())
+      //
+      kernel_bandwidth = energy_transfer_form[b].size();
+  }
+
+  // only the upper triangle of the kernel is stored, the lower one is given by the detailed balance
+  //
   btemp = false;
 
   do {
     //
-    _kernel.resize(size());
+    itemp = kernel_bandwidth < size() ? kernel_bandwidth : size();
+
+    _kernel.resize(size(), itemp);
     _kernel = 0.;
 
-    Lapack::Matrix tmp_kernel(size());
+    Lapack::BandMatrix tmp_kernel(size(), itemp);
 
     for(int b = 0; b < Model::buffer_size(); ++b) {
 
@@ -864,39 +895,31 @@ void MasterEquation::Well::_set_kernel (const Model::Well& model)
 
       tmp_kernel = 0.;
 
-      // collisional energy transfer down probability distribution on the grid
-      //
-      itemp = (int)std::ceil(model.kernel(b)->cutoff_energy(temperature()) / energy_step());
-      
-      std::vector<double> energy_transfer_form(itemp);
-      
-      for(int i = 0; i < energy_transfer_form.size(); ++i)
-	//
-	energy_transfer_form[i] = (*model.kernel(b))((double)i * energy_step(), temperature());
-
-      if(!b || kernel_bandwidth < energy_transfer_form.size())
-	//
-	kernel_bandwidth = energy_transfer_form.size();
+      const std::vector<double>& form = energy_transfer_form[b];
 
       // energy transfer UP probability functional form predefined
       //
       if(Model::Kernel::flags() & Model::Kernel::UP) {
 	//
+	// lower triangle row
+	//
+	std::vector<double> kernel_row(form.size());
+
 	for(int i = size() - 1; i >= 0; --i) {// energy grid cycle
 
-	  itemp = i + energy_transfer_form.size();
+	  itemp = i + form.size();
 	  const int jmax = itemp < size() ? itemp : size(); 
-	  itemp = i - energy_transfer_form.size() + 1;
+	  itemp = i - form.size() + 1;
 	  const int jmin = itemp  > 0 ? itemp : 0;
 
 	  // normalization constant
 	  //
 	  c = 0.;
 	  for(int j = jmin; j <= i; ++j) {
-	    dtemp = energy_transfer_form[i - j];
+	    dtemp = form[i - j];
 	    if(Model::Kernel::flags() & Model::Kernel::DENSITY)
 	      dtemp *= state_density(j);
-	    tmp_kernel(i, j) = -dtemp;
+	    kernel_row[j - jmin] = -dtemp;
 	    c += dtemp;
 	  }
 
@@ -922,12 +945,12 @@ void MasterEquation::Well::_set_kernel (const Model::Well& model)
 
 	    for(int j = jmin; j < i; ++j) {
 	      //
-	      tmp_kernel(i, j) *= a;
+	      dtemp = kernel_row[j - jmin] * a;
 	      
-	      tmp_kernel(j, i) = tmp_kernel(i, j) * state_density(i) / state_density(j) * thermal_factor(i - j);
+	      tmp_kernel(j, i) = dtemp * state_density(i) / state_density(j) * thermal_factor(i - j);
 	    }
       
-	    tmp_kernel(i, i) = tmp_kernel(i, i) * a + kernel_fraction(b);
+	    tmp_kernel(i, i) = kernel_row[i - jmin] * a + kernel_fraction(b);
 	  }
 	}// energy grid cycle
       }
@@ -937,9 +960,9 @@ void MasterEquation::Well::_set_kernel (const Model::Well& model)
 	//
 	for(int i = 0; i < size(); ++i) {// energy grid cycle
 
-	  itemp = i + energy_transfer_form.size();
+	  itemp = i + form.size();
 	  const int jmax = itemp < size() ? itemp : size(); 
-	  itemp = i - energy_transfer_form.size() + 1;
+	  itemp = i - form.size() + 1;
 	  const int jmin = itemp  > 0 ? itemp : 0;
 
 	  // normalization constant
@@ -948,7 +971,7 @@ void MasterEquation::Well::_set_kernel (const Model::Well& model)
 	  
 	  for(int j = i; j < jmax; ++j) {
 	    //
-	    dtemp = energy_transfer_form[j - i];
+	    dtemp = form[j - i];
 	    
 	    if(Model::Kernel::flags() & Model::Kernel::DENSITY)
 	      //
@@ -965,7 +988,7 @@ void MasterEquation::Well::_set_kernel (const Model::Well& model)
 	  
 	  for(int j = jmin; j < i; ++j)
 	    //
-	    a += tmp_kernel(i, j);
+	    a += tmp_kernel(j, i) * state_density(j) / state_density(i) / thermal_factor(i - j);
 	  
     
 	  if(a < 0.) {
@@ -981,10 +1004,8 @@ void MasterEquation::Well::_set_kernel (const Model::Well& model)
 	      
 	      IO::log << ", collision frequency = " << dtemp << "\n";
 	      tmp_kernel(i, i) = dtemp;
-	      for(int j = i + 1; j < jmax; ++j) {
+	      for(int j = i + 1; j < jmax; ++j)
 		tmp_kernel(i, j) = 0.;
-		tmp_kernel(j, i) = 0.;
-	      }
 	    }
 	    else {
 	      IO::log << ", truncating the well\n";
@@ -996,12 +1017,9 @@ void MasterEquation::Well::_set_kernel (const Model::Well& model)
 	    //
 	    a /= c;
 	  
-	    for(int j = i + 1; j < jmax; ++j) {
+	    for(int j = i + 1; j < jmax; ++j)
 	      //
 	      tmp_kernel(i, j) *= a;
-	      
-	      tmp_kernel(j, i) = tmp_kernel(i, j) * state_density(i) / state_density(j) / thermal_factor(j - i);
-	    }
 	    
 	    tmp_kernel(i, i) = tmp_kernel(i, i) * a + kernel_fraction(b);
 	  }
@@ -1027,6 +1045,17 @@ void MasterEquation::Well::_set_kernel (const Model::Well& model)
 
 }
 
+double MasterEquation::Well::kernel (int i, int j) const
+{
+  if(i <= j)
+    //
+    return _kernel(i, j);
+
+  // detailed balance
+  //
+  return _kernel(j, i) * state_density(j) / state_density(i) / thermal_factor(i - j);
+}
+
 void MasterEquation::Well::_set_crm_basis ()
 {
   const char funame [] = "MasterEquation::Well::_set_crm_basis: ";
@@ -1125,7 +1154,47 @@ MasterEquation::Well::Well (const Model::Well& model)
   for(int i = 0; i < size(); ++i)
     _crm_bra.row(i) /= boltzman(i);
 
-  _crm_kernel = Lapack::SymmetricMatrix(_crm_basis.transpose() * _kernel * _crm_bra);
+  // the r-th CRM basis vector is proportional to the Boltzmann distribution for i <= r, has 
+  // one more nonzero component at i = r + 1, and vanishes for i > r + 1
+  //
+  _crm_kernel.resize(crm_size());
+
+  {
+    // kernel row partial sums, sum_{j <= s} K(i, j)
+    //
+    std::vector<double> row_sum(size());
+    
+    // kernel times the bra basis vector
+    //
+    std::vector<double> kernel_bra(size());
+
+    for(int s = 0; s < crm_size(); ++s) {
+      //
+      itemp = s - kernel_bandwidth + 1;
+      const int imin = itemp > 0 ? itemp : 0;
+      itemp = s + kernel_bandwidth;
+      const int imax = itemp < size() ? itemp : size();
+
+      for(int i = imin; i < imax; ++i)
+	//
+	row_sum[i] += kernel(i, s);
+
+      for(int i = 0; i <= s + 1; ++i)
+	//
+	kernel_bra[i] = row_sum[i] * _crm_bra(0, s) + kernel(i, s + 1) * _crm_bra(s + 1, s);
+
+      // thermally weighted kernel_bra partial sum
+      //
+      double bsum = 0.;
+
+      for(int r = 0; r <= s; ++r) {
+	//
+	bsum += boltzman(r) * kernel_bra[r];
+
+	_crm_kernel(r, s) = bsum * _crm_bra(0, r) + _crm_basis(r + 1, r) * kernel_bra[r + 1];
+      }
+    }
+  }
 
   IO::log << IO::log_offset << model.name() 
 	  << " Well: kernel in relaxation modes basis done, elapsed time[sec] = "
@@ -1244,6 +1313,233 @@ MasterEquation::Well::Well (const Model::Well& model)
 	  << int((energy_reference() - (double)size() * energy_step()) / Phys_const::incm) << " 1/cm\n";
 }
 
+/********************************************************************************************
+ *********************************** STATES GRID CACHE **************************************
+ ********************************************************************************************/
+
+namespace MasterEquation {
+  //
+  // states on the grid computed so far
+  //
+  struct _GridStates {
+    std::vector<double> value;
+    bool                complete; // nonpositive value has been reached
+    
+    _GridStates () : complete(false) {}
+  };
+
+  // only the states on the last energy grid are kept in memory: the grid changes with the
+  // temperature, unless the energy step and the reference energy are given explicitly
+  //
+  std::map<std::string, _GridStates> _grid_cache;
+
+  std::pair<double, double>          _grid_cache_grid; // energy reference and step
+
+  std::mutex                         _grid_cache_lock;
+
+  const char _grid_cache_magic [] = "MESSGRD1";
+
+  // the species name, mode, and input description hash, which detects the changes of
+  // the species model between the jobs, and the energy grid
+  //
+  std::string _grid_key (const Model::Species& model)
+  {
+    std::ostringstream key;
+
+    key.precision(17);
+
+    key << model.name() << " " << model.mode() << " " << model.input_hash() << " " << model.ground() << " "
+	<< energy_reference() << " " << energy_step();
+
+    return key.str();
+  }
+
+  std::string _grid_file (const std::string& key)
+  {
+    uint64_t hash = 14695981039346656037ULL;
+
+    for(int i = 0; i < key.size(); ++i) {
+      hash ^= (unsigned char)key[i];
+      hash *= 1099511628211ULL;
+    }
+
+    char buf [17];
+
+    std::sprintf(buf, "%016llx", (unsigned long long)hash);
+
+    return grid_cache_dir + "/" + buf + ".grd";
+  }
+
+  bool _load_grid (const std::string& key, _GridStates& data)
+  {
+    std::ifstream from(_grid_file(key).c_str(), std::ios::binary);
+
+    if(!from)
+      return false;
+
+    char     magic [sizeof(_grid_cache_magic) - 1];
+    uint32_t key_size;
+    char     complete;
+    uint64_t value_size;
+
+    if(!from.read(magic, sizeof(magic)) || std::memcmp(magic, _grid_cache_magic, sizeof(magic)) ||
+       !from.read((char*)&key_size, sizeof(key_size)))
+      return false;
+
+    std::string stemp(key_size, 0);
+
+    if(!from.read(&stemp[0], key_size) || stemp != key)
+      return false;
+
+    if(!from.read(&complete, 1) || !from.read((char*)&value_size, sizeof(value_size)))
+      return false;
+
+    data.value.resize(value_size);
+
+    if(value_size && !from.read((char*)&data.value[0], value_size * sizeof(double)))
+      return false;
+
+    data.complete = complete;
+
+    return true;
+  }
+
+  // the file is written under a temporary name and renamed, so that it is always complete
+  //
+  void _save_grid (const std::string& key, const _GridStates& data)
+  {
+    const char funame [] = "MasterEquation::_save_grid: ";
+
+    const std::string file = _grid_file(key);
+
+    std::ostringstream tmp;
+
+    tmp << file << "." << getpid() << ".tmp";
+
+    {
+      std::ofstream to(tmp.str().c_str(), std::ios::binary);
+
+      if(!to) {
+	std::cerr << funame << "WARNING: cannot open " << tmp.str() << " file\n";
+	return;
+      }
+
+      const uint32_t key_size   = key.size();
+      const char     complete   = data.complete;
+      const uint64_t value_size = data.value.size();
+
+      to.write(_grid_cache_magic, sizeof(_grid_cache_magic) - 1);
+      to.write((const char*)&key_size, sizeof(key_size));
+      to.write(key.data(), key_size);
+      to.write(&complete, 1);
+      to.write((const char*)&value_size, sizeof(value_size));
+
+      if(value_size)
+	to.write((const char*)&data.value[0], value_size * sizeof(double));
+
+      if(!to) {
+	std::cerr << funame << "WARNING: cannot write " << tmp.str() << " file\n";
+	std::remove(tmp.str().c_str());
+	return;
+      }
+    }
+
+    if(std::rename(tmp.str().c_str(), file.c_str())) {
+      std::cerr << funame << "WARNING: cannot rename " << tmp.str() << " file\n";
+      std::remove(tmp.str().c_str());
+    }
+  }
+}
+
+void MasterEquation::grid_states (const Model::Species& model, int size, Lapack::Vector& states)
+{
+  const char funame [] = "MasterEquation::grid_states: ";
+
+  int    itemp;
+
+  if(size < 0) {
+    std::cerr << funame << "negative size\n";
+    throw Error::Range();
+  }
+  
+  const std::string key = _grid_key(model);
+
+  // the species model without the input description cannot be identified between the jobs
+  //
+  const bool use_dir = grid_cache_dir.size() && model.input_hash().size();
+
+  _GridStates data;
+
+  bool from_file = false;
+
+  {
+    std::lock_guard<std::mutex> lock(_grid_cache_lock);
+
+    std::map<std::string, _GridStates>::const_iterator cit = _grid_cache.find(key);
+
+    if(cit != _grid_cache.end())
+      data = cit->second;
+    else if(use_dir)
+      from_file = _load_grid(key, data);
+  }
+
+  const int cache_size = data.value.size();
+
+  // compute missing values
+  //
+  if(!data.complete && cache_size < size) {
+    //
+    std::vector<double> value(size - cache_size);
+
+    model.states_on_grid(energy_reference() - (double)cache_size * energy_step(), energy_step(), value.size(), value.data());
+
+    for(int e = 0; e < value.size(); ++e) {
+      //
+      if(value[e] <= 0.) {
+	data.complete = true;
+	break;
+      }
+
+      data.value.push_back(value[e]);
+    }
+  }
+
+  if(cache_size)
+    IO::log << IO::log_offset << model.name() << ": " << (cache_size < data.value.size() ? cache_size : data.value.size())
+	    << " grid states reused" << (from_file ? " from the cache directory" : "") << "\n";
+  
+  itemp = size < data.value.size() ? size : data.value.size();
+
+  states.resize(itemp);
+
+  for(int e = 0; e < itemp; ++e)
+    states[e] = data.value[e];
+
+  if(data.value.size() == cache_size && !from_file)
+    return;
+  
+  std::lock_guard<std::mutex> lock(_grid_cache_lock);
+
+  const std::pair<double, double> grid(energy_reference(), energy_step());
+
+  if(grid != _grid_cache_grid) {
+    //
+    _grid_cache.clear();
+
+    _grid_cache_grid = grid;
+  }
+
+  _GridStates& cache = _grid_cache[key];
+
+  if(cache.value.size() > data.value.size() || (cache.complete && !data.complete))
+    return;
+
+  cache = data;
+
+  if(use_dir && data.value.size() > cache_size)
+    _save_grid(key, data);
+}
+
 /********************************************************************************************
  ************************************ SETTING BARRIER ***************************************
  ********************************************************************************************/
@@ -1262,22 +1558,17 @@ MasterEquation::Barrier::Barrier (const Model::Species& model)
     new_size = itemp < new_size ? itemp : new_size;      
   }
 
-  _state_number.resize(new_size);
   resize_thermal_factor(new_size);
 
-  double ener = energy_reference();
+  grid_states(model, new_size, _state_number);
+
+  if(size() < new_size)
+    IO::log << IO::log_offset  << model.name() << " Barrier: nonpositive number of states at " 
+	    << (energy_reference() - (double)size() * energy_step()) / Phys_const::incm  << " 1/cm => truncating\n";
+
   _weight = 0.;
-  for(int e = 0; e < size(); ++e, ener -= energy_step()) {
-    dtemp = model.states(ener);
-    if(dtemp <= 0.) {
-      IO::log << IO::log_offset  << model.name() << " Barrier: nonpositive number of states at " 
-	      << ener / Phys_const::incm  << " 1/cm => truncating\n";
-      _state_number.resize(e);
-      break;
-    }
-    _state_number[e] = dtemp;
-    _weight += dtemp * thermal_factor(e);
-  }
+  for(int e = 0; e < size(); ++e)
+    _weight += _state_number[e] * thermal_factor(e);
   _weight *= energy_step() / temperature();
 
   _real_weight = model.weight(temperature()) * std::exp((energy_reference() - model.ground()) / temperature());  
@@ -1410,8 +1701,8 @@ void MasterEquation::low_eigenvalue_matrix (Lapack::SymmetricMatrix& k_11, Lapac
   
     for(int w = 0; w < Model::well_size(); ++w) {
       dtemp = 0.;
-      for(int i = 0; i < cum_stat_num[w].size(); ++i)
-	dtemp += cum_stat_num[w][i] * thermal_factor(i);
+      for(int i = 0; i < context().cum_stat_num[w].size(); ++i)
+	dtemp += context().cum_stat_num[w][i] * thermal_factor(i);
       dtemp /= 2. * M_PI * well(w).weight();
       k_11(w, w) = dtemp;
       if(Model::well(w).escape()) {
@@ -1448,11 +1739,11 @@ void MasterEquation::low_eigenvalue_matrix (Lapack::SymmetricMatrix& k_11, Lapac
 	  vtemp[i] = well(w).escape_rate(i) / well(w).weight_sqrt();
       }
       else {
-	vtemp.resize(cum_stat_num[w].size());
+	vtemp.resize(context().cum_stat_num[w].size());
 	vtemp = 0.;
       }
-      for(int i = 0; i < cum_stat_num[w].size(); ++i)
-	vtemp[i] += cum_stat_num[w][i] / 2. / M_PI / well(w).state_density(i) / well(w).weight_sqrt();
+      for(int i = 0; i < context().cum_stat_num[w].size(); ++i)
+	vtemp[i] += context().cum_stat_num[w][i] / 2. / M_PI / well(w).state_density(i) / well(w).weight_sqrt();
       for(int r = 0; r < well(w).crm_size(); ++r)
 	k_21(r + well_shift[w], w) =  parallel_vdot(well(w).crm_column(r), vtemp, vtemp.size());
     }
@@ -1483,12 +1774,12 @@ void MasterEquation::low_eigenvalue_matrix (Lapack::SymmetricMatrix& k_11, Lapac
 	  vtemp[i] = well(w).escape_rate(i) / well(w).boltzman(i);
       }
       else {
-	vtemp.resize(cum_stat_num[w].size());
+	vtemp.resize(context().cum_stat_num[w].size());
 	vtemp = 0.;
       }
-      for(int i = 0; i < cum_stat_num[w].size(); ++i) {
+      for(int i = 0; i < context().cum_stat_num[w].size(); ++i) {
 	dtemp = well(w).state_density(i);
-	vtemp[i] += cum_stat_num[w][i] / 2. / M_PI / dtemp / dtemp / thermal_factor(i);
+	vtemp[i] += context().cum_stat_num[w][i] / 2. / M_PI / dtemp / dtemp / thermal_factor(i);
       }
 
       for(int r1 = 0; r1 < well(w).crm_size(); ++r1) 
@@ -1564,6 +1855,34 @@ void MasterEquation::low_eigenvalue_matrix (Lapack::SymmetricMatrix& k_11, Lapac
   }
 }
 
+namespace MasterEquation {
+  //
+  // binds the scratch pool of the calling thread for the duration of the solve, so that the
+  // matrices released at one pressure are reused at the next one, and reports the pool usage
+  //
+  class _ScratchPool {
+    //
+    Arena::Bind _bind;
+
+  public:
+    //
+    _ScratchPool () : _bind(Arena::thread_pool()) { Arena::thread_pool().reset_stat(); }
+
+    ~_ScratchPool ()
+    {
+      if(!Arena::current())
+	//
+	return;
+
+      IO::log << IO::log_offset;
+
+      Arena::thread_pool().report(IO::log.target());
+
+      IO::log << "\n";
+    }
+  };
+}
+
 void MasterEquation::low_eigenvalue_method (std::map<std::pair<int, int>, double>& rate_data, Partition& well_partition, int flags) 
   
 {
@@ -1571,6 +1890,8 @@ void MasterEquation::low_eigenvalue_method (std::map<std::pair<int, int>, double
 
   IO::Marker funame_marker(funame);
 
+  _ScratchPool scratch_pool;
+
   int            itemp;
   double         dtemp;
   bool           btemp;
@@ -1614,14 +1935,14 @@ void MasterEquation::low_eigenvalue_method (std::map<std::pair<int, int>, double
 
   // hot distribution
   Lapack::Matrix hot_chem;
-  if(hot_energy_size) {
-    hot_chem.resize(hot_energy_size, Model::well_size());
+  if(context().hot_energy_size) {
+    hot_chem.resize(context().hot_energy_size, Model::well_size());
     hot_chem = 0.;
     vtemp.resize(crm_size);
     
     std::map<int, std::vector<int> >::const_iterator hit;
     int count = 0;
-    for(hit = hot_index.begin(); hit != hot_index.end(); ++hit)
+    for(hit = context().hot_index.begin(); hit != context().hot_index.end(); ++hit)
       for(int i = 0; i < hit->second.size(); ++i, ++count) {
 	hot_chem(count, hit->first) = 1. / well(hit->first).weight_sqrt();
 	
@@ -1701,15 +2022,7 @@ void MasterEquation::low_eigenvalue_method (std::map<std::pair<int, int>, double
   // chemical eigenvalues and eigenvectors
   Lapack::Matrix chem_evec(Model::well_size());
 
-#ifdef WITH_MPACK
-  
-  Lapack::Vector chem_eval = Mpack::dd_eigenvalues(k_11, &chem_evec);
-
-#else
-  
-  Lapack::Vector chem_eval = k_11.eigenvalues(&chem_evec);
-
-#endif
+  Lapack::Vector chem_eval = chem_eigenvalues(k_11, chem_evec);
   
   // relaxational projection of the chemical eigenvector
   l_21 = l_21 * chem_evec;
@@ -2108,6 +2421,8 @@ void MasterEquation::well_reduction_method (std::map<std::pair<int, int>, double
   rate_data.clear();
 
   IO::Marker funame_marker(funame);
+
+  _ScratchPool scratch_pool;
   
   IO::log << IO::log_offset << "Pressure = ";
   switch(pressure_unit) {
@@ -2151,102 +2466,230 @@ void MasterEquation::well_reduction_method (std::map<std::pair<int, int>, double
 
     IO::Marker well_part_marker("kinetically active basis");
 
-    for(int e = 0; e < ener_index_max; ++e) {// energy cycle
+    // The microcanonical kinetic matrices are set up serially, a block of energies at a time,
+    // and diagonalized concurrently in chunks of consecutive energies with the same wells,
+    // the small ones by the batched Jacobi method
+    //
+    static const int block_size = 4096;
+
+    static const int chunk_size = 64;
+
+    static const int batch_size_max = 6;
+
+    for(int block_start = 0; block_start < ener_index_max; block_start += block_size) {// energy block cycle
       //
-      // available energy bins
+      const int block_end = block_start + block_size < ener_index_max ? block_start + block_size : ener_index_max;
+
+      // packed kinetic matrices
       //
-      std::vector<int> well_array;
+      std::vector<double> km_data;
+      std::vector<int>    km_shift(block_end - block_start);
+
+      // energy chunks
+      //
+      std::vector<int> chunk_start;
+
+      for(int e = block_start; e < block_end; ++e) {// energy cycle
+	//
+	// available energy bins
+	//
+	std::vector<int> well_array;
      
-      std::map<int, int> well_index;
+	std::map<int, int> well_index;
       
-      for(int w = 0; w < Model::well_size(); ++w) {
-	//
-	if(well(w).size() > e) {
+	for(int w = 0; w < Model::well_size(); ++w) {
 	  //
-	  well_index[w] = well_array.size();
+	  if(well(w).size() > e) {
+	    //
+	    well_index[w] = well_array.size();
 	  
-	  well_array.push_back(w);
+	    well_array.push_back(w);
+	  }
 	}
-      }
 
-      kinetic_basis[e].well_index_map = well_index;
+	kinetic_basis[e].well_index_map = well_index;
       
-      kinetic_basis[e].index_well_map = well_array;
+	kinetic_basis[e].index_well_map = well_array;
 
-      // microcanonical kinetic matrix
-      //
-      Lapack::SymmetricMatrix km(well_array.size());
-      km = 0.;
+	const int n = well_array.size();
 
-      // nondiagonal isomerization contribution
-      //
-      for(int b = 0; b < Model::inner_barrier_size(); ++b) {
+	kinetic_basis[e].eigenvalue.resize(n);
+
+	kinetic_basis[e].eigenvector.resize(n);
+
+	if(e == block_start || n != kinetic_basis[e - 1].index_well_map.size() || e - chunk_start.back() == chunk_size)
+	  //
+	  chunk_start.push_back(e);
+
+	// microcanonical kinetic matrix, upper triangle packed
 	//
-	if(e < inner_barrier(b).size()) {
+	km_shift[e - block_start] = km_data.size();
+
+	km_data.resize(km_data.size() + n * (n + 1) / 2, 0.);
+
+	double* km = &km_data[km_shift[e - block_start]];
+
+	// nondiagonal isomerization contribution
+	//
+	for(int b = 0; b < Model::inner_barrier_size(); ++b) {
 	  //
-	  int w1 = Model::inner_connect(b).first;
+	  if(e < inner_barrier(b).size()) {
+	    //
+	    int w1 = Model::inner_connect(b).first;
 	  
-	  int w2 = Model::inner_connect(b).second;
+	    int w2 = Model::inner_connect(b).second;
       
-	  std::map<int, int>::const_iterator p1 = well_index.find(w1);
+	    std::map<int, int>::const_iterator p1 = well_index.find(w1);
 	  
-	  std::map<int, int>::const_iterator p2 = well_index.find(w2);
+	    std::map<int, int>::const_iterator p2 = well_index.find(w2);
       
-	  if(p1 == well_index.end() || p2 == well_index.end()) {
-	    //
-	    std::cerr << funame << "no density of states for wells connected with " 
-		      << Model::inner_barrier(b).name() << " barrier at "
-		      <<  (energy_reference()  - (double)e * energy_step()) / Phys_const::kcal 
-		      << " kcal/mol\n";
+	    if(p1 == well_index.end() || p2 == well_index.end()) {
+	      //
+	      std::cerr << funame << "no density of states for wells connected with " 
+			<< Model::inner_barrier(b).name() << " barrier at "
+			<<  (energy_reference()  - (double)e * energy_step()) / Phys_const::kcal 
+			<< " kcal/mol\n";
 	    
-	    throw Error::Logic();
-	  }
+	      throw Error::Logic();
+	    }
 
-	  km(p1->second, p2->second) -= inner_barrier(b).state_number(e) / 2. / M_PI
-	    //
-	    / std::sqrt(well(w1).state_density(e) * well(w2).state_density(e));
+	    const int i = p1->second < p2->second ? p1->second : p2->second;
+	    const int j = p1->second < p2->second ? p2->second : p1->second;
+
+	    km[i + j * (j + 1) / 2] -= inner_barrier(b).state_number(e) / 2. / M_PI
+	      //
+	      / std::sqrt(well(w1).state_density(e) * well(w2).state_density(e));
+	  }
 	}
-      }
 
-      // diagonal isomerization contribution
-      //
-      for(int i = 0; i < well_array.size(); ++i) {
+	// diagonal isomerization contribution
 	//
-	int w = well_array[i];
-	
-	if(e < cum_stat_num[w].size())
+	for(int i = 0; i < n; ++i) {
 	  //
-	  km(i, i) = cum_stat_num[w][e] / 2. / M_PI / well(w).state_density(e);
+	  int w = well_array[i];
+
+	  double& kii = km[i + i * (i + 1) / 2];
 	
-	if(Model::well(w).escape())
-	  //
-	  km(i, i) += well(w).escape_rate(i);
-      }
+	  if(e < context().cum_stat_num[w].size())
+	    //
+	    kii = context().cum_stat_num[w][e] / 2. / M_PI / well(w).state_density(e);
+	
+	  if(Model::well(w).escape())
+	    //
+	    kii += well(w).escape_rate(i);
+	}
+	//
+      }// energy cycle
+
+      chunk_start.push_back(block_end);
 
       // relaxation eigenvalues
       //
-      Lapack::Matrix evec(well_array.size());
-      
-      Lapack::Vector eval = km.eigenvalues(&evec);
+      const int chunk_num = chunk_start.size() - 1;
 
-      kinetic_basis[e].eigenvalue  = eval;
-      
-      kinetic_basis[e].eigenvector = evec;
+      std::vector<std::exception_ptr> chunk_error(chunk_num);
+
+#pragma omp parallel for default(shared) schedule(dynamic, 1)
+
+      for(int c = 0; c < chunk_num; ++c) {// chunk cycle
+	//
+	try {
+	  //
+	  const int e0 = chunk_start[c];
+
+	  const int batch = chunk_start[c + 1] - e0;
+
+	  const int n = kinetic_basis[e0].index_well_map.size();
+
+	  const int psize = n * (n + 1) / 2;
+
+	  if(n <= batch_size_max) {
+	    //
+	    std::vector<double> a(psize * batch), eval(n * batch), evec(n * n * batch);
+
+	    for(int k = 0; k < batch; ++k)
+	      //
+	      for(int i = 0; i < psize; ++i)
+		//
+		a[i * batch + k] = km_data[km_shift[e0 + k - block_start] + i];
+
+	    Lapack::batch_eigenvalues(n, batch, &a[0], &eval[0], &evec[0]);
+
+	    for(int k = 0; k < batch; ++k) {
+	      //
+	      KineticBasis& kb = kinetic_basis[e0 + k];
+
+	      for(int j = 0; j < n; ++j) {
+		//
+		kb.eigenvalue[j] = eval[j * batch + k];
+
+		for(int i = 0; i < n; ++i)
+		  //
+		  kb.eigenvector(i, j) = evec[(i + j * n) * batch + k];
+	      }
+	    }
+	  }
+	  else
+	    //
+	    for(int k = 0; k < batch; ++k) {
+	      //
+	      KineticBasis& kb = kinetic_basis[e0 + k];
+
+	      const double* km = &km_data[km_shift[e0 + k - block_start]];
+
+	      Lapack::SymmetricMatrix sm(n);
+
+	      for(int j = 0; j < n; ++j)
+		//
+		for(int i = 0; i <= j; ++i)
+		  //
+		  sm(i, j) = km[i + j * (j + 1) / 2];
+
+	      Lapack::Matrix evec(n);
+
+	      Lapack::Vector eval = sm.eigenvalues(&evec);
+
+	      for(int j = 0; j < n; ++j) {
+		//
+		kb.eigenvalue[j] = eval[j];
+
+		for(int i = 0; i < n; ++i)
+		  //
+		  kb.eigenvector(i, j) = evec(i, j);
+	      }
+	    }
+	}
+	catch(...) {
+	  //
+	  chunk_error[c] = std::current_exception();
+	}
+      }// chunk cycle
+
+      for(int c = 0; c < chunk_num; ++c)
+	//
+	if(chunk_error[c])
+	  //
+	  std::rethrow_exception(chunk_error[c]);
       
       // kinetically active subspace
       //
-      for(itemp = 0; itemp < well_array.size(); ++itemp) {
+      for(int e = block_start; e < block_end; ++e) {
 	//
-	int w = well_array[itemp];
-	
-	if(eval[itemp] > well(w).collision_frequency() * reduction_threshold)
+	const std::vector<int>& well_array = kinetic_basis[e].index_well_map;
+
+	for(itemp = 0; itemp < well_array.size(); ++itemp) {
 	  //
-	  break;
-      }
+	  int w = well_array[itemp];
+	
+	  if(kinetic_basis[e].eigenvalue[itemp] > well(w).collision_frequency() * reduction_threshold)
+	    //
+	    break;
+	}
       
-      kinetic_basis[e].active_size = itemp;
+	kinetic_basis[e].active_size = itemp;
+      }
       //
-    }//energy cycle
+    }// energy block cycle
     //
   }// kinetically active basis
 
@@ -2466,8 +2909,8 @@ void MasterEquation::well_reduction_method_old (std::map<std::pair<int, int>, do
       // diagonal isomerization contribution
       for(int i = 0; i < well_array.size(); ++i) {
 	int w = well_array[i];
-	if(e < cum_stat_num[w].size())
-	  km(i, i) = cum_stat_num[w][e] / 2. / M_PI / well(w).state_density(e);
+	if(e < context().cum_stat_num[w].size())
+	  km(i, i) = context().cum_stat_num[w][e] / 2. / M_PI / well(w).state_density(e);
       }
 
       // relaxation eigenvalues
@@ -3391,171 +3834,856 @@ void MasterEquation::well_reduction_method_old (std::map<std::pair<int, int>, do
  ************ THE DIRECT DIAGONALIZATION OF THE GLOBAL KINETIC RELAXATION MATRIX ************
  ********************************************************************************************/
 
-void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>, double>& rate_data, Partition& well_partition, int flags)
-  
+int MasterEquation::energy_ordering (const std::vector<int>& well_shift, std::vector<std::vector<int> >& band_index,
+				     std::vector<int>& global_index)
 {
-  const char funame [] = "MasterEquation::direct_diagonalization_method: ";
+  int global_size = 0;
 
-  // bimolecular rate units
-  const double bru = Phys_const::cm * Phys_const::cm * Phys_const::cm * Phys_const::herz;
+  for(int w = 0; w < Model::well_size(); ++w)
+    //
+    global_size += well(w).size();
+  
+  // energy ordering: states of all wells at the same energy are adjacent, so that both
+  // collisional (within kernel bandwidth) and isomerization (same energy) couplings are banded
+  //
+  global_index.resize(global_size);
+      
+  band_index.resize(Model::well_size());
 
-  if(!isset()) {
-    std::cerr << funame << "reactive complex is not set\n";
-    throw Error::Init();
-  }
+  for(int w = 0; w < Model::well_size(); ++w)
+    //
+    band_index[w].resize(well(w).size());
 
-  IO::Marker funame_marker(funame);
-  
-  IO::log << IO::log_offset << "Pressure = ";
-  switch(pressure_unit) {
-  case BAR:
-    IO::log << pressure() / Phys_const::bar << " bar";
-    break;
-  case TORR:
-    IO::log << pressure() / Phys_const::tor << " torr";
-    break;
-  case ATM:
-    IO::log << pressure() / Phys_const::atm << " atm";
-    break;
-  }
-  IO::log << "\t Temperature = "
-	  << temperature() / Phys_const::kelv << " K\n";
-  //<< IO::log_offset << "collision frequency = " 
-  //<< MasterEquation::collision_frequency() / Phys_const::herz
-  //<< " 1/sec\n";
+  int count = 0;
+  for(int i = 0; count < global_size; ++i)
+    //
+    for(int w = 0; w < Model::well_size(); ++w)
+      //
+      if(i < well(w).size()) {
+	//
+	band_index[w][i] = count;
+	    
+	global_index[count++] = well_shift[w] + i;
+      }
 
-  if(evec_out.is_open()) {
-    evec_out << "Pressure = ";
-    switch(pressure_unit) {
-    case BAR:
-      evec_out << pressure() / Phys_const::bar << " bar";
-      break;
-    case TORR:
-      evec_out << pressure() / Phys_const::tor << " torr";
-      break;
-    case ATM:
-      evec_out << pressure() / Phys_const::atm << " atm";
-      break;
+  // band width
+  //
+  int band_size = 1;
+  for(int w = 0; w < Model::well_size(); ++w) {
+    //
+    int width = well(w).radiation() ? well(w).size() : well(w).kernel_bandwidth;
+	
+    if(width > well(w).size())
+      //
+      width = well(w).size();
+	
+    for(int i = 0; i + width - 1 < well(w).size(); ++i) {
+      //
+      const int itemp = band_index[w][i + width - 1] - band_index[w][i] + 1;
+
+      if(itemp > band_size)
+	//
+	band_size = itemp;
     }
-    evec_out << "\t Temperature = "
-	     << temperature() / Phys_const::kelv << " K\n";
   }
 
-  rate_data.clear();
+  for(int b = 0; b < Model::inner_barrier_size(); ++b) {
+    //
+    const int w1 = Model::inner_connect(b).first;
+    const int w2 = Model::inner_connect(b).second;
 
-  int                 itemp;
-  double              dtemp;
-  bool                btemp;
-  std::string         stemp;
+    for(int i = 0; i < inner_barrier(b).size(); ++i) {
+      //
+      const int itemp = std::abs(band_index[w1][i] - band_index[w2][i]) + 1;
 
-  Lapack::Vector      vtemp;
-  Lapack::Matrix      mtemp;
+      if(itemp > band_size)
+	//
+	band_size = itemp;
+    }
+  }
 
-  double proj;
+  return band_size;
+}
 
-  // total kinetic relaxation matrix dimension and index shifts for individual wells
-  //
-  std::vector<int> well_shift(Model::well_size());
-  
-  itemp = 0;
-  for(int w = 0; w < Model::well_size(); ++w) {
-    well_shift[w] = itemp;
-    itemp += well(w).size();
-  }
-  const int global_size = itemp;
+MasterEquation::AdaptiveGrid::AdaptiveGrid (const std::vector<int>& well_shift)
+{
+  const char funame [] = "MasterEquation::AdaptiveGrid::AdaptiveGrid: ";
 
-  //  if(global_size >= 
-  IO::log << IO::log_offset << "global relaxation matrix dimension = " << global_size << "\n";
+  int global_size = 0;
 
   for(int w = 0; w < Model::well_size(); ++w)
-    if(!w || well(w).size() > itemp)
-      itemp = well(w).size();
-  
-  const int well_size_max = itemp;
-    
-  /********************************* SETTING GLOBAL MATRICES *********************************/
+    //
+    global_size += well(w).size();
 
-  // kinetic relaxation matrix
-  Lapack::SymmetricMatrix kin_mat(global_size); // kinetic relaxation matrix
-  kin_mat = 0.;
+  _node.resize(global_size);
 
-  // bimolecular product vectors
-  Lapack::Matrix global_bim;
-  if(Model::bimolecular_size()) {
-    global_bim.resize(global_size,  Model::bimolecular_size());
-    global_bim = 0.;
-  }
+  _weight.resize(2 * global_size);
 
-  // Boltzmann distributions
-  Lapack::Matrix global_pop(global_size, Model::well_size());
-  global_pop = 0.;
+  // basis functions norms
+  //
+  std::vector<double> norm;
 
-  // well escape vectors
-  Lapack::Matrix global_escape;
-  if(Model::escape_size()) {
-    global_escape.resize(global_size, Model::escape_size());
-    global_escape = 0.;
-  }
+  for(int w = 0; w < Model::well_size(); ++w) {
+    //
+    // thresholds: grid indices just below the barrier tops
+    //
+    std::vector<int> threshold;
 
-  {
-    IO::Marker set_marker("setting global matrices", IO::Marker::ONE_LINE);
+    for(int b = 0; b < Model::inner_barrier_size(); ++b)
+      //
+      if(Model::inner_connect(b).first == w || Model::inner_connect(b).second == w)
+	//
+	threshold.push_back(inner_barrier(b).size());
 
-    // kin_mat initialization
-    // nondiagonal isomerization contribution
-    for(int b = 0; b < Model::inner_barrier_size(); ++b) {
-      int w1 = Model::inner_connect(b).first;
-      int w2 = Model::inner_connect(b).second;    
-      for(int i = 0; i < inner_barrier(b).size(); ++i)
-	kin_mat(i + well_shift[w1], i + well_shift[w2]) = - inner_barrier(b).state_number(i) / 2. / M_PI
-	  / std::sqrt(well(w1).state_density(i) * well(w2).state_density(i));
-    }
+    for(int b = 0; b < Model::outer_barrier_size(); ++b)
+      //
+      if(Model::outer_connect(b).first == w)
+	//
+	threshold.push_back(outer_barrier(b).size());
 
-    // diagonal isomerization contribution
-    for(int w = 0; w < Model::well_size(); ++w) {
-      for(int i = 0; i < cum_stat_num[w].size(); ++i)
-	kin_mat(i + well_shift[w], i + well_shift[w]) = cum_stat_num[w][i] / 2. / M_PI
-	  / well(w).state_density(i);
-      if(Model::well(w).escape())
-	for(int i = 0; i < well(w).size(); ++i) {
-	  dtemp = well(w).escape_rate(i);
-	  //if(dtemp != 0.)
-	  //std::cerr << "energy[kcal/mol] = "
-	  //	      << (energy_reference() - (double)i * energy_step()) / Phys_const::kcal
-	  //	      << "   escape rate[Hz] = " << dtemp / Phys_const::herz << "\n"; 
-	  kin_mat(i + well_shift[w], i + well_shift[w]) += dtemp;
-	}
-    }
+    // energy transfer range and the widest node spacing, in grid bins
+    //
+    const int range = well(w).kernel_bandwidth > 0 ? well(w).kernel_bandwidth : 1;
 
-    // collision relaxation contribution 
-    for(int w = 0; w < Model::well_size(); ++w) {
-      for(int i = 0; i < well(w).size(); ++i) {
-	for(int j = i; j < well(w).size(); ++j) 
-	  kin_mat(i + well_shift[w], j + well_shift[w]) +=  well(w).collision_frequency() * well(w).kernel(i, j) 
-	    * well(w).boltzman_sqrt(i) / well(w).boltzman_sqrt(j);
-      }
-    }
+    int width_max = (int)(adaptive_grid_width * (double)range);
 
-    // radiational transitions contribution
+    if(width_max < 1)
+      //
+      width_max = 1;
+
+    // the first and the last energies are the nodes
     //
-    for(int w = 0; w < Model::well_size(); ++w)
-      if(well(w).radiation()) {
+    const int last = well(w).size() - 1;
 
-#pragma omp parallel for default(shared) schedule(dynamic)
-	
-	for(int i = 0; i < well(w).size(); ++i) {
-	  for(int j = i; j < well(w).size(); ++j) 
-	    kin_mat(i + well_shift[w], j + well_shift[w]) +=  well(w).radiation_rate(i, j); 
-	}
-      }
+    for(int i = 0; i <= last;) {
+      //
+      // distance to the nearest threshold
+      //
+      int dist = well(w).size();
 
-    // bimolecular product vectors
-    //
-    for(int b = 0; b < Model::outer_barrier_size(); ++b) {
-      const int w = Model::outer_connect(b).first;
-      const int p = Model::outer_connect(b).second;
+      for(int t = 0; t < threshold.size(); ++t)
+	//
+	if(std::abs(i - threshold[t]) < dist)
+	  //
+	  dist = std::abs(i - threshold[t]);
 
-      for(int i = 0; i < outer_barrier(b).size(); ++i)
-	global_bim(i + well_shift[w], p) = outer_barrier(b).state_number(i) / 2. / M_PI
+      // the nodes are spaced by one bin within the energy transfer range from the thresholds
+      //
+      int width = 1;
+
+      if(dist > range)
+	//
+	width += (int)((long)(dist - range) * (long)width_max / (long)range);
+
+      if(width > width_max)
+	//
+	width = width_max;
+
+      if(width > last - i)
+	//
+	width = last - i;
+
+      // the thresholds are the nodes
+      //
+      for(int t = 0; t < threshold.size(); ++t)
+	//
+	if(threshold[t] > i && threshold[t] < i + width)
+	  //
+	  width = threshold[t] - i;
+
+      const int node = norm.size();
+
+      // the lower node basis function at the node and both basis functions between the nodes
+      //
+      _node[i + well_shift[w]] = node;
+
+      _weight[2 * (i + well_shift[w])]     = 1.;
+      _weight[2 * (i + well_shift[w]) + 1] = 0.;
+
+      for(int k = 1; k < width; ++k) {
+	//
+	const int g = k + i + well_shift[w];
+
+	const double x = (double)k / (double)width;
+
+	_node[g] = node;
+
+	_weight[2 * g]     = 1. - x;
+	_weight[2 * g + 1] = x;
+      }
+
+      norm.push_back(0.);
+
+      if(!width)
+	//
+	break;
+
+      i += width;
+    }
+
+    // Boltzmann weighting
+    //
+    for(int i = 0; i <= last; ++i) {
+      //
+      const int g = i + well_shift[w];
+
+      for(int p = 0; p < 2; ++p) {
+	//
+	_weight[2 * g + p] *= well(w).boltzman_sqrt(i);
+
+	if(_weight[2 * g + p] != 0.)
+	  //
+	  norm[_node[g] + p] += _weight[2 * g + p] * _weight[2 * g + p];
+      }
+    }
+  }
+
+  const int size = norm.size();
+
+  for(int n = 0; n < size; ++n) {
+    //
+    if(norm[n] == 0.) {
+      //
+      std::cerr << funame << "basis function " << n << " vanishes: Boltzmann factor underflow\n";
+
+      throw Error::Range();
+    }
+
+    norm[n] = std::sqrt(norm[n]);
+  }
+
+  for(int g = 0; g < global_size; ++g)
+    //
+    for(int p = 0; p < 2; ++p)
+      //
+      if(_weight[2 * g + p] != 0.)
+	//
+	_weight[2 * g + p] /= norm[_node[g] + p];
+
+  // basis overlap, tridiagonal in each well
+  //
+  Lapack::SymmetricMatrix overlap(size);
+
+  overlap = 0.;
+
+  for(int g = 0; g < global_size; ++g)
+    //
+    for(int p = 0; p < 2; ++p)
+      //
+      for(int q = p; q < 2; ++q)
+	//
+	if(_weight[2 * g + p] != 0. && _weight[2 * g + q] != 0.)
+	  //
+	  overlap(_node[g] + p, _node[g] + q) += _weight[2 * g + p] * _weight[2 * g + q];
+
+  // symmetric orthonormalization
+  //
+  Lapack::Matrix evec;
+
+  Lapack::Vector eval = overlap.eigenvalues(&evec);
+
+  if(eval[0] <= 0.) {
+    //
+    std::cerr << funame << "basis overlap is not positive definite: smallest eigenvalue = " << eval[0] << "\n";
+
+    throw Error::Range();
+  }
+
+  for(int l = 0; l < size; ++l)
+    //
+    eval[l] = 1. / std::sqrt(eval[l]);
+
+  _orth.resize(size);
+
+  for(int i = 0; i < size; ++i)
+    //
+    for(int j = i; j < size; ++j) {
+      //
+      double dtemp = 0.;
+
+      for(int l = 0; l < size; ++l)
+	//
+	dtemp += evec(i, l) * evec(j, l) * eval[l];
+
+      _orth(i, j) = _orth(j, i) = dtemp;
+    }
+}
+
+void MasterEquation::AdaptiveGrid::add (Lapack::SymmetricMatrix& kin, int i, int j, double val) const
+{
+  for(int p = 0; p < 2; ++p) {
+    //
+    const double wi = _weight[2 * i + p];
+
+    if(wi == 0.)
+      //
+      continue;
+
+    for(int q = i == j ? p : 0; q < 2; ++q) {
+      //
+      const double wj = _weight[2 * j + q];
+
+      if(wj == 0.)
+	//
+	continue;
+
+      const int ni = _node[i] + p;
+      const int nj = _node[j] + q;
+
+      // both (i, j) and (j, i) elements contribute to the diagonal basis element
+      //
+      if(i != j && ni == nj)
+	//
+	kin(ni, nj) += 2. * val * wi * wj;
+      else
+	//
+	kin(ni, nj) += val * wi * wj;
+    }
+  }
+}
+
+Lapack::SymmetricMatrix MasterEquation::AdaptiveGrid::orthogonalize (const Lapack::SymmetricMatrix& kin) const
+{
+  return Lapack::SymmetricMatrix(_orth * kin * _orth);
+}
+
+Lapack::Matrix MasterEquation::AdaptiveGrid::expand (const Lapack::Matrix& comp) const
+{
+  const char funame [] = "MasterEquation::AdaptiveGrid::expand: ";
+
+  if(comp.size1() != size()) {
+    std::cerr << funame << "dimensions mismatch: " << comp.size1() << ", " << size() << "\n";
+    throw Error::Range();
+  }
+
+  const Lapack::Matrix coef = _orth * comp;
+
+  Lapack::Matrix res((int)_node.size(), comp.size2());
+
+  res = 0.;
+
+  for(int c = 0; c < comp.size2(); ++c)
+    //
+    for(int g = 0; g < _node.size(); ++g)
+      //
+      for(int p = 0; p < 2; ++p)
+	//
+	if(_weight[2 * g + p] != 0.)
+	  //
+	  res(g, c) += _weight[2 * g + p] * coef(_node[g] + p, c);
+
+  return res;
+}
+
+Lapack::Matrix MasterEquation::AdaptiveGrid::project (const Lapack::Matrix& vec) const
+{
+  const char funame [] = "MasterEquation::AdaptiveGrid::project: ";
+
+  if(vec.size1() != _node.size()) {
+    std::cerr << funame << "dimensions mismatch: " << vec.size1() << ", " << _node.size() << "\n";
+    throw Error::Range();
+  }
+
+  Lapack::Matrix res(size(), vec.size2());
+
+  res = 0.;
+
+  for(int c = 0; c < vec.size2(); ++c)
+    //
+    for(int g = 0; g < _node.size(); ++g)
+      //
+      for(int p = 0; p < 2; ++p)
+	//
+	if(_weight[2 * g + p] != 0.)
+	  //
+	  res(_node[g] + p, c) += _weight[2 * g + p] * vec(g, c);
+
+  return _orth * res;
+}
+
+Lapack::Vector MasterEquation::global_eigenvalues (const Lapack::SymmetricMatrix& kin_mat, int eigen_size,
+						  Lapack::Matrix& eigen_global)
+{
+  const char funame [] = "MasterEquation::global_eigenvalues: ";
+
+  const int global_size = kin_mat.size();
+
+  if(eigen_size <= 0 || eigen_size > global_size) {
+    std::cerr << funame << "number of eigenstates out of range: " << eigen_size << "\n";
+    throw Error::Range();
+  }
+
+  Lapack::Vector eigenval;
+  Lapack::Matrix evec;
+
+  switch(eigensolver) {
+  case PACKED_EIGENSOLVER:
+    //
+    eigenval = kin_mat.eigenvalues(&evec);
+
+    break;
+  case DC_EIGENSOLVER:
+    //
+    eigenval = kin_mat.dc_eigenvalues(&evec);
+
+    break;
+  case RANGE_EIGENSOLVER:
+    //
+    eigenval = kin_mat.eigenvalues(0, eigen_size, &evec);
+
+    break;
+  default:
+    //
+    std::cerr << funame << "unknown eigensolver: " << eigensolver << "\n";
+    throw Error::Logic();
+  }
+
+  eigen_global = evec.transpose();
+
+  return eigenval;
+}
+
+double MasterEquation::lanczos_shift ()
+{
+  // relative to the smallest collision frequency
+  //
+  static const double shift_factor = 1.e-3;
+
+  double res = well(0).collision_frequency();
+
+  for(int w = 1; w < Model::well_size(); ++w)
+    //
+    if(well(w).collision_frequency() < res)
+      //
+      res = well(w).collision_frequency();
+
+  return -shift_factor * res;
+}
+
+Lapack::Vector MasterEquation::band_eigenvalues (const Lapack::BandMatrix& band_mat, const std::vector<int>& global_index,
+						int eigen_size, Lapack::Matrix& eigen_global)
+{
+  const char funame [] = "MasterEquation::band_eigenvalues: ";
+
+  const int global_size = band_mat.size();
+
+  if(eigen_size <= 0 || eigen_size > global_size) {
+    std::cerr << funame << "number of eigenstates out of range: " << eigen_size << "\n";
+    throw Error::Range();
+  }
+
+  Lapack::Vector eigenval;
+  Lapack::Matrix band_evec;
+
+  if(eigensolver == LANCZOS_EIGENSOLVER) {
+    //
+    const Lapack::Matrix& guess = context().relax_evec;
+
+    if(guess.isinit() && guess.size1() == global_size) {
+      //
+      eigenval = band_mat.lanczos_eigenvalues(eigen_size, lanczos_shift(), &band_evec, &guess);
+    }
+    else
+      //
+      eigenval = band_mat.lanczos_eigenvalues(eigen_size, lanczos_shift(), &band_evec);
+
+    // the context copies may share the storage, so that the eigenvectors are rebound, not overwritten
+    //
+    context().relax_evec = band_evec;
+  }
+  else if(eigen_size < global_size) {
+    //
+    eigenval = band_mat.eigenvalues(0, eigen_size, &band_evec);
+  }
+  else
+    //
+    eigenval = band_mat.eigenvalues(&band_evec);
+
+  // back to the well ordering
+  //
+  eigen_global.resize(band_evec.size2(), global_size);
+
+  for(int i = 0; i < global_size; ++i)
+    //
+    for(int l = 0; l < band_evec.size2(); ++l)
+      //
+      eigen_global(l, global_index[i]) = band_evec(i, l);
+
+  return eigenval;
+}
+
+Lapack::Matrix MasterEquation::relaxation_solve (const Lapack::BandMatrix& kin_band, const std::vector<int>& global_index,
+						 const Lapack::Vector& eigenval, const Lapack::Matrix& eigen_global, int chem_size,
+						 const Lapack::Matrix& rhs)
+{
+  const char funame [] = "MasterEquation::relaxation_solve: ";
+
+  static const double tol = 1.e-12;
+
+  static const int iter_max = 100;
+
+  // preconditioner shift relative to the smallest relaxation eigenvalue
+  //
+  static const double shift_factor = 1.e-3;
+
+  const int global_size = kin_band.size();
+
+  const int eigen_size = eigen_global.size1();
+
+  if(rhs.size1() != global_size || eigen_global.size2() != global_size || eigenval.size() != eigen_size
+     //
+     || chem_size >= eigen_size) {
+    std::cerr << funame << "dimensions mismatch\n";
+    throw Error::Range();
+  }
+
+  // the shifted matrix is the preconditioner for the iterative refinement, which converges
+  // in the relaxation subspace as the shift factor
+  //
+  Lapack::BandCholesky factor(kin_band, -shift_factor * eigenval[chem_size]);
+
+  Lapack::Matrix res(global_size, rhs.size2());
+
+  Lapack::Vector x(global_size), r(global_size), vtemp(global_size), utemp(global_size);
+
+  for(int p = 0; p < rhs.size2(); ++p) {
+    //
+    const double rhs_norm = vlength(&rhs(0, p), global_size);
+
+    x = 0.;
+
+    for(int i = 0; i < global_size; ++i)
+      //
+      r[i] = rhs(i, p);
+
+    int iter;
+    for(iter = 0; iter < iter_max; ++iter) {
+      //
+      if(vlength(r, global_size) <= tol * rhs_norm)
+	//
+	break;
+
+      // correction
+      //
+      for(int i = 0; i < global_size; ++i)
+	//
+	vtemp[i] = r[global_index[i]];
+
+      vtemp = factor.invert(vtemp);
+
+      for(int i = 0; i < global_size; ++i)
+	//
+	utemp[global_index[i]] = vtemp[i];
+
+      for(int l = 0; l < chem_size; ++l)
+	//
+	orthogonalize(utemp, &eigen_global(l, 0), global_size, 1, eigen_size);
+
+      x += utemp;
+
+      // residual
+      //
+      for(int i = 0; i < global_size; ++i)
+	//
+	vtemp[i] = x[global_index[i]];
+
+      kin_band.multiply(vtemp, utemp);
+
+      for(int i = 0; i < global_size; ++i)
+	//
+	r[global_index[i]] = rhs(global_index[i], p) - utemp[i];
+
+      for(int l = 0; l < chem_size; ++l)
+	//
+	orthogonalize(r, &eigen_global(l, 0), global_size, 1, eigen_size);
+    }
+
+    if(iter == iter_max) {
+      //
+      std::cerr << funame << "iterative refinement did not converge\n";
+
+      throw Error::Math();
+    }
+
+    for(int i = 0; i < global_size; ++i)
+      //
+      res(i, p) = x[i];
+  }
+
+  return res;
+}
+
+void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>, double>& rate_data, Partition& well_partition, int flags)
+  
+{
+  const char funame [] = "MasterEquation::direct_diagonalization_method: ";
+
+  // bimolecular rate units
+  const double bru = Phys_const::cm * Phys_const::cm * Phys_const::cm * Phys_const::herz;
+
+  if(!isset()) {
+    std::cerr << funame << "reactive complex is not set\n";
+    throw Error::Init();
+  }
+
+  IO::Marker funame_marker(funame);
+
+  _ScratchPool scratch_pool;
+  
+  IO::log << IO::log_offset << "Pressure = ";
+  switch(pressure_unit) {
+  case BAR:
+    IO::log << pressure() / Phys_const::bar << " bar";
+    break;
+  case TORR:
+    IO::log << pressure() / Phys_const::tor << " torr";
+    break;
+  case ATM:
+    IO::log << pressure() / Phys_const::atm << " atm";
+    break;
+  }
+  IO::log << "\t Temperature = "
+	  << temperature() / Phys_const::kelv << " K\n";
+  //<< IO::log_offset << "collision frequency = " 
+  //<< MasterEquation::collision_frequency() / Phys_const::herz
+  //<< " 1/sec\n";
+
+  if(evec_out.is_open()) {
+    evec_out << "Pressure = ";
+    switch(pressure_unit) {
+    case BAR:
+      evec_out << pressure() / Phys_const::bar << " bar";
+      break;
+    case TORR:
+      evec_out << pressure() / Phys_const::tor << " torr";
+      break;
+    case ATM:
+      evec_out << pressure() / Phys_const::atm << " atm";
+      break;
+    }
+    evec_out << "\t Temperature = "
+	     << temperature() / Phys_const::kelv << " K\n";
+  }
+
+  rate_data.clear();
+
+  int                 itemp;
+  double              dtemp;
+  bool                btemp;
+  std::string         stemp;
+
+  Lapack::Vector      vtemp;
+  Lapack::Matrix      mtemp;
+
+  double proj;
+
+  // total kinetic relaxation matrix dimension and index shifts for individual wells
+  //
+  std::vector<int> well_shift(Model::well_size());
+  
+  itemp = 0;
+  for(int w = 0; w < Model::well_size(); ++w) {
+    well_shift[w] = itemp;
+    itemp += well(w).size();
+  }
+  const int global_size = itemp;
+
+  //  if(global_size >= 
+  IO::log << IO::log_offset << "global relaxation matrix dimension = " << global_size << "\n";
+
+  for(int w = 0; w < Model::well_size(); ++w)
+    if(!w || well(w).size() > itemp)
+      itemp = well(w).size();
+  
+  const int well_size_max = itemp;
+
+  // adaptive energy grid basis
+  //
+  SharedPointer<AdaptiveGrid> grid;
+
+  // relaxation matrix dimension
+  //
+  int kin_size = global_size;
+
+  if(adaptive_grid_width > 0.) {
+    //
+    if(eigensolver == BAND_EIGENSOLVER || eigensolver == LANCZOS_EIGENSOLVER) {
+      //
+      IO::log << IO::log_offset << "the energy-ordered band eigensolvers use the uniform energy grid\n";
+    }
+    else {
+      //
+      grid = SharedPointer<AdaptiveGrid>(new AdaptiveGrid(well_shift));
+
+      kin_size = grid->size();
+
+      IO::log << IO::log_offset << "adaptive energy grid dimension = " << kin_size << "\n";
+    }
+  }
+    
+  /********************************* SETTING GLOBAL MATRICES *********************************/
+
+  // kinetic relaxation matrix: for the band and Lanczos eigensolvers it is kept in the energy-ordered
+  // band storage only
+  //
+  const bool is_band = eigensolver == BAND_EIGENSOLVER || eigensolver == LANCZOS_EIGENSOLVER;
+
+  Lapack::SymmetricMatrix kin_mat;
+  Lapack::BandMatrix      kin_band;
+  Lapack::BandMatrix      coll_band; // collisional part of the band matrix
+
+  bool is_relax_set = false;
+
+  std::vector<std::vector<int> > band_index;
+  std::vector<int>               global_index; // band index to global index map
+  std::vector<int>               band_pos;     // global index to band index map
+
+  if(is_band) {
+    //
+    itemp = energy_ordering(well_shift, band_index, global_index);
+
+    IO::log << IO::log_offset << "band size = " << itemp << "\n";
+
+    // the pressure independent part is set at the first pressure of the sweep only
+    //
+    const Lapack::BandMatrix& base = context().relax_base;
+
+    is_relax_set = base.isinit() && base.size() == global_size && base.band_size() == itemp;
+
+    if(!is_relax_set) {
+      //
+      kin_band.resize(global_size, itemp);
+      kin_band = 0.;
+
+      coll_band.resize(global_size, itemp);
+      coll_band = 0.;
+    }
+
+    band_pos.resize(global_size);
+
+    for(int i = 0; i < global_size; ++i)
+      //
+      band_pos[global_index[i]] = i;
+  }
+  else {
+    //
+    kin_mat.resize(kin_size);
+    kin_mat = 0.;
+  }
+
+  // kinetic relaxation matrix contribution in the global indices
+  //
+  struct KinMatElement {
+    //
+    Lapack::SymmetricMatrix& packed;
+    Lapack::BandMatrix&      band;
+    const std::vector<int>&  band_pos;
+    const AdaptiveGrid*      grid;
+
+    void add (int i, int j, double val)
+    {
+      if(band.isinit()) {
+	//
+	band(band_pos[i], band_pos[j]) += val;
+      }
+      else if(grid) {
+	//
+	grid->add(packed, i, j, val);
+      }
+      else
+	//
+	packed(i, j) += val;
+    }
+  };
+
+  KinMatElement kin_elem  = {kin_mat, kin_band,  band_pos, grid};
+  KinMatElement coll_elem = {kin_mat, coll_band, band_pos, grid};
+
+  // bimolecular product vectors
+  Lapack::Matrix global_bim;
+  if(Model::bimolecular_size()) {
+    global_bim.resize(global_size,  Model::bimolecular_size());
+    global_bim = 0.;
+  }
+
+  // Boltzmann distributions
+  Lapack::Matrix global_pop(global_size, Model::well_size());
+  global_pop = 0.;
+
+  // well escape vectors
+  Lapack::Matrix global_escape;
+  if(Model::escape_size()) {
+    global_escape.resize(global_size, Model::escape_size());
+    global_escape = 0.;
+  }
+
+  {
+    IO::Marker set_marker("setting global matrices", IO::Marker::ONE_LINE);
+
+    // kinetic relaxation matrix; the band eigensolvers keep its pressure independent part at given
+    // temperature, and the collisional part, linear in pressure, is rescaled
+    //
+    if(!is_relax_set) {
+      //
+      // kin_mat initialization
+      // nondiagonal isomerization contribution
+      for(int b = 0; b < Model::inner_barrier_size(); ++b) {
+	int w1 = Model::inner_connect(b).first;
+	int w2 = Model::inner_connect(b).second;    
+	for(int i = 0; i < inner_barrier(b).size(); ++i)
+	  kin_elem.add(i + well_shift[w1], i + well_shift[w2], - inner_barrier(b).state_number(i) / 2. / M_PI
+		       / std::sqrt(well(w1).state_density(i) * well(w2).state_density(i)));
+      }
+
+      // diagonal isomerization contribution
+      for(int w = 0; w < Model::well_size(); ++w) {
+	for(int i = 0; i < context().cum_stat_num[w].size(); ++i)
+	  kin_elem.add(i + well_shift[w], i + well_shift[w], context().cum_stat_num[w][i] / 2. / M_PI
+		       / well(w).state_density(i));
+	if(Model::well(w).escape())
+	  for(int i = 0; i < well(w).size(); ++i) {
+	    dtemp = well(w).escape_rate(i);
+	    //if(dtemp != 0.)
+	    //std::cerr << "energy[kcal/mol] = "
+	    //	      << (energy_reference() - (double)i * energy_step()) / Phys_const::kcal
+	    //	      << "   escape rate[Hz] = " << dtemp / Phys_const::herz << "\n"; 
+	    kin_elem.add(i + well_shift[w], i + well_shift[w], dtemp);
+	  }
+      }
+
+      // collision relaxation contribution 
+      for(int w = 0; w < Model::well_size(); ++w) {
+	for(int i = 0; i < well(w).size(); ++i) {
+	  for(int j = i; j < well(w).size() && j - i < well(w).kernel_bandwidth; ++j) 
+	    coll_elem.add(i + well_shift[w], j + well_shift[w], well(w).collision_frequency() * well(w).kernel(i, j) 
+			  * well(w).boltzman_sqrt(i) / well(w).boltzman_sqrt(j));
+	}
+      }
+
+      // radiational transitions contribution
+      //
+      for(int w = 0; w < Model::well_size(); ++w)
+	if(well(w).radiation()) {
+
+	  // the adaptive grid basis functions are shared by the neighboring energies
+	  //
+#pragma omp parallel for default(shared) schedule(dynamic) if(!grid)
+	
+	  for(int i = 0; i < well(w).size(); ++i) {
+	    for(int j = i; j < well(w).size(); ++j) 
+	      kin_elem.add(i + well_shift[w], j + well_shift[w], well(w).radiation_rate(i, j)); 
+	  }
+	}
+    }
+
+    // bimolecular product vectors
+    //
+    for(int b = 0; b < Model::outer_barrier_size(); ++b) {
+      const int w = Model::outer_connect(b).first;
+      const int p = Model::outer_connect(b).second;
+
+      for(int i = 0; i < outer_barrier(b).size(); ++i)
+	global_bim(i + well_shift[w], p) = outer_barrier(b).state_number(i) / 2. / M_PI
 	  * thermal_factor(i) / well(w).boltzman_sqrt(i);
     }
   
@@ -3581,18 +4709,69 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
     //
   }// global matrices
 
+  if(is_band) {
+    //
+    if(!is_relax_set) {
+      //
+      context().relax_base      = kin_band;
+      context().relax_collision = coll_band;
+      context().relax_pressure  = pressure();
+    }
+
+    // the context storage is shared by the point contexts copies and is not modified in place
+    //
+    kin_band = context().relax_collision.copy();
+
+    kin_band *= pressure() / context().relax_pressure;
+
+    kin_band += context().relax_base;
+  }
+
+  if(grid)
+    //
+    kin_mat = grid->orthogonalize(kin_mat);
+
   /******************** DIAGONALIZING THE GLOBAL KINETIC RELAXATION MATRIX ********************/
 
+  // the relaxation part of the spectrum is needed only for time evolution, escape rates,
+  // hot energies branching ratios, and product energy distributions
+  //
+  if(Model::time_evolution || Model::escape_size() || context().hot_energy_size || ped_out.is_open())
+    //
+    itemp = kin_size;
+  else
+    //
+    itemp = Model::well_size() + (evec_out_num > 0 ? evec_out_num : 1);
+
+  if(itemp > kin_size)
+    //
+    itemp = kin_size;
+
   Lapack::Vector eigenval;
-  Lapack::Matrix eigen_global(global_size);
+  Lapack::Matrix eigen_global;
 
   {
     IO::Marker solve_marker("diagonalizing global relaxation matrix", IO::Marker::ONE_LINE);
 
-    eigenval = kin_mat.eigenvalues(&eigen_global);
-    eigen_global = eigen_global.transpose();
+    if(kin_band.isinit()) {
+      //
+      eigenval = band_eigenvalues(kin_band, global_index, itemp, eigen_global);
+    }
+    else
+      //
+      eigenval = global_eigenvalues(kin_mat, itemp, eigen_global);
   }
 
+  // eigenvectors on the uniform grid
+  //
+  if(grid)
+    //
+    eigen_global = grid->expand(eigen_global.transpose()).transpose();
+
+  // number of eigenstates found
+  //
+  const int eigen_size = eigenval.size();
+
   const double min_relax_eval = eigenval[Model::well_size()];
   const double max_relax_eval = eigenval.back();
 
@@ -3657,15 +4836,7 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
 
     Lapack::Matrix chem_evec(Model::well_size());
     
-#ifdef WITH_MPACK
-  
-    Lapack::Vector chem_eval = Mpack::dd_eigenvalues(k_11, &chem_evec);
-
-#else
-    
-    Lapack::Vector chem_eval = k_11.eigenvalues(&chem_evec);
-
-#endif
+    Lapack::Vector chem_eval = chem_eigenvalues(k_11, chem_evec);
     
     // low-eigenvalue chemical subspace
     itemp = 1;
@@ -3822,10 +4993,10 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
     //
   }// low eigenvalue method
 
-  Lapack::Matrix eigen_well(global_size, Model::well_size());
-  for(int l = 0; l < global_size; ++l)
+  Lapack::Matrix eigen_well(eigen_size, Model::well_size());
+  for(int l = 0; l < eigen_size; ++l)
     for(int w = 0; w < Model::well_size(); ++w)
-      eigen_well(l, w) = vlength(&eigen_global(l, well_shift[w]), well(w).size(), global_size);
+      eigen_well(l, w) = vlength(&eigen_global(l, well_shift[w]), well(w).size(), eigen_size);
   
   // projection of the  eigenvectors onto the thermal subspace
   //
@@ -3890,7 +5061,7 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
 	std::vector<double> well_pop(Model::well_size());
 	std::vector<double> bim_pop(Model::bimolecular_size());
 
-	for(int l = 0; l < global_size; ++l) {
+	for(int l = 0; l < eigen_size; ++l) {
 	  dtemp = eigenval[l] * time_val;
 	  if(dtemp > 50.)
 	    dtemp = 1. / eigenval[l];
@@ -3942,16 +5113,18 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
       for(Lapack::Vector::iterator i = init_dist.begin(); i != init_dist.end(); ++i)
 	*i /= norm_fac;
 
-      std::vector<double> init_coef(global_size);
-      for(int l = 0; l < global_size; ++l)
-	init_coef[l] = parallel_vdot(init_dist, &eigen_global(l, well_shift[react]), well(react).size(), 1, global_size);
+      std::vector<double> init_coef(eigen_size);
+      for(int l = 0; l < eigen_size; ++l)
+	init_coef[l] = parallel_vdot(init_dist, &eigen_global(l, well_shift[react]), well(react).size(), 1, eigen_global.size1());
+
+      bool is_pop_warned = false;
 
       double time_val = Model::time_evolution->start();
       for(int t = 0;  t < Model::time_evolution->size(); ++t, time_val *= Model::time_evolution->step()) {
 	std::vector<double> well_pop(Model::well_size());
 	std::vector<double> bim_pop(Model::bimolecular_size());
 
-	for(int l = 0; l < global_size; ++l) {
+	for(int l = 0; l < eigen_size; ++l) {
 	  dtemp = eigenval[l] * time_val;
 	  if(dtemp > 100.)
 	    dtemp = 0.;
@@ -3969,6 +5142,26 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
 	// normalization
 	for(int w = 0; w < Model::well_size(); ++w)
 	  well_pop[w] *= well(w).weight_sqrt();
+
+	// population conservation check
+	//
+	if(!Model::escape_size() && !is_pop_warned) {
+	  //
+	  dtemp = 0.;
+	  for(int w = 0; w < Model::well_size(); ++w)
+	    dtemp += well_pop[w];
+
+	  for(int p = 0; p < Model::bimolecular_size(); ++p)
+	    dtemp += bim_pop[p];
+
+	  if(std::fabs(dtemp - 1.) > 0.01) {
+	    //
+	    IO::log << IO::log_offset << "WARNING: time evolution: total population = " << dtemp
+		    << " at " << time_val * Phys_const::herz << " sec differs from unity\n";
+
+	    is_pop_warned = true;
+	  }
+	}
 	
 	// output
 	Model::time_evolution->out << std::setw(13) << time_val * Phys_const::herz;
@@ -3986,13 +5179,13 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
   
   // eigenvector distributions at hot energies
   Lapack::Matrix eigen_hot;
-  if(hot_energy_size) {
-    eigen_hot.resize(global_size, hot_energy_size);
+  if(context().hot_energy_size) {
+    eigen_hot.resize(eigen_size, context().hot_energy_size);
     std::map<int, std::vector<int> >::const_iterator hit;
     int count = 0;
-    for(hit = hot_index.begin(); hit != hot_index.end(); ++hit)
+    for(hit = context().hot_index.begin(); hit != context().hot_index.end(); ++hit)
       for(int i = 0; i < hit->second.size(); ++i, ++count) {
-	for(int l = 0; l < global_size; ++l)
+	for(int l = 0; l < eigen_size; ++l)
 	  eigen_hot(l, count) = eigen_global(l, well_shift[hit->first] + hit->second[i]) 
 	    / well(hit->first).boltzman_sqrt(hit->second[i]);
       }
@@ -4218,7 +5411,7 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
   /***** PARTITIONING THE GLOBAL PHASE SPACE INTO THE CHEMICAL AND COLLISIONAL SUBSPACES *****/
 
   // collisional relaxation eigenvalues and eigenvectors
-  const int relax_size = global_size - chem_size;
+  const int relax_size = eigen_size - chem_size;
   Lapack::Vector relax_lave(relax_size);
   for(int r = 0; r < relax_size; ++r) {
     itemp = r + chem_size;
@@ -4226,31 +5419,61 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
   }
 
   // kinetic matrix modified
+  //
+  if(kin_mat.isinit()) {
+    //
+    // chemical eigenvectors on the relaxation matrix grid
+    //
+    Lapack::Matrix chem_kin;
+
+    if(grid) {
+      //
+      mtemp = Lapack::Matrix(global_size, chem_size);
+
+      for(int l = 0; l < chem_size; ++l)
+	//
+	for(int g = 0; g < global_size; ++g)
+	  //
+	  mtemp(g, l) = eigen_global(l, g);
+
+      chem_kin = grid->project(mtemp).transpose();
+    }
+    else
+      //
+      chem_kin = eigen_global;
 
 #pragma omp parallel for default(shared) private(dtemp) schedule(dynamic)
 	
-  for(int i = 0; i < global_size; ++i) {
-    for(int j = i; j < global_size; ++j) {
-      dtemp = 0.;
-      for(int l = 0; l < chem_size; ++l)
-	dtemp += eigen_global(l, i) * eigen_global(l, j);
-      kin_mat(i, j) += dtemp * well(0).collision_frequency();
+    for(int i = 0; i < kin_size; ++i) {
+      for(int j = i; j < kin_size; ++j) {
+	dtemp = 0.;
+	for(int l = 0; l < chem_size; ++l)
+	  dtemp += chem_kin(l, i) * chem_kin(l, j);
+	kin_mat(i, j) += dtemp * well(0).collision_frequency();
+      }
     }
   }
 
   Lapack::Matrix proj_bim = global_bim.copy();
   for(int p = 0; p < Model::bimolecular_size(); ++p)
     for(int l = 0; l < chem_size; ++l)
-      parallel_orthogonalize(&proj_bim(0, p), &eigen_global(l, 0), global_size, 1, global_size);
+      parallel_orthogonalize(&proj_bim(0, p), &eigen_global(l, 0), global_size, 1, eigen_size);
 
   Lapack::Matrix inv_proj_bim; 
-  if(Model::bimolecular_size())
+  if(Model::bimolecular_size() && kin_mat.isinit() && grid)
+    //
+    // Galerkin solution on the adaptive grid
+    //
+    inv_proj_bim = grid->expand(Lapack::Cholesky(kin_mat).invert(grid->project(proj_bim)));
+  else if(Model::bimolecular_size() && kin_mat.isinit())
     inv_proj_bim = Lapack::Cholesky(kin_mat).invert(proj_bim);
+  else if(Model::bimolecular_size())
+    inv_proj_bim = relaxation_solve(kin_band, global_index, eigenval, eigen_global, chem_size, proj_bim);
 
   Lapack::Matrix proj_pop = global_pop.copy();
   for(int w = 0; w < Model::well_size(); ++w)
     for(int l = 0; l < chem_size; ++l)
-      parallel_orthogonalize(&proj_pop(0, w), &eigen_global(l, 0), global_size, 1, global_size);
+      parallel_orthogonalize(&proj_pop(0, w), &eigen_global(l, 0), global_size, 1, eigen_size);
   
   // kappa matrix
   //
@@ -4323,7 +5546,7 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
       Lapack::Matrix proj_escape = global_escape.copy();
       for(int count = 0; count < Model::escape_size(); ++count)
 	for(int l = 0; l < chem_size; ++l)
-	  parallel_orthogonalize(&proj_escape(0, count), &eigen_global(l, 0), global_size, 1, global_size);
+	  parallel_orthogonalize(&proj_escape(0, count), &eigen_global(l, 0), global_size, 1, eigen_size);
     
       Lapack::Matrix escape_bim = proj_escape.transpose() * inv_proj_bim;
       */
@@ -4416,7 +5639,7 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
 	//
 	// Hot energies-to-escape channels distribution
 	//
-	if(hot_energy_size) {
+	if(context().hot_energy_size) {
 	  //
 	  ped_out << "Hot-to-escape product energy distributions:\n";
 
@@ -4428,7 +5651,7 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
 
 	    vtemp.resize(well(ew).size());
 	    
-	    for(hit = hot_index.begin(); hit != hot_index.end(); ++hit) {
+	    for(hit = context().hot_index.begin(); hit != context().hot_index.end(); ++hit) {
 	      //
 	      const int& hw = hit->first;
 	      
@@ -4544,7 +5767,7 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
       }// escape output
 
       // hot product energy distributions
-      if(hot_energy_size) {
+      if(context().hot_energy_size) {
 	ped_out << "Hot product energy distributions:\n\n";
 
 	// dimension
@@ -4559,7 +5782,7 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
 	// hot energy cycle
 	int count = 0;
 	std::map<int, std::vector<int> >::const_iterator hit;
-	for(hit = hot_index.begin(); hit != hot_index.end(); ++hit)
+	for(hit = context().hot_index.begin(); hit != context().hot_index.end(); ++hit)
 	  for(int i = 0; i < hit->second.size(); ++i, ++count) {
 	    dtemp = (energy_reference() - (double)hit->second[i] * energy_step()) / Phys_const::kcal;
 	    ped_out << "Initial well: "<< Model::well(hit->first).name()
@@ -4934,7 +6157,7 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
 
   // hot distribution branching ratios
   //
-  if(hot_energy_size) {
+  if(context().hot_energy_size) {
     //
     IO::log << IO::log_offset << "Hot distribution branching ratios:\n"
 	    << IO::log_offset //<< std::setprecision(6)
@@ -4961,7 +6184,7 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
     
     int count = 0;
     
-    for(hit = hot_index.begin(); hit != hot_index.end(); ++hit)
+    for(hit = context().hot_index.begin(); hit != context().hot_index.end(); ++hit)
       //
       for(int i = 0; i < hit->second.size(); ++i, ++count) {
 	//
@@ -5011,21 +6234,126 @@ void MasterEquation::set_well_partition_method (const std::string& method)
     return;
   }
 
-  // incremental method
-  if(method == "incremental") {
-    well_partition_method = incremental_well_partition;
-    return;
-  }
+  // incremental method
+  if(method == "incremental") {
+    well_partition_method = incremental_well_partition;
+    return;
+  }
+
+  // sequential method
+  if(method == "sequential") {
+    well_partition_method =   sequential_well_partition;
+    return;
+  }
+
+  std::cerr << funame << ": unknown well partition method: " << method
+	    << "; available methods: threshold (default), sort_out, incremental, sequential\n";
+  throw Error::Input();
+}
+
+void MasterEquation::set_eigensolver (const std::string& solver)  
+{
+  const char funame [] = "MasterEquation::set_eigensolver: ";
+
+  // packed storage
+  if(solver == "packed") {
+    eigensolver = PACKED_EIGENSOLVER;
+    return;
+  }
+
+  // full storage divide-and-conquer
+  if(solver == "dsyevd") {
+    eigensolver = DC_EIGENSOLVER;
+    return;
+  }
+
+  // full storage eigenvalue index range
+  if(solver == "dsyevr") {
+    eigensolver = RANGE_EIGENSOLVER;
+    return;
+  }
+
+  // energy-ordered band
+  if(solver == "band") {
+    eigensolver = BAND_EIGENSOLVER;
+    return;
+  }
+
+  // shift-and-invert Lanczos on the energy-ordered band matrix
+  if(solver == "lanczos") {
+    eigensolver = LANCZOS_EIGENSOLVER;
+    return;
+  }
+
+  std::cerr << funame << ": unknown eigensolver: " << solver
+	    << "; available eigensolvers: packed (default), dsyevd, dsyevr, band, lanczos\n";
+  throw Error::Input();
+}
+
+void MasterEquation::set_chem_eigensolver (const std::string& solver)  
+{
+  const char funame [] = "MasterEquation::set_chem_eigensolver: ";
+
+  // double precision
+  if(solver == "double") {
+    chem_eigensolver = DOUBLE_CHEM_EIGENSOLVER;
+    return;
+  }
+
+  // double precision refined with the doubled precision residuals
+  if(solver == "refined") {
+    chem_eigensolver = REFINED_CHEM_EIGENSOLVER;
+    return;
+  }
+
+  // MPACK double-double
+  if(solver == "mpack") {
+    //
+#ifdef WITH_MPACK
+
+    chem_eigensolver = MPACK_CHEM_EIGENSOLVER;
+    return;
+
+#else
+
+    std::cerr << funame << "the code is built without the MPACK library\n";
+    throw Error::Input();
+
+#endif
+  }
+
+  std::cerr << funame << ": unknown eigensolver: " << solver
+	    << "; available eigensolvers: double, refined (default), mpack\n";
+  throw Error::Input();
+}
+
+Lapack::Vector MasterEquation::chem_eigenvalues (const Lapack::SymmetricMatrix& k_11, Lapack::Matrix& chem_evec)
+{
+  const char funame [] = "MasterEquation::chem_eigenvalues: ";
+
+  switch(chem_eigensolver) {
+    //
+  case DOUBLE_CHEM_EIGENSOLVER:
+    //
+    return k_11.eigenvalues(&chem_evec);
+
+  case REFINED_CHEM_EIGENSOLVER:
+    //
+    return k_11.refined_eigenvalues(&chem_evec);
+
+#ifdef WITH_MPACK
+
+  case MPACK_CHEM_EIGENSOLVER:
+    //
+    return Mpack::dd_eigenvalues(k_11, &chem_evec);
 
-  // sequential method
-  if(method == "sequential") {
-    well_partition_method =   sequential_well_partition;
-    return;
-  }
+#endif
 
-  std::cerr << funame << ": unknown well partition method: " << method
-	    << "; available methods: threshold (default), sort_out, incremental, sequential\n";
-  throw Error::Input();
+  default:
+    //
+    std::cerr << funame << "unknown eigensolver: " << chem_eigensolver << "\n";
+    throw Error::Logic();
+  }
 }
 
 double MasterEquation::threshold_well_partition (const Lapack::Matrix& pop_chem, Partition& well_partition,
@@ -5091,25 +6419,13 @@ double MasterEquation::threshold_well_partition (const Lapack::Matrix& pop_chem,
     //
     IO::log << IO::log_offset << funame << "WARNING: large well projection is smaller than the well projection threshold\n";
   
-  double pmax = -1.;
+  double pmax;
   
-  for(PartitionGenerator pg(chem_size, well_map.size()); !pg.end(); ++pg) {
-    //
-    // initialize new partition
-    //
-    Partition p(pg, well_map);
+  PartitionMap high_part;
 
-    // partition projection
-    //
-    dtemp = p.projection(pop_chem, weight);
+  partition_search(pop_chem, weight, chem_size, well_map, false, 1, high_part);
 
-    if(dtemp > pmax) {
-      //
-      pmax = dtemp;
-      
-      well_partition = p;
-    }
-  }
+  well_partition = high_part.rbegin()->second.first;
 
   while(bimolecular_group.size()) {
     //
@@ -5186,7 +6502,6 @@ double MasterEquation::sort_well_partition (const Lapack::Matrix& pop_chem, Part
   //IO::Marker funame_marker(funame);
 
   int    itemp;
-  double dtemp;
   bool   btemp;
   std::string stemp;
 
@@ -5204,49 +6519,14 @@ double MasterEquation::sort_well_partition (const Lapack::Matrix& pop_chem, Part
     throw Error::Logic();
   }
 
-  std::multimap<double, std::pair<Partition, Group> > high_part;
+  PartitionMap high_part;
 
   std::clock_t start_cpu = std::clock();
   std::time_t  start_time = std::time(0);
 
-  // partitioning the wells into equilibrated groups
-  int part_size = chem_size;
-  for(PartitionGenerator pg(part_size, well_size); !pg.end(); ++pg) {
-    // initialize new partition
-    Partition part(pg);
-
-    // partition projection
-    dtemp = part.projection(pop_chem, weight);
-
-    if(high_part.size() < red_out_num)
-      high_part.insert(std::make_pair(dtemp, std::make_pair(part, Group())));
-    else if(dtemp > high_part.begin()->first) {
-      high_part.erase(high_part.begin());
-      high_part.insert(std::make_pair(dtemp, std::make_pair(part, Group())));
-    }
-  }
-
-  // the case when some of the wells equilibrate with bimolecular products
-  // is solved by allowing the bimolecular group and then removing it
-  part_size = chem_size + 1;
-  for(PartitionGenerator pg(part_size, well_size); !pg.end(); ++pg) {
-    // initialize new partition
-    Partition part(pg);
-    for(int g = 0; g < part_size; ++g) {
-      Partition q = part;
-      Group bg = q[g];
-      // removing the bimolecular group
-      q.erase(q.begin() + g);
-      // partition projection
-      dtemp = q.projection(pop_chem, weight);
-      if(high_part.size() < red_out_num)
-	high_part.insert(std::make_pair(dtemp, std::make_pair(q, bg)));
-      else if(dtemp > high_part.begin()->first) {
-	high_part.erase(high_part.begin());
-	high_part.insert(std::make_pair(dtemp, std::make_pair(q, bg)));
-      }
-    }
-  }
+  // partitioning the wells into equilibrated groups; the case when some of the wells equilibrate
+  // with bimolecular products is solved by allowing the bimolecular group
+  partition_search(pop_chem, weight, chem_size, std::vector<int>(), true, red_out_num, high_part);
 
   well_partition    = high_part.rbegin()->second.first;
   bimolecular_group = high_part.rbegin()->second.second;
@@ -5274,7 +6554,7 @@ double MasterEquation::sort_well_partition (const Lapack::Matrix& pop_chem, Part
     IO::log.setf(std::ios_base::fmtflags(0), std::ios_base::floatfield);
 
     IO::log << IO::log_offset << "closest well partitions:\n";
-    std::multimap<double, std::pair<Partition, Group> >::const_reverse_iterator rit;
+    PartitionMap::const_reverse_iterator rit;
     IO::log << IO::log_offset 
 	    << std::setw(15) << "reduction error" 
 	    << std::setw(50) << "equilibrated_groups"
@@ -5649,6 +6929,446 @@ void MasterEquation::PartitionGenerator::operator++ ()
   _end = true;
 }
 
+/***************** Branch-and-bound search for the largest projection partitions ****************/
+
+namespace {
+  //
+  using namespace MasterEquation;
+
+  // the wells are assigned to the groups one by one, in the order of decreasing single well
+  // projections, so that the group labels grow with the first assigned well (no equivalent
+  // assignments); the label -1 stands for the bimolecular group
+  //
+  class PartitionSearch {
+    //
+    const Lapack::Matrix&      _pop_chem;
+    const std::vector<double>& _weight;
+    const std::vector<int>&    _well_map;
+
+    const int  _part_size;
+    const bool _is_bim;
+    const int  _high_size;
+
+    int _chem_size;
+
+    std::vector<int>    _order;     // search order to the partition generator index map
+    std::vector<int>    _well;      // partition generator index to the well index map
+    std::vector<double> _proj_sqrt; // weighted chemical subspace projection of the well, squared root of the weight
+    std::vector<double> _rest;      // single well projections sum over the wells not assigned yet
+
+    // search state
+    //
+    struct State {
+      std::vector<int>    assign;
+      int                 group_num;
+      std::vector<double> sum;      // weighted chemical subspace projections sum of the group
+      std::vector<double> norm;     // group weight
+      std::vector<double> proj;     // group projection
+      PartitionMap        high;     // largest projection partitions found in the subtree
+      double              thresh;   // smallest projection to beat
+    };
+
+    void _push (State&, int g) const;
+    void _pop  (State&)        const;
+
+    double _bound (const State&) const;
+
+    void _leaf   (State&) ;
+    void _branch (State&) ;
+
+    // smallest projection of the largest projection partitions found by all threads
+    //
+    std::mutex   _lock;
+    PartitionMap _high;
+    double       _thresh;
+
+    void _merge (State&) ;
+
+  public:
+    PartitionSearch (const Lapack::Matrix& pop_chem, const std::vector<double>& weight, const std::vector<int>& well_map,
+		     int part_size, bool is_bim, int high_size) ;
+
+    void run (PartitionMap&) ;
+  };
+
+  // the partition projections are compared within the round-off error
+  //
+  const double proj_tol = 1.e-10;
+
+  // minimal number of the concurrently searched subtrees
+  //
+  const int task_min = 256;
+
+  PartitionSearch::PartitionSearch (const Lapack::Matrix& pop_chem, const std::vector<double>& weight,
+				    const std::vector<int>& well_map, int part_size, bool is_bim, int high_size)
+    : _pop_chem(pop_chem), _weight(weight), _well_map(well_map), _part_size(part_size), _is_bim(is_bim),
+      _high_size(high_size), _chem_size(pop_chem.size2()), _thresh(-1.)
+  {
+    const char funame [] = "MasterEquation::PartitionSearch::PartitionSearch: ";
+
+    const int size = well_map.size() ? well_map.size() : pop_chem.size1();
+
+    if(part_size < 1 || part_size > size || high_size < 1) {
+      std::cerr << funame << "out of range: partition size = " << part_size << ", wells number = " << size
+		<< ", partitions number = " << high_size << "\n";
+      throw Error::Range();
+    }
+
+    _well.resize(size);
+
+    for(int i = 0; i < size; ++i)
+      //
+      _well[i] = well_map.size() ? well_map[i] : i;
+
+    // single well projections
+    //
+    std::vector<double> proj(size);
+
+    std::multimap<double, int> proj_map;
+
+    _proj_sqrt.resize(size * _chem_size);
+
+    for(int i = 0; i < size; ++i) {
+      //
+      const int w = _well[i];
+
+      const double ws = weight.size() ? std::sqrt(weight[w]) : well(w).weight_sqrt();
+
+      for(int l = 0; l < _chem_size; ++l)
+	//
+	_proj_sqrt[i * _chem_size + l] = ws * pop_chem(w, l);
+
+      proj[i] = Group(w).projection(pop_chem, weight);
+
+      proj_map.insert(std::make_pair(proj[i], i));
+    }
+
+    for(std::multimap<double, int>::const_reverse_iterator p = proj_map.rbegin(); p != proj_map.rend(); ++p)
+      //
+      _order.push_back(p->second);
+
+    _rest.resize(size + 1);
+
+    _rest[size] = 0.;
+
+    for(int k = size - 1; k >= 0; --k)
+      //
+      _rest[k] = _rest[k + 1] + proj[_order[k]];
+  }
+
+  void PartitionSearch::_push (State& s, int g) const
+  {
+    const int i = _order[s.assign.size()];
+
+    s.assign.push_back(g);
+
+    if(g < 0)
+      //
+      return;
+
+    if(g == s.group_num)
+      //
+      ++s.group_num;
+
+    const int w = _well[i];
+
+    s.norm[g] += _weight.size() ? _weight[w] : well(w).weight();
+
+    double dtemp = 0.;
+
+    for(int l = 0; l < _chem_size; ++l) {
+      //
+      s.sum[g * _chem_size + l] += _proj_sqrt[i * _chem_size + l];
+
+      dtemp += s.sum[g * _chem_size + l] * s.sum[g * _chem_size + l];
+    }
+
+    s.proj[g] = dtemp / s.norm[g];
+  }
+
+  void PartitionSearch::_pop (State& s) const
+  {
+    const int g = s.assign.back();
+
+    s.assign.pop_back();
+
+    if(g < 0)
+      //
+      return;
+
+    const int i = _order[s.assign.size()];
+
+    const int w = _well[i];
+
+    s.norm[g] -= _weight.size() ? _weight[w] : well(w).weight();
+
+    double dtemp = 0.;
+
+    for(int l = 0; l < _chem_size; ++l) {
+      //
+      s.sum[g * _chem_size + l] -= _proj_sqrt[i * _chem_size + l];
+
+      dtemp += s.sum[g * _chem_size + l] * s.sum[g * _chem_size + l];
+    }
+
+    bool is_empty = true;
+
+    for(int k = 0; k < s.assign.size(); ++k)
+      //
+      if(s.assign[k] == g) {
+	//
+	is_empty = false;
+
+	break;
+      }
+
+    if(is_empty) {
+      //
+      --s.group_num;
+
+      s.norm[g] = 0.;
+
+      s.proj[g] = 0.;
+
+      for(int l = 0; l < _chem_size; ++l)
+	//
+	s.sum[g * _chem_size + l] = 0.;
+    }
+    else
+      //
+      s.proj[g] = dtemp / s.norm[g];
+  }
+
+  // the group projection does not exceed the sum of the projections of its parts (Cauchy-Schwarz)
+  //
+  double PartitionSearch::_bound (const State& s) const
+  {
+    double res = _rest[s.assign.size()];
+
+    for(int g = 0; g < s.group_num; ++g)
+      //
+      res += s.proj[g];
+
+    return res;
+  }
+
+  void PartitionSearch::_leaf (State& s)
+  {
+    // partition in the partition generator order: the groups are ordered by their first wells
+    //
+    std::vector<int> assign(_well.size());
+
+    for(int k = 0; k < s.assign.size(); ++k)
+      //
+      assign[_order[k]] = s.assign[k];
+
+    std::vector<int> label(_part_size, -1);
+
+    Partition part(_part_size);
+
+    Group bim;
+
+    int group_num = 0;
+
+    for(int i = 0; i < assign.size(); ++i) {
+      //
+      const int g = assign[i];
+
+      if(g < 0) {
+	//
+	bim.insert(_well[i]);
+
+	continue;
+      }
+
+      if(label[g] < 0)
+	//
+	label[g] = group_num++;
+
+      part[label[g]].insert(_well[i]);
+    }
+
+    const double proj = part.projection(_pop_chem, _weight);
+
+    if(s.high.size() < _high_size)
+      //
+      s.high.insert(std::make_pair(proj, std::make_pair(part, bim)));
+    else if(proj > s.high.begin()->first) {
+      //
+      s.high.erase(s.high.begin());
+
+      s.high.insert(std::make_pair(proj, std::make_pair(part, bim)));
+    }
+    else
+      //
+      return;
+
+    if(s.high.size() == _high_size && s.high.begin()->first > s.thresh)
+      //
+      s.thresh = s.high.begin()->first;
+  }
+
+  void PartitionSearch::_branch (State& s)
+  {
+    const int k = s.assign.size();
+
+    // not enough wells left to fill the groups
+    //
+    if(_part_size - s.group_num > _well.size() - k)
+      //
+      return;
+
+    if(_bound(s) < s.thresh - proj_tol)
+      //
+      return;
+
+    if(k == _well.size()) {
+      //
+      _leaf(s);
+
+      return;
+    }
+
+    for(int g = 0; g < s.group_num; ++g) {
+      //
+      _push(s, g);
+
+      _branch(s);
+
+      _pop(s);
+    }
+
+    if(s.group_num < _part_size) {
+      //
+      _push(s, s.group_num);
+
+      _branch(s);
+
+      _pop(s);
+    }
+
+    if(_is_bim) {
+      //
+      _push(s, -1);
+
+      _branch(s);
+
+      _pop(s);
+    }
+  }
+
+  void PartitionSearch::_merge (State& s)
+  {
+    std::lock_guard<std::mutex> lock(_lock);
+
+    for(PartitionMap::const_iterator p = s.high.begin(); p != s.high.end(); ++p)
+      //
+      if(_high.size() < _high_size)
+	//
+	_high.insert(*p);
+      else if(p->first > _high.begin()->first) {
+	//
+	_high.erase(_high.begin());
+
+	_high.insert(*p);
+      }
+
+    if(_high.size() == _high_size)
+      //
+      _thresh = _high.begin()->first;
+
+    s.high.clear();
+
+    if(_thresh > s.thresh)
+      //
+      s.thresh = _thresh;
+  }
+
+  void PartitionSearch::run (PartitionMap& res)
+  {
+    const char funame [] = "MasterEquation::PartitionSearch::run: ";
+
+    State root;
+
+    root.group_num = 0;
+    root.sum.resize(_part_size * _chem_size, 0.);
+    root.norm.resize(_part_size, 0.);
+    root.proj.resize(_part_size, 0.);
+    root.thresh = -1.;
+
+    // subtrees roots: the assignments of the first wells, as many as needed to keep the threads busy
+    //
+    std::vector<std::vector<int> > task(1);
+
+    for(int k = 0; k < _well.size() && task.size() < task_min; ++k) {
+      //
+      std::vector<std::vector<int> > next;
+
+      for(int t = 0; t < task.size(); ++t) {
+	//
+	int group_num = 0;
+
+	for(int i = 0; i < task[t].size(); ++i)
+	  //
+	  if(task[t][i] == group_num)
+	    //
+	    ++group_num;
+
+	const int gmax = group_num < _part_size ? group_num : _part_size - 1;
+
+	for(int g = _is_bim ? -1 : 0; g <= gmax; ++g) {
+	  //
+	  const int gnum = g == group_num ? group_num + 1 : group_num;
+
+	  if(_part_size - gnum > _well.size() - k - 1)
+	    //
+	    continue;
+
+	  next.push_back(task[t]);
+
+	  next.back().push_back(g);
+	}
+      }
+
+      task.swap(next);
+    }
+
+#pragma omp parallel for default(shared) schedule(dynamic, 1)
+
+    for(int t = 0; t < task.size(); ++t) {
+      //
+      State s = root;
+
+      {
+	std::lock_guard<std::mutex> lock(_lock);
+
+	s.thresh = _thresh;
+      }
+
+      for(int k = 0; k < task[t].size(); ++k)
+	//
+	_push(s, task[t][k]);
+
+      _branch(s);
+
+      _merge(s);
+    }
+
+    if(!_high.size()) {
+      std::cerr << funame << "no partitions found\n";
+      throw Error::Logic();
+    }
+
+    res = _high;
+  }
+}
+
+void MasterEquation::partition_search (const Lapack::Matrix& pop_chem, const std::vector<double>& weight, int part_size,
+				       const std::vector<int>& well_map, bool is_bim, int high_size, PartitionMap& high_part)
+{
+  PartitionSearch(pop_chem, weight, well_map, part_size, is_bim, high_size).run(high_part);
+}
+
 /*************** Generator of group of m elements from the pool of n elements *******************/
 
 MasterEquation::GroupGenerator::GroupGenerator (int m, int n) 
@@ -22,6 +22,7 @@
 #include <map>
 
 #include "error.hh"
+#include "io.hh"
 #include "lapack.hh"
 #include "model.hh"
 
@@ -30,8 +31,8 @@ namespace MasterEquation {
   class Partition;
 
   // eigenvector and eigenvalue output
-  extern std::ofstream eval_out;// eigenvalues output
-  extern std::ofstream evec_out;// eigenvalues output
+  extern IO::LogOut eval_out;// eigenvalues output
+  extern IO::LogOut evec_out;// eigenvalues output
   extern int           evec_out_num;// number of relaxation eigenvalues to print
 
   enum {TORR, BAR, ATM};
@@ -48,7 +49,7 @@ namespace MasterEquation {
   extern std::map<std::string, std::vector<double> > hot_energy;
 
   // product energy distributions
-  extern std::ofstream ped_out;
+  extern IO::LogOut ped_out;
   void set_ped_pair(const std::vector<std::string>& ped_spec) ;
 
   extern double         well_cutoff;// well cutoff parameter
@@ -73,6 +74,21 @@ namespace MasterEquation {
   // set states densities, states numbers, etc. 
   void set (std::map<std::pair<int, int>, double>& rate_data, std::map<int, double>& capture) ;
 
+  /************************************* STATES GRID CACHE ************************************/
+
+  // the densities and numbers of states on the energy grid are kept for each species and
+  // energy grid and reused by later temperatures on the same grid and, if the cache
+  // directory is set, by restarted jobs and parameter scans; the cached species are
+  // identified by their input description, so that the changes in the data files
+  // it refers to are not detected
+  //
+  extern std::string grid_cache_dir;
+
+  // states of the species on the grid from the energy reference down; the result is
+  // truncated at the first nonpositive value
+  //
+  void grid_states (const Model::Species&, int size, Lapack::Vector& states) ;
+
   /********************************************************************************************
    ***************************************** WELL CLASS ***************************************
    ********************************************************************************************/
@@ -90,7 +106,7 @@ namespace MasterEquation {
     Lapack::Vector          _boltzman_sqrt;      // Boltzmann distribution
     Lapack::Matrix          _crm_basis;          // CRM basis (ket)
     Lapack::Matrix          _crm_bra;            // CRM basis (bra)
-    Lapack::Matrix          _kernel;             // energy relaxation kernel
+    Lapack::BandMatrix      _kernel;             // energy relaxation kernel, upper triangle
     Lapack::SymmetricMatrix _crm_kernel;         // kernel in CRM basis
     Lapack::Vector          _escape_rate;        // escape rate;
 
@@ -115,7 +131,7 @@ namespace MasterEquation {
     double  state_density (int i)           const { return     _state_density[i]; }
     double       boltzman (int i)           const { return          _boltzman[i]; }
     double  boltzman_sqrt (int i)           const { return     _boltzman_sqrt[i]; }
-    double         kernel (int i, int j)    const { return         _kernel(i, j); }
+    double         kernel (int i, int j)    const ;
 
     double minimal_relaxation_eigenvalue () const { return       _min_relax_eval; }
     double maximal_relaxation_eigenvalue () const { return       _max_relax_eval; }
@@ -174,6 +190,54 @@ namespace MasterEquation {
     double   weight () const { return   _weight; }
   };
 
+  /********************************************************************************************
+   **************************************** SOLVER CONTEXT ************************************
+   ********************************************************************************************/
+
+  // The state of the calculation at one temperature-pressure point: the energy grid,
+  // the wells, barriers, and bimolecular species set on it, etc. Every thread works
+  // with its own current context, so that independent points can be solved concurrently;
+  // the copies share the wells and barriers which are read-only after MasterEquation::set
+  //
+  class Context {
+  public:
+    double temperature;
+    double pressure;
+    double energy_step;
+    double energy_reference;
+    bool   isset;
+
+    std::vector<double>                      thermal_factor; // exp(E/T) on the grid
+
+    std::vector<SharedPointer<Well> >        well;
+    std::vector<SharedPointer<Bimolecular> > bimolecular;
+    std::vector<SharedPointer<Barrier> >     inner_barrier;
+    std::vector<SharedPointer<Barrier> >     outer_barrier;
+
+    std::vector<Array<double> >              cum_stat_num;   // cumulative number of states for each well
+
+    std::map<int, std::vector<int> >         hot_index;      // hot energies grid indices
+    int                                      hot_energy_size;
+
+    // pressure sweep continuation of the band eigensolvers at given temperature: the pressure
+    // independent and the collisional parts of the energy-ordered band relaxation matrix, the latter
+    // at relax_pressure, and the eigenvectors found last, as columns in the band ordering
+    //
+    Lapack::BandMatrix                       relax_base;
+    Lapack::BandMatrix                       relax_collision;
+    double                                   relax_pressure;
+    Lapack::Matrix                           relax_evec;
+
+    Context () : temperature(-1.), pressure(-1.), energy_step(-1.), energy_reference(0.),
+		 isset(false), hot_energy_size(0), relax_pressure(-1.) {}
+  };
+
+  // current thread context
+  Context& context ();
+
+  // make the context current for the calling thread; zero pointer restores the default one
+  void set_context (Context*);
+
   /*********************************************************************************************/
 
   const Well&                            well (int w);
@@ -215,6 +279,102 @@ namespace MasterEquation {
   double  sequential_well_partition (const Lapack::Matrix&, Partition&, Group&, const std::vector<double>&)
     ;
 
+  /************************* GLOBAL RELAXATION MATRIX EIGENSOLVER *****************************/
+
+  // packed storage (dspev, default), full storage divide-and-conquer (dsyevd), full storage 
+  // index range (dsyevr), and energy-ordered band (dsbevd/dsbevx) eigensolvers; the full storage
+  // ones diagonalize a full square copy of the packed matrix, which triples the memory needed;
+  // the band and Lanczos eigensolvers never store the global relaxation matrix in full:
+  // it is set in the energy-ordered band storage, and the Lanczos one finds only the requested
+  // lowest eigenstates by the shift-and-invert Lanczos iterations
+  //
+  enum {PACKED_EIGENSOLVER, DC_EIGENSOLVER, RANGE_EIGENSOLVER, BAND_EIGENSOLVER, LANCZOS_EIGENSOLVER};
+  
+  extern int eigensolver;
+
+  void set_eigensolver (const std::string&) ;
+
+  // chemical subspace (low eigenvalue method) eigensolvers: double precision (dspev), double precision
+  // refined with the residuals in the doubled precision (default), which keeps the relative accuracy
+  // of the smallest eigenvalues, and MPACK double-double diagonalization, if built WITH_MPACK
+  //
+  enum {DOUBLE_CHEM_EIGENSOLVER, REFINED_CHEM_EIGENSOLVER, MPACK_CHEM_EIGENSOLVER};
+
+  extern int chem_eigensolver;
+
+  void set_chem_eigensolver (const std::string&) ;
+
+  // eigenvalues of the chemical subspace kinetic matrix and its eigenvectors as columns
+  //
+  Lapack::Vector chem_eigenvalues (const Lapack::SymmetricMatrix&, Lapack::Matrix&) ;
+
+  // lowest eigenvalues of the global relaxation matrix and corresponding eigenvectors as rows by the
+  // packed, divide-and-conquer, and index range eigensolvers; the full spectrum is returned by the first two
+  //
+  Lapack::Vector global_eigenvalues (const Lapack::SymmetricMatrix& kin_mat, int eigen_size,
+				     Lapack::Matrix& eigen_global) ;
+
+  // energy ordering of the global states: states of all wells at the same energy are adjacent;
+  // band_index[w][i] is the position of the i-th state of the w-th well, global_index is the inverse
+  // map to the global (well ordered) index; returns the band size of the global relaxation matrix
+  //
+  int energy_ordering (const std::vector<int>& well_shift, std::vector<std::vector<int> >& band_index,
+		       std::vector<int>& global_index) ;
+
+  // adaptive energy grid: the relaxation matrix is projected on the Boltzmann-weighted piecewise linear
+  // functions of energy with the nodes at every grid energy near the barrier thresholds and spaced wider
+  // deep in the wells and high above the thresholds, where the populations are smooth; the widest spacing
+  // is adaptive_grid_width times the collisional energy transfer range (kernel bandwidth), the zero width
+  // keeps the uniform grid. The thermal distributions lie in the basis span, so that the detailed balance
+  // is kept exactly. It is used with the packed, dsyevd, and dsyevr eigensolvers
+  //
+  extern double adaptive_grid_width;
+
+  class AdaptiveGrid {
+    //
+    std::vector<int>    _node;   // lower node of the global index
+    std::vector<double> _weight; // lower and upper node basis functions at the global index
+    Lapack::Matrix      _orth;   // symmetric orthonormalization: the basis overlap to the -1/2 power
+
+  public:
+    explicit AdaptiveGrid (const std::vector<int>& well_shift) ;
+
+    int size () const { return _orth.size1(); }
+
+    // contribution of the (i, j) and, if different, (j, i) global relaxation matrix elements to the
+    // matrix projected on the basis, not orthonormalized yet
+    //
+    void add (Lapack::SymmetricMatrix&, int i, int j, double val) const;
+
+    // projected matrix in the orthonormalized basis
+    //
+    Lapack::SymmetricMatrix orthogonalize (const Lapack::SymmetricMatrix&) const;
+
+    // global vectors (columns) from their orthonormalized basis components and the projection back
+    //
+    Lapack::Matrix  expand (const Lapack::Matrix&) const;
+    Lapack::Matrix project (const Lapack::Matrix&) const;
+  };
+
+  // lowest eigenvalues of the energy-ordered band relaxation matrix and corresponding eigenvectors
+  // as rows in the well ordering; the Lanczos eigensolver starts from the eigenvectors found last
+  // in the current context, if they are of the same size
+  //
+  Lapack::Vector band_eigenvalues (const Lapack::BandMatrix& band_mat, const std::vector<int>& global_index,
+				   int eigen_size, Lapack::Matrix& eigen_global) ;
+
+  // shift of the global relaxation matrix below its spectrum for the shift-and-invert iterations
+  //
+  double lanczos_shift ();
+
+  // solution of the relaxation matrix linear equations with the right hand sides orthogonal to the
+  // chemical subspace spanned by the first chem_size eigenvectors (rows of eigen_global); at least
+  // one relaxation eigenstate is needed
+  //
+  Lapack::Matrix relaxation_solve (const Lapack::BandMatrix& kin_band, const std::vector<int>& global_index,
+				   const Lapack::Vector& eigenval, const Lapack::Matrix& eigen_global, int chem_size,
+				   const Lapack::Matrix& rhs) ;
+
   /******************************************* HELPERS *******************************************/
 
   // group of wells
@@ -295,6 +455,20 @@ namespace MasterEquation {
     int operator[]      (int i) const { return _group_index[i]; }
   };
 
+  // partitions with the largest projections onto the chemical subspace, ordered by the projection
+  //
+  typedef std::multimap<double, std::pair<Partition, Group> > PartitionMap;
+
+  // branch-and-bound search for the high_size largest projection partitions of the wells (of the
+  // well_map wells, if given) into part_size groups, with the result of the PartitionGenerator
+  // enumeration. With is_bim set the wells may also be left out in the bimolecular group, which
+  // covers the partitions into part_size + 1 groups with one of them removed. The group projection
+  // does not exceed the sum of its wells projections, which bounds the partition projection from
+  // above; the subtrees are searched concurrently
+  //
+  void partition_search (const Lapack::Matrix& pop_chem, const std::vector<double>& weight, int part_size,
+			 const std::vector<int>& well_map, bool is_bim, int high_size, PartitionMap& high_part) ;
+
   // description of the species as a group of equilibrated wells at high pressure
   struct HPWell : public Group {
     double weight; // statistical weight
@@ -306,7 +480,7 @@ namespace MasterEquation {
   };
 
   // auxilliary output
-  extern std::ofstream eval_out; // eigenvalues output
+  extern IO::LogOut eval_out; // eigenvalues output
 }
 
 #endif
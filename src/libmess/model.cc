@@ -24,6 +24,10 @@
 #include <ctime>
 #include <cstring>
 #include <cstdarg>
+#include <cstdlib>
+#include <exception>
+#include <unistd.h>
+#include <sys/stat.h>
 
 #include "atom.hh"
 #include "model.hh"
@@ -31,6 +35,7 @@
 #include "key.hh"
 #include "io.hh"
 #include "slatec.h"
+#include "convolution.hh"
 
 // sparse matrix eigenvalue solver
 //#include "feast.h"
@@ -347,6 +352,199 @@ void Model::TimeEvolution::set_reactant () const
  ******************************** MODEL INITIALIZATION **************************************
  ********************************************************************************************/
 
+namespace {
+  //
+  // 64-bit FNV-1a hash continued over the bytes
+  //
+  unsigned long long _fnv_hash (const char* p, size_t n, unsigned long long hash = 14695981039346656037ULL)
+  {
+    for(const char* end = p + n; p != end; ++p) {
+      hash ^= (unsigned char)*p;
+      hash *= 1099511628211ULL;
+    }
+
+    return hash;
+  }
+
+  // the text hash as a hexadecimal string
+  //
+  std::string _text_hash (const std::string& text)
+  {
+    std::ostringstream res;
+
+    res << std::hex << std::setw(16) << std::setfill('0') << _fnv_hash(text.data(), text.size());
+
+    return res.str();
+  }
+
+  // species description recorded while the model input is parsed
+  //
+  struct _SpeciesInput {
+    //
+    enum type_t {WELL, BARRIER, BIMOLECULAR};
+
+    type_t                              type;
+    std::string                         name;
+    std::streampos                      start; // description position in the input stream
+    SharedPointer<IO::KeyBufferStream>  input; // description text
+    std::string                         hash;  // description text hash
+  };
+
+  // records the species description: the input up to the next species or, for barriers and
+  // bimolecular products, which do not read them, up to the next default collision model
+  //
+  void _record_species (IO::KeyBufferStream& from, _SpeciesInput::type_t type, const std::string& name,
+			std::vector<_SpeciesInput>& species_input)
+  {
+    static const char* const species_key [] = {"Well", "Barrier", "Bimolecular"};
+    static const char* const default_key [] = {"EnergyRelaxation", "CollisionFrequency"};
+
+    _SpeciesInput res;
+
+    res.type  = type;
+    res.name  = name;
+    res.start = from.tellg();
+
+    std::string text, line, token;
+
+    while(true) {
+      //
+      const std::streampos line_start = from.tellg();
+
+      if(!std::getline(from, line))
+	//
+	break;
+
+      std::istringstream iss(line);
+
+      if(iss >> token) {
+	//
+	bool is_stop = false;
+
+	for(int i = 0; i < 3; ++i)
+	  if(token == species_key[i])
+	    is_stop = true;
+
+	if(type != _SpeciesInput::WELL)
+	  for(int i = 0; i < 2; ++i)
+	    if(token == default_key[i])
+	      is_stop = true;
+
+	if(is_stop) {
+	  //
+	  from.seekg(line_start);
+
+	  break;
+	}
+      }
+
+      text += line + "\n";
+    }
+
+    res.input.init(new IO::KeyBufferStream(text));
+
+    res.hash = _text_hash(text);
+
+    species_input.push_back(res);
+  }
+
+  // builds the recorded species concurrently; the output goes in the input order
+  //
+  void _build_species (const std::vector<_SpeciesInput>& species_input, std::vector<SharedPointer<Model::Species> >& barrier)
+  {
+    const int size = species_input.size();
+
+    std::vector<SharedPointer<Model::Well> >        well_pool(size);
+    std::vector<SharedPointer<Model::Bimolecular> > bimolecular_pool(size);
+    std::vector<SharedPointer<Model::Species> >     barrier_pool(size);
+    std::vector<SharedPointer<IO::Capture> >        output(size);
+    std::vector<std::exception_ptr>                 error(size);
+
+    for(int s = 0; s < size; ++s)
+      //
+      output[s].init(new IO::Capture);
+
+    const IO::Offset master_offset = IO::log_offset;
+
+#pragma omp parallel for default(shared) schedule(dynamic, 1)
+
+    for(int s = 0; s < size; ++s) {
+      //
+      const _SpeciesInput& spec = species_input[s];
+
+      IO::log_offset = master_offset;
+
+      output[s]->start();
+
+      try {
+	//
+	switch(spec.type) {
+	  //
+	case _SpeciesInput::WELL:
+	  //
+	  IO::log << IO::log_offset << "WELL: " << spec.name << "\n";
+
+	  well_pool[s].init(new Model::Well(*spec.input, spec.name));
+
+	  well_pool[s]->species()->set_input_hash(spec.hash);
+
+	  break;
+
+	case _SpeciesInput::BIMOLECULAR:
+	  //
+	  IO::log << IO::log_offset << "BIMOLECULAR: " << spec.name << "\n";
+
+	  bimolecular_pool[s] = Model::new_bimolecular(*spec.input, spec.name);
+
+	  break;
+
+	case _SpeciesInput::BARRIER:
+	  //
+	  IO::log << IO::log_offset << "BARRIER: " << spec.name << "\n";
+
+	  barrier_pool[s] = Model::new_species(*spec.input, spec.name, Model::NUMBER);
+
+	  barrier_pool[s]->set_input_hash(spec.hash);
+	}
+      }
+      catch(...) {
+	//
+	error[s] = std::current_exception();
+      }
+
+      output[s]->stop();
+    }
+
+    for(int s = 0; s < size; ++s) {
+      //
+      output[s]->release();
+
+      if(error[s])
+	//
+	std::rethrow_exception(error[s]);
+
+      switch(species_input[s].type) {
+	//
+      case _SpeciesInput::WELL:
+	//
+	Model::_well.push_back(*well_pool[s]);
+
+	break;
+
+      case _SpeciesInput::BIMOLECULAR:
+	//
+	Model::_bimolecular.push_back(bimolecular_pool[s]);
+
+	break;
+
+      case _SpeciesInput::BARRIER:
+	//
+	barrier.push_back(barrier_pool[s]);
+      }
+    }
+  }
+}
+
 void Model::init (IO::KeyBufferStream& from) 
 {
   const char funame [] = "Model::init: ";
@@ -403,6 +601,7 @@ void Model::init (IO::KeyBufferStream& from)
   std::vector<std::pair<std::string, std::string> > connect_verbal;
   typedef std::vector<std::pair<std::string, std::string> >::const_iterator It;
   std::vector<SharedPointer<Species> > barrier;   // barrier pool
+  std::vector<std::string>        barrier_name;
   std::set<std::string> species_name;  // all wells, barriers, and bimolecular products names
   std::map<std::string, int>        well_index;
   std::map<std::string, int> bimolecular_index;
@@ -410,214 +609,247 @@ void Model::init (IO::KeyBufferStream& from)
   std::string wout_file;
   double temp_rel_incr = 0.001;
 
+  // The input is parsed in two phases.  The species descriptions are only recorded in the
+  // first pass over the input and are built afterwards concurrently.  The model input
+  // following a species description is parsed from what the species has not read, in the
+  // input order, and the input stream is then put right after the model section end.
+  //
+  std::vector<_SpeciesInput> species_input;
 
-  while(from >> token) {
-    // end input 
-    if(IO::end_key() == token) {
-      std::getline(from, comment);
-      break;
-    }
-    // relative temperature increment
-    else if(tincr_key == token) {
-      if(!(from >> temp_rel_incr)) {
-	std::cerr << funame << token << ": corrupted\n";
-	throw Error::Input();
-      }
+  int  well_count = 0;
+  int  bimolecular_count = 0;
+  bool is_end = false;
 
-      std::getline(from, comment);
+  for(int pass = -1; pass < (int)species_input.size() && !is_end; ++pass) {// input pass cycle
+    //
+    if(!pass)
+      //
+      _build_species(species_input, barrier);
 
-      if(temp_rel_incr <= 0. || temp_rel_incr >= 1.) {
-	std::cerr << funame << token << ": out of range\n";
-	throw Error::Range();
-      }
-    }
-    // weight output
-    else if(wout_key == token) {
-      if(!(from >> wout_file)) {
-	std::cerr << funame << token << ": corrupted\n";
-	throw Error::Input();
-      }
-      std::getline(from, comment);
-    }
-    // output reference energy
-    else if(eref_key == token) {
-      if(!(from >> eref)) {
-	std::cerr << funame << token << ": corrupted\n";
-	throw Error::Input();
-      }
-      std::getline(from, comment);
+    IO::KeyBufferStream& input = pass < 0 ? from : *species_input[pass].input;
 
-      eref *= Phys_const::kcal;
-    }
-    // output temperature step
-    else if(tstep_key == token) {
-      if(!(from >> tstep)) {
-	std::cerr << funame << token << ": corrupted\n";
-	throw Error::Input();
-      }
-      std::getline(from, comment);
+    while(input >> token) {
+      // end input 
+      if(IO::end_key() == token) {
+	std::getline(input, comment);
 
-      if(tstep <= 0) {
-	std::cerr << funame << token << ": out of range\n";
-	throw Error::Range();
-      }
+	is_end = true;
+
+	if(pass >= 0) {
+	  //
+	  from.clear();
 	
-    }
-    // output temperature start
-    else if(tmin_key == token) {
-      if(!(from >> tmin)) {
-	std::cerr << funame << token << ": corrupted\n";
-	throw Error::Input();
+	  from.seekg(species_input[pass].start + std::streamoff(input.tellg()));
+	}
+	break;
       }
-      std::getline(from, comment);
+      // relative temperature increment
+      else if(tincr_key == token) {
+	if(!(input >> temp_rel_incr)) {
+	  std::cerr << funame << token << ": corrupted\n";
+	  throw Error::Input();
+	}
 
-      if(tmin <= 0) {
-	std::cerr << funame << token << ": out of range\n";
-	throw Error::Range();
+	std::getline(input, comment);
+
+	if(temp_rel_incr <= 0. || temp_rel_incr >= 1.) {
+	  std::cerr << funame << token << ": out of range\n";
+	  throw Error::Range();
+	}
       }
-	
-    }
-    // output temperature size
-    else if(tsize_key == token) {
-      if(!(from >> tsize)) {
-	std::cerr << funame << token << ": corrupted\n";
-	throw Error::Input();
+      // weight output
+      else if(wout_key == token) {
+	if(!(input >> wout_file)) {
+	  std::cerr << funame << token << ": corrupted\n";
+	  throw Error::Input();
+	}
+	std::getline(input, comment);
       }
-      std::getline(from, comment);
+      // output reference energy
+      else if(eref_key == token) {
+	if(!(input >> eref)) {
+	  std::cerr << funame << token << ": corrupted\n";
+	  throw Error::Input();
+	}
+	std::getline(input, comment);
 
-      if(tsize <= 0) {
-	std::cerr << funame << token << ": out of range\n";
-	throw Error::Range();
-      }	
-    }
-    // collision frequency model
-    else if(freq_key == token) {
-      _default_collision.push_back(new_collision(from));
-    }
-    // energy relaxation kernel
-    else if(cer_key == token) {
-      _default_kernel.push_back(new_kernel(from));
-    }
-    // buffer gas fraction
-    else if(buff_key == token) {
-      if(_buffer_fraction.size()) {
-	std::cerr << funame << token << ": already defined\n";
-	throw Error::Init();
+	eref *= Phys_const::kcal;
       }
+      // output temperature step
+      else if(tstep_key == token) {
+	if(!(input >> tstep)) {
+	  std::cerr << funame << token << ": corrupted\n";
+	  throw Error::Input();
+	}
+	std::getline(input, comment);
 
-      IO::LineInput lin(from);
-      while(lin >> dtemp) {
-	if(dtemp <= 0.) {
-	  std::cerr << funame << token << ": should be positive\n";
+	if(tstep <= 0) {
+	  std::cerr << funame << token << ": out of range\n";
 	  throw Error::Range();
 	}
-	_buffer_fraction.push_back(dtemp);
+	
       }
+      // output temperature start
+      else if(tmin_key == token) {
+	if(!(input >> tmin)) {
+	  std::cerr << funame << token << ": corrupted\n";
+	  throw Error::Input();
+	}
+	std::getline(input, comment);
 
-      if(!_buffer_fraction.size()) {
-	std::cerr << funame << token << ": corrupted\n";
-	throw Error::Init();
+	if(tmin <= 0) {
+	  std::cerr << funame << token << ": out of range\n";
+	  throw Error::Range();
+	}
+	
       }
+      // output temperature size
+      else if(tsize_key == token) {
+	if(!(input >> tsize)) {
+	  std::cerr << funame << token << ": corrupted\n";
+	  throw Error::Input();
+	}
+	std::getline(input, comment);
 
-      dtemp = 0.;
-      for(int i = 0; i < _buffer_fraction.size(); ++i)
-	dtemp += _buffer_fraction[i];
-
-      for(int i = 0; i < _buffer_fraction.size(); ++i)
-	_buffer_fraction[i] /= dtemp;
-    }
-    // energy relaxation kernel flags
-    else if(kflag_key == token) {
-      from >> stemp;
-      std::getline(from, comment);
-      if(stemp == "up")
-	Kernel::add_flag(Kernel::UP);
-      else if(stemp == "density")
-	Kernel::add_flag(Kernel::DENSITY);
-      else if(stemp == "notruncation")
-	Kernel::add_flag(Kernel::NOTRUN);
-      else {
-	std::cerr << funame << token << ": unknown key: " << stemp 
-		  << " possible keys: up, density, notruncation\n";
-	throw Error::Range();
+	if(tsize <= 0) {
+	  std::cerr << funame << token << ": out of range\n";
+	  throw Error::Range();
+	} 
       }
-    }
-    // new well
-    else if(well_key == token) {
-      if(!(from >> name)) {
-	std::cerr << funame << token << ": bad input\n";
+      // the species descriptions are recorded line by line
+      else if(pass >= 0 && (well_key == token || barr_key == token || bimol_key == token)) {
+	std::cerr << funame << token << ": should start a new line\n";
 	throw Error::Input();
       }
-      std::getline(from, comment);
-
-      if(species_name.find(name) != species_name.end()) {
-	std::cerr << funame << token << ": name " << name << " already in use\n";
-	throw Error::Logic();
-      }
-      species_name.insert(name);
-      well_index[name] = _well.size();
-      IO::log << IO::log_offset << "WELL: " << name << "\n";
-      _well.push_back(Well(from, name));
-      //_well.rbegin()->set_name(name);
-    }
-    // new bimolecular
-    else if(bimol_key == token) {
-      if(!(from >> name)) {
-	std::cerr << funame << token << ": corrupted\n";
+      // the wells have been built with the default collision models
+      else if(pass >= 0 && (freq_key == token || cer_key == token)) {
+	std::cerr << funame << token << ": default collision models should be defined before the wells\n";
 	throw Error::Input();
       }
-      std::getline(from, comment);
-
-      if(species_name.find(name) != species_name.end()) {
-	std::cerr << funame << token << ": name " << name << " already in use\n";
-	throw Error::Logic();
+      // collision frequency model
+      else if(freq_key == token) {
+	_default_collision.push_back(new_collision(input));
       }
-      species_name.insert(name);
-      bimolecular_index[name] = _bimolecular.size();
-      IO::log << IO::log_offset << "BIMOLECULAR: " << name << "\n";
-      _bimolecular.push_back(new_bimolecular(from, name));
-      //_bimolecular.back()->set_name(name);
-    }
-    // new barrier
-    else if(barr_key == token) {
-      if(!(from >> name >> species_pair.first >> species_pair.second)) {
-	std::cerr << funame << token << ": corrupted\n";
-	throw Error::Input();
+      // energy relaxation kernel
+      else if(cer_key == token) {
+	_default_kernel.push_back(new_kernel(input));
       }
-      std::getline(from, comment);
+      // buffer gas fraction
+      else if(buff_key == token) {
+	if(_buffer_fraction.size()) {
+	  std::cerr << funame << token << ": already defined\n";
+	  throw Error::Init();
+	}
 
-      if(species_name.find(name) != species_name.end()) {
-	std::cerr << funame << token << ": name " << name << " already in use\n";
-	throw Error::Logic();
+	IO::LineInput lin(input);
+	while(lin >> dtemp) {
+	  if(dtemp <= 0.) {
+	    std::cerr << funame << token << ": should be positive\n";
+	    throw Error::Range();
+	  }
+	  _buffer_fraction.push_back(dtemp);
+	}
+
+	if(!_buffer_fraction.size()) {
+	  std::cerr << funame << token << ": corrupted\n";
+	  throw Error::Init();
+	}
+
+	dtemp = 0.;
+	for(int i = 0; i < _buffer_fraction.size(); ++i)
+	  dtemp += _buffer_fraction[i];
+
+	for(int i = 0; i < _buffer_fraction.size(); ++i)
+	  _buffer_fraction[i] /= dtemp;
+      }
+      // energy relaxation kernel flags
+      else if(kflag_key == token) {
+	input >> stemp;
+	std::getline(input, comment);
+	if(stemp == "up")
+	  Kernel::add_flag(Kernel::UP);
+	else if(stemp == "density")
+	  Kernel::add_flag(Kernel::DENSITY);
+	else if(stemp == "notruncation")
+	  Kernel::add_flag(Kernel::NOTRUN);
+	else {
+	  std::cerr << funame << token << ": unknown key: " << stemp 
+		    << " possible keys: up, density, notruncation\n";
+	  throw Error::Range();
+	}
       }
-      if(species_pair.first == species_pair.second) {
-	std::cerr << funame << name << "barrier connects " 
-		  << species_pair.first <<" well with itself\n";
-	throw Error::Logic();
+      // new well
+      else if(well_key == token) {
+	if(!(input >> name)) {
+	  std::cerr << funame << token << ": bad input\n";
+	  throw Error::Input();
+	}
+	std::getline(input, comment);
+
+	if(species_name.find(name) != species_name.end()) {
+	  std::cerr << funame << token << ": name " << name << " already in use\n";
+	  throw Error::Logic();
+	}
+	species_name.insert(name);
+	well_index[name] = well_count++;
+	_record_species(input, _SpeciesInput::WELL, name, species_input);
       }
-      for(It b = connect_verbal.begin(); b != connect_verbal.end(); ++b) {
-	itemp = b - connect_verbal.begin();
-	if(b->first == species_pair.second && b->second == species_pair.first ||
-	   *b == species_pair) {
-	  std::cerr << funame << name << " and " << barrier[itemp]->name()
-		    << " barriers connect the same pair of species\n";
+      // new bimolecular
+      else if(bimol_key == token) {
+	if(!(input >> name)) {
+	  std::cerr << funame << token << ": corrupted\n";
+	  throw Error::Input();
+	}
+	std::getline(input, comment);
+
+	if(species_name.find(name) != species_name.end()) {
+	  std::cerr << funame << token << ": name " << name << " already in use\n";
 	  throw Error::Logic();
 	}
-      } 
-      species_name.insert(name);
-      connect_verbal.push_back(species_pair);
-      IO::log << IO::log_offset << "BARRIER: " << name << "\n";
-      barrier.push_back(new_species(from, name, NUMBER));
-      //barrier.back()->set_name(name);
-    }
-    // unknown keyword
-    else if(IO::skip_comment(token, from)) {
-      std::cerr << funame << "unknown keyword " << token << "\n";
-      Key::show_all(std::cerr);
-      std::cerr << "\n";
-      throw Error::Init();
+	species_name.insert(name);
+	bimolecular_index[name] = bimolecular_count++;
+	_record_species(input, _SpeciesInput::BIMOLECULAR, name, species_input);
+      }
+      // new barrier
+      else if(barr_key == token) {
+	if(!(input >> name >> species_pair.first >> species_pair.second)) {
+	  std::cerr << funame << token << ": corrupted\n";
+	  throw Error::Input();
+	}
+	std::getline(input, comment);
+
+	if(species_name.find(name) != species_name.end()) {
+	  std::cerr << funame << token << ": name " << name << " already in use\n";
+	  throw Error::Logic();
+	}
+	if(species_pair.first == species_pair.second) {
+	  std::cerr << funame << name << "barrier connects " 
+		    << species_pair.first <<" well with itself\n";
+	  throw Error::Logic();
+	}
+	for(It b = connect_verbal.begin(); b != connect_verbal.end(); ++b) {
+	  itemp = b - connect_verbal.begin();
+	  if(b->first == species_pair.second && b->second == species_pair.first ||
+	     *b == species_pair) {
+	    std::cerr << funame << name << " and " << barrier_name[itemp]
+		      << " barriers connect the same pair of species\n";
+	    throw Error::Logic();
+	  }
+	} 
+	species_name.insert(name);
+	connect_verbal.push_back(species_pair);
+	barrier_name.push_back(name);
+	_record_species(input, _SpeciesInput::BARRIER, name, species_input);
+      }
+      // unknown keyword
+      else if(IO::skip_comment(token, input)) {
+	std::cerr << funame << "unknown keyword " << token << "\n";
+	Key::show_all(std::cerr);
+	std::cerr << "\n";
+	throw Error::Init();
+      }
     }
-  }
+  }// input pass cycle
   
   /************************************* CHECKING *********************************************/
 
@@ -2247,21 +2479,7 @@ void Model::Tunnel::convolute(Array<double>& stat, double step) const
 
   td /= fac;
 
-  Array<double> new_stat(stat.size());
-  
-#pragma omp parallel for default(shared) private(dtemp) schedule(dynamic, 1)
-
-  for(int j = 0; j < stat.size(); ++j) {
-    dtemp = 0.;
-    for(int i = 0; i < td.size(); ++i) {
-      if(i > j)
-	break;
-      dtemp += stat[j - i] * td[i];
-    }
-    new_stat[j] = dtemp;
-  }
-  
-  stat = new_stat;
+  Convolution::dense(stat, td);
 }
 
 // statistical weight relative to cutoff energy
@@ -3349,9 +3567,11 @@ void Model::Rotor::convolute(Array<double>& stat_grid, double ener_quant) const
   int    itemp;
   double dtemp;
 
-  Array<double> new_stat_grid = stat_grid;
+  // ground level
+  //
+  std::map<int, double> shift;
 
-  std::map<int, int> shift;
+  shift[0] = 1.;
   
   for(int n = 1; n < level_size(); ++n) {
     //
@@ -3369,7 +3589,7 @@ void Model::Rotor::convolute(Array<double>& stat_grid, double ener_quant) const
       //
       itemp = (int)dtemp;
       
-      shift[itemp]++;
+      shift[itemp] += 1.;
     }
     else {
       //
@@ -3379,17 +3599,7 @@ void Model::Rotor::convolute(Array<double>& stat_grid, double ener_quant) const
     }
   }
 
-#pragma omp parallel for default(shared) schedule(static, 10)
-
-  for(int i = 0; i < stat_grid.size(); ++i)
-    //
-    for(std::map<int, int>::const_iterator it = shift.begin(); it != shift.end(); ++it)
-      //
-      if(i >= it->first)
-	//
-	new_stat_grid[i] += (double)it->second * stat_grid[i - it->first];
-
-  stat_grid = new_stat_grid; 
+  Convolution::sparse(stat_grid, shift);
 }
 
 /********************************************************************************************
@@ -5030,6 +5240,66 @@ Model::Core::~Core ()
   //std::cout << "Model::Core destroyed\n";
 }
 
+void Model::Core::states_on_grid (double ener_ref, double step, int n, double* res) const
+{
+  for(int i = 0; i < n; ++i)
+    //
+    res[i] = states(ener_ref - (double)i * step);
+}
+
+// states on the grid from the spline interpolation with the power extrapolation beyond it;
+// the relative energy ener_ref - i * step decreases with the grid index
+//
+void Model::spline_states_on_grid (const Math::Spline& spline, double nmax, double ener_ref, double step, int n, double* res,
+				   const char* funame)
+{
+  int i;
+
+  // extrapolation
+  //
+  for(i = 0; i < n; ++i) {
+    //
+    const double ener = ener_ref - (double)i * step;
+
+    if(ener < spline.arg_max())
+      //
+      break;
+
+    res[i] = spline.fun_max() * std::pow(ener / spline.arg_max(), nmax);
+  }
+
+  if(i && ener_ref >= spline.arg_max() * 2.)
+    //
+    IO::log << IO::log_offset << funame << "WARNING: energy far beyond interpolation range\n";
+
+  // interpolation
+  //
+  const int imin = i;
+
+  std::vector<double> ener;
+
+  for(; i < n; ++i) {
+    //
+    const double dtemp = ener_ref - (double)i * step;
+
+    if(dtemp <= 0.)
+      //
+      break;
+
+    ener.push_back(dtemp);
+  }
+
+  if(ener.size())
+    //
+    spline.evaluate(&ener[0], ener.size(), res + imin);
+
+  // below the ground
+  //
+  for(; i < n; ++i)
+    //
+    res[i] = 0.;
+}
+
 /********************************************************************************************
  *************************** PHASE SPACE THEORY NUMBER OF STATES ****************************
  ********************************************************************************************/
@@ -6265,6 +6535,25 @@ double Model::RigidRotor::states (double ener) const
   return _states(ener);
 }
 
+void Model::RigidRotor::states_on_grid (double ener_ref, double step, int n, double* res) const
+{
+  const char funame [] = "Model::RigidRotor::states_on_grid: ";
+
+  if(mode() == NOSTATES) {
+    std::cerr << funame << "wrong case\n";
+    throw Error::Logic();
+  }
+
+  if(!_frequency.size()) {
+    //
+    Core::states_on_grid(ener_ref, step, n, res);
+
+    return;
+  }
+
+  spline_states_on_grid(_states, _nmax, ener_ref - ground(), step, n, res, funame);
+}
+
 double Model::RigidRotor::_core_states (double ener) const
 {
   const char funame [] = "Model::RigidRotor::states: ";
@@ -10082,9 +10371,9 @@ Model::MultiRotor::MultiRotor(IO::KeyBufferStream& from, const std::vector<Atom>
 
   /************************************* INTERPOLATION ********************************************/
 
-  Slatec::Spline one_qstates; // one-dimensional rotors model quantum   density/number of states
+  Math::Spline one_qstates; // one-dimensional rotors model quantum   density/number of states
 
-  Slatec::Spline one_cstates; // one_dimensional rotors model classical density/number of states
+  Math::Spline one_cstates; // one_dimensional rotors model classical density/number of states
  
   // quantum correction factor
   //
@@ -10111,8 +10400,6 @@ Model::MultiRotor::MultiRotor(IO::KeyBufferStream& from, const std::vector<Atom>
     
     /************************* CLASSICAL DENSITY/NUMBER OF STATES *****************************/
 
-    typedef std::map<int, double>::const_iterator pit_t;
-
     itemp = (int)std::ceil(_extra_ener / _ener_quant);
 
     Array<double> ener_grid(itemp);
@@ -10151,9 +10438,7 @@ Model::MultiRotor::MultiRotor(IO::KeyBufferStream& from, const std::vector<Atom>
 	  //
 	  itemp = (int)round(_vib_grid[g][v] / _ener_quant);
 
-	  for(int i = itemp; i < ener_grid.size(); ++i)
-	    //
-	    stat_freq[i] += stat_freq[i - itemp];
+	  Convolution::harmonic(stat_freq, itemp);
 	}
 	
 	// potential energy shift and mass factor
@@ -10195,24 +10480,9 @@ Model::MultiRotor::MultiRotor(IO::KeyBufferStream& from, const std::vector<Atom>
 	shift_factor[itemp] += dtemp;
       }
 
-#pragma omp parallel for default(shared) private(itemp, dtemp)  schedule(static)
-
-      for(int i = 0; i < ener_grid.size(); ++i) {
-	//
-	dtemp = 0.;
-    
-	for(pit_t pit = shift_factor.begin(); pit != shift_factor.end(); ++pit) {
-	  //
-	  itemp = i - pit->first;
-
-	  if(itemp >= 0)
-	    //
-	    dtemp  += stat_base[itemp] * pit->second;
-	}
+      stat_grid = stat_base;
 
-	stat_grid[i] = dtemp;
-      }//
-      //
+      Convolution::sparse(stat_grid, shift_factor);
     }// no vibrations
     
     // angular integration done
@@ -10293,9 +10563,7 @@ Model::MultiRotor::MultiRotor(IO::KeyBufferStream& from, const std::vector<Atom>
       //
       itemp = (int)round(_vib_four[v][0] / _ener_quant);
 
-      for(int i = itemp; i < ener_grid.size(); ++i)
-	//
-	stat_grid[i] += stat_grid[i - itemp];
+      Convolution::harmonic(stat_grid, itemp);
     }
 
     // effective one-dimensional rotors quantum density/number of states interpolation
@@ -10334,9 +10602,7 @@ Model::MultiRotor::MultiRotor(IO::KeyBufferStream& from, const std::vector<Atom>
       //
       itemp = (int)round(_vib_four[v][0] / _ener_quant);
 
-      for(int i = itemp; i < ener_grid.size(); ++i)
-	//
-	stat_grid[i] += stat_grid[i - itemp];
+      Convolution::harmonic(stat_grid, itemp);
     }
 
     // one-dimensional rotors classical density/number of states interpolation
@@ -11308,9 +11574,7 @@ void Model::MultiRotor::_set_qfactor ()
     //
     itemp = (int)round(_vib_four[v][0] / _ener_quant);
 
-    for(int i = itemp; i < qstat_grid.size(); ++i)
-      //
-      qstat_grid[i] += qstat_grid[i - itemp];
+    Convolution::harmonic(qstat_grid, itemp);
   }
 
   /*************** CLASSICAL DENSITY/NUMBER OF STATES *******************/
@@ -11334,25 +11598,9 @@ void Model::MultiRotor::_set_qfactor ()
     shift_factor[itemp] += dtemp;
   }
 
-  Array<double> stat_grid(stat_base.size());
-
-#pragma omp parallel for default(shared) private(itemp, dtemp)  schedule(static)
-
-  for(int i = 0; i < stat_grid.size(); ++i) {
-    //
-    dtemp = 0.;
-
-    for(pit_t pit = shift_factor.begin(); pit != shift_factor.end(); ++pit) {
-      //
-      itemp = i - pit->first;
-
-      if(itemp >= 0)
-	//
-	dtemp  += stat_base[itemp] * pit->second;
-    }
+  Array<double> stat_grid = stat_base;
 
-    stat_grid[i] = dtemp;
-  }
+  Convolution::sparse(stat_grid, shift_factor);
 
   // convolution with average vibrational frequencies
   //
@@ -11360,9 +11608,7 @@ void Model::MultiRotor::_set_qfactor ()
     //
     itemp = (int)round(_vib_four[v][0] / _ener_quant);
 
-    for(int i = itemp; i < stat_grid.size(); ++i)
-      //
-      stat_grid[i] += stat_grid[i - itemp];
+    Convolution::harmonic(stat_grid, itemp);
   }
 
   // energy grid
@@ -11377,7 +11623,7 @@ void Model::MultiRotor::_set_qfactor ()
 
   // classical density/number of states interpolation
   //
-  Slatec::Spline eff_cstates(ener_grid, stat_grid, ener_grid.size());
+  Math::Spline eff_cstates(ener_grid, stat_grid, ener_grid.size());
 
   /**************** QUANTUM CORRECTION FACTOR  ***************/
 
@@ -13011,6 +13257,22 @@ double Model::Species::mass () const
 
 double Model::Species::tunnel_weight (double) const { return 1.; }
 
+void Model::Species::states_on_grid (double ener_ref, double step, int n, double* res) const
+{
+  for(int i = 0; i < n; ++i)
+    //
+    res[i] = states(ener_ref - (double)i * step);
+}
+
+void Model::Species::weights (const std::vector<double>& temperature, std::vector<double>& res) const
+{
+  res.resize(temperature.size());
+
+  for(int t = 0; t < temperature.size(); ++t)
+    //
+    res[t] = weight(temperature[t]);
+}
+
 // radiational transitions
 double Model::Species::oscillator_frequency (int) const
 {
@@ -13275,6 +13537,61 @@ double Model::ReadSpecies::states (double en) const
   return std::exp(_spline(std::log(en)));
 }
 
+void Model::ReadSpecies::states_on_grid (double ener_ref, double step, int n, double* res) const
+{
+  int i;
+
+  ener_ref -= _ground;
+
+  // extrapolation
+  //
+  for(i = 0; i < n; ++i) {
+    //
+    const double ener = ener_ref - (double)i * step;
+
+    if(ener < _emax)
+      //
+      break;
+
+    res[i] = _amax * std::pow(ener, _nmax);
+  }
+
+  // interpolation in logarithmic coordinates
+  //
+  const int imin = i;
+
+  std::vector<double> lener;
+
+  for(; i < n; ++i) {
+    //
+    const double ener = ener_ref - (double)i * step;
+
+    if(ener <= _emin)
+      //
+      break;
+
+    lener.push_back(std::log(ener));
+  }
+
+  if(lener.size()) {
+    //
+    _spline.evaluate(&lener[0], lener.size(), res + imin);
+
+    for(int j = imin; j < i; ++j)
+      //
+      res[j] = std::exp(res[j]);
+  }
+
+  // low energy extrapolation
+  //
+  for(; i < n; ++i) {
+    //
+    const double ener = ener_ref - (double)i * step;
+
+    res[i] = ener > 0. ? _amin * std::pow(ener, _nmin) : 0.;
+  }
+}
+
 double Model::ReadSpecies::weight (double temperature) const
 {
   const char funame [] = "Model::ReadSpecies::weight: ";
@@ -13947,7 +14264,7 @@ Model::MonteCarlo::~MonteCarlo() {}
 
 Model::MonteCarlo::MonteCarlo(IO::KeyBufferStream& from, const std::string& n, int m)
   : Species(from, n, m), _symm_fac(1.), _noqf(false), _nohess(false), _nocurv(false),
-    _cmshift(false), _ists(false), _ref_tem(-1.)
+    _cmshift(false), _ists(false), _ref_tem(-1.), _sample_data(0), _sample_size(0)
 {
   const char funame [] = "Model::MonteCarlo::MonteCarlo: ";
 
@@ -14496,6 +14813,8 @@ Model::MonteCarlo::MonteCarlo(IO::KeyBufferStream& from, const std::string& n, i
     throw Error::Init();
   }
 
+  _init_samples();
+
   if(!isrefen && isground) {
     //
     IO::log << IO::log_offset << "WARNING: the reference energy set to the ground state energy: " << _ground  / Phys_const::kcal << " kcal/mol\n";
@@ -14544,68 +14863,138 @@ double Model::MonteCarlo::states (double ener) const
 }
 
 double Model::MonteCarlo::weight_with_error (double temperature, double& werr) const
+{
+  std::vector<double> weight, error;
+
+  weight_with_error(std::vector<double>(1, temperature), weight, error);
+
+  werr = error[0];
+
+  return weight[0];
+}
+
+int Model::MonteCarlo::sample_chunk_size = 1024;
+
+void Model::MonteCarlo::weight_with_error (const std::vector<double>& temperature,
+					   std::vector<double>&       weight,
+					   std::vector<double>&       werr) const
 {
   const char funame [] = "Model::MonteCarlo::weight_with_error: ";
 
-  int    itemp;
-  
   double dtemp;
 
   IO::Marker funame_marker(funame);
+
+  const int tsize = temperature.size();
   
-  std::ifstream from(_data_file.c_str());
+  weight.resize(tsize);
 
-  if(!from) {
-    //
-    std::cerr << funame << "cannot open data file " << _data_file << "\n";
+  werr.resize(tsize);
 
-    throw Error::File();
-  }
+  if(!tsize)
+    //
+    return;
+  
+  std::vector<double> res(tsize, 0.), variance(tsize, 0.);
 
-  std::string comment;
+  const int cart_size = atom_size() * 3;
 
-  std::getline(from, comment);
+  const int chunk_size = sample_chunk_size > 0 ? sample_chunk_size : 1;
   
-  double res = 0.;
+  // sampling contributions, failures, output, and exceptions for the current chunk
+  //
+  std::vector<double>                      chunk_weight(chunk_size * tsize);
 
-  double variance = 0.;
+  std::vector<int>                         chunk_fail(chunk_size);
 
-  double ener;
+  std::vector<SharedPointer<IO::Capture> > chunk_output(chunk_size);
 
-  // cartesian coordinates
-  //
-  Lapack::Vector          cart_pos(atom_size() * 3);
+  std::vector<std::exception_ptr>          chunk_error(chunk_size);
 
-  // cartesian gradient
-  //
-  Lapack::Vector          cart_grad(atom_size() * 3);
+  for(int i = 0; i < chunk_size; ++i)
+    //
+    chunk_output[i].init(new IO::Capture);
 
-  // cartesian force constant matrix
-  //
-  Lapack::SymmetricMatrix cart_fc(atom_size() * 3);
+  const IO::Offset master_offset = IO::log_offset;
 
-  int count = 0, samp = 0;
+  int count = 0;
   
-  while(_read(from, ener, cart_pos, cart_grad, cart_fc)) {
+  for(int start = 0; start < _sample_size; start += chunk_size) {
     //
-    ++samp;
-    
-    IO::log << IO::log_offset << "Sampling " << samp << "\n";
-    
-    dtemp = _local_weight(ener, cart_pos, cart_grad, cart_fc, temperature);
+    const int end = start + chunk_size < _sample_size ? start + chunk_size : _sample_size;
 
-    if(dtemp < 0.) {
+#pragma omp parallel for default(shared) schedule(dynamic, 1)
+
+    for(int s = start; s < end; ++s) {
       //
-      std::cerr << funame << samp << "-th sampling failed\n";
+      const int i = s - start;
 
-      continue;
+      IO::log_offset = master_offset;
+
+      chunk_output[i]->start();
+
+      try {
+	//
+	IO::log << IO::log_offset << "Sampling " << s + 1 << "\n";
+    
+	double ener;
+
+	Lapack::Vector          cart_pos(cart_size);
+
+	Lapack::Vector          cart_grad(cart_size);
+
+	Lapack::SymmetricMatrix cart_fc(cart_size);
+
+	_sample(s, ener, cart_pos, cart_grad, cart_fc);
+
+	_LocalData data;
+
+	chunk_fail[i] = !_local_data(ener, cart_pos, cart_grad, cart_fc, data);
+
+	if(!chunk_fail[i])
+	  //
+	  for(int t = 0; t < tsize; ++t)
+	    //
+	    chunk_weight[i * tsize + t] = _local_weight(data, temperature[t]);
+      }
+      catch(...) {
+	//
+	chunk_error[i] = std::current_exception();
+      }
+
+      chunk_output[i]->stop();
     }
+
+    // output and accumulation in the serial order
+    //
+    for(int s = start; s < end; ++s) {
+      //
+      const int i = s - start;
+
+      chunk_output[i]->release();
+
+      if(chunk_error[i])
+	//
+	std::rethrow_exception(chunk_error[i]);
+      
+      if(chunk_fail[i]) {
+	//
+	std::cerr << funame << s + 1 << "-th sampling failed\n";
+
+	continue;
+      }
     
-    ++count;
+      ++count;
     
-    res += dtemp;
+      for(int t = 0; t < tsize; ++t) {
+	//
+	dtemp = chunk_weight[i * tsize + t];
+	
+	res[t] += dtemp;
 
-    variance += dtemp * dtemp;
+	variance[t] += dtemp * dtemp;
+      }
+    }
   }
 
   if(!count) {
@@ -14614,22 +15003,50 @@ double Model::MonteCarlo::weight_with_error (double temperature, double& werr) c
 
     throw Error::Input();
   }
+
+  IO::log << IO::log_offset
+	  << std::setw(7)  << "T, K"
+	  << std::setw(13) << "Z"
+	  << std::setw(13) << "Error, %"
+	  << "\n";
   
-  // normalize
-  //
-  res /= (double)count;
+  for(int t = 0; t < tsize; ++t) {
+    //
+    // normalize
+    //
+    res[t] /= (double)count;
 
-  variance /= (double)count * res * res;
+    variance[t] /= (double)count * res[t] * res[t];
 
-  variance -= 1.;
+    variance[t] -= 1.;
 
-  variance /= (double)count;
+    variance[t] /= (double)count;
 
-  if(variance < 0.)
-    //
-    variance = 0.;
+    if(variance[t] < 0.)
+      //
+      variance[t] = 0.;
+
+    werr[t] = std::sqrt(variance[t]) * 100.;
+
+    weight[t] = res[t] * _weight_factor(temperature[t]);
+
+    IO::log << IO::log_offset
+	    << std::setw(7)  << temperature[t] / Phys_const::kelv
+	    << std::setw(13) << weight[t]
+	    << std::setw(13) << werr[t]
+	    << "\n";
+  }
+}
 
-  werr = std::sqrt(variance) * 100.;
+// sampling-independent factor of the statistical weight
+//
+double Model::MonteCarlo::_weight_factor (double temperature) const
+{
+  int    itemp;
+  
+  double dtemp;
+
+  double res = 1.;
   
   // span factor
   //
@@ -14682,21 +15099,254 @@ double Model::MonteCarlo::weight_with_error (double temperature, double& werr) c
     for(int f = 0; f < _nm_freq.size(); ++f)
       //
       res /= _nm_freq[f];
+
+  return res;
+}
+
+/***********************************************************************************************************
+ ****************************************** BINARY SAMPLE STORE ********************************************
+ ***********************************************************************************************************/
+
+int Model::MonteCarlo::_record_size () const
+{
+  const int cart_size = atom_size() * 3;
+
+  if(_nohess)
+    //
+    return 1 + cart_size;
+
+  return 1 + 2 * cart_size + cart_size * (cart_size + 1) / 2;
+}
+
+void Model::MonteCarlo::_sample (int                     s,
+				 double&                 ener,
+				 Lapack::Vector          cart_pos,
+				 Lapack::Vector          cart_grad,
+				 Lapack::SymmetricMatrix cart_fc
+				 ) const
+{
+  const char funame [] = "Model::MonteCarlo::_sample: ";
+
+  if(s < 0 || s >= _sample_size) {
+    //
+    std::cerr << funame << "sampling index out of range: " << s << "\n";
+
+    throw Error::Range();
+  }
+
+  const int cart_size = atom_size() * 3;
+
+  const double* p = _sample_data + (size_t)s * _record_size();
+
+  ener = *p++;
+
+  std::memcpy((double*)cart_pos, p, cart_size * sizeof(double));
+
+  if(_nohess)
+    //
+    return;
+  
+  p += cart_size;
   
+  std::memcpy((double*)cart_grad, p, cart_size * sizeof(double));
 
-  IO::log << IO::log_offset
-	  << std::setw(7)  << "T, K"
-	  << std::setw(13) << "Z"
-	  << std::setw(13) << "Error, %"
-	  << "\n"
-	  << std::setw(7)  << temperature / Phys_const::kelv
-	  << std::setw(13) << res
-	  << std::setw(13) << werr
-	  << "\n";
+  p += cart_size;
+
+  std::memcpy((double*)cart_fc, p, cart_size * (cart_size + 1) / 2 * sizeof(double));
+}
+
+void Model::MonteCarlo::_init_samples ()
+{
+  const char funame [] = "Model::MonteCarlo::_init_samples: ";
+
+  IO::Marker funame_marker(funame);
   
-  return res;
+  // binary cache header; the data file is identified by its size and contents hash
+  //
+  enum {MAGIC, VERSION, ATOM_SIZE, NOHESS, RECORD_SIZE, DATA_SIZE, DATA_HASH, SAMPLE_SIZE, HEADER_SIZE};
+
+  static const long long magic = 0x4d455353434d4301LL;
+
+  struct stat data_stat;
+
+  if(stat(_data_file.c_str(), &data_stat)) {
+    //
+    std::cerr << funame << "cannot access data file " << _data_file << "\n";
+
+    throw Error::File();
+  }
+
+  // data file contents hash
+  //
+  unsigned long long data_hash = _fnv_hash(0, 0);
+
+  {
+    std::ifstream from(_data_file.c_str(), std::ios::binary);
+
+    std::vector<char> buf(1 << 20);
+
+    while(from.read(&buf[0], buf.size()) || from.gcount())
+      //
+      data_hash = _fnv_hash(&buf[0], from.gcount(), data_hash);
+  }
+
+  std::vector<long long> header(HEADER_SIZE);
+
+  header[MAGIC]       = magic;
+  header[VERSION]     = 2;
+  header[ATOM_SIZE]   = atom_size();
+  header[NOHESS]      = _nohess;
+  header[RECORD_SIZE] = _record_size();
+  header[DATA_SIZE]   = data_stat.st_size;
+  header[DATA_HASH]   = (long long)data_hash;
+
+  const size_t header_bytes = HEADER_SIZE * sizeof(long long);
+  
+  const std::string cache_file = _data_file + ".bin";
+
+  // existing cache
+  //
+  std::ifstream cache_in(cache_file.c_str(), std::ios::binary);
+
+  if(cache_in) {
+    //
+    std::vector<long long> cache_header(HEADER_SIZE);
+
+    cache_in.read((char*)&cache_header[0], header_bytes);
+
+    bool is_valid = (bool)cache_in;
+
+    for(int i = 0; is_valid && i < SAMPLE_SIZE; ++i)
+      //
+      if(cache_header[i] != header[i])
+	//
+	is_valid = false;
+
+    if(is_valid && cache_header[SAMPLE_SIZE] > 0) {
+      //
+      _sample_map.init(new System::MappedFile(cache_file));
+
+      _sample_size = cache_header[SAMPLE_SIZE];
+
+      if(_sample_map->size() == header_bytes + (size_t)_sample_size * _record_size() * sizeof(double)) {
+	//
+	_sample_data = (const double*)((const char*)_sample_map->data() + header_bytes);
+
+	IO::log << IO::log_offset << _sample_size << " samplings mapped from " << cache_file << "\n";
+
+	return;
+      }
+
+      _sample_map.init(0);
+
+      _sample_size = 0;
+    }
+  }
+
+  cache_in.close();
+
+  // parse the data file
+  //
+  std::ifstream from(_data_file.c_str());
+
+  if(!from) {
+    //
+    std::cerr << funame << "cannot open data file " << _data_file << "\n";
+
+    throw Error::File();
+  }
+
+  std::string comment;
+
+  std::getline(from, comment);
+
+  const int cart_size = atom_size() * 3;
+  
+  double ener;
+
+  Lapack::Vector          cart_pos(cart_size);
+
+  Lapack::Vector          cart_grad(cart_size);
+
+  Lapack::SymmetricMatrix cart_fc(cart_size);
+
+  _sample_buffer.clear();
+  
+  while(_read(from, ener, cart_pos, cart_grad, cart_fc)) {
+    //
+    _sample_buffer.push_back(ener);
+
+    _sample_buffer.insert(_sample_buffer.end(), cart_pos.begin(), cart_pos.end());
+
+    if(_nohess)
+      //
+      continue;
+
+    _sample_buffer.insert(_sample_buffer.end(), cart_grad.begin(), cart_grad.end());
+
+    const double* fc = cart_fc;
+      
+    _sample_buffer.insert(_sample_buffer.end(), fc, fc + cart_size * (cart_size + 1) / 2);
+  }
+
+  _sample_size = _sample_buffer.size() / _record_size();
+
+  if(!_sample_size) {
+    //
+    std::cerr << funame << "no samplings in " << _data_file << "\n";
+
+    throw Error::Input();
+  }
+
+  _sample_data = &_sample_buffer[0];
+  
+  IO::log << IO::log_offset << _sample_size << " samplings read from " << _data_file << "\n";
+
+  // write the cache to the uniquely named temporary file first: other processes and the species
+  // built concurrently may read the same data
+  //
+  header[SAMPLE_SIZE] = _sample_size;
+
+  std::string tmp_file = cache_file + ".XXXXXX";
+
+  const int fd = mkstemp(&tmp_file[0]);
+
+  if(fd < 0) {
+    //
+    IO::log << IO::log_offset << "WARNING: cannot create temporary file for " << cache_file << ", samplings are kept in memory\n";
+
+    return;
+  }
+
+  fchmod(fd, 0644);
+
+  close(fd);
+
+  std::ofstream to(tmp_file.c_str(), std::ios::binary);
+
+  to.write((const char*)&header[0], header_bytes);
+
+  to.write((const char*)_sample_data, _sample_buffer.size() * sizeof(double));
+
+  to.close();
+
+  if(!to || std::rename(tmp_file.c_str(), cache_file.c_str())) {
+    //
+    std::remove(tmp_file.c_str());
+
+    IO::log << IO::log_offset << "WARNING: cannot write binary cache " << cache_file << ", samplings are kept in memory\n";
+
+    return;
+  }
+
+  _sample_map.init(new System::MappedFile(cache_file));
+
+  _sample_data = (const double*)((const char*)_sample_map->data() + header_bytes);
+
+  std::vector<double>().swap(_sample_buffer);
 }
 
+
 // read data from file
 //
 bool Model::MonteCarlo::_read (std::istream&           from,       // data stream
@@ -14877,52 +15527,41 @@ void Model::MonteCarlo::_set_reference_energy ()
 {
   const char funame [] = "Model::MonteCarlo::_set_reference_energy: ";
 
-  int    itemp;
-  
   double dtemp;
 
-  if(!_data_file.size()) {
+  if(!_sample_size) {
     //
-    std::cerr << funame << "no data file\n";
+    std::cerr << funame << "no samplings\n";
 
     throw Error::Init();
   }
   
-  std::ifstream from(_data_file.c_str());
-
-  if(!from) {
-    //
-    std::cerr << funame << "cannot open data file " << _data_file << "\n";
-
-    throw Error::File();
-  }
-
-  std::string comment;
-
-  std::getline(from, comment);
-  
-  double res = 0.;
-
-  double ener;
-
   const int cart_size = atom_size() * 3;
   
-  // cartesian coordinates
+  // sampling energies with zero-point energy correction
   //
-  Lapack::Vector          cart_pos(cart_size);
+  std::vector<double> sample_ener(_sample_size);
+  
+#pragma omp parallel for default(shared) private(dtemp) schedule(dynamic, 16)
 
-  // cartesian gradient
-  //
-  Lapack::Vector          cart_grad(cart_size);
+  for(int s = 0; s < _sample_size; ++s) {
+    //
+    double ener;
+    
+    // cartesian coordinates
+    //
+    Lapack::Vector          cart_pos(cart_size);
 
-  // cartesian force constant matrix
-  //
-  Lapack::SymmetricMatrix cart_fc(cart_size);
+    // cartesian gradient
+    //
+    Lapack::Vector          cart_grad(cart_size);
 
-  int count = 0;
-  
-  while(_read(from, ener, cart_pos, cart_grad, cart_fc)) {
+    // cartesian force constant matrix
     //
+    Lapack::SymmetricMatrix cart_fc(cart_size);
+
+    _sample(s, ener, cart_pos, cart_grad, cart_fc);
+
     if(!_noqf && !_nohess) {
       //
       for(int c = 0; c < cart_size; ++c)
@@ -14947,11 +15586,11 @@ void Model::MonteCarlo::_set_reference_energy ()
       ener += dtemp / 2.;
     }
 
-    if(!count++ || ener < _refen)
-      //
-      _refen = ener;
+    sample_ener[s] = ener;
   }
 
+  _refen = *std::min_element(sample_ener.begin(), sample_ener.end());
+
   // non-fluxional modes zero-point energy correction
   //
   if(_nohess && !_noqf)
@@ -14965,6 +15604,7 @@ void Model::MonteCarlo::_set_reference_energy ()
   _refen = std::floor(_refen * 10. / Phys_const::kcal) / 10. * Phys_const::kcal;
 }
 
+
 // non-fluxional mode minimal frequency in 1/cm
 //
 double Model::MonteCarlo::nm_freq_min = 10.;
@@ -15032,25 +15672,17 @@ void Model::MonteCarlo::_make_cm_shift (Lapack::Vector pos) const
       pos[a * 3 + i] -= shift;
   }
 }
-// local weight contribution for the well
+// temperature-independent part of the local weight contribution
 //
-double Model::MonteCarlo::_local_weight (double                  ener,       // energy of the sampling 
-					 Lapack::Vector          cart_pos,   // cartesian coordinates    
-					 Lapack::Vector          cart_grad,  // energy gradient in cartesian coordinates
-					 Lapack::SymmetricMatrix cart_fc,    // cartesian force constant matrix
-					 double                  temperature // temprature
-					 ) const
+bool Model::MonteCarlo::_local_data (double                  ener,       // energy of the sampling 
+				     Lapack::Vector          cart_pos,   // cartesian coordinates    
+				     Lapack::Vector          cart_grad,  // energy gradient in cartesian coordinates
+				     Lapack::SymmetricMatrix cart_fc,    // cartesian force constant matrix
+				     _LocalData&             data        // temperature-independent data
+				     ) const
 {
-  const char funame [] = "Model::MonteCarlo::_local_weight: ";
-
-  // high frequency threshold x = freq / 2 / T.
-  //
-  static const double high_freq_thres = 5.;
+  const char funame [] = "Model::MonteCarlo::_local_data: ";
 
-  // maximal exponent argument
-  //
-  static const double exp_arg_max = 50.;
-  
   /*****************************************************************************
    **************************** CALCULATION BEGINS *****************************
    *****************************************************************************/
@@ -15234,85 +15866,21 @@ double Model::MonteCarlo::_local_weight (double                  ener,       //
     
   Lapack::Vector eval;
   
-  bool deep_tunnel = false;
-  
-  // quantum correction factor
+  // frequencies for the quantum correction factor
   //
   if(!_noqf && !_nohess) {
     //
     eval = fc.eigenvalues(&evec);
 
-    for(int f = 0; f < in_size; ++f) {
+    if(_ists && eval[0] >= 0.) {
       //
-      if(_ists && !f && eval[f] >= 0.) {
-	//
-	std::cerr << funame << "not a saddle point: lowest frequency = " << std::sqrt(eval[0]) / Phys_const::incm << " 1/cm\n";
-
-	throw Error::Range();
-      }
-      
-      if(eval[f] < 0.) {
-	//
-	dtemp = std::sqrt(-eval[f]) / temperature / 2.;
-
-	if(dtemp < 0.9 * M_PI) {
-	  //
-	  wfac *= dtemp / std::sin(dtemp);
-	}
-	else if(!deep_tunnel) {
-	  //
-	  deep_tunnel = true;
-	
-	  std::cerr << funame << "WARNING: the system is in the deep tunneling regime, check the log file\n";
+      std::cerr << funame << "not a saddle point: lowest frequency = " << std::sqrt(eval[0]) / Phys_const::incm << " 1/cm\n";
 
-	  IO::log << IO::log_offset << "WARNING: the system is in the deep tunneling regime" << std::endl;
-	}
-      }
-      else if(eval[f] > 0.) {
-	//
-	dtemp = std::sqrt(eval[f]) / temperature / 2.;
-      
-	if(dtemp > high_freq_thres) {
-	  //
-	  ener += dtemp * temperature;
-	
-	  wfac *= 2. * dtemp;
-	}
-	else
-	  //
-	  wfac *= dtemp / std::sinh(dtemp);
-      }
+      throw Error::Range();
     }
 
-    // deep tunneling regime output
-    //
-    if(deep_tunnel) {
-      //
-      IO::log << IO::log_offset << "Deep tunneling regime:\n";
-      
-      IO::log << IO::log_offset << "Energy (including zero-point energy correction) = "
-	      << (ener - _refen) / Phys_const::kcal << " kcal/mol" << std::endl;
-
-      IO::log << IO::log_offset << "Frequencies, 1/cm:";
-
-      for(int f = 0; f < in_size; ++f) {
-	//
-	IO::log << "   ";
-    
-	if(eval[f] < 0.) {
-	  //
-	  IO::log << -std::sqrt(-eval[f]) / Phys_const::incm;
-	}
-	else
-	  //
-	  IO::log << std::sqrt(eval[f]) / Phys_const::incm;
-      }
-
-      IO::log << std::endl;
-      //
-    }// deep tunneling
-
-  }// quantum correction factor
+    data.eval = eval;
+  }
   
   // transition state calculation
   //
@@ -15554,7 +16122,7 @@ double Model::MonteCarlo::_local_weight (double                  ener,       //
 	//
 	std::cerr << funame << "non-fluxional mode frequency is too low: " << dtemp  << " 1/cm \n";
 
-	return -1.;
+	return false;
       }
   
       // classical weight factor for non-fluxional modes
@@ -15565,11 +16133,81 @@ double Model::MonteCarlo::_local_weight (double                  ener,       //
       }
     }
 
-    if(_nohess && !_noqf) {
+  }// stable species
+  
+  data.ener = ener;
+
+  data.wfac = wfac;
+  
+  // reference potential correction
+  //
+  data.ref_pow = 0.;
+  
+  if(_ref_pot) {
+    //
+    Lapack::Vector flux_pos(_fluxional.size());
+
+    for(int f = 0; f < _fluxional.size(); ++f)
       //
-      for(int f = 0; f < _nm_freq.size(); ++f) {
+      flux_pos[f] = _fluxional[f].evaluate(cart_pos);
+  
+    data.ref_pow = _ref_pot(flux_pos) / _ref_tem;
+  }
+
+  return true;
+}
+
+
+// local weight contribution for the well
+//
+double Model::MonteCarlo::_local_weight (const _LocalData& data, double temperature) const
+{
+  const char funame [] = "Model::MonteCarlo::_local_weight: ";
+
+  // high frequency threshold x = freq / 2 / T.
+  //
+  static const double high_freq_thres = 5.;
+
+  // maximal exponent argument
+  //
+  static const double exp_arg_max = 50.;
+  
+  double dtemp;
+
+  double ener = data.ener;
+
+  double wfac = data.wfac;
+  
+  bool deep_tunnel = false;
+  
+  // quantum correction factor
+  //
+  if(data.eval.isinit()) {
+    //
+    const Lapack::Vector& eval = data.eval;
+    
+    for(int f = 0; f < eval.size(); ++f) {
+      //
+      if(eval[f] < 0.) {
+	//
+	dtemp = std::sqrt(-eval[f]) / temperature / 2.;
+
+	if(dtemp < 0.9 * M_PI) {
+	  //
+	  wfac *= dtemp / std::sin(dtemp);
+	}
+	else if(!deep_tunnel) {
+	  //
+	  deep_tunnel = true;
+	
+	  std::cerr << funame << "WARNING: the system is in the deep tunneling regime, check the log file\n";
+
+	  IO::log << IO::log_offset << "WARNING: the system is in the deep tunneling regime" << std::endl;
+	}
+      }
+      else if(eval[f] > 0.) {
 	//
-	dtemp = _nm_freq[f] / temperature / 2.;
+	dtemp = std::sqrt(eval[f]) / temperature / 2.;
       
 	if(dtemp > high_freq_thres) {
 	  //
@@ -15582,24 +16220,61 @@ double Model::MonteCarlo::_local_weight (double                  ener,       //
 	  wfac *= dtemp / std::sinh(dtemp);
       }
     }
-  }// stable species
-  
-  // Boltzmann factor, including zero-point energy of high-frequency modes relative to the reference energy
-  //
-  double bpow = (ener - _refen) / temperature;
 
-  // reference potential correction
-  //
-  if(_ref_pot) {
+    // deep tunneling regime output
     //
-    Lapack::Vector flux_pos(_fluxional.size());
+    if(deep_tunnel) {
+      //
+      IO::log << IO::log_offset << "Deep tunneling regime:\n";
+      
+      IO::log << IO::log_offset << "Energy (including zero-point energy correction) = "
+	      << (ener - _refen) / Phys_const::kcal << " kcal/mol" << std::endl;
 
-    for(int f = 0; f < _fluxional.size(); ++f)
+      IO::log << IO::log_offset << "Frequencies, 1/cm:";
+
+      for(int f = 0; f < eval.size(); ++f) {
+	//
+	IO::log << "   ";
+    
+	if(eval[f] < 0.) {
+	  //
+	  IO::log << -std::sqrt(-eval[f]) / Phys_const::incm;
+	}
+	else
+	  //
+	  IO::log << std::sqrt(eval[f]) / Phys_const::incm;
+      }
+
+      IO::log << std::endl;
       //
-      flux_pos[f] = _fluxional[f].evaluate(cart_pos);
-  
-    bpow -= _ref_pot(flux_pos) / _ref_tem;
+    }// deep tunneling
+
+  }// quantum correction factor
+
+  // non-fluxional modes quantum correction without hessian data
+  //
+  if(!_ists && _nohess && !_noqf) {
+    //
+    for(int f = 0; f < _nm_freq.size(); ++f) {
+      //
+      dtemp = _nm_freq[f] / temperature / 2.;
+      
+      if(dtemp > high_freq_thres) {
+	//
+	ener += dtemp * temperature;
+	
+	wfac *= 2. * dtemp;
+      }
+      else
+	//
+	wfac *= dtemp / std::sinh(dtemp);
+    }
   }
+  
+  // Boltzmann factor, including zero-point energy of high-frequency modes relative to the reference energy,
+  // and reference potential correction
+  //
+  double bpow = (ener - _refen) / temperature - data.ref_pow;
 
   if(bpow > exp_arg_max)
     //
@@ -15617,6 +16292,7 @@ double Model::MonteCarlo::_local_weight (double                  ener,       //
   return wfac * std::exp(-bpow);
 }
 
+
 /***********************************************************************************************************
  ****************************** CRUDE MONTE-CARLO SAMPLING WITH DUMMY ATOMS ********************************
  ***********************************************************************************************************/
@@ -16699,7 +17375,26 @@ Model::RRHO::RRHO(IO::KeyBufferStream& from, const std::string& n, int m)
       
       std::getline(from, comment);
 
-      _init_graphex(from);
+      // the graph expansion is set up through the Graph namespace globals,
+      // while the species may be built concurrently
+      //
+      std::exception_ptr error;
+
+#pragma omp critical(graph_expansion_init)
+      {
+	try {
+	  //
+	  _init_graphex(from);
+	}
+	catch(...) {
+	  //
+	  error = std::current_exception();
+	}
+      }
+
+      if(error)
+	//
+	std::rethrow_exception(error);
     }
     // tunneling
     else if(tunn_key == token) {
@@ -17123,13 +17818,12 @@ Model::RRHO::RRHO(IO::KeyBufferStream& from, const std::string& n, int m)
       //
       IO::Marker elev_marker("electronic states contribution", IO::Marker::ONE_LINE);
 
-      new_stat_grid = 0.;
+      std::map<int, double> shift;
       for(int l = 0; l < _elevel.size(); ++l) {
 	itemp = (int)round(_elevel[l] / ener_quant);
-	for(int i = itemp; i < ener_grid.size(); ++i)
-	  new_stat_grid[i] += stat_grid[i - itemp] * double(_edegen[l]);
+	shift[itemp] += double(_edegen[l]);
       }
-      stat_grid = new_stat_grid;
+      Convolution::sparse(stat_grid, shift);
     }
     //
     else if(_edegen[0] != 1) {
@@ -17154,8 +17848,7 @@ Model::RRHO::RRHO(IO::KeyBufferStream& from, const std::string& n, int m)
 	    std::cerr << funame << "negative frequency\n";
 	    throw Error::Range();
 	  }
-	  for(int e = itemp; e < ener_grid.size(); ++e)
-	    stat_grid[e] += stat_grid[e - itemp];
+	  Convolution::harmonic(stat_grid, itemp);
 	}
     }
   
@@ -17194,8 +17887,7 @@ Model::RRHO::RRHO(IO::KeyBufferStream& from, const std::string& n, int m)
 	new_stat_grid = stat_grid;
 	itemp = (int)round(_frequency[f] / ener_quant);
 
-	for(int e = itemp; e < ener_grid.size(); ++e)
-	  new_stat_grid[e] += new_stat_grid[e - itemp];
+	Convolution::harmonic(new_stat_grid, itemp);
 
 	for(int e = itemp; e < ener_grid.size(); ++e)
 	  if(stat_grid[e] != 0.) {
@@ -17262,6 +17954,7 @@ void Model::RRHO::_init_graphex (std::istream& from)
   Key      keep_key("KeepPermutedGraphs"              );
   Key      scut_key("FourierSumCutoff"                );
   Key      redt_key("ReductionThreshold"              );
+  Key     store_key("GraphValueStore"                 );
 
   // potential expansion
   //
@@ -17406,6 +18099,21 @@ void Model::RRHO::_init_graphex (std::istream& from)
 
       std::getline(from, comment);
     }	
+    // persistent graph value store file
+    //
+    else if(store_key == token) {
+      //
+      if(!(from >> name)) {
+	//
+	ErrOut err_out;
+
+	err_out << funame << token << ": corrupted";
+      }
+
+      Graph::Expansion::store_file = name;
+
+      std::getline(from, comment);
+    }	
     // unknown keyword
     //
     else if(IO::skip_comment(token, from)) {
@@ -17461,6 +18169,13 @@ double Model::RRHO::states (double ener) const
   return _states(ener);
 }
 
+void Model::RRHO::states_on_grid (double ener_ref, double step, int n, double* res) const
+{
+  const char funame [] = "Model::RRHO::states_on_grid: ";
+
+  spline_states_on_grid(_states, _nmax, ener_ref - ground(), step, n, res, funame);
+}
+
 double Model::RRHO::weight (double temperature) const
 {
   double dtemp;
@@ -17752,6 +18467,32 @@ double Model::UnionSpecies::states (double energy) const
   return res;
 }
 
+void Model::UnionSpecies::states_on_grid (double ener_ref, double step, int n, double* res) const
+{
+  // grid points above the ground
+  //
+  int size = 0;
+
+  while(size < n && ener_ref - (double)size * step > _ground)
+    //
+    ++size;
+
+  for(int i = 0; i < n; ++i)
+    //
+    res[i] = 0.;
+
+  std::vector<double> sub(size);
+
+  for(_Cit w = _species.begin(); w != _species.end(); ++w) {
+    //
+    (*w)->states_on_grid(ener_ref, step, size, sub.data());
+
+    for(int i = 0; i < size; ++i)
+      //
+      res[i] += sub[i];
+  }
+}
+
 double Model::UnionSpecies::weight (double temperature) const
 {
   double res = 0.;
@@ -18170,6 +18911,13 @@ double Model::VarBarrier::states (double ener) const
   return _states(ener);
 }
 
+void Model::VarBarrier::states_on_grid (double ener_ref, double step, int n, double* res) const
+{
+  const char funame [] = "Model::VarBarrier::states_on_grid: ";
+
+  spline_states_on_grid(_states, _nmax, ener_ref - _ground, step, n, res, funame);
+}
+
 double Model::VarBarrier::weight (double temperature) const
 {
   const char funame [] = "Model::VarBarrier::weight: ";
@@ -22,7 +22,7 @@
 //#include<multiset>
 
 #include "graph_omp.hh"
-#include "slatec.hh"
+#include "spline.hh"
 #include "shared.hh"
 #include "lapack.hh"
 #include "multindex.hh"
@@ -175,7 +175,7 @@ namespace Model {
    **************************************************************************************/
 
   class ReadTunnel: public Tunnel {
-    Slatec::Spline _action;
+    Math::Spline _action;
 
   public:
     ReadTunnel(IO::KeyBufferStream&) ;
@@ -222,7 +222,7 @@ namespace Model {
 
     double _potential (double x) { return x * x * (0.5  + _v3 * x + _v4 * x * x); }
 
-    Slatec::Spline _action; // semiclassical action for energies below barrier 
+    Math::Spline _action; // semiclassical action for energies below barrier 
 
     class XratioSearch : public Math::NewtonRaphsonSearch {
       double _vratio;
@@ -423,6 +423,11 @@ namespace Model {
    ************************************* RRHO CORE **************************************
    **************************************************************************************/
 
+  // states on the grid ener_ref - i * step of the relative energy from the spline interpolation
+  // and the power extrapolation beyond the interpolation range
+  //
+  void spline_states_on_grid (const Math::Spline&, double nmax, double ener_ref, double step, int n, double* res, const char* funame);
+
   class Core {
     int _mode;
     Core ();
@@ -437,6 +442,10 @@ namespace Model {
     virtual double weight (double) const =0; // statistical weight relative to the ground
     virtual double states (double) const =0; // density or number of states relative to the ground
 
+    // states on the energy grid res[i] = states(ener_ref - i * step), i = 0, ..., n - 1
+    //
+    virtual void states_on_grid (double ener_ref, double step, int n, double* res) const;
+
     int mode () const { return _mode; }
   };
 
@@ -496,7 +505,7 @@ namespace Model {
     // interpolation
     double           _emax; // interpolation energy maximum
     double           _nmax; // extrapolation power value
-    Slatec::Spline _states;
+    Math::Spline _states;
 
     double _core_states (double) const;
     double _core_weight (double) const;
@@ -508,6 +517,8 @@ namespace Model {
     double ground ()       const;
     double weight (double) const;
     double states (double) const;
+
+    void states_on_grid (double, double, int, double*) const;
   };
 
   /*****************************************************************************************
@@ -520,7 +531,7 @@ namespace Model {
     Array<double>       _rotd_nos; // density of states of the transitional modes on the grid
 
     double              _ground;
-    Slatec::Spline      _rotd_spline;
+    Math::Spline      _rotd_spline;
     double              _rotd_emin, _rotd_emax;
     double              _rotd_nmin, _rotd_amin;
     double              _rotd_nmax, _rotd_amax;
@@ -679,9 +690,9 @@ namespace Model {
 
     double _cstates_pow;     // extrapolation power value
 
-    Slatec::Spline _cstates; // classical number/density of states relative to the potential minimum
+    Math::Spline _cstates; // classical number/density of states relative to the potential minimum
 
-    Slatec::Spline _qfactor; // quantum correction factor for number/density of states relative to the ground level
+    Math::Spline _qfactor; // quantum correction factor for number/density of states relative to the ground level
 
     void _set_qfactor ();
 
@@ -738,6 +749,7 @@ namespace Model {
     std::vector<Atom> _atom;
     std::string _name;
     int    _mode;
+    std::string _input_hash;
 
     Species ();
 
@@ -766,6 +778,15 @@ namespace Model {
     virtual double states (double) const =0; // density or number of states of absolute energy
     virtual double weight (double) const =0; // weight relative to the ground
 
+    // states on the energy grid res[i] = states(ener_ref - i * step), i = 0, ..., n - 1,
+    // in one call instead of one virtual call per grid bin
+    //
+    virtual void states_on_grid (double ener_ref, double step, int n, double* res) const;
+
+    // weights for the temperature list at once
+    //
+    virtual void weights (const std::vector<double>&, std::vector<double>&) const;
+
     double ground () const { return _ground; }
     virtual void shift_ground (double e) { _ground += e; }
     virtual double real_ground () const { return _ground; }
@@ -782,6 +803,12 @@ namespace Model {
     //void set_name (const std::string& n) { _name = n; }
     const std::string& name () const { return _name; }
 
+    // input description hash, which identifies the species model in the persistent caches;
+    // empty, if the species is not built from its own input description
+    //
+    const std::string& input_hash () const { return _input_hash; }
+    void set_input_hash (const std::string& h) { _input_hash = h; }
+
     // radiational transitions
     virtual double   infrared_intensity (double, int) const;
     virtual double oscillator_frequency (int)         const;
@@ -919,14 +946,43 @@ namespace Model {
     //
     static double nm_freq_min;
     
+    // temperature-independent part of the sampling contribution
+    //
+    struct _LocalData {
+      //
+      // energy, including the transition state energy correction
+      //
+      double ener;
+
+      // mass and frequency factors
+      //
+      double wfac;
+
+      // squared frequencies for the quantum correction factor
+      //
+      Lapack::Vector eval;
+
+      // reference potential exponent
+      //
+      double ref_pow;
+    };
+
+    // returns false if the sampling should be discarded
+    //
+    bool _local_data (double                  ener,       // energy
+		      Lapack::Vector          cart_pos,   // cartesian coordinates    
+		      Lapack::Vector          cart_grad,  // energy gradient in cartesian coordinates
+		      Lapack::SymmetricMatrix cart_fc,    // cartesian force constant matrix
+		      _LocalData&             data        // temperature-independent data
+		      ) const;
+
     // statistical weight prefactor including mass factors and quantum prefactor in local harmonic approximation
     //
-    double _local_weight (double                  ener,       // energy
-			  Lapack::Vector          cart_pos,   // cartesian coordinates    
-			  Lapack::Vector          cart_grad,  // energy gradient in cartesian coordinates
-			  Lapack::SymmetricMatrix cart_fc,    // cartesian force constant matrix
-			  double                  temperature // temprature
-			  ) const;
+    double _local_weight (const _LocalData& data, double temperature) const;
+
+    // sampling-independent factor of the statistical weight
+    //
+    double _weight_factor (double temperature) const;
 
     // read data from the file
     //
@@ -937,6 +993,34 @@ namespace Model {
 		Lapack::SymmetricMatrix cart_fc     // cartesian force constant matrix
 		) const;
 
+    // binary sample store: the data file is parsed once and cached in the binary file
+    // which is memory-mapped on subsequent runs
+    //
+    SharedPointer<System::MappedFile> _sample_map;
+
+    // in-memory store, if the binary cache cannot be written
+    //
+    std::vector<double>               _sample_buffer;
+
+    const double*                     _sample_data;
+
+    int                               _sample_size;
+
+    // number of doubles per sampling: energy, coordinates, gradient, and packed force constant matrix
+    //
+    int _record_size () const;
+
+    void _init_samples ();
+
+    // s-th sampling data
+    //
+    void _sample (int                     s,
+		  double&                 ener,
+		  Lapack::Vector          cart_pos,
+		  Lapack::Vector          cart_grad,
+		  Lapack::SymmetricMatrix cart_fc
+		  ) const;
+
     // set reference energy to the minimal total energy including zero-point energy
     //
     void _set_reference_energy ();
@@ -992,8 +1076,19 @@ namespace Model {
     
     double weight_with_error (double, double&) const;
 
+    // all temperatures in one pass over the samplings
+    //
+    void weight_with_error (const std::vector<double>& temperature, std::vector<double>& weight, std::vector<double>& werr) const;
+
     double weight (double temperature) const { double dtemp; return weight_with_error(temperature, dtemp); }
 
+    void weights (const std::vector<double>& temperature, std::vector<double>& weight) const
+    { std::vector<double> werr; weight_with_error(temperature, weight, werr); }
+
+    // samplings per parallel pass; the output is buffered for the pass
+    //
+    static int sample_chunk_size;
+
     int atom_size () const { return _mass_sqrt.size(); }
   };
   
@@ -1083,10 +1178,10 @@ namespace Model {
     // interpolation
     double           _emax; // interpolation energy maximum
     double           _nmax; // extrapolation power value
-    Slatec::Spline _states;
+    Math::Spline _states;
 
     // radiative transitions
-    std::vector<Slatec::Spline> _occ_num; // average occupation numbers for vibrational modes
+    std::vector<Math::Spline> _occ_num; // average occupation numbers for vibrational modes
     std::vector<double>     _occ_num_der; // occupation number derivatives (for extrapolation)
     std::vector<double>         _osc_int; // oscillator strength (infrared intensities)
     
@@ -1101,6 +1196,8 @@ namespace Model {
     double states (double) const; // density or number of states of absolute energy
     double weight (double) const; // weight relative to the ground
 
+    void states_on_grid (double, double, int, double*) const;
+
     double real_ground () const { return _real_ground; }
     void shift_ground (double e) { _ground += e; _real_ground += e; }
 
@@ -1120,7 +1217,7 @@ namespace Model {
     Array<double> _states; // density/number of states on the grid
     int _mode;
 
-    Slatec::Spline _spline;
+    Math::Spline _spline;
     double _emin, _emax;
     double _nmin, _amin;
     double _nmax, _amax;
@@ -1134,6 +1231,8 @@ namespace Model {
 
     double states (double) const;
     double weight (double) const;
+
+    void states_on_grid (double, double, int, double*) const;
   };
   
   
@@ -1157,6 +1256,8 @@ namespace Model {
     double states (double) const;
     double weight (double) const;
 
+    void states_on_grid (double, double, int, double*) const;
+
     void shift_ground (double);
     double real_ground () const { return _real_ground; }
 
@@ -1180,7 +1281,7 @@ namespace Model {
     double       _nmax; // extrapolation power value
 
     Array<double>  _stat_grid;
-    Slatec::Spline _states;
+    Math::Spline _states;
 
     // two-transition-states model calculation method
     enum {STATISTICAL, DYNAMICAL};
@@ -1193,6 +1294,8 @@ namespace Model {
     double states (double) const;
     double weight (double) const;
 
+    void states_on_grid (double, double, int, double*) const;
+
     double real_ground () const { return _real_ground; }
     void shift_ground (double e) { _ground += e; _real_ground += e; }
 
@@ -1231,7 +1334,7 @@ namespace Model {
     // interpolation
     double           _emax; // interpolation energy maximum
     double           _nmax; // extrapolation power value
-    Slatec::Spline _states;
+    Math::Spline _states;
 
   public:
     Arrhenius(IO::KeyBufferStream& from, const std::string&) ;
@@ -1296,7 +1399,7 @@ namespace Model {
 
   class FitEscape : public Escape {
     double _ground;
-    Slatec::Spline _rate;
+    Math::Spline _rate;
 
   public:
     FitEscape(IO::KeyBufferStream&) ;
@@ -1514,7 +1617,7 @@ namespace Model {
     double excess_reactant_concentration () const { return _excess; }
     double temperature () const { return _temperature; }
 
-    std::ofstream out;
+    IO::LogOut out;
   };
 
   extern SharedPointer<TimeEvolution> time_evolution;
@@ -9775,9 +9775,9 @@ Model::MultiRotor::MultiRotor(IO::KeyBufferStream& from, const std::vector<Atom>
 
   /************************************* INTERPOLATION ********************************************/
 
-  Slatec::Spline one_qstates; // one-dimensional rotors model quantum   density/number of states
+  Math::Spline one_qstates; // one-dimensional rotors model quantum   density/number of states
 
-  Slatec::Spline one_cstates; // one_dimensional rotors model classical density/number of states
+  Math::Spline one_cstates; // one_dimensional rotors model classical density/number of states
  
   // quantum correction factor
   //
@@ -11070,7 +11070,7 @@ void Model::MultiRotor::_set_qfactor ()
 
   // classical density/number of states interpolation
   //
-  Slatec::Spline eff_cstates(ener_grid, stat_grid, ener_grid.size());
+  Math::Spline eff_cstates(ener_grid, stat_grid, ener_grid.size());
 
   /**************** QUANTUM CORRECTION FACTOR  ***************/
 
@@ -0,0 +1,492 @@
+/*
+        Chemical Kinetics and Dynamics Library
+        Copyright (C) 2008-2013, Yuri Georgievski <ygeorgi@anl.gov>
+
+        This library is free software; you can redistribute it and/or
+        modify it under the terms of the GNU Library General Public
+        License as published by the Free Software Foundation; either
+        version 2 of the License, or (at your option) any later version.
+
+        This library is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+        Library General Public License for more details.
+*/
+
+#include "ode.hh"
+
+#include <cmath>
+#include <cfloat>
+#include <iostream>
+#include <algorithm>
+
+int Ode::BatchSolver::step_max = 100000;
+
+namespace {
+  //
+  // Dormand-Prince 5(4) tableau
+  //
+  const double rk_c [7] = {0., 1./5., 3./10., 4./5., 8./9., 1., 1.};
+
+  const double rk_a [7][6] = {
+    {0.},
+    {1./5.},
+    {3./40., 9./40.},
+    {44./45., -56./15., 32./9.},
+    {19372./6561., -25360./2187., 64448./6561., -212./729.},
+    {9017./3168., -355./33., 46732./5247., 49./176., -5103./18656.},
+    {35./384., 0., 500./1113., 125./192., -2187./6784., 11./84.}
+  };
+
+  // fifth minus fourth order weights
+  //
+  const double rk_e [7] = {71./57600., 0., -71./16695., 71./1920., -17253./339200., 22./525., -1./40.};
+
+  // step size control
+  //
+  const double safety  = 0.9;
+  const double fac_min = 0.2;
+  const double fac_max = 5.;
+
+  // the step reaching the target time within this relative margin is the last one
+  //
+  const double last_margin = 1.e-10;
+}
+
+Ode::BatchSolver::BatchSolver (int dim, int size, method_t m)
+  : _dim(dim), _size(size), _method(m)
+{
+  const char funame [] = "Ode::BatchSolver::BatchSolver: ";
+
+  if(dim <= 0 || size <= 0) {
+    std::cerr << funame << "wrong dimensions: " << dim << ", " << size << "\n";
+    throw Error::Range();
+  }
+
+  _y.resize(dim * size);
+  _f.resize(dim * size);
+  _ytmp.resize(dim * size);
+
+  for(int s = 0; s < 6; ++s)
+    _k[s].resize(dim * size);
+
+  if(_method == ADAMS)
+    for(int s = 0; s < 3; ++s)
+      _hist[s].resize(dim * size);
+
+  _hist_size.resize(size, 0);
+
+  _rel_tol.resize(dim * size);
+  _abs_tol.resize(dim * size);
+
+  _time.resize(size, 0.);
+  _ttmp.resize(size, 0.);
+  _step.resize(size, 0.);
+  _status.resize(size, IDLE);
+  _count.resize(size, 0);
+  _fval.resize(size, false);
+}
+
+void Ode::BatchSolver::set (int k, double time, const double* y, const double* rel_tol, const double* abs_tol)
+{
+  const char funame [] = "Ode::BatchSolver::set: ";
+
+  if(k < 0 || k >= _size) {
+    std::cerr << funame << "member index out of range: " << k << "\n";
+    throw Error::Range();
+  }
+
+  for(int i = 0; i < _dim; ++i)
+    if(rel_tol[i] < 0. || abs_tol[i] <= 0.) {
+      std::cerr << funame << i << "-th component: error tolerance should be positive\n";
+      throw Error::Range();
+    }
+
+  for(int i = 0; i < _dim; ++i) {
+    //
+    const int n = i * _size + k;
+
+    _y[n]       = y[i];
+    _rel_tol[n] = rel_tol[i];
+    _abs_tol[n] = abs_tol[i];
+  }
+
+  _time[k]      = time;
+  _step[k]      = 0.;
+  _status[k]    = RUN;
+  _fval[k]      = false;
+  _hist_size[k] = 0;
+}
+
+void Ode::BatchSolver::get (int k, double* y) const
+{
+  for(int i = 0; i < _dim; ++i)
+    //
+    y[i] = _y[i * _size + k];
+}
+
+double Ode::BatchSolver::_scale (int i, int k, double y1, double y2) const
+{
+  const int n = i * _size + k;
+
+  return _abs_tol[n] + _rel_tol[n] * std::max(std::fabs(y1), std::fabs(y2));
+}
+
+void Ode::BatchSolver::_eval (BatchRhs& rhs, const double* y, double* dydt, std::vector<int>& member)
+{
+  if(!member.size())
+    //
+    return;
+
+  std::vector<int> fail;
+
+  rhs(&_ttmp[0], y, dydt, _size, member, fail);
+
+  if(!fail.size())
+    //
+    return;
+
+  for(int f = 0; f < fail.size(); ++f)
+    //
+    _status[fail[f]] = RHS_FAIL;
+
+  std::vector<int> res;
+
+  for(int m = 0; m < member.size(); ++m)
+    if(_status[member[m]] == RUN)
+      res.push_back(member[m]);
+
+  member.swap(res);
+}
+
+// the ratio of the solution and its derivative norms
+//
+double Ode::BatchSolver::_initial_step (int k) const
+{
+  double y0 = 0., f0 = 0.;
+
+  for(int i = 0; i < _dim; ++i) {
+    //
+    const int n = i * _size + k;
+
+    const double sc = _scale(i, k, _y[n], _y[n]);
+
+    y0 = std::max(y0, std::fabs(_y[n]) / sc);
+    f0 = std::max(f0, std::fabs(_f[n]) / sc);
+  }
+
+  if(y0 < 1.e-5 || f0 < 1.e-5)
+    //
+    return 1.e-6;
+
+  return 0.01 * y0 / f0;
+}
+
+void Ode::BatchSolver::_push_hist (int k)
+{
+  for(int i = 0; i < _dim; ++i) {
+    //
+    const int n = i * _size + k;
+
+    _hist[2][n] = _hist[1][n];
+    _hist[1][n] = _hist[0][n];
+    _hist[0][n] = _f[n];
+  }
+
+  if(_hist_size[k] < 4)
+    //
+    ++_hist_size[k];
+}
+
+void Ode::BatchSolver::_rk_step (BatchRhs& rhs, std::vector<int>& member, const double* tout)
+{
+  if(!member.size())
+    //
+    return;
+
+  std::vector<double> h(_size);
+  std::vector<bool>   last(_size, false);
+
+  for(int m = 0; m < member.size(); ++m) {
+    //
+    const int k = member[m];
+
+    const double dt = tout[k] - _time[k];
+
+    h[k] = _step[k];
+
+    if(std::fabs(h[k]) >= std::fabs(dt) * (1. - last_margin)) {
+      //
+      h[k]    = dt;
+      last[k] = true;
+    }
+  }
+
+  // stages
+  //
+  for(int s = 1; s < 7; ++s) {
+    //
+    for(int i = 0; i < _dim; ++i)
+      for(int m = 0; m < member.size(); ++m) {
+	//
+	const int k = member[m];
+	const int n = i * _size + k;
+
+	double d = rk_a[s][0] * _f[n];
+
+	for(int j = 1; j < s; ++j)
+	  d += rk_a[s][j] * _k[j - 1][n];
+
+	_ytmp[n] = _y[n] + h[k] * d;
+      }
+
+    for(int m = 0; m < member.size(); ++m)
+      //
+      _ttmp[member[m]] = _time[member[m]] + rk_c[s] * h[member[m]];
+
+    _eval(rhs, &_ytmp[0], &_k[s - 1][0], member);
+  }
+
+  // error estimate, acceptance, and the next step
+  //
+  for(int m = 0; m < member.size(); ++m) {
+    //
+    const int k = member[m];
+
+    ++_count[k];
+
+    double err = 0.;
+
+    for(int i = 0; i < _dim; ++i) {
+      //
+      const int n = i * _size + k;
+
+      double d = rk_e[0] * _f[n];
+
+      for(int j = 1; j < 7; ++j)
+	d += rk_e[j] * _k[j - 1][n];
+
+      err = std::max(err, std::fabs(h[k] * d) / _scale(i, k, _y[n], _ytmp[n]));
+    }
+
+    const double fac = err > 0. ? safety * std::pow(err, -0.2) : fac_max;
+
+    if(err <= 1.) {
+      //
+      // Adams history: the step is equally spaced with the previous ones unless it is the
+      // last one or the step is to be increased
+      //
+      const bool restart = last[k] || (_method == ADAMS && fac > 2.);
+
+      if(_method == ADAMS && !restart)
+	_push_hist(k);
+
+      for(int i = 0; i < _dim; ++i) {
+	//
+	const int n = i * _size + k;
+
+	_y[n] = _ytmp[n];
+	_f[n] = _k[5][n];
+      }
+
+      _time[k] = last[k] ? tout[k] : _time[k] + h[k];
+
+      if(_method == ADAMS) {
+	//
+	if(restart)
+	  _hist_size[k] = 1;
+
+	if(fac > 2. && !last[k])
+	  _step[k] = h[k] * std::min(fac, fac_max);
+      }
+      else if(!last[k] || fac < 1.)
+	_step[k] = h[k] * std::min(fac, fac_max);
+    }
+    else {
+      //
+      _step[k] = h[k] * std::max(fac, fac_min);
+
+      _hist_size[k] = 1;
+
+      if(std::fabs(_step[k]) < 16. * DBL_EPSILON * std::max(std::fabs(_time[k]), 1.))
+	_status[k] = STEP_FAIL;
+    }
+  }
+}
+
+// fourth order Adams-Bashforth predictor, Adams-Moulton corrector, and the derivatives
+// at the corrected point (PECE); the local error is estimated by the Milne device
+//
+void Ode::BatchSolver::_adams_step (BatchRhs& rhs, std::vector<int>& member)
+{
+  if(!member.size())
+    //
+    return;
+
+  // predictor, kept in the third stage array
+  //
+  for(int i = 0; i < _dim; ++i)
+    for(int m = 0; m < member.size(); ++m) {
+      //
+      const int k = member[m];
+      const int n = i * _size + k;
+
+      _ytmp[n] = _y[n] + _step[k] / 24. * (55. * _f[n] - 59. * _hist[0][n] + 37. * _hist[1][n] - 9. * _hist[2][n]);
+
+      _k[2][n] = _ytmp[n];
+    }
+
+  for(int m = 0; m < member.size(); ++m)
+    //
+    _ttmp[member[m]] = _time[member[m]] + _step[member[m]];
+
+  _eval(rhs, &_ytmp[0], &_k[0][0], member);
+
+  // corrector
+  //
+  for(int i = 0; i < _dim; ++i)
+    for(int m = 0; m < member.size(); ++m) {
+      //
+      const int k = member[m];
+      const int n = i * _size + k;
+
+      _ytmp[n] = _y[n] + _step[k] / 24. * (9. * _k[0][n] + 19. * _f[n] - 5. * _hist[0][n] + _hist[1][n]);
+    }
+
+  _eval(rhs, &_ytmp[0], &_k[1][0], member);
+
+  for(int m = 0; m < member.size(); ++m) {
+    //
+    const int k = member[m];
+
+    ++_count[k];
+
+    double err = 0.;
+
+    for(int i = 0; i < _dim; ++i) {
+      //
+      const int n = i * _size + k;
+
+      err = std::max(err, 19. / 270. * std::fabs(_ytmp[n] - _k[2][n]) / _scale(i, k, _y[n], _ytmp[n]));
+    }
+
+    const double fac = err > 0. ? safety * std::pow(err, -0.2) : fac_max;
+
+    if(err <= 1.) {
+      //
+      _push_hist(k);
+
+      for(int i = 0; i < _dim; ++i) {
+	//
+	const int n = i * _size + k;
+
+	_y[n] = _ytmp[n];
+	_f[n] = _k[1][n];
+      }
+
+      _time[k] += _step[k];
+
+      // the step is doubled and the history restarted
+      //
+      if(fac > 2.) {
+	//
+	_step[k] *= 2.;
+
+	_hist_size[k] = 1;
+      }
+    }
+    else {
+      //
+      _step[k] *= std::max(std::min(fac, 0.5), fac_min);
+
+      _hist_size[k] = 1;
+
+      if(std::fabs(_step[k]) < 16. * DBL_EPSILON * std::max(std::fabs(_time[k]), 1.))
+	_status[k] = STEP_FAIL;
+    }
+  }
+}
+
+void Ode::BatchSolver::advance (BatchRhs& rhs, const double* tout)
+{
+  std::vector<int> member;
+
+  for(int k = 0; k < _size; ++k)
+    if(_status[k] == RUN && tout[k] != _time[k]) {
+      //
+      member.push_back(k);
+
+      _count[k] = 0;
+    }
+
+  // derivatives at the starting points
+  //
+  std::vector<int> start;
+
+  for(int m = 0; m < member.size(); ++m)
+    if(!_fval[member[m]]) {
+      //
+      start.push_back(member[m]);
+
+      _ttmp[member[m]] = _time[member[m]];
+    }
+
+  _eval(rhs, &_y[0], &_f[0], start);
+
+  for(int m = 0; m < start.size(); ++m) {
+    //
+    _fval[start[m]]      = true;
+    _hist_size[start[m]] = 1;
+  }
+
+  std::vector<int> rk, adams;
+
+  while(1) {
+    //
+    rk.clear();
+    adams.clear();
+
+    for(int m = 0; m < member.size(); ++m) {
+      //
+      const int k = member[m];
+
+      if(_status[k] != RUN || _time[k] == tout[k])
+	continue;
+
+      if(_count[k] >= step_max) {
+	//
+	_status[k] = COUNT_FAIL;
+
+	continue;
+      }
+
+      const double dt = tout[k] - _time[k];
+
+      // initial step and the direction change
+      //
+      if(_step[k] == 0.)
+	_step[k] = _initial_step(k);
+
+      if(_step[k] * dt < 0.) {
+	//
+	_step[k] = -_step[k];
+
+	_hist_size[k] = 1;
+      }
+
+      if(_method == ADAMS && _hist_size[k] == 4 && std::fabs(dt) > std::fabs(_step[k]) * (1. + last_margin))
+	//
+	adams.push_back(k);
+      else
+	rk.push_back(k);
+    }
+
+    if(!rk.size() && !adams.size())
+      //
+      break;
+
+    _rk_step(rhs, rk, tout);
+
+    _adams_step(rhs, adams);
+  }
+}
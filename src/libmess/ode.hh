@@ -0,0 +1,135 @@
+/*
+        Chemical Kinetics and Dynamics Library
+        Copyright (C) 2008-2013, Yuri Georgievski <ygeorgi@anl.gov>
+
+        This library is free software; you can redistribute it and/or
+        modify it under the terms of the GNU Library General Public
+        License as published by the Free Software Foundation; either
+        version 2 of the License, or (at your option) any later version.
+
+        This library is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+        Library General Public License for more details.
+*/
+
+#ifndef ODE_HH
+#define ODE_HH
+
+#include <vector>
+
+#include "error.hh"
+
+/********************************************************************************************
+ * Adaptive integration of a batch of ODE systems of the same dimension, each member having
+ * its own time, step, tolerances, and target time.  The state is kept in the structure of
+ * arrays layout, the i-th component of the k-th member at i * size + k, so that the step
+ * arithmetic runs over the members in the inner loop.  The failures are reported through
+ * the member status and do not affect the other members.  The solver has no global state
+ * and each thread may run its own batch
+ ********************************************************************************************/
+
+namespace Ode {
+
+  // RUNGE_KUTTA: Dormand-Prince 5(4) pair with the local extrapolation;
+  // ADAMS:       fourth order Adams-Bashforth-Moulton predictor-corrector,
+  //              started and restarted by the Runge-Kutta steps
+  //
+  enum method_t {RUNGE_KUTTA, ADAMS};
+
+  enum status_t {
+    RUN,        // in progress
+    IDLE,       // not started or stopped
+    RHS_FAIL,   // right hand side evaluation failed
+    STEP_FAIL,  // step size underflow
+    COUNT_FAIL  // too many steps to reach the target time
+  };
+
+  // right hand side of the batch
+  //
+  class BatchRhs {
+  public:
+    //
+    // derivatives of the listed members; the members for which the evaluation failed are
+    // appended to fail
+    //
+    virtual void operator() (const double* time, const double* y, double* dydt, int stride,
+			     const std::vector<int>& member, std::vector<int>& fail) =0;
+
+    virtual ~BatchRhs () {}
+  };
+
+  class BatchSolver {
+    //
+    int      _dim;
+    int      _size;
+    method_t _method;
+
+    // state, derivatives at the current point, and the stages
+    //
+    std::vector<double> _y;
+    std::vector<double> _f;
+    std::vector<double> _ytmp;
+    std::vector<double> _k [6];
+
+    // Adams history: derivatives at the three previous points, the most recent first,
+    // and the number of the equally spaced points known, the current one included
+    //
+    std::vector<double> _hist [3];
+    std::vector<int>    _hist_size;
+
+    std::vector<double> _rel_tol;
+    std::vector<double> _abs_tol;
+
+    std::vector<double> _time;
+    std::vector<double> _ttmp;
+    std::vector<double> _step;
+    std::vector<int>    _status;
+    std::vector<int>    _count;
+    std::vector<bool>   _fval;   // the derivatives at the current point are valid
+
+    // evaluates the derivatives and removes the failed members from the list
+    //
+    void _eval (BatchRhs&, const double* y, double* dydt, std::vector<int>&);
+
+    double _initial_step (int k) const;
+
+    void _rk_step    (BatchRhs&, std::vector<int>&, const double* tout);
+    void _adams_step (BatchRhs&, std::vector<int>&);
+
+    void _push_hist  (int k);
+
+    double _scale (int i, int k, double y1, double y2) const;
+
+  public:
+    //
+    // maximal number of steps to reach the target time
+    //
+    static int step_max;
+
+    BatchSolver (int dim, int size, method_t =RUNGE_KUTTA) ;
+
+    int      dim    () const { return _dim; }
+    int      size   () const { return _size; }
+    method_t method () const { return _method; }
+
+    // (re)starts the member at the given point; the step history is discarded
+    //
+    void set (int k, double time, const double* y, const double* rel_tol, const double* abs_tol) ;
+
+    // the member is not advanced any more
+    //
+    void stop (int k) { _status[k] = IDLE; }
+
+    void   get    (int k, double* y) const;
+    double time   (int k)            const { return _time[k]; }
+    int    status (int k)            const { return _status[k]; }
+    bool   is_run (int k)            const { return _status[k] == RUN; }
+
+    // advances the running members to their target times
+    //
+    void advance (BatchRhs&, const double* tout) ;
+  };
+}
+
+#endif
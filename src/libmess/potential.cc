@@ -86,6 +86,45 @@ void Potential::Wrap::read (std::istream& from)
   
 }
 
+// default batch evaluation: configuration by configuration
+//
+void Potential::Base::evaluate (int n, const double* coord, int stride, double* ener, double* force, int* fail) const
+{
+  Array<double> pos(Dynamic::Coordinates::size());
+
+  D3::Vector torque [3];
+
+  for(int k = 0; k < n; ++k) {
+    //
+    for(int i = 0; i < pos.size(); ++i)
+      //
+      pos[i] = coord[i * stride + k];
+
+    fail[k] = 0;
+
+    try {
+      //
+      Dynamic::Coordinates dc(pos);
+
+      if(force) {
+	//
+	ener[k] = (*this)(dc, torque);
+
+	for(int j = 0; j < 9; ++j)
+	  //
+	  force[j * stride + k] = torque[j / 3][j % 3];
+      }
+      else
+	//
+	ener[k] = (*this)(dc, 0);
+    }
+    catch(Error::General) {
+      //
+      fail[k] = 1;
+    }
+  }
+}
+
 /*
 Potential::Harmonic::Harmonic (std::istream& from) 
 {
@@ -156,8 +195,8 @@ Potential::Harmonic::Harmonic (std::istream& from)
 */
 
 Potential::Analytic::Analytic (std::istream& from)  
-  :  _pot_ener(0), _pot_init(0), _corr_ener(0), _corr_init(0),
-     _dist_incr(1.e-4),  _angl_incr(1.e-4)
+  :  _pot_ener(0), _pot_batch(0), _pot_init(0), _corr_ener(0), _corr_batch(0), _corr_init(0),
+     _dist_incr(1.e-4),  _angl_incr(1.e-4), _thread_safe(false)
 {    
   const char funame [] = "Potential::Analytic::Analytic: ";
 
@@ -168,6 +207,7 @@ Potential::Analytic::Analytic (std::istream& from)
 
   Key  pot_libr_key("Library");
   Key  pot_ener_key("EnergyMethod");
+  Key pot_batch_key("BatchEnergyMethod");
   Key  pot_init_key("InitMethod");
   Key  pot_data_key("InitData");
   Key  pot_rpar_key("ParameterReal");
@@ -175,6 +215,7 @@ Potential::Analytic::Analytic (std::istream& from)
 
   Key corr_libr_key("CorrectionLibrary");
   Key corr_ener_key("CorrectionEnergyMethod");
+  Key corr_batch_key("CorrectionBatchEnergyMethod");
   Key corr_init_key("CorrectionInitMethod");
   Key corr_data_key("CorrectionInitData");
   Key corr_rpar_key("CorrectionParameterReal");
@@ -183,6 +224,8 @@ Potential::Analytic::Analytic (std::istream& from)
   Key dist_key("DistanceIncrement");
   Key angl_key("AngularIncrement");
 
+  Key safe_key("ThreadSafe");
+
   std::string token, line, comment, stemp;
 
   std::string pot_data, corr_data;
@@ -214,6 +257,17 @@ Potential::Analytic::Analytic (std::istream& from)
 
       _pot_ener = (ener_t)_pot_libr.member(stemp);
     }
+    // potential batch energy method
+    else if(token == pot_batch_key) {
+
+      if(!(from >> stemp)) {
+	std::cerr << funame << token << ": is corrupted\n";
+	throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      _pot_batch = (batch_ener_t)_pot_libr.member(stemp);
+    }
     // potential initialization method
     else if(token == pot_init_key) {
 
@@ -278,6 +332,17 @@ Potential::Analytic::Analytic (std::istream& from)
 
       _corr_ener = (ener_t)_corr_libr.member(stemp);
     }
+    // correction batch energy method
+    else if(token == corr_batch_key) {
+
+      if(!(from >> stemp)) {
+	std::cerr << funame << token << ": is corrupted\n";
+	throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      _corr_batch = (batch_ener_t)_corr_libr.member(stemp);
+    }
     // correction initialization method
     else if(token == corr_init_key) {
 
@@ -320,6 +385,17 @@ Potential::Analytic::Analytic (std::istream& from)
 
       _corr_ipar = ipar;
     }
+    // the potential libraries are reentrant
+    else if(token == safe_key) {
+
+      if(!(from >> itemp)) {
+	std::cerr << funame << token << ": corrupted\n";
+	throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      _thread_safe = itemp;
+    }
     // distance displacement
     else if(token == dist_key) {
 
@@ -365,7 +441,7 @@ Potential::Analytic::Analytic (std::istream& from)
     throw Error::Form();
   }
 
-  if(!_pot_ener) {
+  if(!_pot_ener && !_pot_batch) {
     std::cerr << funame << "no energy calculation method was provided\n";
     throw Error::Init();
   }
@@ -395,94 +471,142 @@ double Potential::Analytic::_tot_ener (const double* coord) const
 {
   const char funame [] = "Potential::Analytic::_tot_ener: ";
 
-  int ifail = 0;
+  double res;
+  int  ifail;
+
+  _tot_ener(1, coord, &res, &ifail);
 
-  double res = _pot_ener(coord,  _pot_rpar,  _pot_ipar, ifail);
   if(ifail)
     throw Error::Run();
 
-  if(_corr_ener) {
-    res += _corr_ener(coord, _corr_rpar, _corr_ipar, ifail);
-    if(ifail)
-      throw Error::Run();
-  }
-  
-
   return res;
 }
 
-double Potential::Analytic::operator() (const Dynamic::Coordinates& dc, D3::Vector* torque) const 
+void Potential::Analytic::_tot_ener (int n, const double* coord, double* ener, int* fail) const 
 {
-  static const char funame [] = "Potential::Analytic::operator(): ";
+  const int csize = 3 * Structure::size();
+
+  for(int g = 0; g < n; ++g)
+    fail[g] = 0;
+
+  // the external libraries are not assumed to be reentrant
+  std::unique_lock<std::mutex> lock(_lock, std::defer_lock);
+  if(!_thread_safe)
+    lock.lock();
+
+  if(_pot_batch)
+    _pot_batch(n, coord, _pot_rpar, _pot_ipar, ener, fail);
   
-  int    itemp;
-  double dtemp;
+  Array<double> corr;
+  Array<int>    corr_fail;
 
-  Array_2<double> coord(3, Structure::size());
-  _dc2cart(dc, coord);
+  if(_corr_batch) {
+    corr.resize(n);
+    corr_fail.resize(n);
+    
+    for(int g = 0; g < n; ++g)
+      corr_fail[g] = 0;
 
-  if(!torque)
-    return _tot_ener(coord);
+    _corr_batch(n, coord, _corr_rpar, _corr_ipar, corr, corr_fail);
+  }
 
-  D3::Vector& force = *torque;
-  torque += 1;
+  // single geometry methods
+  if(!_pot_batch || (_corr_ener && !_corr_batch)) {
+    //
+    Array<double> geom(csize);
 
-  D3::Vector vtemp;
-  D3::Vector atom_force;
+    for(int g = 0; g < n; ++g) {
+      //
+      if(fail[g])
+	continue;
 
-  // initialization
-  force = 0.;
-  for(int frag = 0; frag < 2; ++frag)
-    torque[frag] = 0.;
-	
-  // numerical gradient
+      for(int i = 0; i < csize; ++i)
+	//
+	geom[i] = coord[i * n + g];
+
+      if(!_pot_batch)
+	//
+	ener[g] = _pot_ener(geom, _pot_rpar, _pot_ipar, fail[g]);
+
+      if(!fail[g] && _corr_ener && !_corr_batch)
+	//
+	ener[g] += _corr_ener(geom, _corr_rpar, _corr_ipar, fail[g]);
+    }
+  }
+
+  if(_corr_batch) {
+    //
+    for(int g = 0; g < n; ++g) {
+      //
+      if(corr_fail[g]) {
+	//
+	fail[g] = 1;
+      }
+      else
+	//
+	ener[g] += corr[g];
+    }
+  }
+}
+
+int Potential::Analytic::_small_fragment ()
+{
+  return Structure::fragment(0).size() < Structure::fragment(1).size() ? 0 : 1;
+}
+
+int Potential::Analytic::_disp_size ()
+{
+  // reference geometry, cartesian displacements, and, for a polyatomic small fragment, rotations
+  if(Structure::fragment(_small_fragment()).type() == Molecule::MONOATOMIC)
+    return 7;
+
+  return 13;
+}
+
+void Potential::Analytic::_displace (const Dynamic::Coordinates& dc, double* res, int stride) const 
+{
+  const int csize = 3 * Structure::size();
 
-  double ener_val = _tot_ener(coord);
+  Array_2<double> coord(3, Structure::size());
+  _dc2cart(dc, coord);
 
-  const int sfrag = Structure::fragment(0).size() < Structure::fragment(1).size() ? 0 : 1;         // small fragment
-  const int lfrag = 1 - sfrag; // large fragment
+  const double* cp = coord;
+
+  int g = 0;
+  for(int i = 0; i < csize; ++i)
+    res[i * stride + g] = cp[i];
+  ++g;
+
+  const int sfrag = _small_fragment();
 
   const int at_shift = sfrag ? Structure::fragment(0).size() : 0;
 
-  // force calculation on small fragment
+  // displacements of the small fragment
   double incr2 = 2. * _dist_incr;
 
   for(int i = 0; i < 3; ++i) {
     for(int at = 0; at < Structure::fragment(sfrag).size(); ++at)
       coord(i, at + at_shift) -= _dist_incr;
-    force[i] += _tot_ener(coord);
+
+    for(int j = 0; j < csize; ++j)
+      res[j * stride + g] = cp[j];
+    ++g;
 
     for(int at = 0; at < Structure::fragment(sfrag).size(); ++at)
       coord(i, at + at_shift) += incr2;
-    force[i] -= _tot_ener(coord);
+
+    for(int j = 0; j < csize; ++j)
+      res[j * stride + g] = cp[j];
+    ++g;
 
     for(int at = 0; at < Structure::fragment(sfrag).size(); ++at)
       coord(i, at + at_shift) -= _dist_incr;
-	
-    if(sfrag)
-      force[i] /=  incr2;
-    else
-      force[i] /= -incr2;
   }
 
-  // torque calculation
-  if (Structure::fragment(sfrag).type() == Molecule::MONOATOMIC) {// small fragment is an atom
-    switch(Structure::fragment(lfrag).type()) {
-    case Molecule::LINEAR:
-      D3::vprod(force, dc.orb_pos(), torque[lfrag]);
-      // enforce orthogonality with the angular vector
-      torque[lfrag].orthogonalize(dc.ang_pos(lfrag));
-      break;
-    case Molecule::NONLINEAR:
-      D3::vprod(force, dc.orb_pos(), vtemp);
-      dc.lf2mf(lfrag, vtemp, torque[lfrag]);
-      break;
-    }
-    return ener_val;
-  }// atom
-
-  // torque on the small fragment
-  incr2 = 2. * _angl_incr;
+  if(Structure::fragment(sfrag).type() == Molecule::MONOATOMIC)
+    return;
+  
+  // rotations of the small fragment
   double cos_val = std::cos(_angl_incr) - 1.;
   double sin_val = std::sin(_angl_incr);
 
@@ -494,13 +618,19 @@ double Potential::Analytic::operator() (const Dynamic::Coordinates& dc, D3::Vect
       coord(i1, at + at_shift) += cos_val * dc.rel_pos(sfrag)[at][i1] + sin_val * dc.rel_pos(sfrag)[at][i2];
       coord(i2, at + at_shift) += cos_val * dc.rel_pos(sfrag)[at][i2] - sin_val * dc.rel_pos(sfrag)[at][i1];
     }
-    torque[sfrag][i] += _tot_ener(coord);
+
+    for(int j = 0; j < csize; ++j)
+      res[j * stride + g] = cp[j];
+    ++g;
 
     for(int at = 0; at < Structure::fragment(sfrag).size(); ++at) {
       coord(i1, at + at_shift) -= 2. * sin_val * dc.rel_pos(sfrag)[at][i2];
       coord(i2, at + at_shift) += 2. * sin_val * dc.rel_pos(sfrag)[at][i1];
     }
-    torque[sfrag][i] -= _tot_ener(coord);
+
+    for(int j = 0; j < csize; ++j)
+      res[j * stride + g] = cp[j];
+    ++g;
 
     if(!sfrag)
       for(int at = 0; at < Structure::fragment(sfrag).size(); ++at) {
@@ -512,10 +642,56 @@ double Potential::Analytic::operator() (const Dynamic::Coordinates& dc, D3::Vect
 	coord(i1, at + at_shift) = dc.rel_pos(sfrag)[at][i1] + dc.orb_pos(i1);
 	coord(i2, at + at_shift) = dc.rel_pos(sfrag)[at][i2] + dc.orb_pos(i2);
       }
+  }
+}
+
+double Potential::Analytic::_gradient (const Dynamic::Coordinates& dc, const double* ener, D3::Vector* torque) const
+{
+  D3::Vector& force = *torque;
+  torque += 1;
+
+  D3::Vector vtemp;
 
-    torque[sfrag][i] /= incr2;
+  const int sfrag = _small_fragment(); // small fragment
+  const int lfrag = 1 - sfrag;         // large fragment
+
+  // force on the small fragment
+  double incr2 = 2. * _dist_incr;
+
+  for(int i = 0; i < 3; ++i) {
+    force[i] = ener[2 * i + 1] - ener[2 * i + 2];
+	
+    if(sfrag)
+      force[i] /=  incr2;
+    else
+      force[i] /= -incr2;
   }
 
+  for(int frag = 0; frag < 2; ++frag)
+    torque[frag] = 0.;
+
+  // torque calculation
+  if (Structure::fragment(sfrag).type() == Molecule::MONOATOMIC) {// small fragment is an atom
+    switch(Structure::fragment(lfrag).type()) {
+    case Molecule::LINEAR:
+      D3::vprod(force, dc.orb_pos(), torque[lfrag]);
+      // enforce orthogonality with the angular vector
+      torque[lfrag].orthogonalize(dc.ang_pos(lfrag));
+      break;
+    case Molecule::NONLINEAR:
+      D3::vprod(force, dc.orb_pos(), vtemp);
+      dc.lf2mf(lfrag, vtemp, torque[lfrag]);
+      break;
+    }
+    return ener[0];
+  }// atom
+
+  // torque on the small fragment
+  incr2 = 2. * _angl_incr;
+
+  for(int i = 0; i < 3; ++i)
+    torque[sfrag][i] = (ener[2 * i + 7] - ener[2 * i + 8]) / incr2;
+
   // torque on the large fragment
   D3::vprod(force, dc.orb_pos(), vtemp);
   for(int i = 0; i < 3; ++i)
@@ -534,7 +710,135 @@ double Potential::Analytic::operator() (const Dynamic::Coordinates& dc, D3::Vect
       break;
     }
 
-  return ener_val;
+  return ener[0];
+}
+
+double Potential::Analytic::operator() (const Dynamic::Coordinates& dc, D3::Vector* torque) const 
+{
+  static const char funame [] = "Potential::Analytic::operator(): ";
+  
+  if(!torque) {
+    //
+    Array_2<double> coord(3, Structure::size());
+    _dc2cart(dc, coord);
+
+    return _tot_ener(coord);
+  }
+
+  // numerical gradient
+  const int dsize = _disp_size();
+
+  Array<double> coord(3 * Structure::size() * dsize);
+  Array<double> ener(dsize);
+  Array<int>    fail(dsize);
+
+  _displace(dc, coord, dsize);
+
+  _tot_ener(dsize, coord, ener, fail);
+
+  for(int g = 0; g < dsize; ++g)
+    if(fail[g])
+      throw Error::Run();
+
+  return _gradient(dc, ener, torque);
+}
+
+// the displaced geometries of all configurations go to the potential libraries at once
+//
+void Potential::Analytic::evaluate (int n, const double* coord, int stride, double* ener, double* force, int* fail) const
+{
+  const int csize = 3 * Structure::size();
+  const int dsize = force ? _disp_size() : 1;
+
+  std::vector<Dynamic::Coordinates> dc;
+  std::vector<int>                  member;
+
+  Array<double> pos(Dynamic::Coordinates::size());
+
+  for(int k = 0; k < n; ++k) {
+    //
+    fail[k] = 0;
+
+    for(int i = 0; i < pos.size(); ++i)
+      //
+      pos[i] = coord[i * stride + k];
+
+    try {
+      //
+      dc.push_back(Dynamic::Coordinates(pos));
+      member.push_back(k);
+    }
+    catch(Error::General) {
+      //
+      fail[k] = 1;
+    }
+  }
+
+  if(!member.size())
+    return;
+
+  const int gsize = member.size() * dsize;
+
+  Array<double> geom(csize * gsize);
+  Array<double> gener(gsize);
+  Array<int>    gfail(gsize);
+
+  Array_2<double> cart(3, Structure::size());
+
+  for(int m = 0; m < member.size(); ++m)
+    //
+    if(force) {
+      //
+      _displace(dc[m], (double*)geom + m * dsize, gsize);
+    }
+    else {
+      //
+      _dc2cart(dc[m], cart);
+
+      const double* cp = cart;
+
+      for(int i = 0; i < csize; ++i)
+	//
+	geom[i * gsize + m] = cp[i];
+    }
+
+  _tot_ener(gsize, geom, gener, gfail);
+
+  D3::Vector torque [3];
+
+  for(int m = 0; m < member.size(); ++m) {
+    //
+    const int k = member[m];
+
+    for(int g = m * dsize; g < (m + 1) * dsize; ++g)
+      //
+      if(gfail[g])
+	//
+	fail[k] = 1;
+
+    if(fail[k])
+      continue;
+
+    if(!force) {
+      //
+      ener[k] = gener[m];
+
+      continue;
+    }
+
+    try {
+      //
+      ener[k] = _gradient(dc[m], (const double*)gener + m * dsize, torque);
+
+      for(int j = 0; j < 9; ++j)
+	//
+	force[j * stride + k] = torque[j / 3][j % 3];
+    }
+    catch(Error::General) {
+      //
+      fail[k] = 1;
+    }
+  }
 }
 
 /*************************************************************************
@@ -608,6 +912,68 @@ double Potential::ChargeLinear::operator() (const Dynamic::Coordinates& dc, D3::
   return ener_val;
 }
 
+// the charge-linear molecule terms over the batch, the configurations in the inner loop
+//
+void Potential::ChargeLinear::evaluate (int n, const double* coord, int stride, double* ener, double* force, int* fail) const
+{
+  static const double c3 = 1./3.;
+
+  const double* rx = coord + Structure::orb_pos()   * stride;
+  const double* ry = rx + stride;
+  const double* rz = ry + stride;
+
+  const double* lx = coord + Structure::ang_pos(1) * stride;
+  const double* ly = lx + stride;
+  const double* lz = ly + stride;
+
+  for(int k = 0; k < n; ++k) {
+    //
+    const double r = std::sqrt(rx[k] * rx[k] + ry[k] * ry[k] + rz[k] * rz[k]);
+    const double l = std::sqrt(lx[k] * lx[k] + ly[k] * ly[k] + lz[k] * lz[k]);
+
+    fail[k] = r == 0. || l == 0.;
+
+    const double r1 = fail[k] ? 1. : 1. / r;
+    const double l1 = fail[k] ? 1. : 1. / l;
+
+    const double r2 = r1 * r1;
+    const double r3 = r2 * r1;
+    const double r4 = r3 * r1;
+    const double r5 = r4 * r1;
+
+    const double x = (rx[k] * lx[k] + ry[k] * ly[k] + rz[k] * lz[k]) * r1 * l1;
+
+    ener[k] = - _dipole * x * r2 + (0.75 * _quadrupole * r3  - 0.5 * _anisotropic_polarizability * r4)
+      * (x * x - c3) - 0.5 * _isotropic_polarizability * r4;
+
+    if(!force)
+      continue;
+
+    // -dV/dR and -dV/dX, X = cos(theta)
+    const double vr = - 2. * _dipole * x * r3 + (2.25 * _quadrupole * r4  - 2. * _anisotropic_polarizability * r5) 
+      * (x * x - c3) - 2. * _isotropic_polarizability * r5;
+
+    const double va = _dipole * r2 - (1.5 * _quadrupole * r3  - _anisotropic_polarizability * r4) * x;
+
+    const double fr = (vr - x * va * r1) * r1;
+    const double fl = va * r1 * l1;
+
+    force[k]              = fr * rx[k] + fl * lx[k];
+    force[stride + k]     = fr * ry[k] + fl * ly[k];
+    force[2 * stride + k] = fr * rz[k] + fl * lz[k];
+
+    force[3 * stride + k] = 0.;
+    force[4 * stride + k] = 0.;
+    force[5 * stride + k] = 0.;
+
+    const double tl = va * r1 * l1;
+
+    force[6 * stride + k] = tl * (ly[k] * rz[k] - lz[k] * ry[k]);
+    force[7 * stride + k] = tl * (lz[k] * rx[k] - lx[k] * rz[k]);
+    force[8 * stride + k] = tl * (lx[k] * ry[k] - ly[k] * rx[k]);
+  }
+}
+
 Potential::ChargeLinear::ChargeLinear (std::istream& from) 
   : _charge(1.), _dipole(0.), _quadrupole(0.), _isotropic_polarizability(0.), _anisotropic_polarizability(0.)
 {
@@ -1115,6 +1481,181 @@ Potential::ChargeNonlinear::ChargeNonlinear (std::istream& from)
     return ener_val;
   }
 
+// the dipoles are put into the laboratory frame member by member, the interaction terms are
+// then evaluated over the batch
+//
+void Potential::DipoleDipole::evaluate (int n, const double* coord, int stride, double* ener, double* force, int* fail) const
+{
+  static const char funame [] = "Potential::DipoleDipole::evaluate: ";
+
+  // laboratory frame dipoles and, for nonlinear fragments, the molecular frame orientations
+  std::vector<double> lfd [2];
+  std::vector<double> mfo [2];
+
+  D3::Matrix mat;
+  double     vtemp [3];
+
+  for(int k = 0; k < n; ++k)
+    //
+    fail[k] = 0;
+
+  for(int frag = 0; frag < 2; ++frag) {
+    //
+    lfd[frag].resize(3 * n);
+
+    const double* ang = coord + Structure::ang_pos(frag) * stride;
+
+    switch(Structure::fragment(frag).type()) {
+    case Molecule::LINEAR:
+      //
+      for(int k = 0; k < n; ++k) {
+	//
+	double dtemp = 0.;
+	for(int i = 0; i < 3; ++i)
+	  dtemp += ang[i * stride + k] * ang[i * stride + k];
+
+	if(dtemp == 0.) {
+	  fail[k] = 1;
+	  dtemp = 1.;
+	}
+	
+	dtemp = _dipole[frag][0] / std::sqrt(dtemp);
+
+	for(int i = 0; i < 3; ++i)
+	  lfd[frag][i * n + k] = dtemp * ang[i * stride + k];
+      }
+      break;
+
+    case Molecule::NONLINEAR:
+      //
+      mfo[frag].resize(9 * n);
+
+      for(int k = 0; k < n; ++k) {
+	//
+	double quat [4];
+	for(int i = 0; i < 4; ++i)
+	  quat[i] = ang[i * stride + k];
+
+	try {
+	  //
+	  quat2mat(quat, mat);
+	}
+	catch(Error::General) {
+	  //
+	  fail[k] = 1;
+	  mat = 0.;
+	}
+
+	D3::vprod(_dipole[frag], mat, vtemp);
+
+	for(int i = 0; i < 3; ++i) {
+	  //
+	  lfd[frag][i * n + k] = vtemp[i];
+
+	  for(int j = 0; j < 3; ++j)
+	    mfo[frag][(i * 3 + j) * n + k] = mat(i, j);
+	}
+      }
+      break;
+
+    default:
+      std::cerr << funame << "you are in trouble. Ha, ha, ha ...\n";
+      throw Error::Logic();
+    }
+  }
+
+  const double* rx = coord + Structure::orb_pos() * stride;
+  const double* ry = rx + stride;
+  const double* rz = ry + stride;
+
+  const double* d0x = &lfd[0][0];
+  const double* d0y = d0x + n;
+  const double* d0z = d0y + n;
+
+  const double* d1x = &lfd[1][0];
+  const double* d1y = d1x + n;
+  const double* d1z = d1y + n;
+
+  const double p0 = _polarizability[0];
+  const double p1 = _polarizability[1];
+
+  for(int k = 0; k < n; ++k) {
+    //
+    double r = std::sqrt(rx[k] * rx[k] + ry[k] * ry[k] + rz[k] * rz[k]);
+
+    if(r == 0.) {
+      fail[k] = 1;
+      r = 1.;
+    }
+
+    const double r2  = 1. / r / r ;
+    const double r3  = r2 / r;
+    const double r5  = r3 * r2;
+    const double r6  = r5 / r;
+    const double r7  = r6 / r;
+    const double r8  = r7 / r;
+    const double r10 = r8 * r2;
+
+    const double dr0 = rx[k] * d0x[k] + ry[k] * d0y[k] + rz[k] * d0z[k];
+    const double dr1 = rx[k] * d1x[k] + ry[k] * d1y[k] + rz[k] * d1z[k];
+    const double dd  = d0x[k] * d1x[k] + d0y[k] * d1y[k] + d0z[k] * d1z[k];
+
+    ener[k] = dd * r3 - 3. * dr0 * dr1 * r5 // dipole - dipole         term
+      - _dispersion * r6                    // dispersion              term
+      - 1.5 * (p0 * dr1 * dr1 + p1 * dr0 * dr0) * r8; // dipole - induced dipole term
+
+    if(!force)
+      continue;
+
+    // force
+    const double fr = -6. * _dispersion * r8 + 3. * dd * r5 - 15. * dr0 * dr1 * r7
+      - 12. * (dr0 * dr0 * p1 + dr1 * dr1 * p0) * r10;
+
+    const double c0 = 3. * dr1 * r5 + 3. * p1 * dr0 * r8;
+    const double c1 = 3. * dr0 * r5 + 3. * p0 * dr1 * r8;
+
+    force[k]              = fr * rx[k] + c0 * d0x[k] + c1 * d1x[k];
+    force[stride + k]     = fr * ry[k] + c0 * d0y[k] + c1 * d1y[k];
+    force[2 * stride + k] = fr * rz[k] + c0 * d0z[k] + c1 * d1z[k];
+
+    // ... and torques: d1 x d2 and d x r terms
+    const double ddx = d0y[k] * d1z[k] - d0z[k] * d1y[k];
+    const double ddy = d0z[k] * d1x[k] - d0x[k] * d1z[k];
+    const double ddz = d0x[k] * d1y[k] - d0y[k] * d1x[k];
+
+    force[3 * stride + k] = -r3 * ddx + c0 * (d0y[k] * rz[k] - d0z[k] * ry[k]);
+    force[4 * stride + k] = -r3 * ddy + c0 * (d0z[k] * rx[k] - d0x[k] * rz[k]);
+    force[5 * stride + k] = -r3 * ddz + c0 * (d0x[k] * ry[k] - d0y[k] * rx[k]);
+
+    force[6 * stride + k] =  r3 * ddx + c1 * (d1y[k] * rz[k] - d1z[k] * ry[k]);
+    force[7 * stride + k] =  r3 * ddy + c1 * (d1z[k] * rx[k] - d1x[k] * rz[k]);
+    force[8 * stride + k] =  r3 * ddz + c1 * (d1x[k] * ry[k] - d1y[k] * rx[k]);
+  }
+
+  if(!force)
+    return;
+
+  // for nonlinear fragments convert torques to their molecular frames
+  for(int frag = 0; frag < 2; ++frag)
+    //
+    if(Structure::fragment(frag).type() == Molecule::NONLINEAR) {
+      //
+      double* t = force + 3 * (frag + 1) * stride;
+
+      const double* m = &mfo[frag][0];
+
+      for(int k = 0; k < n; ++k) {
+	//
+	const double tx = t[k];
+	const double ty = t[stride + k];
+	const double tz = t[2 * stride + k];
+
+	for(int i = 0; i < 3; ++i)
+	  t[i * stride + k] = m[3 * i * n + k] * tx + m[(3 * i + 1) * n + k] * ty + m[(3 * i + 2) * n + k] * tz;
+      }
+    }
+}
+
 Potential::DipoleDipole::DipoleDipole (std::istream& from) 
 {
   static const char funame [] = "Potential::DipoleDipole::DipoleDipole: ";
@@ -20,6 +20,8 @@
 #include "io.hh"
 #include "system.hh"
 
+#include <mutex>
+
 namespace Potential {
 
   // potential types
@@ -40,6 +42,13 @@ namespace Potential {
     virtual double operator() (const Dynamic::Coordinates&, D3::Vector* force) const =0;
     virtual int    type       ()                                               const =0;
 
+    // batch of n configurations in the structure of arrays layout: the i-th coordinate of the
+    // k-th configuration at coord[i * stride + k], i < Dynamic::Coordinates::size(); the energies
+    // go to ener[k] and, if force is not null, the force and the torques, as in operator(),
+    // to force[j * stride + k], j < 9; fail[k] is nonzero if the calculation has failed
+    //
+    virtual void evaluate (int n, const double* coord, int stride, double* ener, double* force, int* fail) const;
+
     virtual ~Base () {}
   };
 
@@ -58,10 +67,15 @@ namespace Potential {
     operator  bool () const { return  _fun; }
     bool operator! () const { return !_fun; }
 
+    bool operator== (const Wrap& w) const { return _fun == w._fun; }
+    bool operator!= (const Wrap& w) const { return _fun != w._fun; }
+
     void   isinit () const ;
 
     double operator() (const Dynamic::Coordinates&, D3::Vector* =0) const ;
     int    type       ()                                            const ;
+
+    void evaluate (int n, const double* coord, int stride, double* ener, double* force, int* fail) const ;
   };
 
   inline void Wrap::isinit () const 
@@ -86,6 +100,12 @@ namespace Potential {
     return _fun->type();
   }
 
+  inline void Wrap::evaluate (int n, const double* coord, int stride, double* ener, double* force, int* fail) const 
+  {
+    isinit();
+    _fun->evaluate(n, coord, stride, ener, force, fail);
+  }
+
   // Low potential energy condition
   class Condition : public Dynamic::Condition 
   {
@@ -124,7 +144,7 @@ namespace Potential {
   {
     EnergyConverter                       _convert;
     ConstSharedPointer<HarmonicExpansion> _harmonic_expansion [2];
-    std::vector<Slatec::Spline>           _expansion_coefficient;
+    std::vector<Math::Spline>           _expansion_coefficient;
 
     double _dist_incr, _angl_incr;
 
@@ -139,28 +159,51 @@ namespace Potential {
   extern "C" {
     typedef double (*ener_t) (const double* coord, const double* rpar, const int* ipar, int& ifail);
     typedef void   (*init_t) (const char* data_file_name);
+
+    // n geometries, the i-th cartesian coordinate of the k-th geometry at coord[i * n + k],
+    // i < 3 * (number of atoms); ifail[k] is set to nonzero if the k-th energy has failed
+    typedef void (*batch_ener_t) (int n, const double* coord, const double* rpar, const int* ipar, 
+				  double* ener, int* ifail);
   }
 
   class Analytic : public Base
   {
     System::DynLib  _pot_libr;
     ener_t          _pot_ener;
+    batch_ener_t    _pot_batch;
     init_t          _pot_init;
     Array<double>   _pot_rpar;
     Array<int>      _pot_ipar;
 
     System::DynLib _corr_libr;
     ener_t         _corr_ener;
+    batch_ener_t   _corr_batch;
     init_t         _corr_init;
     Array<double>  _corr_rpar;
     Array<int>     _corr_ipar;
 
     double _dist_incr, _angl_incr; // cartesian & angular increments for numerical differentiation
 
+    // concurrent calls of the potential libraries are serialized unless they are thread safe
+    bool               _thread_safe;
+    mutable std::mutex _lock;
+
     static void _dc2cart (const Dynamic::Coordinates&, Array_2<double>&); // convert dc (my) to cartesian
 
     double _tot_ener (const double* coord) const ;
 
+    // energies of n geometries in the batch layout
+    void   _tot_ener (int n, const double* coord, double* ener, int* fail) const ;
+
+    // geometries needed for the numerical gradient, the reference one first: the i-th cartesian
+    // coordinate of the g-th geometry goes to coord[i * stride + g], g < _disp_size()
+    static int _small_fragment () ;
+    static int _disp_size      () ;
+    void       _displace       (const Dynamic::Coordinates&, double* coord, int stride) const;
+
+    // energy, force, and torques from the energies of the displaced geometries
+    double     _gradient       (const Dynamic::Coordinates&, const double* ener, D3::Vector* torque) const;
+
     // no copies
     Analytic (const Analytic&);
     Analytic& operator= (const Analytic&);
@@ -171,6 +214,8 @@ namespace Potential {
 
     double operator() (const Dynamic::Coordinates&, D3::Vector*) const ;
     int type () const { return ANALYTIC; }
+
+    void evaluate (int n, const double* coord, int stride, double* ener, double* force, int* fail) const;
   };
 
   // Multipole potential for a charge(1) and a linear(2) molecule
@@ -194,6 +239,8 @@ namespace Potential {
 
     double operator() (const Dynamic::Coordinates&, D3::Vector*) const ;
     int type () const { return CL; }
+
+    void evaluate (int n, const double* coord, int stride, double* ener, double* force, int* fail) const;
   };
 
   // Multipole potential for a charge(1) and a nonlinear(2) molecule
@@ -232,6 +279,8 @@ namespace Potential {
 
     double operator() (const Dynamic::Coordinates& dc, D3::Vector*) const ;
     int type () const { return DD; }
+
+    void evaluate (int n, const double* coord, int stride, double* ener, double* force, int* fail) const;
   };
 
 
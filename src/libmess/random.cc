@@ -18,58 +18,177 @@
 #include <cstdlib>
 #include <ctime>
 #include <iostream>
+#include <atomic>
 
 /****************************************************************
  ******************* Random Number Generators *******************
  ****************************************************************/
 
-void Random::init ()
+namespace Random {
+  //
+  std::atomic<uint64_t> _seed(20080101);
+
+  // seed generation: the thread streams are reinitialized when the seed changes
+  //
+  std::atomic<unsigned> _seed_generation(0);
+
+  // number of thread streams created for the current seed
+  //
+  std::atomic<uint64_t> _thread_count(0);
+}
+
+void Random::set_seed (uint64_t s)
 {
-  srand48(std::time(0));
+  _seed = s;
+
+  _thread_count = 0;
+
+  ++_seed_generation;
 }
 
-void Random::init (int i)
+uint64_t Random::seed ()
 {
-  srand48(i);
+  return _seed;
 }
 
-double Random::flat ()
+Random::Stream& Random::thread_stream ()
+{
+  thread_local Stream   stream;
+
+  thread_local unsigned generation = 0;
+
+  thread_local bool     isinit     = false;
+
+  const unsigned current = _seed_generation;
+
+  if(!isinit || generation != current) {
+    //
+    stream.init(_seed, _thread_count++);
+
+    generation = current;
+
+    isinit = true;
+  }
+
+  return stream;
+}
+
+/****************************************************************
+ *********************** Philox4x32-10 stream *******************
+ ****************************************************************/
+
+Random::Stream::Stream (uint64_t i)
+{
+  init(_seed, i);
+}
+
+void Random::Stream::init (uint64_t s, uint64_t i)
 {
-    return drand48 ();
+  _key[0]  = (uint32_t)s;
+  _key[1]  = (uint32_t)(s >> 32);
+  _index   = i;
+  _counter = 0;
+  _pos     = 4;
+}
+
+void Random::Stream::_next_block ()
+{
+  static const uint32_t mult [] = {0xD2511F53, 0xCD9E8D57};
+  static const uint32_t weyl [] = {0x9E3779B9, 0xBB67AE85};
+
+  uint32_t ctr [4] = {(uint32_t)_counter, (uint32_t)(_counter >> 32), (uint32_t)_index, (uint32_t)(_index >> 32)};
+
+  uint32_t key [2] = {_key[0], _key[1]};
+
+  for(int r = 0; r < 10; ++r) {
+    //
+    const uint64_t p0 = (uint64_t)mult[0] * ctr[0];
+    const uint64_t p1 = (uint64_t)mult[1] * ctr[2];
+
+    const uint32_t c1 = ctr[1];
+    const uint32_t c3 = ctr[3];
+
+    ctr[0] = (uint32_t)(p1 >> 32) ^ c1 ^ key[0];
+    ctr[1] = (uint32_t)p1;
+    ctr[2] = (uint32_t)(p0 >> 32) ^ c3 ^ key[1];
+    ctr[3] = (uint32_t)p0;
+
+    key[0] += weyl[0];
+    key[1] += weyl[1];
+  }
+
+  for(int i = 0; i < 4; ++i)
+    //
+    _block[i] = ctr[i];
+
+  ++_counter;
+
+  _pos = 0;
+}
+
+double Random::Stream::flat ()
+{
+  const uint64_t hi = _next() >> 5;
+  const uint64_t lo = _next() >> 6;
+
+  return (double)((hi << 26) | lo) * (1. / 9007199254740992.);
+}
+
+void Random::Stream::flat (double* res, int n)
+{
+  for(int i = 0; i < n; ++i)
+    //
+    res[i] = flat();
 }
 
 // normal distribution RNG
 //
-double Random::norm ()
+double Random::Stream::norm ()
 {
   double dtemp;
 
-  dtemp = Random::flat();
+  dtemp = flat();
 
   if(dtemp == 0.)
     //
     return 100.;
 
-  if(dtemp == 1.)
+  return std::sqrt(-2. * std::log(dtemp)) * std::cos(2. * M_PI * flat());
+}
+
+// both Box-Muller variates are used
+//
+void Random::Stream::norm (double* res, int n)
+{
+  double r, phi;
+
+  for(int i = 0; i < n; i += 2) {
     //
-    return 0.;
-  
-  return std::sqrt(-2. * std::log(dtemp)) * std::cos(2. * M_PI * Random::flat());
+    r   = std::sqrt(-2. * std::log(1. - flat()));
+
+    phi = 2. * M_PI * flat();
+
+    res[i] = r * std::cos(phi);
+
+    if(i + 1 < n)
+      //
+      res[i + 1] = r * std::sin(phi);
+  }
 }
 
-double Random::exp ()
+double Random::Stream::exp ()
 {// RNG for the distribution exp(-u**2/2)u*du
-  return std::sqrt(-2.0 * std::log(Random::flat()));
+  return std::sqrt(-2.0 * std::log(1. - flat()));
 }
 
-void Random::orient (double* vec, int dim)
+void Random::Stream::orient (double* vec, int dim)
 { // randomly orients vector _vec_ of the dimension _dim_ of unity length
   double norm, temp;
   do {
     norm = 0.0;
     for (int i = 0; i < dim; ++i)
       {
-	temp = 2.0 * Random::flat () - 1.0;
+	temp = 2.0 * flat () - 1.0;
 	norm += temp * temp;
 	vec[i] = temp;
       }
@@ -80,13 +199,13 @@ void Random::orient (double* vec, int dim)
     vec[i] /= norm;
 }
 
-double Random::vol (double* vec, int dim)
+double Random::Stream::vol (double* vec, int dim)
 { // random point inside the sphere of unity radius
   double norm, temp;
   do {
     norm = 0.0;
     for (int i = 0; i < dim; ++i) {
-      temp = 2.0 * Random::flat () - 1.0;
+      temp = 2.0 * flat () - 1.0;
       norm += temp * temp;
       vec[i] = temp;
     }
@@ -96,9 +215,9 @@ double Random::vol (double* vec, int dim)
 }
 
 // random point inside the spherical layer 
-void Random::spherical_layer (double* vec, int dim, double rmin, double rmax) 
+void Random::Stream::spherical_layer (double* vec, int dim, double rmin, double rmax) 
 { 
-  const char funame [] = "Random::spherical_layer: ";
+  const char funame [] = "Random::Stream::spherical_layer: ";
 
   if(rmin <= 0. || rmax <= 0. || rmin >= rmax || dim <= 0 || vec == 0) {
     std::cerr << funame << "out of range\n";
@@ -115,10 +234,53 @@ void Random::spherical_layer (double* vec, int dim, double rmin, double rmax)
   do {
     norm = 0.;
     for (double* it = vec; it != end; ++it) {
-      dtemp = (2. * Random::flat () - 1.) * rmax;
+      dtemp = (2. * flat () - 1.) * rmax;
       *it = dtemp;
       norm += dtemp * dtemp;
     }
   } while (norm < rmin2 || norm > rmax2);
 }
 
+/****************************************************************
+ ***************** Calling thread stream shortcuts **************
+ ****************************************************************/
+
+void Random::init ()
+{
+  set_seed(std::time(0));
+}
+
+void Random::init (int i)
+{
+  set_seed(i);
+}
+
+double Random::flat ()
+{
+  return thread_stream().flat();
+}
+
+double Random::norm ()
+{
+  return thread_stream().norm();
+}
+
+double Random::exp ()
+{
+  return thread_stream().exp();
+}
+
+void Random::orient (double* vec, int dim)
+{
+  thread_stream().orient(vec, dim);
+}
+
+double Random::vol (double* vec, int dim)
+{
+  return thread_stream().vol(vec, dim);
+}
+
+void Random::spherical_layer (double* vec, int dim, double rmin, double rmax) 
+{
+  thread_stream().spherical_layer(vec, dim, rmin, rmax);
+}
@@ -18,16 +18,113 @@
 
 #include "error.hh"
 
+#include <stdint.h>
+
 namespace Random {
 
+  // global seed; the stream with a given seed and stream index always generates
+  // the same sequence, independently of the thread it is used by
+  //
+  void     set_seed (uint64_t);
+  uint64_t seed     ();
+
+  /*****************************************************************************************
+   ************************** COUNTER-BASED RANDOM NUMBER STREAM ***************************
+   *****************************************************************************************/
+
+  // Philox4x32-10 generator: the n-th random block of the stream is the keyed bijection
+  // of the counter (n, stream index), so that the streams are independent, need no
+  // shared state, and can be skipped ahead at no cost; one stream per task (trajectory,
+  // sample, chunk) makes the parallel sampling reproducible for any number of threads
+  //
+  class Stream {
+    //
+    uint32_t _key [2];
+
+    uint64_t _index;
+
+    uint64_t _counter;
+
+    uint32_t _block [4];
+
+    int      _pos;
+
+    void _next_block ();
+
+    uint32_t _next () { if(_pos == 4) _next_block(); return _block[_pos++]; }
+
+  public:
+    //
+    // stream with the global seed
+    //
+    explicit Stream (uint64_t index = 0);
+
+    Stream (uint64_t seed, uint64_t index) { init(seed, index); }
+
+    void init (uint64_t seed, uint64_t index);
+
+    uint64_t index () const { return _index; }
+
+    // skip n random blocks (four 32-bit numbers each)
+    //
+    void skip (uint64_t n) { _counter += n; _pos = 4; }
+
+    // uniform distribution in [0, 1) with 53-bit resolution
+    //
+    double flat ();
+
+    // normal distribution
+    //
+    double norm ();
+
+    // distribution exp(-u**2/2)u*du
+    //
+    double exp  ();
+
+    void   orient (double*, int);
+    double vol    (double*, int);
+
+    void spherical_layer (double* vec, int dim, double rmin, double rmax);
+
+    // bulk generation
+    //
+    void flat (double*, int);
+    void norm (double*, int);
+  };
+
+  // stream of the calling thread used by the functions below: the first thread
+  // to use it gets stream index 0, so that serial runs are reproducible
+  //
+  Stream& thread_stream ();
+
+  // while in scope, the calling thread draws from the stream of the given task index,
+  // so that the task random numbers do not depend on the thread which runs it
+  //
+  class TaskStream {
+    //
+    Stream _save;
+
+    TaskStream            (const TaskStream&);
+    TaskStream& operator= (const TaskStream&);
+
+  public:
+    //
+    explicit TaskStream (uint64_t task) : _save(thread_stream()) { thread_stream().init(seed(), task); }
+
+    ~TaskStream () { thread_stream() = _save; }
+  };
+
+  // task indices start here not to overlap with the thread stream indices
+  //
+  const uint64_t task_base = (uint64_t)1 << 32;
+
   void   init      ();
   void   init      (int);
-  void   send_seed (int);
   double flat      ();             // rand_flat ();
   double norm      ();             // rand_norm ();
   double exp       ();             // rand_exp ();
   void   orient    (double*, int); // rand_orient (double*, int);
-  double vol       (double*, int); 
+  double vol       (double*, int);
 
   void spherical_layer (double* vec, int dim, double rmin, double rmax) ;
 }
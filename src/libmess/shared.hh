@@ -18,6 +18,7 @@
 
 #include "error.hh"
 #include <iostream>
+#include <atomic>
 
 /************************************************************************************
  ********************************* Shared Pointer ***********************************
@@ -31,7 +32,10 @@ class SharedPointer
 {
 private:
   T*   _pnt;
-  int* _count;
+
+  // the reference counter is atomic, so that the copies can be made and destroyed concurrently
+  //
+  std::atomic<int>* _count;
 
   void _delete_ref ();
   void _create_ref (const SharedPointer&);
@@ -39,7 +43,13 @@ private:
 public:
   explicit SharedPointer (T* =0);
   SharedPointer (const SharedPointer& s) { _create_ref(s); }
-  SharedPointer& operator= (const SharedPointer& s) { _delete_ref(); _create_ref(s); return *this; }
+  SharedPointer& operator= (const SharedPointer& s) { if(_count != s._count) { _delete_ref(); _create_ref(s); } return *this; }
+
+  // the reference is taken over from the temporary without touching the counter
+  //
+  SharedPointer (SharedPointer&& s) : _pnt(s._pnt), _count(s._count) { s._pnt = 0; s._count = 0; }
+  SharedPointer& operator= (SharedPointer&& s)
+  { if(this != &s) { _delete_ref(); _pnt = s._pnt; _count = s._count; s._pnt = 0; s._count = 0; } return *this; }
   ~SharedPointer () { _delete_ref(); }
 
   void init (T*) ;
@@ -68,9 +78,7 @@ void SharedPointer<T>::_delete_ref()
 {
   if(!_count)
     return;
-  if(*_count > 1)
-    --(*_count);
-  else {
+  if(!--(*_count)) {
     delete _pnt;
     delete _count;
   }
@@ -101,14 +109,14 @@ void SharedPointer<T>::init (T* p)
   }
 
   _pnt = p;
-  _count = new int(1);
+  _count = new std::atomic<int>(1);
 }
 
 template <typename T>
 SharedPointer<T>::SharedPointer (T* p) : _pnt(p)
 {
   if(p)
-    _count = new int(1);
+    _count = new std::atomic<int>(1);
   else
     _count = 0;
 }
@@ -144,7 +152,7 @@ class ConstSharedPointer
 {
 private:
   const T*   _pnt;
-  int* _count;
+  std::atomic<int>* _count;
 
   void _delete_ref ();
   void _create_ref (const ConstSharedPointer&);
@@ -154,10 +162,14 @@ public:
   explicit ConstSharedPointer (const T* =0);
   ConstSharedPointer (const ConstSharedPointer& s) { _create_ref(s); }
   ConstSharedPointer& operator= (const ConstSharedPointer& s) 
-  { _delete_ref(); _create_ref(s); return *this; }
+  { if(_count != s._count) { _delete_ref(); _create_ref(s); } return *this; }
   ConstSharedPointer (const SharedPointer<T>& s) { _create_ref(s); }
   ConstSharedPointer& operator= (const SharedPointer<T>& s) 
-  { _delete_ref(); _create_ref(s); return *this; }
+  { if(_count != s._count) { _delete_ref(); _create_ref(s); } return *this; }
+
+  ConstSharedPointer (ConstSharedPointer&& s) : _pnt(s._pnt), _count(s._count) { s._pnt = 0; s._count = 0; }
+  ConstSharedPointer& operator= (ConstSharedPointer&& s)
+  { if(this != &s) { _delete_ref(); _pnt = s._pnt; _count = s._count; s._pnt = 0; s._count = 0; } return *this; }
 
   ~ConstSharedPointer () { _delete_ref(); }
 
@@ -186,9 +198,7 @@ void ConstSharedPointer<T>::_delete_ref()
 {
   if(!_count)
     return;
-  if(*_count > 1)
-    --(*_count);
-  else {
+  if(!--(*_count)) {
     delete _pnt;
     delete _count;
   }
@@ -228,14 +238,14 @@ void ConstSharedPointer<T>::init (const T* p)
   }
 
   _pnt = p;
-  _count = new int(1);
+  _count = new std::atomic<int>(1);
 }
 
 template <typename T>
 ConstSharedPointer<T>::ConstSharedPointer (const T* p) : _pnt(p)
 {
   if(p)
-    _count = new int(1);
+    _count = new std::atomic<int>(1);
   else
     _count = 0;
 }
@@ -127,78 +127,3 @@ void Slatec::AdamSolver::run(double& x, double* y, double xout,
     throw Error::Run();
   }
 }
-
-
-/**********************************************************************************
- *                                  Spline fitting                                *
- *********************************************************************************/
-
-void Slatec::Spline::init (const double* x, const double* y, 
-		       int_t s) 
-{
-    const char funame [] = "Slatec::Spline::init: ";
-
-    if(_size) {
-      std::cerr << funame << "already initialized\n";
-      throw Error::Init();
-    }
-    
-    // check dimensions
-    if(s < 2) {
-	std::cerr << funame << "wrong array size: " << s << "\n";
-	throw Error::Init();
-    }
-
-    _size = s;
-
-    // check order
-    const double* const end = x + _size;
-    for(const double* p = x; p != end; ++p) {
-	if(p != x && *p <= _xmax) {
-	    std::cerr << funame << "x values are not in increasing order at i = " 
-		      << p - x << "\n";
-	    throw Error::Init();
-	}
-	_xmax = *p;
-    }
-
-    _xmin = *x;
-    _ymin = *y;
-    _ymax = *(y + _size - 1);
-
-    // initialization
-    _inbv = 1;
-    _dim = _size + 2;
-    _kn.resize(_dim + 4);
-    _bc.resize(_dim);
-    Array<double> work(5 * _dim);
-
-    int_t n, k;
-    dbint4_(x, y, _size, 2, 2, 0., 0., 1, 
-	     _kn, _bc, n, k, work);
-
-    if (n != _dim || k != 4) {
-	std::cerr << funame << "slatec dbint4 failed\n";
-	throw Error::Init();
-    }
-}
-
-double Slatec::Spline::operator()(double x, int_t drv) const 
-{
-    const char funame [] = "Slatec::Spline::fit: ";
-
-    if(!_size) {
-      std::cerr << funame << "not initialized\n";
-      throw Error::Init();
-    }
-
-    static double work[12];
-    if(x < _xmin || x > _xmax) {
-	std::cerr << funame << " x is out of range: xmin = " 
-		  << _xmin   << ", x = " << x << ", xmax = " 
-		  << _xmax << "\n";
-	throw Error::Range();
-    }
-
-    return dbvalu_(_kn, _bc, _dim, 4, drv, x, _inbv, work);
-}
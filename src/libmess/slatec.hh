@@ -55,46 +55,6 @@ namespace Slatec {
     void run(double& x, double* y, double xout, void* param = 0, Mode mode =CONTINUE) ; 
   };
 
-  /********************************************************************************
-   *                              Spline fitting                                  *
-   *******************************************************************************/
-
-  class Spline
-  {
-    int_t _size;
-
-    int_t         _dim;
-    Array<double> _kn;   // spline knots
-    Array<double> _bc;   // spline coefficients
-    mutable int_t _inbv; // slatec internal parameter
-
-    double _xmax;
-    double _xmin;
-    double _ymin;
-    double _ymax;
-
-    //Spline (const Spline&);
-    //Spline& operator= (const Spline&);
-
-  public:
-
-    Spline () : _size(0) {}
-    void init (const double*, const double*, int_t) ;
-    Spline (const double* x, const double* y, int_t n)  : _size(0) { init(x, y, n); }
-
-    int_t size () const { return _size; }
-
-    double arg_min () const { return _xmin; }
-    double arg_max () const { return _xmax; }
-    double fun_min () const { return _ymin; }
-    double fun_max () const { return _ymax; }
-    
-    ~Spline () {}
-
-    // evaluate i-th derivative at x
-    double operator() (double, int_t =0) const ; 
-  };
-
 } // Slatec
 
 #endif
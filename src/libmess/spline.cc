@@ -0,0 +1,308 @@
+/*
+        Chemical Kinetics and Dynamics Library
+        Copyright (C) 2008-2013, Yuri Georgievski <ygeorgi@anl.gov>
+
+        This library is free software; you can redistribute it and/or
+        modify it under the terms of the GNU Library General Public
+        License as published by the Free Software Foundation; either
+        version 2 of the License, or (at your option) any later version.
+
+        This library is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+        Library General Public License for more details.
+*/
+
+#include "spline.hh"
+
+#include <iostream>
+#include <algorithm>
+
+void Math::Spline::init (const double* x, const double* y, int n)
+{
+  const char funame [] = "Math::Spline::init: ";
+
+  if(_x.size()) {
+    std::cerr << funame << "already initialized\n";
+    throw Error::Init();
+  }
+
+  if(n < 2) {
+    std::cerr << funame << "wrong array size: " << n << "\n";
+    throw Error::Init();
+  }
+
+  for(int i = 1; i < n; ++i)
+    if(x[i] <= x[i - 1]) {
+      std::cerr << funame << "x values are not in increasing order at i = " << i << "\n";
+      throw Error::Init();
+    }
+
+  // second derivatives at the knots: tridiagonal system with zero end values
+  //
+  std::vector<double> m(n), diag(n), rhs(n);
+
+  for(int i = 1; i < n - 1; ++i) {
+    //
+    const double h0 = x[i] - x[i - 1];
+    const double h1 = x[i + 1] - x[i];
+
+    diag[i] = 2. * (h0 + h1);
+
+    rhs[i]  = 6. * ((y[i + 1] - y[i]) / h1 - (y[i] - y[i - 1]) / h0);
+  }
+
+  // forward elimination
+  //
+  for(int i = 2; i < n - 1; ++i) {
+    //
+    const double h0 = x[i] - x[i - 1];
+
+    const double f = h0 / diag[i - 1];
+
+    diag[i] -= f * h0;
+
+    rhs[i]  -= f * rhs[i - 1];
+  }
+
+  // back substitution
+  //
+  for(int i = n - 2; i > 0; --i)
+    //
+    m[i] = (rhs[i] - (x[i + 1] - x[i]) * m[i + 1]) / diag[i];
+
+  _x.assign(x, x + n);
+
+  _coef.resize(4 * n);
+
+  for(int i = 0; i < n - 1; ++i) {
+    //
+    const double h = x[i + 1] - x[i];
+
+    double* c = &_coef[4 * i];
+
+    c[0] = y[i];
+    c[1] = (y[i + 1] - y[i]) / h - h * (2. * m[i] + m[i + 1]) / 6.;
+    c[2] = m[i] / 2.;
+    c[3] = (m[i + 1] - m[i]) / h / 6.;
+  }
+
+  // last knot value
+  //
+  double* c = &_coef[4 * (n - 1)];
+
+  c[0] = y[n - 1];
+  c[1] = c[2] = c[3] = 0.;
+}
+
+double Math::Spline::fun_max () const
+{
+  return _coef[4 * (size() - 1)];
+}
+
+// interval containing x: the right one at the inner knots and the last one at the right end
+//
+int Math::Spline::_interval (double x) const
+{
+  int res = std::upper_bound(_x.begin(), _x.end(), x) - _x.begin() - 1;
+
+  if(res > size() - 2)
+    //
+    return size() - 2;
+
+  if(res < 0)
+    //
+    return 0;
+
+  return res;
+}
+
+double Math::Spline::_value (int i, double t, int drv) const
+{
+  const double* c = &_coef[4 * i];
+
+  switch(drv) {
+    //
+  case 0:
+    //
+    return c[0] + t * (c[1] + t * (c[2] + t * c[3]));
+
+  case 1:
+    //
+    return c[1] + t * (2. * c[2] + t * 3. * c[3]);
+
+  case 2:
+    //
+    return 2. * c[2] + 6. * c[3] * t;
+
+  case 3:
+    //
+    return 6. * c[3];
+
+  default:
+    //
+    return 0.;
+  }
+}
+
+double Math::Spline::operator() (double x, int drv) const
+{
+  const char funame [] = "Math::Spline::operator(): ";
+
+  if(!size()) {
+    std::cerr << funame << "not initialized\n";
+    throw Error::Init();
+  }
+
+  if(x < arg_min() || x > arg_max()) {
+    std::cerr << funame << " x is out of range: xmin = " << arg_min() << ", x = " << x << ", xmax = " << arg_max() << "\n";
+    throw Error::Range();
+  }
+
+  if(drv < 0) {
+    std::cerr << funame << "negative derivative order: " << drv << "\n";
+    throw Error::Range();
+  }
+
+  const int i = _interval(x);
+
+  return _value(i, x - _x[i], drv);
+}
+
+void Math::Spline::evaluate (double xmin, double step, int n, double* res, int drv) const
+{
+  const char funame [] = "Math::Spline::evaluate: ";
+
+  if(!size()) {
+    std::cerr << funame << "not initialized\n";
+    throw Error::Init();
+  }
+
+  if(n <= 0)
+    //
+    return;
+
+  if(step <= 0. && n > 1) {
+    std::cerr << funame << "nonpositive step: " << step << "\n";
+    throw Error::Range();
+  }
+
+  const double xmax = xmin + (double)(n - 1) * step;
+
+  if(xmin < arg_min() || xmax > arg_max()) {
+    std::cerr << funame << "grid is out of range: xmin = " << arg_min() << ", grid = [" << xmin << ", " << xmax
+	      << "], xmax = " << arg_max() << "\n";
+    throw Error::Range();
+  }
+
+  if(drv < 0) {
+    std::cerr << funame << "negative derivative order: " << drv << "\n";
+    throw Error::Range();
+  }
+
+  // the grid points are processed interval by interval
+  //
+  int k = 0;
+
+  int i = _interval(xmin);
+
+  while(k < n) {
+    //
+    // last grid point in the interval
+    //
+    int kmax = n;
+
+    if(i < size() - 2) {
+      //
+      kmax = (int)((_x[i + 1] - xmin) / step);
+
+      // grid points at the knot belong to the right interval
+      //
+      while(kmax >= k && xmin + (double)kmax * step >= _x[i + 1])
+	--kmax;
+
+      ++kmax;
+
+      if(kmax > n)
+	kmax = n;
+    }
+
+    const double x0 = _x[i];
+
+    const double* c = &_coef[4 * i];
+
+    switch(drv) {
+      //
+    case 0:
+      //
+      for(int j = k; j < kmax; ++j) {
+	//
+	const double t = xmin + (double)j * step - x0;
+
+	res[j] = c[0] + t * (c[1] + t * (c[2] + t * c[3]));
+      }
+
+      break;
+
+    default:
+      //
+      for(int j = k; j < kmax; ++j)
+	//
+	res[j] = _value(i, xmin + (double)j * step - x0, drv);
+    }
+
+    k = kmax;
+
+    ++i;
+  }
+}
+
+void Math::Spline::evaluate (const double* x, int n, double* res, int drv) const
+{
+  const char funame [] = "Math::Spline::evaluate: ";
+
+  if(!size()) {
+    std::cerr << funame << "not initialized\n";
+    throw Error::Init();
+  }
+
+  if(n <= 0)
+    //
+    return;
+
+  if(drv < 0) {
+    std::cerr << funame << "negative derivative order: " << drv << "\n";
+    throw Error::Range();
+  }
+
+  // the points are processed in increasing order
+  //
+  const int dir = x[n - 1] < x[0] ? -1 : 1;
+
+  int j = dir > 0 ? 0 : n - 1;
+
+  const double xmin = x[j];
+  const double xmax = x[n - 1 - j];
+
+  if(xmin < arg_min() || xmax > arg_max()) {
+    std::cerr << funame << "points are out of range: xmin = " << arg_min() << ", points = [" << xmin << ", " << xmax
+	      << "], xmax = " << arg_max() << "\n";
+    throw Error::Range();
+  }
+
+  int i = _interval(xmin);
+
+  for(int k = 0; k < n; ++k, j += dir) {
+    //
+    if(k && x[j] < x[j - dir]) {
+      std::cerr << funame << "points are not ordered\n";
+      throw Error::Range();
+    }
+
+    while(i < size() - 2 && x[j] >= _x[i + 1])
+      //
+      ++i;
+
+    res[j] = _value(i, x[j] - _x[i], drv);
+  }
+}
@@ -0,0 +1,75 @@
+/*
+        Chemical Kinetics and Dynamics Library
+        Copyright (C) 2008-2013, Yuri Georgievski <ygeorgi@anl.gov>
+
+        This library is free software; you can redistribute it and/or
+        modify it under the terms of the GNU Library General Public
+        License as published by the Free Software Foundation; either
+        version 2 of the License, or (at your option) any later version.
+
+        This library is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+        Library General Public License for more details.
+*/
+
+#ifndef SPLINE_HH
+#define SPLINE_HH
+
+#include <vector>
+
+#include "error.hh"
+
+/********************************************************************************************
+ * Cubic spline interpolation with zero second derivatives at the ends: the same fit as the
+ * former slatec dbint4 B-spline (knots at the data points, natural end conditions), kept as
+ * the piecewise polynomial coefficients; the evaluation has no internal state and is safe
+ * to call from several threads
+ ********************************************************************************************/
+
+namespace Math {
+
+  class Spline {
+    //
+    // knots
+    //
+    std::vector<double> _x;
+
+    // polynomial coefficients for each interval: y = c0 + c1 * t + c2 * t^2 + c3 * t^3, t = x - x_i
+    //
+    std::vector<double> _coef;
+
+    int _interval (double x) const;
+
+    double _value (int i, double t, int drv) const;
+
+  public:
+    //
+    Spline () {}
+
+    Spline (const double* x, const double* y, int n) { init(x, y, n); }
+
+    void init (const double* x, const double* y, int n) ;
+
+    int size () const { return _x.size(); }
+
+    double arg_min () const { return _x.front(); }
+    double arg_max () const { return _x.back(); }
+    double fun_min () const { return _coef[0]; }
+    double fun_max () const;
+
+    // evaluate drv-th derivative at x
+    //
+    double operator() (double x, int drv = 0) const ;
+
+    // evaluate drv-th derivative on the uniform grid x_k = xmin + k * step, k = 0, ..., n - 1
+    //
+    void evaluate (double xmin, double step, int n, double* res, int drv = 0) const ;
+
+    // evaluate drv-th derivative at the ordered (increasing or decreasing) points
+    //
+    void evaluate (const double* x, int n, double* res, int drv = 0) const ;
+  };
+}
+
+#endif
@@ -28,6 +28,7 @@
 #include <cerrno>
 #include <cstdlib>
 #include <dlfcn.h>
+#include <sys/mman.h>
 
 #include <string>
 #include <vector>
@@ -70,6 +71,31 @@ int System::file_copy(const char* old_fname, const char* new_fname)
   return 0;
 }
 
+// append data to file
+int System::file_append(const char* fname, const char* data, size_t size)
+{
+    int fd = open(fname, O_WRONLY | O_CREAT | O_APPEND, 
+		  S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if(fd < 0)
+	return 1;
+
+    while(size) {
+	ssize_t count = write(fd, data, size);
+	if(count < 0) {
+	    if(errno == EINTR)
+		continue;
+	    close(fd);
+	    return -1;
+	}
+	data += count;
+	size -= count;
+    }
+
+    if(close(fd))
+	return -1;
+    return 0;
+}
+
 /************************************************************************
  **************         External call      ******************************
  ************************************************************************/
@@ -330,3 +356,56 @@ void* System::DynLib::member (const std::string& sym)
     return res;
 }
 
+/*********************************************************************************************
+ *                                  Read-only Memory-Mapped File                             *
+ ********************************************************************************************/
+
+void System::MappedFile::open (const std::string& file)
+{
+    const char funame [] = "System::MappedFile::open: ";
+
+    close();
+
+    int fd = ::open(file.c_str(), O_RDONLY);
+    if(fd < 0) {
+	std::cerr << funame << "cannot open " << file << ": " << std::strerror(errno) << "\n";
+	throw Error::File();
+    }
+
+    struct stat file_stat;
+    if(fstat(fd, &file_stat)) {
+	std::cerr << funame << "cannot stat " << file << ": " << std::strerror(errno) << "\n";
+	::close(fd);
+	throw Error::File();
+    }
+
+    if(!file_stat.st_size) {
+	std::cerr << funame << file << " is empty\n";
+	::close(fd);
+	throw Error::File();
+    }
+
+    void* data = mmap(0, file_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+    // the mapping stays valid after the descriptor is closed
+    ::close(fd);
+
+    if(data == MAP_FAILED) {
+	std::cerr << funame << "cannot map " << file << ": " << std::strerror(errno) << "\n";
+	throw Error::File();
+    }
+
+    _data = data;
+    _size = file_stat.st_size;
+}
+
+void System::MappedFile::close ()
+{
+    if(!_data)
+	return;
+
+    munmap(_data, _size);
+
+    _data = 0;
+    _size = 0;
+}
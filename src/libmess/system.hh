@@ -30,6 +30,9 @@ namespace System {
     // file copy
     int file_copy(const char*, const char*);
 
+    // appends the data to the file in one write, so that the concurrent appends do not interleave
+    int file_append(const char*, const char*, size_t);
+
     /**********************************************************************
      * call to external executable (substitute for system());             *
      * list of arguments in call_exe() should be terminated by 0 pointer  *
@@ -148,6 +151,31 @@ namespace System {
 	    ++(*_count); 
     }
  
+    /*********************************************************************************************
+     *                                  Read-only Memory-Mapped File                             *
+     ********************************************************************************************/
+
+    class MappedFile {
+	void*  _data;
+	size_t _size;
+
+	MappedFile (const MappedFile&);
+	MappedFile& operator= (const MappedFile&);
+
+    public:
+	MappedFile () : _data(0), _size(0) {}
+	explicit MappedFile (const std::string& file) : _data(0), _size(0) { open(file); }
+	~MappedFile () { close(); }
+
+	void open (const std::string&) ;
+	void close ();
+
+	bool isopen () const { return _data; }
+
+	const void* data () const { return _data; }
+	size_t      size () const { return _size; }
+    };
+
 }// System
 
 #endif
@@ -17,151 +17,275 @@
 #include "units.hh"
 
 namespace Trajectory {
-  double Propagator::step = 100;
+  double        Propagator::step   = 100;
+  Ode::method_t Propagator::method = Ode::RUNGE_KUTTA;
   //Flags Propagator::flags;
   //Dynamic::CCP fail_condition;
 }
 
-// dvd calculator
-extern "C" void Trajectory::set_dvd (const double& time, const double* dv, double* dvd, 
-				     void*, void* par) 
-{
-  DvdPar& dvd_par = *static_cast<DvdPar*>(par);
-
-  // Comulative force acting on a second fragment
-  // and Torques on each fragment: This can be either 
-  // laboratory frame torque for a linear fragment or
-  // molecular  frame torque for a nonlinear fragment
-  D3::Vector torque [3]; 
-  Dynamic::Coordinates dc(dv);
-
-  try {
-      // energies, forces and torques
-      dvd_par.ener = dvd_par.pot(dc, torque);
-  }
-  catch (Error::General) {
-    longjmp(dvd_par.jmp, 1);
+namespace {
+  //
+  // dynamical variables derivatives of the trajectories batch
+  //
+  class BatchDvd : public Ode::BatchRhs {
+    //
+    const std::vector<Potential::Wrap>& _pot;
+
+    Array<double> _dv;
+    Array<double> _dvd;
+
+    // coordinates, energies, forces and torques, and failures of the members
+    // sharing the potential, in the potential batch layout
+    std::vector<double> _pos;
+    std::vector<double> _ener;
+    std::vector<double> _force;
+    std::vector<int>    _fail;
+
+  public:
+    //
+    explicit BatchDvd (const std::vector<Potential::Wrap>& pot) 
+      : _pot(pot), _dv(Structure::dv_size()), _dvd(Structure::dv_size()) {}
+
+    void operator() (const double*, const double* y, double* dydt, int stride,
+		     const std::vector<int>& member, std::vector<int>& fail);
+  };
+
+  void BatchDvd::operator() (const double*, const double* y, double* dydt, int stride,
+			     const std::vector<int>& member, std::vector<int>& fail)
+  {
+    const int pos_size = Structure::pos_size();
+
+    std::vector<bool> done(member.size(), false);
+
+    std::vector<int> group;
+
+    for(int m0 = 0; m0 < member.size(); ++m0) {
+      //
+      if(done[m0])
+	continue;
+
+      // members with the same potential
+      group.clear();
+      for(int m = m0; m < member.size(); ++m)
+	//
+	if(!done[m] && _pot[member[m]] == _pot[member[m0]]) {
+	  //
+	  group.push_back(member[m]);
+	  done[m] = true;
+	}
+
+      const int n = group.size();
+
+      _pos.resize(pos_size * n);
+      _ener.resize(n);
+      _force.resize(9 * n);
+      _fail.resize(n);
+
+      for(int i = 0; i < pos_size; ++i)
+	//
+	for(int g = 0; g < n; ++g)
+	  //
+	  _pos[i * n + g] = y[i * stride + group[g]];
+
+      // Comulative force acting on a second fragment
+      // and Torques on each fragment: This can be either 
+      // laboratory frame torque for a linear fragment or
+      // molecular  frame torque for a nonlinear fragment
+      _pot[group[0]].evaluate(n, &_pos[0], n, &_ener[0], &_force[0], &_fail[0]);
+
+      D3::Vector torque [3]; 
+
+      for(int g = 0; g < n; ++g) {
+	//
+	const int k = group[g];
+
+	if(_fail[g]) {
+	  //
+	  fail.push_back(k);
+
+	  continue;
+	}
+
+	for(int j = 0; j < 9; ++j)
+	  //
+	  torque[j / 3][j % 3] = _force[j * n + g];
+
+	for(int i = 0; i < _dv.size(); ++i)
+	  //
+	  _dv[i] = y[i * stride + k];
+
+	// dynamic variables derivatives
+	Dynamic::set_dvd(torque, _dv, _dvd);
+
+	for(int i = 0; i < _dvd.size(); ++i)
+	  //
+	  dydt[i * stride + k] = _dvd[i];
+      }
+    }
   }
-  // dynamic variables derivatives
-  Dynamic::set_dvd(torque, dv, dvd);
+}
+
+Trajectory::status_t Trajectory::Propagator::run (Dynamic::CCP stop, const Dynamic::Classifier& sort) 
+{
+  std::vector<Propagator*>  prop(1, this);
+  std::vector<Dynamic::CCP> cond(1, stop);
+  std::vector<status_t>     stat;
+
+  Trajectory::run(prop, cond, sort, stat);
 
-  // something else
-  // ...
+  return stat[0];
 }
 
-void Trajectory::Propagator::run (Dynamic::CCP stop, const Dynamic::Classifier& sort) 
+void Trajectory::run (const std::vector<Propagator*>& prop, const std::vector<Dynamic::CCP>& stop,
+		      const Dynamic::Classifier& sort, std::vector<status_t>& stat) 
 {
-  const char funame [] = "Trajectory::Propagator::run: ";
+  const char funame [] = "Trajectory::run: ";
 
   double dtemp;
   int itemp;
   D3::Vector vtemp;
-	
-  // Long jump facility to transfer failure information 
-  // between the dvd calculator and calling function
-  DvdPar dvd_par;
-  dvd_par.pot = _pot;
-
-  if(setjmp(dvd_par.jmp)) {
-    //std::cerr << funame << "potential calculation failed\n"; 
-    throw PotentialFailure();
+
+  if(stop.size() != prop.size()) {
+    std::cerr << funame << "stop conditions and trajectories numbers mismatch\n";
+    throw Error::Range();
   }
 
-  // dynamic variables
-  Array<double> dv(size());
-
-  put(dv);
-  Mode mode = RESTART;
-
-  double timeout;
-  int adjust_count = 0;
-  while(1) {// main cycle
-
-    switch(_dir) {
-    case FORWARD:
-      timeout = _time + step;
-      break;
-    case BACKWARD:
-      timeout = _time - step;
-      break;
-    default:
+  stat.resize(prop.size());
+
+  if(!prop.size())
+    return;
+
+  for(int t = 0; t < prop.size(); ++t)
+    if(prop[t]->_dir != FORWARD && prop[t]->_dir != BACKWARD) {
       std::cerr << funame << "wrong case\n";
       throw Error::Logic();
     }
 
-    try {
-      AdamSolver::run(_time, dv, timeout, static_cast<void*>(&dvd_par), mode);
-    }
-    catch(Error::General) {
-      throw RunFailure();
-    }
+  // dynamic variables
+  Array<double> dv(Dynamic::Vars::size());
+
+  std::vector<Potential::Wrap> pot(prop.size());
+
+  Ode::BatchSolver solver(dv.size(), prop.size(), Propagator::method);
+
+  for(int t = 0; t < prop.size(); ++t) {
+    //
+    pot[t] = prop[t]->_pot;
+
+    prop[t]->put(dv);
+
+    solver.set(t, prop[t]->_time, dv, prop[t]->rel_tol, prop[t]->abs_tol);
+  }
+
+  BatchDvd dvd(pot);
+
+  std::vector<double> timeout(prop.size());
+  std::vector<int>    adjust_count(prop.size());
+
+  int run_num = prop.size();
+
+  while(run_num) {// main cycle
 
-    // get dynamical variables data and normalize
-    get(dv);
+    for(int t = 0; t < prop.size(); ++t)
+      if(solver.is_run(t))
+	timeout[t] = prop[t]->_dir == FORWARD ? prop[t]->_time + Propagator::step : prop[t]->_time - Propagator::step;
 
-    // checking orthogonality of angular velocity to the molecular axis 
-    // for linear fragments  and normalization of the angular vectors
-    // for all nonatomic fragments
+    solver.advance(dvd, &timeout[0]);
 
-    bool need_adjustment = false;
-    for(int frag = 0; frag < 2; ++frag) {// fragment cycle
-      if(Structure::fragment(frag).type() == Molecule::MONOATOMIC)
+    for(int t = 0; t < prop.size(); ++t) {// trajectory cycle
+      //
+      if(solver.status(t) == Ode::IDLE)
 	continue;
 
-      if(length(frag) > 2. || length(frag) < 0.5) {
-	std::cerr << funame << "WARNING: length of " << frag << "-th fragment is not normalized\n";
-	need_adjustment = true;
+      if(solver.status(t) != Ode::RUN) {
+	//
+	stat[t] = solver.status(t) == Ode::RHS_FAIL ? POTENTIAL_FAILURE : RUN_FAILURE;
+
+	solver.stop(t);
+	--run_num;
+	continue;
       }
 
-      if(Structure::fragment(frag).type() == Molecule::LINEAR) {
-	// velocity projection
-	dtemp = vdot(ang_pos(frag), ang_vel(frag), 3);
-	dtemp = dtemp > 0. ? dtemp : -dtemp;
+      Propagator& p = *prop[t];
+
+      p._time = solver.time(t);
+
+      // get dynamical variables data and normalize
+      solver.get(t, dv);
+      p.get(dv);
 
-	// checking if velocity projection on the molecular axis does exceed the calculation error
-	itemp = Structure::pos_size() + Structure::ang_vel(frag);
-	double avl = vlength(ang_vel(frag), 3);
-	if(dtemp > abs_tol[itemp] + rel_tol[itemp] * avl) {
-	  std::cerr << funame << "WARNING: angular velocity of the " << frag 
-		    << "-th fragment is not orthogonal, angle = "
-		    << dtemp / avl / length(frag) << " rad, adjusting " << ++adjust_count << " time\n";
+      // checking orthogonality of angular velocity to the molecular axis 
+      // for linear fragments  and normalization of the angular vectors
+      // for all nonatomic fragments
 
-	  orthogonalize(ang_vel(frag), ang_pos(frag), 3);
+      bool need_adjustment = false;
+      for(int frag = 0; frag < 2; ++frag) {// fragment cycle
+	if(Structure::fragment(frag).type() == Molecule::MONOATOMIC)
+	  continue;
+
+	if(p.length(frag) > 2. || p.length(frag) < 0.5) {
+	  std::cerr << funame << "WARNING: length of " << frag << "-th fragment is not normalized\n";
 	  need_adjustment = true;
 	}
+
+	if(Structure::fragment(frag).type() == Molecule::LINEAR) {
+	  // velocity projection
+	  dtemp = vdot(p.ang_pos(frag), p.ang_vel(frag), 3);
+	  dtemp = dtemp > 0. ? dtemp : -dtemp;
+
+	  // checking if velocity projection on the molecular axis does exceed the calculation error
+	  itemp = Structure::pos_size() + Structure::ang_vel(frag);
+	  double avl = vlength(p.ang_vel(frag), 3);
+	  if(dtemp > p.abs_tol[itemp] + p.rel_tol[itemp] * avl) {
+	    std::cerr << funame << "WARNING: angular velocity of the " << frag 
+		      << "-th fragment is not orthogonal, angle = "
+		      << dtemp / avl / p.length(frag) << " rad, adjusting " << ++adjust_count[t] << " time\n";
+
+	    orthogonalize(p.ang_vel(frag), p.ang_pos(frag), 3);
+	    need_adjustment = true;
+	  }
+	}
+	// ...
+      }// fragment cycle
+
+      // restart the integration
+      if(need_adjustment) { 
+	p.put(dv);
+	solver.set(t, p._time, dv, p.rel_tol, p.abs_tol);
       }
+
+      /*	
+      // do some output with the flags
       // ...
-    }// fragment cycle
+	
+      // run watch tests
+      for(int i = 0; i < watch.size(); ++i)
+      watch[i].test(*this);
 
-    if(need_adjustment) { 
-      put(dv);
-      mode = RESTART;
-    }
-    else
-      mode = CONTINUE;
+      // execute registered actions
+      for(int i = 0; i < act.size(); ++i)
+      act[i]->execute(*this);
+      */
 
-    /*	
-    // do some output with the flags
-    // ...
-	
-    // run watch tests
-    for(int i = 0; i < watch.size(); ++i)
-    watch[i].test(*this);
-
-    // execute registered actions
-    for(int i = 0; i < act.size(); ++i)
-    act[i]->execute(*this);
-    */
-
-    // stop condition
-    if(stop->test(*this)) {
-      _spec = sort.classify(*this);
-      _ener = total_kinetic_energy() + _pot(*this);
-      return;
-    }
+      // stop condition
+      if(stop[t]->test(p)) {
+	p._spec = sort.classify(p);
+	p._ener = p.total_kinetic_energy() + p._pot(p);
 
-    // exclude region
-    if(Dynamic::exclude_region && Dynamic::exclude_region->test(*this))
-      throw ExcludeRegionHit();
-  }
+	stat[t] = DONE;
+
+	solver.stop(t);
+	--run_num;
+	continue;
+      }
+
+      // exclude region
+      if(Dynamic::exclude_region && Dynamic::exclude_region->test(p)) {
+	stat[t] = EXCLUDE_REGION_HIT;
+
+	solver.stop(t);
+	--run_num;
+      }
+    }// trajectory cycle
+  }// main cycle
 }
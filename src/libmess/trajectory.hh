@@ -17,30 +17,23 @@
 #define TRAJECTORY_HH
 
 #include "dynamic.hh"
-#include "slatec.hh"
+#include "ode.hh"
 #include "potential.hh"
 
-#include <setjmp.h>
+#include <vector>
 
 enum {BACKWARD = 0, FORWARD = 1};
 
 namespace Trajectory {
 
-  class Exception {};
-  class PotentialFailure : public Exception {};
-  class ExcludeRegionHit : public Exception {};
-  class       RunFailure : public Exception {};
-
-  // dynamic variables derivatives calculator
-  extern "C" void set_dvd (const double& time, const double* dv, double* dvd, void*, void* par);
-
-// container to transfer data between dvd calculator and the calling function
-struct DvdPar {
-    Potential::Wrap pot;
-    double ener; // energy
-    jmp_buf jmp; // jump buffer for for long jumps
-};
-
+  // propagation result
+  //
+  enum status_t {
+    DONE,               // the stop condition is met
+    POTENTIAL_FAILURE,  // the potential calculation failed
+    RUN_FAILURE,        // the integrator failed
+    EXCLUDE_REGION_HIT  // the trajectory entered the exclude region
+  };
 
   // Output Flags and streams
   struct Flags {
@@ -48,7 +41,7 @@ struct DvdPar {
     // ...
   };
 
-  class Propagator : public Dynamic::Vars, public Slatec::AdamSolver
+  class Propagator : public Dynamic::Vars
   {
     int    _dir;
     int    _spec;
@@ -57,23 +50,26 @@ struct DvdPar {
     
     Potential::Wrap _pot;
 
+    friend void run (const std::vector<Propagator*>&, const std::vector<Dynamic::CCP>&, const Dynamic::Classifier&,
+		     std::vector<status_t>&);
+
   public:
 
+    // time between the stop condition checks
     static double step;
-    //static Flags flags;
 
-    Propagator(Potential::Wrap pot, const Dynamic::Vars& dv, const Slatec::AdamSolver& as, int dir) 
-      : _pot(pot), Dynamic::Vars(dv), Slatec::AdamSolver(as), _time(0.0), _dir(dir) {}
+    static Ode::method_t method;
+    //static Flags flags;
 
-    Propagator(Potential::Wrap pot, const Dynamic::Vars& dv, int dir) 
-      : _pot(pot), Dynamic::Vars(dv), Slatec::AdamSolver(Structure::dv_size(), set_dvd), 
-	_time(0.0), _dir(dir) {}
+    // dynamical variables error tolerances
+    ::Array<double> rel_tol;
+    ::Array<double> abs_tol;
 
-    Propagator(Potential::Wrap pot, const Dynamic::Vars& dv, int dir, double rt, double at) 
-      : _pot(pot), Dynamic::Vars(dv), Slatec::AdamSolver(Structure::dv_size(), set_dvd, rt, at), 
+    Propagator(Potential::Wrap pot, const Dynamic::Vars& dv, int dir, double rt = -1., double at = -1.) 
+      : _pot(pot), Dynamic::Vars(dv), rel_tol(Structure::dv_size(), rt), abs_tol(Structure::dv_size(), at),
 	_time(0.0), _dir(dir) {}
 
-    void run (Dynamic::CCP stop, const Dynamic::Classifier& sort) ;
+    status_t run (Dynamic::CCP stop, const Dynamic::Classifier& sort) ;
 
     double time         () const { return _time; }
     int    direction    () const { return _dir; }
@@ -82,6 +78,10 @@ struct DvdPar {
     int    species      () const { return _spec; }
   };
 
+  // propagates the trajectories together, each one until its stop condition is met
+  //
+  void run (const std::vector<Propagator*>&, const std::vector<Dynamic::CCP>& stop, const Dynamic::Classifier& sort,
+	    std::vector<status_t>&) ;
 }
 
 #endif
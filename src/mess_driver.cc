@@ -2,11 +2,65 @@
 #include<fstream>
 #include<sstream>
 #include<cmath>
+#include<exception>
 
 #include "libmess/mess.hh"
 #include "libmess/key.hh"
 #include "libmess/units.hh"
 #include "libmess/io.hh"
+#include "libmess/arena.hh"
+
+// pressure dependent rate coefficients table for the temperature-pressure point
+//
+void point_rate_output (double temperature, double pressure, const std::vector<std::string>& spec_name,
+			const std::map<std::pair<int, int>, double>& rate_data)
+{
+  typedef std::map<std::pair<int, int>, double>::const_iterator Rit;
+
+  IO::out << "Temperature = " << temperature / Phys_const::kelv <<  " K    Pressure = ";
+  switch(MasterEquation::pressure_unit) {
+  case MasterEquation::BAR:
+    IO::out << pressure / Phys_const::bar << " bar";
+    break;
+  case MasterEquation::TORR:
+    IO::out << pressure / Phys_const::tor << " torr";
+    break;
+  case MasterEquation::ATM:
+    IO::out << pressure / Phys_const::atm << " atm";
+    break;
+  }
+  IO::out << "\n\n";
+  IO::out << std::left << std::setw(8) << "From\\To" << std::right;
+  for(int j = 0; j < spec_name.size(); ++j)
+    IO::out << std::setw(13) << spec_name[j];
+	
+  for(int w = 0; w < Model::well_size(); ++w)
+    if(Model::well(w).escape())
+      IO::out << std::setw(13) << Model::well(w).name(); 
+  IO::out << "\n";
+
+  for(int i = 0; i < spec_name.size(); ++i) {
+    IO::out << std::left << std::setw(8) << spec_name[i] << std::right;
+    for(int j = 0; j < spec_name.size(); ++j) {
+      Rit rit = rate_data.find(std::make_pair(i, j));
+      if(rit != rate_data.end())
+	IO::out << std::setw(13) << rit->second;
+      else
+	IO::out << std::setw(13) << "***";
+    }
+    // escape rates
+    for(int w = 0; w < Model::well_size(); ++w)
+      if(Model::well(w).escape()) {
+	Rit rit = rate_data.find(std::make_pair(i, Model::well_size() + Model::bimolecular_size() + w));
+	if(rit != rate_data.end())
+	  IO::out << std::setw(13) << rit->second;
+	else
+	  IO::out << std::setw(13) << "***";
+      }
+    IO::out << "\n";
+  }
+  IO::out << "\n";
+}
 
 int main (int argc, char* argv [])
 {
@@ -19,7 +73,6 @@ int main (int argc, char* argv [])
 
   int                 itemp;
   double              dtemp;
-  bool                btemp;
   std::string         stemp;
   std::pair<int, int> ptemp;
 
@@ -76,6 +129,12 @@ int main (int argc, char* argv [])
   Key mic_step_key("MicroEnerStep[kcal/mol]"    );
   Key tim_evol_key("TimeEvolution"              );
   Key       sl_key("StateLandscape"             );
+  Key  pnt_thr_key("ConcurrentPointNumber"      );
+  Key  eig_slv_key("EigenSolver"                );
+  Key chem_slv_key("ChemicalEigenSolver"        );
+  Key adp_grid_key("AdaptiveEnergyGrid"         );
+  Key grid_dir_key("GridCacheDirectory"         );
+  Key pool_lim_key("ScratchPoolLimit[MB]"       );
 
   std::vector<std::string> ped_spec;// product energy distribution pairs verbal
   std::vector<std::string> reduction_scheme;
@@ -92,6 +151,7 @@ int main (int argc, char* argv [])
   double micro_ener_min  = 0.;
   double micro_ener_step = -1.;
   std::string state_landscape;
+  int point_thread_num = 0; // number of temperature-pressure points solved concurrently
 
   // base name
   std::string base_name = argv[1];
@@ -578,6 +638,65 @@ int main (int argc, char* argv [])
 
       MasterEquation::set_well_partition_method(stemp);
     }
+    // global relaxation matrix eigensolver
+    else if(eig_slv_key == token) {
+      if(!(from >> stemp)) {
+        std::cerr << funame << token << ": corrupted\n";
+        throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      MasterEquation::set_eigensolver(stemp);
+    }
+    // chemical subspace eigensolver
+    else if(chem_slv_key == token) {
+      if(!(from >> stemp)) {
+        std::cerr << funame << token << ": corrupted\n";
+        throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      MasterEquation::set_chem_eigensolver(stemp);
+    }
+    // adaptive energy grid widest node spacing in the units of the energy transfer range
+    else if(adp_grid_key == token) {
+      if(!(from >> MasterEquation::adaptive_grid_width)) {
+        std::cerr << funame << token << ": corrupted\n";
+        throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      if(MasterEquation::adaptive_grid_width < 0.) {
+        std::cerr << funame << token << ": out of range\n";
+        throw Error::Range();
+      }
+    }
+    // states grid cache directory
+    else if(grid_dir_key == token) {
+      if(!(from >> stemp)) {
+        std::cerr << funame << token << ": corrupted\n";
+        throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      MasterEquation::grid_cache_dir = stemp;
+    }
+    // scratch matrices pool size limit; zero disables the pool; by default the pool
+    // with the scratch matrices in use does not exceed the largest working set
+    else if(pool_lim_key == token) {
+      if(!(from >> dtemp)) {
+        std::cerr << funame << token << ": corrupted\n";
+        throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      if(dtemp < 0.) {
+        std::cerr << funame << token << ": should not be negative\n";
+        throw Error::Range();
+      }
+
+      Arena::cache_limit = (long)(dtemp * 1024. * 1024.);
+    }
     // well partition threshold
     else if(wpt_key == token) {
       if(!(from >> dtemp)) {
@@ -702,6 +821,19 @@ int main (int argc, char* argv [])
 	throw Error::Input();
       }
     }
+    // number of temperature-pressure points solved concurrently
+    else if(pnt_thr_key == token) {
+      if(!(from >> point_thread_num)) {
+	std::cerr << funame << token << ": corrupted\n";
+	throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      if(point_thread_num < 0) {
+	std::cerr << funame << token << ": should not be negative\n";
+	throw Error::Range();
+      }
+    }
     // unknown keyword
     else if(IO::skip_comment(token, from)) {
       std::cerr << funame << "unknown keyword " << token << "\n";
@@ -797,18 +929,20 @@ int main (int argc, char* argv [])
 		  << std::setw(15) << states * Phys_const::kcal;
 
 	for(int b = 0; b < Model::inner_barrier_size(); ++b)
-	  if(Model::inner_connect(b).first == w || Model::inner_connect(b).second == w)
+	  if(Model::inner_connect(b).first == w || Model::inner_connect(b).second == w) {
 	    if(states != 0.)
 	      micro_out << std::setw(15) << Model::inner_barrier(b).states(ener) / states / 2. / M_PI / Phys_const::herz;
 	    else
 	      micro_out << std::setw(15) << "***";
+	  }
 
 	for(int b = 0; b < Model::outer_barrier_size(); ++b)
-	  if(Model::outer_connect(b).first == w)
+	  if(Model::outer_connect(b).first == w) {
 	    if(states != 0.)
 	      micro_out << std::setw(15) << Model::outer_barrier(b).states(ener) / states / 2. / M_PI / Phys_const::herz;
 	    else
 	      micro_out << std::setw(15) << "***";
+	  }
 	micro_out << "\n";
       } // energy cycle
     } // well cycle
@@ -870,8 +1004,6 @@ int main (int argc, char* argv [])
 
   }
 
-  typedef std::vector<double>::const_iterator It;
-
   std::map<std::pair<int, int>, double> rate_data;
   std::map<int, double> capture_data;
   std::vector<MasterEquation::Partition> well_partition;
@@ -895,20 +1027,71 @@ int main (int argc, char* argv [])
 
     IO::Marker rate_marker("rate calculation");
 
-    for(It t = temperature.begin(); t != temperature.end(); ++t) {// temperature cycle
-      MasterEquation::set_temperature(*t);
+    const int tsize = temperature.size();
+    const int psize = pressure.size();
+
+    // in the concurrent mode the temperature dependent part of the calculation is done serially,
+    // each temperature-pressure point is then solved in its own context, and the captured output
+    // is released in the serial order
+    //
+    const bool is_concurrent = point_thread_num > 1;
+
+#ifndef _OPENMP
+
+    if(is_concurrent)
+      //
+      IO::log << IO::log_offset << "WARNING: built without OpenMP support: ConcurrentPointNumber = "
+	      << point_thread_num << " is ignored, the temperature-pressure points are solved serially\n";
+
+#endif
+
+    std::vector<MasterEquation::Context>     temperature_context;
+    std::vector<MasterEquation::Context>     point_context;
+    std::vector<SharedPointer<IO::Capture> > temperature_output;
+    std::vector<SharedPointer<IO::Capture> > point_output;
+
+    if(is_concurrent) {
+      //
+      // lazy initialization should not be done concurrently
+      //
+      if(Model::time_evolution)
+	Model::time_evolution->reactant();
+
+      temperature_context.resize(tsize);
+      point_context.resize(tsize * psize);
+
+      well_partition.resize(tsize * psize);
+      rate_coef.resize(tsize * psize);
+
+      for(int t = 0; t < tsize; ++t)
+	temperature_output.push_back(SharedPointer<IO::Capture>(new IO::Capture));
+
+      for(int i = 0; i < tsize * psize; ++i)
+	point_output.push_back(SharedPointer<IO::Capture>(new IO::Capture));
+    }
+
+    for(int t = 0; t < tsize; ++t) {// temperature cycle
+      //
+      if(is_concurrent) {
+	//
+	MasterEquation::set_context(&temperature_context[t]);
+
+	temperature_output[t]->start();
+      }
+
+      MasterEquation::set_temperature(temperature[t]);
 
       // energy step
       if(estep > 0.)
 	MasterEquation::set_energy_step(estep);
       else
-	MasterEquation::set_energy_step(nearbyint(*t * etot / Phys_const::incm) * Phys_const::incm);
+	MasterEquation::set_energy_step(nearbyint(temperature[t] * etot / Phys_const::incm) * Phys_const::incm);
       
       // reference energy
       if(iseref)
 	MasterEquation::set_energy_reference(eref);
       else
-	MasterEquation::set_energy_reference(nearbyint((*t * xtot + Model::maximum_barrier_height())
+	MasterEquation::set_energy_reference(nearbyint((temperature[t] * xtot + Model::maximum_barrier_height())
 						       / Phys_const::incm) * Phys_const::incm);
 
       // set barriers, wells, and bimolecular species
@@ -917,7 +1100,7 @@ int main (int argc, char* argv [])
       capture.push_back(capture_data);
 
       // output
-      IO::out << "Temperature = " << *t / Phys_const::kelv  << " K\n\n";
+      IO::out << "Temperature = " << temperature[t] / Phys_const::kelv  << " K\n\n";
       IO::out << "High Pressure Rate Coefficients:\n\n"
 	      << std::left << std::setw(8) << "From\\To" << std::right;
       for(int j = 0; j < spec_name.size(); ++j)
@@ -936,9 +1119,33 @@ int main (int argc, char* argv [])
       }
       IO::out << "\n";
 
+      if(is_concurrent) {
+	//
+	temperature_output[t]->stop();
+
+	// point contexts share the wells and barriers set at given temperature
+	//
+	for(int p = 0; p < psize; ++p) {
+	  //
+	  const int i = p + t * psize;
+
+	  point_context[i] = temperature_context[t];
+
+	  MasterEquation::set_context(&point_context[i]);
+
+	  MasterEquation::set_pressure(pressure[p]);
+
+	  rate_coef[i] = rate_data;
+	}
+
+	MasterEquation::set_context(0);
+
+	continue;
+      }
+
       // pressure dependent rate coefficients
-      for(It p = pressure.begin(); p != pressure.end(); ++p) {// pressure cycle
-	MasterEquation::set_pressure(*p);
+      for(int p = 0; p < psize; ++p) {// pressure cycle
+	MasterEquation::set_pressure(pressure[p]);
 	// rate calculation
 	if(method) {
 	  well_partition.push_back(MasterEquation::Partition());
@@ -947,51 +1154,74 @@ int main (int argc, char* argv [])
 	}
 
 	// output
-	IO::out << "Temperature = " << *t / Phys_const::kelv <<  " K    Pressure = ";
-	switch(MasterEquation::pressure_unit) {
-	case MasterEquation::BAR:
-	  IO::out << *p / Phys_const::bar << " bar";
-	  break;
-	case MasterEquation::TORR:
-	  IO::out << *p / Phys_const::tor << " torr";
-	  break;
-	case MasterEquation::ATM:
-	  IO::out << *p / Phys_const::atm << " atm";
-	  break;
-	}
-	IO::out << "\n\n";
-	IO::out << std::left << std::setw(8) << "From\\To" << std::right;
-	for(int j = 0; j < spec_name.size(); ++j)
-	  IO::out << std::setw(13) << spec_name[j];
+	point_rate_output(temperature[t], pressure[p], spec_name, rate_data);
+      }// pressure cycle
+
+      // the scratch matrices sizes change with temperature
+      //
+      Arena::thread_pool().clear();
+    }// temperature cycle
+
+    // concurrent temperature-pressure points calculation
+    //
+    if(is_concurrent) {
+      //
+      const IO::Offset master_offset = IO::log_offset;
+
+      std::vector<std::exception_ptr> point_error(tsize * psize);
+
+#pragma omp parallel for default(shared) schedule(dynamic) num_threads(point_thread_num)
 	
-	for(int w = 0; w < Model::well_size(); ++w)
-	  if(Model::well(w).escape())
-	    IO::out << std::setw(13) << Model::well(w).name(); 
-	IO::out << "\n";
+      for(int i = 0; i < tsize * psize; ++i) {
+	//
+	IO::log_offset = master_offset;
 
-	for(int i = 0; i < spec_name.size(); ++i) {
-	  IO::out << std::left << std::setw(8) << spec_name[i] << std::right;
-	  for(int j = 0; j < spec_name.size(); ++j) {
-	    ptemp = std::make_pair(i, j);
-	    if(rate_data.find(ptemp) != rate_data.end())
-	      IO::out << std::setw(13) << rate_data[ptemp];
-	    else
-	      IO::out << std::setw(13) << "***";
-	  }
-	  // escape rates
-	  for(int w = 0; w < Model::well_size(); ++w)
-	    if(Model::well(w).escape()) {
-	      ptemp = std::make_pair(i, Model::well_size() + Model::bimolecular_size() + w);
-	      if(rate_data.find(ptemp) != rate_data.end())
-		IO::out << std::setw(13) << rate_data[ptemp];
-	      else
-		IO::out << std::setw(13) << "***";
-	    }
-	  IO::out << "\n";
+	MasterEquation::set_context(&point_context[i]);
+
+	point_output[i]->start();
+
+	try {
+	  //
+	  if(method)
+	    //
+	    method(rate_coef[i], well_partition[i], 0);
+
+	  point_rate_output(temperature[i / psize], pressure[i % psize], spec_name, rate_coef[i]);
 	}
-	IO::out << "\n";
-      }// pressure cycle
-    }// temperature cycle
+	catch(...) {
+	  //
+	  point_error[i] = std::current_exception();
+	}
+
+	point_output[i]->stop();
+
+	MasterEquation::set_context(0);
+      }
+
+      // release the scratch pools of the threads
+      //
+#pragma omp parallel num_threads(point_thread_num)
+
+      Arena::thread_pool().clear();
+
+      // output in the serial order
+      //
+      for(int t = 0; t < tsize; ++t) {
+	//
+	temperature_output[t]->release();
+
+	for(int p = 0; p < psize; ++p) {
+	  //
+	  const int i = p + t * psize;
+
+	  point_output[i]->release();
+
+	  if(point_error[i])
+	    //
+	    std::rethrow_exception(point_error[i]);
+	}
+      }
+    }
   }
   //catch(Error::General) {
   // IO::log << std::flush;
@@ -179,6 +179,29 @@ int main (int argc, char* argv [])
 
   const double volume_unit = Phys_const::cm * Phys_const::cm * Phys_const::cm;
 
+  // temperatures for the partition function derivatives
+  //
+  std::vector<double> weight_temperature;
+
+  for(int t = 0; t < temperature.size(); ++t) {
+    //
+    const double tval = temperature[t];
+
+    const double temp_incr = tval * temp_rel_incr;
+
+    weight_temperature.push_back(tval);
+    weight_temperature.push_back(tval - temp_incr);
+    weight_temperature.push_back(tval + temp_incr);
+  }
+
+  // statistical weights for all temperatures at once
+  //
+  std::vector<std::vector<double> > species_weight(species.size());
+
+  for(int s = 0; s < species.size(); ++s)
+    //
+    species[s]->weights(weight_temperature, species_weight[s]);
+
   //  IO::out << "Partition function (relative to the ground,1/cm^3):\n"
   IO::out << "Partition function (log) and its derivatives:\n"
 	  << std::left << std::setw(5) << "T, K" << std::right;
@@ -206,13 +229,15 @@ int main (int argc, char* argv [])
       
       for(int i = 0; i < 3; ++i) {
 	//
-	dtemp = species[s]->weight(tt[i]) * std::pow(species[s]->mass() * tt[i] / 2. / M_PI, 1.5) * volume_unit;
+	const double weight = species_weight[s][3 * t + i];
+	
+	dtemp = weight * std::pow(species[s]->mass() * tt[i] / 2. / M_PI, 1.5) * volume_unit;
 
 	if(dtemp <= 0.) {
 	  //
 	  ErrOut err_out;
 
-	  err_out << funame << "negative weight: " << species[s]->weight(tt[i]);
+	  err_out << funame << "negative weight: " << weight;
 	}
 	
 	zz[i] = std::log(dtemp);